@@ -0,0 +1,763 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/linear_algebra/lamp_matrix.h"
+#include "../src/linear_algebra/lamp_simd.h"
+#include "../src/memory/lamp_alloc_count.h"
+#include "../src/neural_network/lamp_activation.h"
+#include "../src/neural_network/lamp_nn.h"
+#include "../src/neural_network/lamp_nn_plan.h"
+#include "../src/neural_network/lamp_data_parallel.h"
+#include "../src/threading/lamp_threadpool.h"
+
+// Microbenchmarks of the hot paths: matrix multiplication, element-wise operations, the forward pass and
+// full training steps. Every benchmark is repeated until it ran for at least the minimum time.
+//
+// Usage: lamp_bench [--format text|csv|json] [--min-time seconds] [--threads n] [--filter name] [--check margin]
+
+#define MAX_RESULTS 128
+#define DEFAULT_MIN_TIME 0.2
+#define BATCH_SIZE 64
+#define ELEMENTWISE_SIZE (1 << 20)
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Measurement
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Metrics, that do not apply to a benchmark, are negative and not reported
+typedef struct {
+    const char *name;
+    char shape[64];
+    size_t iterations;
+    double ns_per_op;
+    double gflops;
+    double ns_per_sample;
+    double allocs_per_op;
+} BenchResult;
+
+typedef struct {
+    double min_time;
+    const char *filter;
+    BenchResult results[MAX_RESULTS];
+    size_t result_count;
+} Bench;
+
+typedef void (*BenchFunction)(void *context);
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static bool bench_enabled(const Bench *bench, const char *name) {
+    return bench->filter == NULL || strstr(name, bench->filter) != NULL;
+}
+
+// Run the function until min_time is reached. The first call is not measured, it warms up caches and lets
+// the library allocate its lazily created buffers. flops and samples describe a single call.
+static void bench_run(Bench *bench, const char *name, const char *shape, BenchFunction function, void *context,
+                      double flops, double samples) {
+    assert(bench->result_count < MAX_RESULTS);
+    function(context);
+
+    size_t iterations = 0;
+    size_t allocations_before = lamp_alloc_count();
+    double begin = now_seconds();
+    double elapsed;
+    do {
+        function(context);
+        iterations++;
+        elapsed = now_seconds() - begin;
+    } while (elapsed < bench->min_time);
+    size_t allocations_after = lamp_alloc_count();
+
+    BenchResult *result = &bench->results[bench->result_count++];
+    result->name = name;
+    snprintf(result->shape, sizeof(result->shape), "%s", shape);
+    result->iterations = iterations;
+    result->ns_per_op = elapsed * 1e9 / (double) iterations;
+    result->gflops = flops > 0 ? flops * (double) iterations / elapsed * 1e-9 : -1.0;
+    result->ns_per_sample = samples > 0 ? result->ns_per_op / samples : -1.0;
+    result->allocs_per_op = lamp_alloc_counting() ?
+                            (double) (allocations_after - allocations_before) / (double) iterations : -1.0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------------------------------------------------
+
+typedef struct {
+    LampMatrix *a;
+    LampMatrix *b;
+    LampMatrix *dst;
+    LampMatrix *scratch;
+} MatrixContext;
+
+static void bench_gemm_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_mat_multiply_into(ctx->dst, ctx->a, ctx->b);
+}
+
+static void bench_gemm(Bench *bench) {
+    if (!bench_enabled(bench, "gemm")) {
+        return;
+    }
+
+    // Square shapes and the skinny ones found in neural networks: matrix * vector, small batches and
+    // weights with a lot of inputs
+    const size_t shapes[][3] = {
+            {64,   64,   64},
+            {256,  256,  256},
+            {512,  512,  512},
+            {1024, 1024, 1024},
+            {1024, 1,    1024},
+            {1024, 16,   1024},
+            {128,  64,   784},
+            {4096, 32,   256},
+    };
+
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i) {
+        size_t m = shapes[i][0], n = shapes[i][1], k = shapes[i][2];
+        MatrixContext ctx = {
+                .a = lamp_mat_alloc(m, k),
+                .b = lamp_mat_alloc(k, n),
+                .dst = lamp_mat_alloc(m, n),
+                .scratch = NULL,
+        };
+        lamp_mat_rand(ctx.a);
+        lamp_mat_rand(ctx.b);
+
+        char shape[64];
+        snprintf(shape, sizeof(shape), "%zux%zux%zu", m, n, k);
+        bench_run(bench, "gemm", shape, bench_gemm_function, &ctx, 2.0 * (double) m * (double) n * (double) k, 0);
+
+        lamp_mat_free(ctx.a);
+        lamp_mat_free(ctx.b);
+        lamp_mat_free(ctx.dst);
+    }
+}
+
+static void bench_gemm_nt_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_mat_multiply_trans_into(ctx->dst, ctx->a, false, ctx->b, true);
+}
+
+static void bench_gemm_tn_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_mat_multiply_trans_into(ctx->dst, ctx->a, true, ctx->b, false);
+}
+
+// What the transposed multiplications cost, if the transpose has to be materialized first
+static void bench_gemm_nt_copy_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_mat_transpose_into(ctx->scratch, ctx->b);
+    lamp_mat_multiply_into(ctx->dst, ctx->a, ctx->scratch);
+}
+
+static void bench_gemm_tn_copy_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_mat_transpose_into(ctx->scratch, ctx->a);
+    lamp_mat_multiply_into(ctx->dst, ctx->scratch, ctx->b);
+}
+
+// The shapes of backpropagation: delta * a^T for the weight gradients and W^T * delta for the deltas of the
+// previous layer, with a batch of 64 samples and 784 inputs and 128 outputs
+static void bench_gemm_trans(Bench *bench) {
+    if (!bench_enabled(bench, "gemm_nt") && !bench_enabled(bench, "gemm_tn")) {
+        return;
+    }
+
+    // m, n, k and whether the first (tn) or second (nt) operand is transposed
+    const struct {
+        size_t m, n, k;
+        bool trans_a;
+    } shapes[] = {
+            {512, 512, 512, false},
+            {512, 512, 512, true},
+            {128, 784, 64,  false},
+            {784, 64,  128, true},
+    };
+
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i) {
+        size_t m = shapes[i].m, n = shapes[i].n, k = shapes[i].k;
+        bool trans_a = shapes[i].trans_a;
+        const char *name = trans_a ? "gemm_tn" : "gemm_nt";
+        if (!bench_enabled(bench, name)) {
+            continue;
+        }
+        MatrixContext ctx = {
+                .a = trans_a ? lamp_mat_alloc(k, m) : lamp_mat_alloc(m, k),
+                .b = trans_a ? lamp_mat_alloc(k, n) : lamp_mat_alloc(n, k),
+                .dst = lamp_mat_alloc(m, n),
+                .scratch = trans_a ? lamp_mat_alloc(m, k) : lamp_mat_alloc(k, n),
+        };
+        lamp_mat_rand(ctx.a);
+        lamp_mat_rand(ctx.b);
+
+        char shape[64];
+        snprintf(shape, sizeof(shape), "%zux%zux%zu", m, n, k);
+        double flops = 2.0 * (double) m * (double) n * (double) k;
+        if (trans_a) {
+            bench_run(bench, "gemm_tn", shape, bench_gemm_tn_function, &ctx, flops, 0);
+            bench_run(bench, "gemm_tn_copy", shape, bench_gemm_tn_copy_function, &ctx, flops, 0);
+        } else {
+            bench_run(bench, "gemm_nt", shape, bench_gemm_nt_function, &ctx, flops, 0);
+            bench_run(bench, "gemm_nt_copy", shape, bench_gemm_nt_copy_function, &ctx, flops, 0);
+        }
+
+        lamp_mat_free(ctx.a);
+        lamp_mat_free(ctx.b);
+        lamp_mat_free(ctx.dst);
+        lamp_mat_free(ctx.scratch);
+    }
+}
+
+static void bench_transpose_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_mat_transpose_into(ctx->dst, ctx->a);
+}
+
+// The straightforward row by row transpose, which lamp_mat_transpose() used to be
+static void bench_transpose_naive_function(void *context) {
+    MatrixContext *ctx = context;
+    for (size_t i = 0; i < ctx->a->num_rows; ++i) {
+        for (size_t j = 0; j < ctx->a->num_cols; ++j) {
+            LAMP_MAT_ELEMENT_AT(ctx->dst, j, i) = LAMP_MAT_ELEMENT_AT(ctx->a, i, j);
+        }
+    }
+}
+
+static void bench_transpose(Bench *bench) {
+    if (!bench_enabled(bench, "transpose")) {
+        return;
+    }
+
+    // Rows of a power of two apart map to the same cache sets, which is the worst case for a transpose
+    const size_t shapes[][2] = {
+            {64,   64},
+            {1000, 1000},
+            {1024, 1024},
+            {4096, 256},
+            {784,  128},
+    };
+
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i) {
+        size_t rows = shapes[i][0], cols = shapes[i][1];
+        MatrixContext ctx = {
+                .a = lamp_mat_alloc(rows, cols),
+                .b = NULL,
+                .dst = lamp_mat_alloc(cols, rows),
+                .scratch = NULL,
+        };
+        lamp_mat_rand(ctx.a);
+
+        char shape[64];
+        snprintf(shape, sizeof(shape), "%zux%zu", rows, cols);
+        // One sample is one element here
+        double elements = (double) rows * (double) cols;
+        if (bench_enabled(bench, "transpose_naive")) {
+            bench_run(bench, "transpose_naive", shape, bench_transpose_naive_function, &ctx, 0, elements);
+        }
+        if (bench_enabled(bench, "transpose")) {
+            bench_run(bench, "transpose", shape, bench_transpose_function, &ctx, 0, elements);
+        }
+
+        lamp_mat_free(ctx.a);
+        lamp_mat_free(ctx.dst);
+    }
+}
+
+static void bench_fill_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_mat_fill_with(ctx->dst, 0.5f);
+}
+
+static void bench_add_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_mat_add(ctx->dst, ctx->a);
+}
+
+static void bench_sigmoid_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_mat_sigmoid(ctx->dst);
+}
+
+static void bench_relu_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_activation_forward(LAMP_ACTIVATION_RELU, ctx->dst);
+}
+
+static void bench_gelu_function(void *context) {
+    MatrixContext *ctx = context;
+    lamp_activation_forward(LAMP_ACTIVATION_GELU, ctx->dst);
+}
+
+static void bench_elementwise(Bench *bench) {
+    const struct {
+        const char *name;
+        BenchFunction function;
+    } ops[] = {
+            {"fill",    bench_fill_function},
+            {"add",     bench_add_function},
+            {"sigmoid", bench_sigmoid_function},
+            {"relu",    bench_relu_function},
+            {"gelu",    bench_gelu_function},
+    };
+
+    MatrixContext ctx = {
+            .a = lamp_mat_alloc(1, ELEMENTWISE_SIZE),
+            .b = NULL,
+            .dst = lamp_mat_alloc(1, ELEMENTWISE_SIZE),
+            .scratch = NULL,
+    };
+    lamp_mat_rand(ctx.a);
+
+    char shape[64];
+    snprintf(shape, sizeof(shape), "%d", ELEMENTWISE_SIZE);
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i) {
+        if (!bench_enabled(bench, ops[i].name)) {
+            continue;
+        }
+        // The activations are applied in place over and over again, so start from the same values every time
+        lamp_mat_copy_into(ctx.dst, ctx.a);
+        // One sample is one element here
+        bench_run(bench, ops[i].name, shape, ops[i].function, &ctx, 0, ELEMENTWISE_SIZE);
+    }
+
+    lamp_mat_free(ctx.a);
+    lamp_mat_free(ctx.dst);
+}
+
+typedef struct {
+    LampNN *nn;
+    LampMatrixView input;
+    LampMatrixView target;
+    LampMatrixView output;
+    LampNNQuantized *quantized;
+    LampNNPlan *plan;
+    LampDataParallel *parallel;
+} NNContext;
+
+static void bench_forward_function(void *context) {
+    NNContext *ctx = context;
+    lamp_nn_forward_view(ctx->nn, &ctx->input);
+}
+
+static void bench_forward_plan_function(void *context) {
+    NNContext *ctx = context;
+    lamp_nn_plan_infer(ctx->plan, &ctx->input, &ctx->output);
+}
+
+static void bench_forward_int8_function(void *context) {
+    NNContext *ctx = context;
+    lamp_nn_forward_quantized(ctx->nn, ctx->quantized);
+}
+
+static void bench_train_function(void *context) {
+    NNContext *ctx = context;
+    lamp_nn_backprop_view(ctx->nn, &ctx->input, &ctx->target);
+    lamp_nn_apply_gradients(ctx->nn, 1e-3f);
+}
+
+static void bench_train_dp_function(void *context) {
+    NNContext *ctx = context;
+    lamp_data_parallel_backprop_view(ctx->parallel, &ctx->input, &ctx->target);
+    lamp_nn_apply_gradients(ctx->nn, 1e-3f);
+}
+
+// train splits every matrix multiplication over the pool, train_dp splits the batch over the threads instead.
+// forward_plan runs the compiled inference plan, whose layers share two buffers.
+// The share of pruned weights of the forward_sparse benchmarks
+static const double prune_sparsities[] = {0.8, 0.9, 0.95};
+static const char *const prune_names[] = {"forward_sparse80", "forward_sparse90", "forward_sparse95"};
+
+static void bench_nn(Bench *bench, LampThreadPool *pool) {
+    bool forward = bench_enabled(bench, "forward");
+    bool forward_plan = bench_enabled(bench, "forward_plan");
+    bool forward_int8 = bench_enabled(bench, "forward_int8");
+    bool forward_sparse = false;
+    for (size_t s = 0; s < sizeof(prune_names) / sizeof(prune_names[0]); ++s) {
+        forward_sparse = forward_sparse || bench_enabled(bench, prune_names[s]);
+    }
+    bool train = bench_enabled(bench, "train");
+    bool train_dp = bench_enabled(bench, "train_dp");
+    if (!forward && !forward_plan && !forward_int8 && !forward_sparse && !train && !train_dp) {
+        return;
+    }
+
+    const size_t architectures[][4] = {
+            {2,   2,   1,   0},
+            {32,  32,  1,   0},
+            {784, 128, 10,  0},
+            {256, 256, 256, 10},
+    };
+
+    for (size_t a = 0; a < sizeof(architectures) / sizeof(architectures[0]); ++a) {
+        size_t layer_count = architectures[a][3] == 0 ? 3 : 4;
+        const size_t *arch = architectures[a];
+        LampNN *nn = lamp_nn_alloc_batched(arch, layer_count, BATCH_SIZE);
+        for (size_t i = 0; i < nn->connection_count; ++i) {
+            lamp_mat_rand(nn->connections[i].weights);
+            lamp_mat_rand(nn->connections[i].bias);
+        }
+
+        LampMatrix *input = lamp_mat_alloc(BATCH_SIZE, arch[0]);
+        LampMatrix *target = lamp_mat_alloc(BATCH_SIZE, arch[layer_count - 1]);
+        LampMatrix *output = lamp_mat_alloc(BATCH_SIZE, arch[layer_count - 1]);
+        lamp_mat_rand(input);
+        lamp_mat_rand(target);
+        NNContext ctx = {.nn = nn, .input = lamp_mat_view(input), .target = lamp_mat_view(target),
+                         .output = lamp_mat_view(output), .quantized = NULL, .plan = NULL, .parallel = NULL};
+
+        // Multiply-adds of one sample for all weights. Backpropagation needs two more matrix multiplications
+        // per connection, except for the first one, which does not propagate deltas to the input.
+        double weights = 0;
+        char shape[64];
+        int written = snprintf(shape, sizeof(shape), "%zu", arch[0]);
+        for (size_t i = 1; i < layer_count; ++i) {
+            weights += (double) arch[i] * (double) arch[i - 1];
+            written += snprintf(&shape[written], sizeof(shape) - (size_t) written, "-%zu", arch[i]);
+        }
+        snprintf(&shape[written], sizeof(shape) - (size_t) written, "/b%d", BATCH_SIZE);
+        double first = (double) arch[1] * (double) arch[0];
+        double forward_flops = 2.0 * weights * BATCH_SIZE;
+        double train_flops = forward_flops + 2.0 * (2.0 * weights - first) * BATCH_SIZE;
+
+        if (forward) {
+            bench_run(bench, "forward", shape, bench_forward_function, &ctx, forward_flops, BATCH_SIZE);
+        }
+        if (forward_plan) {
+            ctx.plan = lamp_nn_compile(nn, BATCH_SIZE);
+            bench_run(bench, "forward_plan", shape, bench_forward_plan_function, &ctx, forward_flops, BATCH_SIZE);
+            lamp_nn_plan_free(ctx.plan);
+        }
+        if (train) {
+            bench_run(bench, "train", shape, bench_train_function, &ctx, train_flops, BATCH_SIZE);
+        }
+        if (train_dp) {
+            ctx.parallel = lamp_data_parallel_alloc(nn, pool);
+            bench_run(bench, "train_dp", shape, bench_train_dp_function, &ctx, train_flops, BATCH_SIZE);
+            lamp_data_parallel_free(ctx.parallel);
+        }
+        if (forward_int8) {
+            // The quantized forward pass reads its input from the input layer
+            lamp_nn_set_batch_size(nn, BATCH_SIZE);
+            lamp_mat_rand(nn->layers[0].activations);
+            ctx.quantized = lamp_nn_quantize(nn);
+            bench_run(bench, "forward_int8", shape, bench_forward_int8_function, &ctx, forward_flops, BATCH_SIZE);
+            lamp_nn_quantized_free(ctx.quantized);
+        }
+        if (forward_sparse) {
+            // Pruning changes the weights, so it runs after all other benchmarks of the network. Every sparsity
+            // prunes the weights, that remain after the one before it. The GFLOP/s only count the multiply-adds of
+            // the remaining weights.
+            for (size_t s = 0; s < sizeof(prune_sparsities) / sizeof(prune_sparsities[0]); ++s) {
+                for (size_t i = 0; i < nn->connection_count; ++i) {
+                    lamp_nn_prune(nn, i, (LAMP_FLOAT_TYPE) prune_sparsities[s]);
+                }
+                if (bench_enabled(bench, prune_names[s])) {
+                    bench_run(bench, prune_names[s], shape, bench_forward_function, &ctx,
+                              forward_flops * (1.0 - prune_sparsities[s]), BATCH_SIZE);
+                }
+            }
+        }
+
+        lamp_mat_free(input);
+        lamp_mat_free(target);
+        lamp_mat_free(output);
+        lamp_nn_free(nn);
+    }
+}
+
+// A small image classifier: 1x28x28 -> conv 3x3 16x28x28 -> max pool 16x14x14 -> conv 3x3 32x14x14 -> dense 10.
+// The FLOPs only count the multiply-adds of the convolutions and the dense connection, not the pooling.
+// im2col pays off with many input channels, the first convolution with a single one favors the direct kernel.
+static void bench_conv(Bench *bench) {
+    const struct {
+        const char *name;
+        LampConvAlgorithm algorithm;
+        bool train;
+    } runs[] = {
+            {"conv_im2col",       LAMP_CONV_IM2COL, false},
+            {"conv_direct",       LAMP_CONV_DIRECT, false},
+            {"conv_train_im2col", LAMP_CONV_IM2COL, true},
+            {"conv_train_direct", LAMP_CONV_DIRECT, true},
+    };
+    bool enabled = false;
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); ++i) {
+        enabled = enabled || bench_enabled(bench, runs[i].name);
+    }
+    if (!enabled) {
+        return;
+    }
+
+    const LampNNConnectionSpec specs[] = {
+            {.kind = LAMP_CONNECTION_CONV2D, .shape = {1, 28, 28, 16, 3, 1, 1}},
+            {.kind = LAMP_CONNECTION_MAX_POOL, .shape = {16, 28, 28, 0, 2, 2, 0}},
+            {.kind = LAMP_CONNECTION_CONV2D, .shape = {16, 14, 14, 32, 3, 1, 1}},
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 10},
+    };
+    LampNN *nn = lamp_nn_alloc_layers(28 * 28, specs, sizeof(specs) / sizeof(specs[0]), BATCH_SIZE);
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_RELU);
+    lamp_nn_set_activation(nn, 2, LAMP_ACTIVATION_RELU);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+
+    LampMatrix *input = lamp_mat_alloc(BATCH_SIZE, 28 * 28);
+    LampMatrix *target = lamp_mat_alloc(BATCH_SIZE, 10);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+    NNContext ctx = {.nn = nn, .input = lamp_mat_view(input), .target = lamp_mat_view(target), .quantized = NULL,
+                     .plan = NULL, .parallel = NULL};
+
+    // The first connection does not propagate deltas to the input
+    char shape[64];
+    snprintf(shape, sizeof(shape), "28x28-16c-p-32c-10/b%d", BATCH_SIZE);
+    double first = 16.0 * 28 * 28 * 9;
+    double rest = 32.0 * 14 * 14 * 16 * 9 + 10.0 * 32 * 14 * 14;
+    double forward_flops = 2.0 * (first + rest) * BATCH_SIZE;
+    double train_flops = forward_flops + 2.0 * (first + 2.0 * rest) * BATCH_SIZE;
+
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); ++i) {
+        if (!bench_enabled(bench, runs[i].name)) {
+            continue;
+        }
+        lamp_nn_set_conv_algorithm(nn, 0, runs[i].algorithm);
+        lamp_nn_set_conv_algorithm(nn, 2, runs[i].algorithm);
+        if (runs[i].train) {
+            bench_run(bench, runs[i].name, shape, bench_train_function, &ctx, train_flops, BATCH_SIZE);
+        } else {
+            bench_run(bench, runs[i].name, shape, bench_forward_function, &ctx, forward_flops, BATCH_SIZE);
+        }
+    }
+
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_nn_free(nn);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------------------------------------------------
+
+typedef enum {
+    FORMAT_TEXT,
+    FORMAT_CSV,
+    FORMAT_JSON
+} OutputFormat;
+
+static void print_metric(const char *format, double value, const char *missing) {
+    if (value < 0) {
+        printf("%s", missing);
+    } else {
+        printf(format, value);
+    }
+}
+
+static void print_results(const Bench *bench, OutputFormat format, size_t threads) {
+    const char *simd = lamp_simd_kernels()->name;
+
+    switch (format) {
+        case FORMAT_TEXT:
+            printf("LAMP Benchmarks (simd: %s, threads: %zu)\n", simd, threads);
+            printf("%-18s %-22s %12s %14s %10s %14s %12s\n", "benchmark", "shape", "iterations", "ns/op", "GFLOP/s",
+                   "ns/sample", "allocs/op");
+            for (size_t i = 0; i < bench->result_count; ++i) {
+                const BenchResult *r = &bench->results[i];
+                printf("%-18s %-22s %12zu %14.1f ", r->name, r->shape, r->iterations, r->ns_per_op);
+                print_metric("%10.2f ", r->gflops, "         - ");
+                print_metric("%14.3f ", r->ns_per_sample, "             - ");
+                print_metric("%12.2f", r->allocs_per_op, "           -");
+                printf("\n");
+            }
+            break;
+        case FORMAT_CSV:
+            printf("benchmark,shape,simd,threads,iterations,ns_per_op,gflops,ns_per_sample,allocs_per_op\n");
+            for (size_t i = 0; i < bench->result_count; ++i) {
+                const BenchResult *r = &bench->results[i];
+                printf("%s,%s,%s,%zu,%zu,%.1f,", r->name, r->shape, simd, threads, r->iterations, r->ns_per_op);
+                print_metric("%.3f", r->gflops, "");
+                printf(",");
+                print_metric("%.3f", r->ns_per_sample, "");
+                printf(",");
+                print_metric("%.2f", r->allocs_per_op, "");
+                printf("\n");
+            }
+            break;
+        case FORMAT_JSON:
+            printf("{\n  \"simd\": \"%s\",\n  \"threads\": %zu,\n  \"results\": [\n", simd, threads);
+            for (size_t i = 0; i < bench->result_count; ++i) {
+                const BenchResult *r = &bench->results[i];
+                printf("    {\"benchmark\": \"%s\", \"shape\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.1f, ",
+                       r->name, r->shape, r->iterations, r->ns_per_op);
+                printf("\"gflops\": ");
+                print_metric("%.3f", r->gflops, "null");
+                printf(", \"ns_per_sample\": ");
+                print_metric("%.3f", r->ns_per_sample, "null");
+                printf(", \"allocs_per_op\": ");
+                print_metric("%.2f", r->allocs_per_op, "null");
+                printf("}%s\n", i + 1 < bench->result_count ? "," : "");
+            }
+            printf("  ]\n}\n");
+            break;
+    }
+}
+
+// With --check the optimized paths must not be slower than the paths they replace. The benchmarks of an
+// expectation run on the same shape, expectations with a benchmark, that did not run, are skipped. So are
+// expectations for SIMD levels below min_level, where the optimized path is not meant to win.
+typedef struct {
+    const char *faster;
+    const char *slower;
+    const char *shape;
+    LampSimdLevel min_level;
+} BenchExpectation;
+
+static const BenchExpectation expectations[] = {
+        {.faster = "forward_int8", .slower = "forward", .shape = "784-128-10/b64", .min_level = LAMP_SIMD_SSE4_1},
+        {.faster = "forward_int8", .slower = "forward", .shape = "256-256-256-10/b64", .min_level = LAMP_SIMD_SSE4_1},
+        {.faster = "forward_sparse80", .slower = "forward", .shape = "784-128-10/b64"},
+        {.faster = "forward_sparse80", .slower = "forward", .shape = "256-256-256-10/b64"},
+        {.faster = "forward_sparse90", .slower = "forward", .shape = "784-128-10/b64"},
+        {.faster = "forward_sparse90", .slower = "forward", .shape = "256-256-256-10/b64"},
+        {.faster = "forward_sparse95", .slower = "forward", .shape = "784-128-10/b64"},
+        {.faster = "forward_sparse95", .slower = "forward", .shape = "256-256-256-10/b64"},
+};
+
+static const BenchResult *find_result(const Bench *bench, const char *name, const char *shape) {
+    for (size_t i = 0; i < bench->result_count; ++i) {
+        if (strcmp(bench->results[i].name, name) == 0 && strcmp(bench->results[i].shape, shape) == 0) {
+            return &bench->results[i];
+        }
+    }
+    return NULL;
+}
+
+// The level of the kernels, that the benchmarks ran with
+static LampSimdLevel selected_level(void) {
+    for (int level = 0; level < LAMP_SIMD_LEVEL_COUNT; ++level) {
+        if (lamp_simd_kernels_for((LampSimdLevel) level) == lamp_simd_kernels()) {
+            return (LampSimdLevel) level;
+        }
+    }
+    return LAMP_SIMD_SCALAR;
+}
+
+// A single run is noisy, so the optimized path may take up to 1 + margin times as long as the path it replaces
+static bool check_expectations(const Bench *bench, double margin) {
+    bool met = true;
+    LampSimdLevel level = selected_level();
+    for (size_t i = 0; i < sizeof(expectations) / sizeof(expectations[0]); ++i) {
+        const BenchExpectation *e = &expectations[i];
+        const BenchResult *faster = find_result(bench, e->faster, e->shape);
+        const BenchResult *slower = find_result(bench, e->slower, e->shape);
+        if (level >= e->min_level && faster != NULL && slower != NULL &&
+            faster->ns_per_op > slower->ns_per_op * (1.0 + margin)) {
+            fprintf(stderr, "Expectation failed: %s %s took %.1f ns/op, %s only %.1f ns/op\n", e->faster, e->shape,
+                    faster->ns_per_op, e->slower, slower->ns_per_op);
+            met = false;
+        }
+    }
+    return met;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--format text|csv|json] [--min-time seconds] [--threads n] [--filter name] "
+                    "[--check margin]\n", program);
+}
+
+int main(int argc, char *argv[]) {
+    static Bench bench = {.min_time = DEFAULT_MIN_TIME, .filter = NULL, .result_count = 0};
+    OutputFormat format = FORMAT_TEXT;
+    size_t threads = 1;
+    // Negative while the expectations are not checked
+    double check_margin = -1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        const char *option = argv[i];
+        const char *value = argv[++i];
+        if (strcmp(option, "--format") == 0) {
+            if (strcmp(value, "text") == 0) {
+                format = FORMAT_TEXT;
+            } else if (strcmp(value, "csv") == 0) {
+                format = FORMAT_CSV;
+            } else if (strcmp(value, "json") == 0) {
+                format = FORMAT_JSON;
+            } else {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(option, "--min-time") == 0) {
+            bench.min_time = strtod(value, NULL);
+        } else if (strcmp(option, "--threads") == 0) {
+            threads = strtoul(value, NULL, 10);
+        } else if (strcmp(option, "--filter") == 0) {
+            bench.filter = value;
+        } else if (strcmp(option, "--check") == 0) {
+            check_margin = strtod(value, NULL);
+            if (check_margin < 0.0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // A single thread runs everything on the calling thread, without a pool
+    LampThreadPool *pool = NULL;
+    if (threads != 1) {
+        pool = lamp_threadpool_alloc(threads);
+        threads = lamp_threadpool_num_threads(pool);
+        lamp_threadpool_set_default(pool);
+    }
+
+    bench_gemm(&bench);
+    bench_gemm_trans(&bench);
+    bench_transpose(&bench);
+    bench_elementwise(&bench);
+    bench_nn(&bench, pool);
+    bench_conv(&bench);
+
+    print_results(&bench, format, threads);
+    bool met = check_margin < 0.0 || check_expectations(&bench, check_margin);
+
+    if (pool != NULL) {
+        lamp_threadpool_set_default(NULL);
+        lamp_threadpool_free(pool);
+    }
+    return met ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -26,9 +26,10 @@
 #include <stdlib.h>
 #include <time.h>
 #include "../src/neural_network/lamp_nn.h"
+#include "../src/neural_network/lamp_optimizer.h"
 
-#define LEARNING_RATE 1e-1f
-#define FINITE_DIFF_STEP 1e-1f
+#define LEARNING_RATE 3e-1f
+#define MOMENTUM 0.9f
 
 #define HALF_ADD_INPUTS 2
 #define HALF_ADD_HIDDEN 2
@@ -64,17 +65,20 @@ int main() {
 
     LampMatrix *target = lamp_mat_alloc_from_array(input->num_rows, 2, targs_ha);
 
-
-    for (int e = 0; e < 10 * 1000; ++e) {
-        lamp_nn_apply_finite_diff_gradients(nn, input, target, FINITE_DIFF_STEP, LEARNING_RATE);
+    LampOptimizerConfig config = lamp_optimizer_sgd(LEARNING_RATE, MOMENTUM);
+    LampOptimizer *optimizer = lamp_optimizer_alloc(nn, &config);
+    for (int e = 0; e < 1000; ++e) {
+        lamp_nn_backprop(nn, input, target);
+        lamp_optimizer_step(optimizer, nn);
         LAMP_FLOAT_TYPE loss = lamp_nn_loss(nn, input, target);
 //        printf("Loss %f\n", loss);
     }
 
+    LampMatrixView samples = lamp_mat_view(input);
+
     for (int it = 0; it < input->num_rows; ++it) {
-        LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 0, 0) = LAMP_MAT_ELEMENT_AT(input, it, 0);
-        LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 1, 0) = LAMP_MAT_ELEMENT_AT(input, it, 1);
-        lamp_nn_forward(nn);
+        LampMatrixView sample = lamp_mat_view_rows(&samples, it, 1);
+        lamp_nn_forward_view(nn, &sample);
         printf("[%f, %f] -> [%f, %f] (%f, %f)\n",
                LAMP_MAT_ELEMENT_AT(input, it, 0),
                LAMP_MAT_ELEMENT_AT(input, it, 1),
@@ -87,6 +91,7 @@ int main() {
 
     lamp_mat_free(input);
     lamp_mat_free(target);
+    lamp_optimizer_free(optimizer);
     lamp_nn_free(nn);
 
     LAMP_FLOAT_TYPE ins_fa[] = {0, 0, 0,
@@ -134,24 +139,30 @@ int main() {
     // On some lucky seeds I was able to train the network to a loss of ~0.375, where it plateaued.
     // Maybe this is a local minimum of the adder? Maybe the approximation with the finite difference method
     // is not good enough? Maybe I am just not smart enough to see the obvious?
-    LAMP_FLOAT_TYPE l_rate = 1e-2f;
-    LAMP_FLOAT_TYPE fds = 1e-1f;
-
-    int max_epochs = 100 * 1000;
+    // NOTE: The training now uses the exact gradients of the backpropagation instead of the finite difference
+    //       approximation.
+    // NOTE: Plain gradient descent still plateaus on most seeds. With momentum the network leaves the plateau
+    //       and learns the full adder in a few thousand epochs.
+    LAMP_FLOAT_TYPE l_rate = 1.0f;
+    config = lamp_optimizer_sgd(l_rate, MOMENTUM);
+    optimizer = lamp_optimizer_alloc(nn, &config);
+
+    int max_epochs = 5 * 1000;
     for (int e = 0; e < max_epochs; ++e) {
-        lamp_nn_apply_finite_diff_gradients(nn, input, target, fds, l_rate);
-        if ((e % 10000) == 0) {
+        lamp_nn_backprop(nn, input, target);
+        lamp_optimizer_step(optimizer, nn);
+        if ((e % 500) == 0) {
             LAMP_FLOAT_TYPE loss = lamp_nn_loss(nn, input, target);
 //            lamp_nn_print(nn);
-            printf("[%d/%d] Loss %f (lr %f | fds %f)\n", e, max_epochs, loss, l_rate, fds);
+            printf("[%d/%d] Loss %f (lr %f)\n", e, max_epochs, loss, l_rate);
         }
     }
 
+    samples = lamp_mat_view(input);
+
     for (int it = 0; it < input->num_rows; ++it) {
-        LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 0, 0) = LAMP_MAT_ELEMENT_AT(input, it, 0);
-        LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 1, 0) = LAMP_MAT_ELEMENT_AT(input, it, 1);
-        LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 2, 0) = LAMP_MAT_ELEMENT_AT(input, it, 2);
-        lamp_nn_forward(nn);
+        LampMatrixView sample = lamp_mat_view_rows(&samples, it, 1);
+        lamp_nn_forward_view(nn, &sample);
         printf("[%f, %f, %f] -> [%f, %f] (%f, %f)\n",
                LAMP_MAT_ELEMENT_AT(input, it, 0),
                LAMP_MAT_ELEMENT_AT(input, it, 1),
@@ -164,6 +175,7 @@ int main() {
     }
     printf("\n");
     lamp_nn_print(nn);
+    lamp_optimizer_free(optimizer);
 
     return 0;
 }
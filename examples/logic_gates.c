@@ -24,8 +24,10 @@
 #include <assert.h>
 #include <stdio.h>
 #include <malloc.h>
+#include <stdlib.h>
 #include <time.h>
 #include "../src/neural_network/lamp_nn.h"
+#include "../src/neural_network/lamp_optimizer.h"
 
 // We create a 2x2x1 network
 // 2 inputs, 2 hidden nodes and one output
@@ -37,7 +39,8 @@
 #define NUM_OUTPUT_NODES 1
 
 #define LEARNING_RATE 1.0f
-#define FINITE_DIFF_STEP 0.5f
+#define MOMENTUM 0.9f
+#define EPOCHS 1000
 
 #define NUMBER_OF_GATES 6
 #define NUMBER_OF_STATES 4
@@ -45,7 +48,7 @@
 int main() {
     // Try learning behavior of logic gates - it is the 'Hello World!' of neural networks
     // NOTE: The functions of logic gates are relatively easy to approximate.
-    //       That allows us to use high learning rate and finite difference step.
+    //       That allows us to use a high learning rate.
     //
     // Running this example will show the output of a network trained to behave like one of six logic gates.
     // As it is known solving the XOR, XNOR gates is what the network struggles with the most.
@@ -79,6 +82,10 @@ int main() {
 
     size_t architecture[] = {NUM_INPUT_NODES, NUM_HIDDEN_NODES, NUM_OUTPUT_NODES};
     LampNN *nn = lamp_nn_alloc(architecture, sizeof(architecture) / sizeof(architecture[0]));
+    // NOTE: Momentum carries the updates over the flat regions of the loss surface, which cuts the
+    //       number of epochs by an order of magnitude compared to plain gradient descent.
+    LampOptimizerConfig config = lamp_optimizer_sgd(LEARNING_RATE, MOMENTUM);
+    LampOptimizer *optimizer = lamp_optimizer_alloc(nn, &config);
 
     for (int i = 0; i < NUMBER_OF_GATES; ++i) {
         LampMatrix *target = lamp_mat_alloc_from_array(input->num_rows, 1, targs[i]);
@@ -86,18 +93,20 @@ int main() {
             lamp_mat_rand(nn->connections[j].weights);
             lamp_mat_rand(nn->connections[j].bias);
         }
+        lamp_optimizer_reset(optimizer);
 
-        for (int e = 0; e < 10 * 1000; ++e) {
-            lamp_nn_apply_finite_diff_gradients(nn, input, target, FINITE_DIFF_STEP, LEARNING_RATE);
+        for (int e = 0; e < EPOCHS; ++e) {
+            lamp_nn_backprop(nn, input, target);
+            lamp_optimizer_step(optimizer, nn);
             LAMP_FLOAT_TYPE loss = lamp_nn_loss(nn, input, target);
 //        printf("Loss %f\n", loss);
         }
 
         printf("%s:\n", gate_descriptions[i]);
+        LampMatrixView samples = lamp_mat_view(input);
         for (int it = 0; it < input->num_rows; ++it) {
-            LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 0, 0) = LAMP_MAT_ELEMENT_AT(input, it, 0);
-            LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 1, 0) = LAMP_MAT_ELEMENT_AT(input, it, 1);
-            lamp_nn_forward(nn);
+            LampMatrixView sample = lamp_mat_view_rows(&samples, it, 1);
+            lamp_nn_forward_view(nn, &sample);
             printf("[%f, %f] -> [%f] (%f)\n",
                    LAMP_MAT_ELEMENT_AT(input, it, 0),
                    LAMP_MAT_ELEMENT_AT(input, it, 1),
@@ -108,6 +117,7 @@ int main() {
         lamp_mat_free(target);
     }
 
+    lamp_optimizer_free(optimizer);
     lamp_nn_free(nn);
 
     return 0;
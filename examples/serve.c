@@ -0,0 +1,405 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/neural_network/lamp_nn.h"
+#include "../src/threading/lamp_queue.h"
+#include "../src/threading/lamp_threadpool.h"
+
+// Inference server with dynamic batching - the way networks are usually served in production.
+//
+// Clients push their requests into a lock-free MPSC queue. A single server thread pops them and coalesces them
+// into micro batches: a batch runs as soon as it is full (max batch size) or its oldest request has waited for
+// the max wait time, whatever happens first. A batch turns many matrix-vector products into one matrix
+// multiplication, which is far more efficient, at the price of letting the first requests wait a little.
+// Try --max-batch 1 to see the difference.
+//
+// The load generator sends the requests from several client threads with exponentially distributed gaps,
+// so they arrive like the requests of many independent users. The clients never wait for answers (open loop),
+// and the latency is measured from the moment a request was supposed to be sent. Otherwise a slow server
+// would slow down the clients as well and hide its own latency.
+//
+// Usage: lamp_serve [--requests n] [--clients n] [--rate requests/s] [--max-batch n] [--max-wait-us us]
+//                   [--threads n]
+
+#define NUM_INPUTS 128
+#define NUM_HIDDEN 256
+#define NUM_OUTPUTS 10
+
+// Number of different input vectors the clients pick their requests from
+#define NUM_SAMPLES 1024
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Latency histogram
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Values are grouped by their power of two, which is split into HISTOGRAM_SUB_BUCKETS linear buckets.
+// So the relative error of a bucket stays below 1/16, no matter if it holds microseconds or seconds,
+// while the whole histogram has a fixed size and recording a value is just an increment.
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS (64 * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} Histogram;
+
+static size_t histogram_bucket(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (size_t) value;
+    }
+    int shift = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BITS;
+    size_t sub_bucket = (size_t) (value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1);
+    return (size_t) (shift + 1) * HISTOGRAM_SUB_BUCKETS + sub_bucket;
+}
+
+// Largest value, that falls into the bucket
+static uint64_t histogram_bucket_limit(size_t bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t first = (uint64_t) (HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+    return first + ((uint64_t) 1 << shift) - 1;
+}
+
+static void histogram_record(Histogram *histogram, uint64_t value) {
+    histogram->counts[histogram_bucket(value)]++;
+    histogram->total++;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+// Smallest value, that is larger than or equal to the given fraction of all values (up to the bucket width)
+static uint64_t histogram_percentile(const Histogram *histogram, double fraction) {
+    uint64_t rank = (uint64_t) ceil(fraction * (double) histogram->total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += histogram->counts[i];
+        if (seen >= rank && seen > 0) {
+            uint64_t limit = histogram_bucket_limit(i);
+            return limit < histogram->max ? limit : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+// Print the counts per power of two
+static void histogram_print(const Histogram *histogram) {
+    const int bar_width = 50;
+    uint64_t counts[64] = {0};
+    uint64_t largest = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        if (histogram->counts[i] == 0) {
+            continue;
+        }
+        size_t power = (size_t) (63 - __builtin_clzll(histogram_bucket_limit(i) | 1));
+        counts[power] += histogram->counts[i];
+        largest = counts[power] > largest ? counts[power] : largest;
+    }
+    for (size_t power = 0; power < 64; ++power) {
+        if (counts[power] == 0) {
+            continue;
+        }
+        printf("  < %10.1f us %8llu |", (double) ((uint64_t) 2 << power) * 1e-3, (unsigned long long) counts[power]);
+        int length = (int) ((double) counts[power] / (double) largest * bar_width + 0.5);
+        for (int i = 0; i < length; ++i) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Server
+// ---------------------------------------------------------------------------------------------------------------------
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+// The queue node has to be the first member, so a popped node can be cast back to its request
+typedef struct {
+    LampQueueNode node;
+    const LAMP_FLOAT_TYPE *input;
+    LAMP_FLOAT_TYPE output[NUM_OUTPUTS];
+    uint64_t enqueued_ns;
+} ServeRequest;
+
+typedef struct {
+    const LampNN *nn;
+    LampNNContext *ctx;
+    LampQueue *queue;
+    size_t max_batch_size;
+    uint64_t max_wait_ns;
+    size_t total_requests;
+
+    // Inputs and outputs of the current batch, one request per row
+    LampMatrix *inputs;
+    LampMatrix *outputs;
+    ServeRequest **batch;
+
+    Histogram latency;
+    size_t batch_count;
+    uint64_t finished_ns;
+} Server;
+
+static void server_run_batch(Server *server, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(&LAMP_MAT_ELEMENT_AT(server->inputs, i, 0), server->batch[i]->input,
+               sizeof(LAMP_FLOAT_TYPE) * NUM_INPUTS);
+    }
+    LampMatrixView inputs = lamp_mat_view(server->inputs);
+    LampMatrixView outputs = lamp_mat_view(server->outputs);
+    inputs = lamp_mat_view_rows(&inputs, 0, count);
+    outputs = lamp_mat_view_rows(&outputs, 0, count);
+    lamp_nn_infer(server->nn, server->ctx, &inputs, &outputs);
+
+    uint64_t done = now_ns();
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(server->batch[i]->output, &LAMP_MAT_ELEMENT_AT(server->outputs, i, 0),
+               sizeof(LAMP_FLOAT_TYPE) * NUM_OUTPUTS);
+        histogram_record(&server->latency, done - server->batch[i]->enqueued_ns);
+    }
+    server->batch_count++;
+}
+
+static void *server_main(void *arg) {
+    Server *server = arg;
+    size_t served = 0;
+    while (served < server->total_requests) {
+        // Wait for the first request, then for more until the batch is full or the first one waited long enough.
+        // Once all requests arrived there is no point in waiting any longer.
+        size_t count = 0;
+        uint64_t deadline = 0;
+        while (count < server->max_batch_size && served + count < server->total_requests) {
+            ServeRequest *request = (ServeRequest *) lamp_queue_pop(server->queue);
+            if (request != NULL) {
+                if (count == 0) {
+                    deadline = request->enqueued_ns + server->max_wait_ns;
+                }
+                server->batch[count++] = request;
+            } else if (count > 0 && now_ns() >= deadline) {
+                break;
+            } else {
+                sched_yield();
+            }
+        }
+        server_run_batch(server, count);
+        served += count;
+    }
+    server->finished_ns = now_ns();
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Load generator
+// ---------------------------------------------------------------------------------------------------------------------
+
+typedef struct {
+    LampQueue *queue;
+    ServeRequest *requests;
+    size_t count;
+    double rate;
+    const LampMatrix *samples;
+    unsigned int seed;
+    uint64_t start_ns;
+} Client;
+
+static void *client_main(void *arg) {
+    Client *client = arg;
+    uint64_t send_ns = client->start_ns;
+    for (size_t i = 0; i < client->count; ++i) {
+        // Exponentially distributed gaps make the arrivals a Poisson process with the given rate
+        double uniform = ((double) rand_r(&client->seed) + 1.0) / ((double) RAND_MAX + 2.0);
+        send_ns += (uint64_t) (-log(uniform) / client->rate * 1e9);
+        struct timespec ts = {.tv_sec = (time_t) (send_ns / 1000000000ull),
+                              .tv_nsec = (long) (send_ns % 1000000000ull)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+        ServeRequest *request = &client->requests[i];
+        size_t sample = (size_t) rand_r(&client->seed) % client->samples->num_rows;
+        request->input = &LAMP_MAT_ELEMENT_AT(client->samples, sample, 0);
+        request->enqueued_ns = send_ns;
+        lamp_queue_push(client->queue, &request->node);
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Main
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--requests n] [--clients n] [--rate requests/s] [--max-batch n] [--max-wait-us us] "
+                    "[--threads n]\n", program);
+}
+
+int main(int argc, char *argv[]) {
+    size_t total_requests = 20000;
+    size_t num_clients = 4;
+    double rate = 5000.0;
+    size_t max_batch_size = 32;
+    double max_wait_us = 200.0;
+    size_t threads = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        const char *option = argv[i];
+        const char *value = argv[++i];
+        if (strcmp(option, "--requests") == 0) {
+            total_requests = strtoul(value, NULL, 10);
+        } else if (strcmp(option, "--clients") == 0) {
+            num_clients = strtoul(value, NULL, 10);
+        } else if (strcmp(option, "--rate") == 0) {
+            rate = strtod(value, NULL);
+        } else if (strcmp(option, "--max-batch") == 0) {
+            max_batch_size = strtoul(value, NULL, 10);
+        } else if (strcmp(option, "--max-wait-us") == 0) {
+            max_wait_us = strtod(value, NULL);
+        } else if (strcmp(option, "--threads") == 0) {
+            threads = strtoul(value, NULL, 10);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (total_requests == 0 || num_clients == 0 || rate <= 0.0 || max_batch_size == 0 || max_wait_us < 0.0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    srand(time(NULL)); // NOLINT: We know about srand() initialization
+
+    // A classifier with random weights - serving does not care about what the network learned
+    size_t architecture[] = {NUM_INPUTS, NUM_HIDDEN, NUM_HIDDEN, NUM_OUTPUTS};
+    LampNN *nn = lamp_nn_alloc(architecture, sizeof(architecture) / sizeof(architecture[0]));
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+        lamp_nn_set_activation(nn, i, LAMP_ACTIVATION_RELU);
+    }
+    lamp_nn_set_activation(nn, nn->connection_count - 1, LAMP_ACTIVATION_SOFTMAX);
+
+    LampMatrix *samples = lamp_mat_alloc(NUM_SAMPLES, NUM_INPUTS);
+    lamp_mat_rand(samples);
+
+    // The server thread uses the pool to split the matrix multiplications of big batches
+    LampThreadPool *pool = NULL;
+    if (threads != 1) {
+        pool = lamp_threadpool_alloc(threads);
+        threads = lamp_threadpool_num_threads(pool);
+        lamp_threadpool_set_default(pool);
+    }
+
+    LampQueue queue;
+    lamp_queue_init(&queue);
+    // TODO: Propagate memory allocation error instead of asserting here
+    ServeRequest *requests = malloc(sizeof(ServeRequest) * total_requests);
+    Server *server = calloc(1, sizeof(Server));
+    Client *clients = malloc(sizeof(Client) * num_clients);
+    pthread_t *client_threads = malloc(sizeof(pthread_t) * num_clients);
+    assert(requests != NULL && server != NULL && clients != NULL && client_threads != NULL);
+
+    server->nn = nn;
+    server->ctx = lamp_nn_context_alloc(nn, max_batch_size);
+    server->queue = &queue;
+    server->max_batch_size = max_batch_size;
+    server->max_wait_ns = (uint64_t) (max_wait_us * 1e3);
+    server->total_requests = total_requests;
+    server->inputs = lamp_mat_alloc(max_batch_size, NUM_INPUTS);
+    server->outputs = lamp_mat_alloc(max_batch_size, NUM_OUTPUTS);
+    server->batch = malloc(sizeof(ServeRequest *) * max_batch_size);
+    assert(server->batch != NULL);
+
+    printf("Serving %zu requests from %zu clients at %.0f requests/s (max batch %zu, max wait %.0f us, %zu threads)\n",
+           total_requests, num_clients, rate, max_batch_size, max_wait_us, threads);
+
+    pthread_t server_thread;
+    pthread_create(&server_thread, NULL, server_main, server);
+
+    // Every client sends its share of the requests with its share of the rate
+    uint64_t start_ns = now_ns();
+    size_t first_request = 0;
+    for (size_t c = 0; c < num_clients; ++c) {
+        size_t count = total_requests * (c + 1) / num_clients - first_request;
+        clients[c] = (Client) {
+                .queue = &queue,
+                .requests = &requests[first_request],
+                .count = count,
+                .rate = rate / (double) num_clients,
+                .samples = samples,
+                .seed = (unsigned int) rand(),
+                .start_ns = start_ns,
+        };
+        first_request += count;
+        pthread_create(&client_threads[c], NULL, client_main, &clients[c]);
+    }
+
+    for (size_t c = 0; c < num_clients; ++c) {
+        pthread_join(client_threads[c], NULL);
+    }
+    pthread_join(server_thread, NULL);
+
+    const Histogram *latency = &server->latency;
+    double elapsed = (double) (server->finished_ns - start_ns) * 1e-9;
+    printf("Throughput %.1f requests/s, %zu batches with %.1f requests on average\n",
+           (double) total_requests / elapsed, server->batch_count,
+           (double) total_requests / (double) server->batch_count);
+    printf("Latency p50 %.1f us, p99 %.1f us, p999 %.1f us, max %.1f us\n",
+           (double) histogram_percentile(latency, 0.5) * 1e-3, (double) histogram_percentile(latency, 0.99) * 1e-3,
+           (double) histogram_percentile(latency, 0.999) * 1e-3, (double) latency->max * 1e-3);
+    histogram_print(latency);
+
+    free(server->batch);
+    lamp_mat_free(server->inputs);
+    lamp_mat_free(server->outputs);
+    lamp_nn_context_free(server->ctx);
+    free(server);
+    free(client_threads);
+    free(clients);
+    free(requests);
+    lamp_mat_free(samples);
+    lamp_nn_free(nn);
+    if (pool != NULL) {
+        lamp_threadpool_set_default(NULL);
+        lamp_threadpool_free(pool);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,355 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lamp_dataset.h"
+#include "../memory/lamp_arena.h"
+
+#define LAMP_DATASET_FILE_MAGIC "LAMPDS\0"
+#define LAMP_DATASET_FILE_BYTE_ORDER 0x01020304u
+
+// Header of a binary dataset. The samples follow directly, each one as num_inputs + num_targets values.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t float_size;
+    uint32_t byte_order;
+    uint32_t reserved0;
+    uint64_t num_inputs;
+    uint64_t num_targets;
+    uint64_t num_samples;
+    uint8_t reserved[16];
+} LampDatasetFileHeader;
+
+_Static_assert(sizeof(LampDatasetFileHeader) == 64, "The dataset header has to be 64 bytes");
+
+struct LampDataset {
+    FILE *file;
+    LampDatasetFormat format;
+    size_t num_inputs;
+    size_t num_targets;
+    size_t batch_size;
+    size_t num_samples;   // Only known for binary files
+    long data_offset;
+
+    // Only touched by the loader thread
+    size_t remaining_samples;
+    char *line;
+    size_t line_capacity;
+
+    // The loader fills the buffers alternately. A buffer is ready from the moment the loader finished it
+    // until the consumer returns it by asking for the next batch. An empty ready buffer marks the end of an epoch.
+    LAMP_FLOAT_TYPE *buffers[2];
+    size_t rows[2];
+    bool ready[2];
+    size_t consume_index;
+    bool holding;
+    bool stop;
+    bool failed;
+
+    pthread_t loader;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+
+static size_t sample_size(const LampDataset *dataset) {
+    return dataset->num_inputs + dataset->num_targets;
+}
+
+static size_t read_binary_rows(LampDataset *dataset, LAMP_FLOAT_TYPE *buffer, bool *failed) {
+    size_t wanted = dataset->remaining_samples < dataset->batch_size ? dataset->remaining_samples : dataset->batch_size;
+    size_t rows = fread(buffer, sizeof(LAMP_FLOAT_TYPE) * sample_size(dataset), wanted, dataset->file);
+    dataset->remaining_samples -= rows;
+    // The header promised more samples than the file contains
+    *failed = rows < wanted;
+    return rows;
+}
+
+// Parse one line with exactly sample_size() comma separated values
+static bool parse_csv_line(const LampDataset *dataset, const char *line, LAMP_FLOAT_TYPE *sample) {
+    const char *cursor = line;
+    for (size_t i = 0; i < sample_size(dataset); ++i) {
+        char *end;
+        sample[i] = strtof(cursor, &end);
+        if (end == cursor) {
+            return false;
+        }
+        cursor = end;
+        while (*cursor == ' ' || *cursor == '\t') {
+            cursor++;
+        }
+        if (i + 1 < sample_size(dataset)) {
+            if (*cursor != ',') {
+                return false;
+            }
+            cursor++;
+        }
+    }
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n') {
+        cursor++;
+    }
+    return *cursor == '\0';
+}
+
+static size_t read_csv_rows(LampDataset *dataset, LAMP_FLOAT_TYPE *buffer, bool *failed) {
+    *failed = false;
+    size_t rows = 0;
+    while (rows < dataset->batch_size && getline(&dataset->line, &dataset->line_capacity, dataset->file) >= 0) {
+        const char *line = dataset->line;
+        while (*line == ' ' || *line == '\t') {
+            line++;
+        }
+        if (*line == '\0' || *line == '\n' || *line == '\r' || *line == '#') {
+            continue;
+        }
+        if (!parse_csv_line(dataset, line, &buffer[rows * sample_size(dataset)])) {
+            *failed = true;
+            return rows;
+        }
+        rows++;
+    }
+    *failed = ferror(dataset->file) != 0;
+    return rows;
+}
+
+static void *loader_main(void *arg) {
+    LampDataset *dataset = arg;
+    size_t index = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&dataset->lock);
+        while (dataset->ready[index] && !dataset->stop) {
+            pthread_cond_wait(&dataset->changed, &dataset->lock);
+        }
+        bool stop = dataset->stop;
+        pthread_mutex_unlock(&dataset->lock);
+        if (stop) {
+            break;
+        }
+
+        // The file is read without holding the lock, the consumer works on the other buffer meanwhile
+        bool failed;
+        size_t rows = dataset->format == LAMP_DATASET_BINARY ?
+                      read_binary_rows(dataset, dataset->buffers[index], &failed) :
+                      read_csv_rows(dataset, dataset->buffers[index], &failed);
+        // Nothing after a broken sample is handed out, the epoch ends with an empty batch instead
+        if (failed) {
+            rows = 0;
+        }
+
+        pthread_mutex_lock(&dataset->lock);
+        dataset->rows[index] = rows;
+        dataset->ready[index] = true;
+        dataset->failed = failed;
+        pthread_cond_broadcast(&dataset->changed);
+        pthread_mutex_unlock(&dataset->lock);
+
+        if (rows == 0) {
+            break;
+        }
+        index ^= 1;
+    }
+    return NULL;
+}
+
+static void start_loader(LampDataset *dataset) {
+    fseek(dataset->file, dataset->data_offset, SEEK_SET);
+    dataset->remaining_samples = dataset->num_samples;
+    dataset->ready[0] = false;
+    dataset->ready[1] = false;
+    dataset->consume_index = 0;
+    dataset->holding = false;
+    dataset->stop = false;
+    dataset->failed = false;
+
+    int rc = pthread_create(&dataset->loader, NULL, loader_main, dataset);
+    assert(rc == 0);
+    (void) rc;
+}
+
+static void stop_loader(LampDataset *dataset) {
+    pthread_mutex_lock(&dataset->lock);
+    dataset->stop = true;
+    pthread_cond_broadcast(&dataset->changed);
+    pthread_mutex_unlock(&dataset->lock);
+    pthread_join(dataset->loader, NULL);
+}
+
+static bool read_binary_header(LampDataset *dataset) {
+    LampDatasetFileHeader header;
+    if (fread(&header, sizeof(header), 1, dataset->file) != 1) {
+        return false;
+    }
+    dataset->num_samples = (size_t) header.num_samples;
+    return memcmp(header.magic, LAMP_DATASET_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+           header.version == LAMP_DATASET_FILE_VERSION &&
+           header.float_size == sizeof(LAMP_FLOAT_TYPE) &&
+           header.byte_order == LAMP_DATASET_FILE_BYTE_ORDER &&
+           header.num_inputs == dataset->num_inputs &&
+           header.num_targets == dataset->num_targets;
+}
+
+LampDataset *lamp_dataset_open(const char *path, LampDatasetFormat format, size_t num_inputs, size_t num_targets,
+                               size_t batch_size) {
+    assert(path != NULL);
+    assert(num_inputs > 0 && batch_size > 0);
+
+    FILE *file = fopen(path, format == LAMP_DATASET_BINARY ? "rb" : "r");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampDataset *dataset = malloc(sizeof(LampDataset));
+    assert(dataset != NULL);
+    dataset->file = file;
+    dataset->format = format;
+    dataset->num_inputs = num_inputs;
+    dataset->num_targets = num_targets;
+    dataset->batch_size = batch_size;
+    dataset->num_samples = SIZE_MAX;
+    dataset->line = NULL;
+    dataset->line_capacity = 0;
+
+    if (format == LAMP_DATASET_BINARY && !read_binary_header(dataset)) {
+        fclose(file);
+        free(dataset);
+        return NULL;
+    }
+    dataset->data_offset = ftell(file);
+
+    // Both buffers in one allocation, each starting at a cache line
+    size_t buffer_size = LAMP_ARENA_ALIGNED_SIZE(sizeof(LAMP_FLOAT_TYPE) * batch_size * sample_size(dataset));
+    dataset->buffers[0] = aligned_alloc(LAMP_ARENA_ALIGNMENT, 2 * buffer_size);
+    assert(dataset->buffers[0] != NULL);
+    dataset->buffers[1] = (LAMP_FLOAT_TYPE *) ((unsigned char *) dataset->buffers[0] + buffer_size);
+
+    pthread_mutex_init(&dataset->lock, NULL);
+    pthread_cond_init(&dataset->changed, NULL);
+    start_loader(dataset);
+    return dataset;
+}
+
+void lamp_dataset_close(LampDataset *dataset) {
+    assert(dataset != NULL);
+    stop_loader(dataset);
+
+    pthread_mutex_destroy(&dataset->lock);
+    pthread_cond_destroy(&dataset->changed);
+    fclose(dataset->file);
+    free(dataset->buffers[0]);
+    free(dataset->line);
+    free(dataset);
+}
+
+bool lamp_dataset_next(LampDataset *dataset, LampMatrixView *inputs, LampMatrixView *targets) {
+    assert(dataset != NULL && inputs != NULL && targets != NULL);
+
+    pthread_mutex_lock(&dataset->lock);
+    // The previous batch is no longer used, so the loader can fill it again
+    if (dataset->holding) {
+        dataset->ready[dataset->consume_index ^ 1] = false;
+        dataset->holding = false;
+        pthread_cond_broadcast(&dataset->changed);
+    }
+    while (!dataset->ready[dataset->consume_index]) {
+        pthread_cond_wait(&dataset->changed, &dataset->lock);
+    }
+    size_t index = dataset->consume_index;
+    size_t rows = dataset->rows[index];
+    // The empty batch at the end of the epoch stays ready, so every further call returns false as well
+    if (rows > 0) {
+        dataset->holding = true;
+        dataset->consume_index ^= 1;
+    }
+    pthread_mutex_unlock(&dataset->lock);
+
+    if (rows == 0) {
+        return false;
+    }
+
+    // Inputs and targets of a sample are stored next to each other, so both views share the stride
+    LAMP_FLOAT_TYPE *buffer = dataset->buffers[index];
+    *inputs = (LampMatrixView) {
+            .num_rows = rows,
+            .num_cols = dataset->num_inputs,
+            .stride = sample_size(dataset),
+            .elements = buffer,
+    };
+    *targets = (LampMatrixView) {
+            .num_rows = rows,
+            .num_cols = dataset->num_targets,
+            .stride = sample_size(dataset),
+            .elements = buffer + dataset->num_inputs,
+    };
+    return true;
+}
+
+void lamp_dataset_rewind(LampDataset *dataset) {
+    assert(dataset != NULL);
+    stop_loader(dataset);
+    start_loader(dataset);
+}
+
+bool lamp_dataset_failed(LampDataset *dataset) {
+    assert(dataset != NULL);
+    pthread_mutex_lock(&dataset->lock);
+    bool failed = dataset->failed;
+    pthread_mutex_unlock(&dataset->lock);
+    return failed;
+}
+
+bool lamp_dataset_save(const char *path, const LampMatrixView *inputs, const LampMatrixView *targets) {
+    assert(path != NULL && inputs != NULL && targets != NULL);
+    assert(inputs->num_rows == targets->num_rows);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    LampDatasetFileHeader header = {
+            .version = LAMP_DATASET_FILE_VERSION,
+            .float_size = sizeof(LAMP_FLOAT_TYPE),
+            .byte_order = LAMP_DATASET_FILE_BYTE_ORDER,
+            .num_inputs = inputs->num_cols,
+            .num_targets = targets->num_cols,
+            .num_samples = inputs->num_rows,
+    };
+    memcpy(header.magic, LAMP_DATASET_FILE_MAGIC, sizeof(header.magic));
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (size_t i = 0; i < inputs->num_rows && success; ++i) {
+        success = fwrite(&LAMP_VIEW_ELEMENT_AT(inputs, i, 0), sizeof(LAMP_FLOAT_TYPE), inputs->num_cols, file) ==
+                  inputs->num_cols &&
+                  fwrite(&LAMP_VIEW_ELEMENT_AT(targets, i, 0), sizeof(LAMP_FLOAT_TYPE), targets->num_cols, file) ==
+                  targets->num_cols;
+    }
+
+    return fclose(file) == 0 && success;
+}
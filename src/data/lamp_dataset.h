@@ -0,0 +1,82 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_DATASET_H
+#define LAMP_LAMP_DATASET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../linear_algebra/lamp_matrix.h"
+
+// A dataset, that is streamed from a file in mini-batches instead of being loaded into memory at once.
+// Every sample consists of num_inputs input values followed by num_targets target values.
+// While the caller works on one batch, a background thread already reads the next one into a second
+// buffer, so reading the file overlaps with the computation.
+//
+// Usage:
+//     LampDataset *dataset = lamp_dataset_open("train.csv", LAMP_DATASET_CSV, 784, 10, 64);
+//     for (int epoch = 0; epoch < epochs; ++epoch) {
+//         LampMatrixView inputs, targets;
+//         while (lamp_dataset_next(dataset, &inputs, &targets)) {
+//             lamp_nn_backprop_view(nn, &inputs, &targets);
+//             lamp_nn_apply_gradients(nn, learning_rate);
+//         }
+//         lamp_dataset_rewind(dataset);
+//     }
+//     lamp_dataset_close(dataset);
+typedef struct LampDataset LampDataset;
+
+typedef enum {
+    // Written by lamp_dataset_save(): a 64 byte header followed by the samples as raw LAMP_FLOAT_TYPE values
+    LAMP_DATASET_BINARY,
+    // One sample per line with comma separated values. Empty lines and lines starting with # are skipped.
+    LAMP_DATASET_CSV
+} LampDatasetFormat;
+
+// Version of the binary dataset format written by lamp_dataset_save()
+#define LAMP_DATASET_FILE_VERSION 1
+
+// Open a dataset and start reading the first batch. Batches contain batch_size samples, except for the
+// last one of an epoch, which contains the remaining samples.
+// Returns NULL if the file can not be opened or - for binary files - does not match num_inputs and num_targets.
+LampDataset *lamp_dataset_open(const char *path, LampDatasetFormat format, size_t num_inputs, size_t num_targets,
+                               size_t batch_size);
+
+void lamp_dataset_close(LampDataset *dataset);
+
+// Hand out the next batch as views of [samples, num_inputs] and [samples, num_targets], which stay valid
+// until the next call. Returns false at the end of the epoch (or if the file is malformed, see
+// lamp_dataset_failed()).
+bool lamp_dataset_next(LampDataset *dataset, LampMatrixView *inputs, LampMatrixView *targets);
+
+// Start the next epoch from the first sample
+void lamp_dataset_rewind(LampDataset *dataset);
+
+// True if the current epoch ended early, because the file could not be read or parsed
+bool lamp_dataset_failed(LampDataset *dataset);
+
+// Write the samples stored in the rows of inputs and targets as a binary dataset.
+// Returns false if the file could not be written.
+bool lamp_dataset_save(const char *path, const LampMatrixView *inputs, const LampMatrixView *targets);
+
+#endif //LAMP_LAMP_DATASET_H
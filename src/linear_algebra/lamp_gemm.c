@@ -0,0 +1,384 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lamp_gemm.h"
+#include "lamp_simd.h"
+#include "../threading/lamp_threadpool.h"
+
+// The kernel follows the well known blocking scheme of GotoBLAS/BLIS:
+// B is split into [KC, NC] blocks and A into [MC, KC] blocks. Both blocks are copied ("packed") into
+// contiguous buffers, arranged in the exact order the micro kernel reads them. The micro kernel then
+// computes a [MR, NR] tile of C in vector registers, touching C only once per KC block. The tile kernel and
+// its size are selected with the other SIMD kernels, so MR and NR are runtime values.
+
+#define LAMP_GEMM_ALIGNMENT 64
+
+// Every thread gets its own packing buffers, which are reused for all multiplications.
+// They are registered with a thread specific key, so they are released once the thread exits.
+typedef struct {
+    LAMP_FLOAT_TYPE *a;
+    LAMP_FLOAT_TYPE *b;
+} PackingBuffers;
+
+static _Thread_local PackingBuffers *packing_buffers = NULL;
+static pthread_key_t packing_buffers_key;
+static pthread_once_t packing_buffers_key_once = PTHREAD_ONCE_INIT;
+
+static LAMP_FLOAT_TYPE *alloc_packing_buffer(size_t num_elements) {
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t size = num_elements * sizeof(LAMP_FLOAT_TYPE);
+    size = (size + LAMP_GEMM_ALIGNMENT - 1) / LAMP_GEMM_ALIGNMENT * LAMP_GEMM_ALIGNMENT;
+    LAMP_FLOAT_TYPE *buffer = aligned_alloc(LAMP_GEMM_ALIGNMENT, size);
+    assert(buffer != NULL);
+    return buffer;
+}
+
+static void free_packing_buffers(void *buffers) {
+    PackingBuffers *pb = buffers;
+    free(pb->a);
+    free(pb->b);
+    free(pb);
+}
+
+static void create_packing_buffers_key(void) {
+    pthread_key_create(&packing_buffers_key, free_packing_buffers);
+}
+
+static PackingBuffers *get_packing_buffers(void) {
+    if (packing_buffers == NULL) {
+        pthread_once(&packing_buffers_key_once, create_packing_buffers_key);
+        packing_buffers = malloc(sizeof(PackingBuffers));
+        assert(packing_buffers != NULL);
+        // The last panel of a block is padded to a full tile
+        packing_buffers->a = alloc_packing_buffer((LAMP_GEMM_MC + LAMP_GEMM_MAX_MR) * LAMP_GEMM_KC);
+        packing_buffers->b = alloc_packing_buffer(LAMP_GEMM_KC * (LAMP_GEMM_NC + LAMP_GEMM_MAX_NR));
+        pthread_setspecific(packing_buffers_key, packing_buffers);
+    }
+    return packing_buffers;
+}
+
+// An operand of the multiplication. X is stored row-major with the leading dimension ld in the given precision,
+// the multiplication uses op(X). Reduced precision elements are converted while they are packed.
+typedef struct {
+    const void *elements;
+    LampPrecision precision;
+    size_t ld;
+    bool trans;
+} GemmOperand;
+
+static size_t operand_index(const GemmOperand *x, size_t row, size_t col) {
+    return x->trans ? col * x->ld + row : row * x->ld + col;
+}
+
+// The part of op(X) starting at [row, col]
+static GemmOperand operand_block(const GemmOperand *x, size_t row, size_t col) {
+    size_t element_size = x->precision == LAMP_PRECISION_FP32 ? sizeof(LAMP_FLOAT_TYPE) : sizeof(LampHalf);
+    GemmOperand block = *x;
+    block.elements = (const unsigned char *) x->elements + operand_index(x, row, col) * element_size;
+    return block;
+}
+
+// Element [row, col] of op(X)
+static inline LAMP_FLOAT_TYPE operand_element(const GemmOperand *x, size_t row, size_t col) {
+    size_t index = operand_index(x, row, col);
+    switch (x->precision) {
+        case LAMP_PRECISION_FP16:
+            return lamp_float_from_fp16(((const LampHalf *) x->elements)[index]);
+        case LAMP_PRECISION_BF16:
+            return lamp_float_from_bf16(((const LampHalf *) x->elements)[index]);
+        default:
+            return ((const LAMP_FLOAT_TYPE *) x->elements)[index];
+    }
+}
+
+// Copy count elements of op(X) starting at [row, col] into dst, either along the row or along the column.
+// Runs that are contiguous in memory are copied (or widened with the vector kernels) at once.
+static void load_run(LAMP_FLOAT_TYPE *dst, const GemmOperand *x, size_t row, size_t col, size_t count,
+                     bool along_row) {
+    size_t index = operand_index(x, row, col);
+    bool contiguous = along_row != x->trans;
+
+    if (x->precision == LAMP_PRECISION_FP32) {
+        const LAMP_FLOAT_TYPE *src = &((const LAMP_FLOAT_TYPE *) x->elements)[index];
+        if (contiguous) {
+            memcpy(dst, src, count * sizeof(LAMP_FLOAT_TYPE));
+        } else {
+            for (size_t t = 0; t < count; ++t) {
+                dst[t] = src[t * x->ld];
+            }
+        }
+    } else if (contiguous) {
+        const LampHalf *src = &((const LampHalf *) x->elements)[index];
+        if (x->precision == LAMP_PRECISION_FP16) {
+            lamp_simd_kernels()->float_from_fp16(dst, src, count);
+        } else {
+            lamp_simd_kernels()->float_from_bf16(dst, src, count);
+        }
+    } else {
+        for (size_t t = 0; t < count; ++t) {
+            dst[t] = along_row ? operand_element(x, row, col + t) : operand_element(x, row + t, col);
+        }
+    }
+}
+
+// Pack a [mc, kc] block of op(A) into panels of tile_mr rows. Each panel stores the tile_mr values of one
+// column next to each other, rows beyond mc are padded with zeros.
+static void pack_a(size_t mc, size_t kc, const GemmOperand *a, size_t tile_mr, LAMP_FLOAT_TYPE *dst) {
+    for (size_t ir = 0; ir < mc; ir += tile_mr) {
+        size_t mr = (mc - ir) < tile_mr ? (mc - ir) : tile_mr;
+        for (size_t p = 0; p < kc; ++p) {
+            load_run(dst, a, ir, p, mr, false);
+            for (size_t i = mr; i < tile_mr; ++i) {
+                dst[i] = 0.0f;
+            }
+            dst += tile_mr;
+        }
+    }
+}
+
+// Pack a [kc, nc] block of op(B) into panels of tile_nr columns. Each panel stores the tile_nr values of one
+// row next to each other, columns beyond nc are padded with zeros.
+static void pack_b(size_t kc, size_t nc, const GemmOperand *b, size_t tile_nr, LAMP_FLOAT_TYPE *dst) {
+    for (size_t jr = 0; jr < nc; jr += tile_nr) {
+        size_t nr = (nc - jr) < tile_nr ? (nc - jr) : tile_nr;
+        for (size_t p = 0; p < kc; ++p) {
+            load_run(dst, b, p, jr, nr, true);
+            for (size_t j = nr; j < tile_nr; ++j) {
+                dst[j] = 0.0f;
+            }
+            dst += tile_nr;
+        }
+    }
+}
+
+// Compute a tile of C from a packed panel of A and B with the tile kernel. Only the [mr, nr] part of the tile
+// is written back, the remaining values belong to the zero padding of the panels.
+// If accumulate is false, the previous content of C is overwritten. The epilogue is only passed in for
+// the last block along k, row_bias then points to the bias of the first row of the tile.
+static void micro_kernel(const LampSimdKernels *kernels, size_t kc, const LAMP_FLOAT_TYPE *a,
+                         const LAMP_FLOAT_TYPE *b, LAMP_FLOAT_TYPE *c, size_t ldc, size_t mr, size_t nr,
+                         bool accumulate, const LAMP_FLOAT_TYPE *row_bias, const LampGemmEpilogue *epilogue) {
+    if (mr == kernels->gemm_mr && nr == kernels->gemm_nr) {
+        kernels->gemm_tile(kc, a, b, c, ldc, accumulate, row_bias);
+    } else {
+        // A tile at the edge of C is computed on the stack, the kernel always writes a full tile
+        _Alignas(LAMP_GEMM_ALIGNMENT) LAMP_FLOAT_TYPE tile[LAMP_GEMM_MAX_MR * LAMP_GEMM_MAX_NR];
+        kernels->gemm_tile(kc, a, b, tile, kernels->gemm_nr, false, NULL);
+        for (size_t i = 0; i < mr; ++i) {
+            LAMP_FLOAT_TYPE *c_row = &c[i * ldc];
+            const LAMP_FLOAT_TYPE *tile_row = &tile[i * kernels->gemm_nr];
+            LAMP_FLOAT_TYPE bias = row_bias != NULL ? row_bias[i] : 0.0f;
+            for (size_t j = 0; j < nr; ++j) {
+                c_row[j] = (accumulate ? c_row[j] : 0.0f) + tile_row[j] + bias;
+            }
+        }
+    }
+
+    if (epilogue != NULL && epilogue->activation != NULL) {
+        for (size_t i = 0; i < mr; ++i) {
+            epilogue->activation(&c[i * ldc], nr);
+        }
+    }
+}
+
+static void macro_kernel(const LampSimdKernels *kernels, size_t mc, size_t nc, size_t kc,
+                         const LAMP_FLOAT_TYPE *pa, const LAMP_FLOAT_TYPE *pb, LAMP_FLOAT_TYPE *c, size_t ldc,
+                         bool accumulate, const LAMP_FLOAT_TYPE *row_bias, const LampGemmEpilogue *epilogue) {
+    size_t tile_mr = kernels->gemm_mr;
+    size_t tile_nr = kernels->gemm_nr;
+    for (size_t jr = 0; jr < nc; jr += tile_nr) {
+        size_t nr = (nc - jr) < tile_nr ? (nc - jr) : tile_nr;
+        for (size_t ir = 0; ir < mc; ir += tile_mr) {
+            size_t mr = (mc - ir) < tile_mr ? (mc - ir) : tile_mr;
+            micro_kernel(kernels, kc, &pa[ir * kc], &pb[jr * kc], &c[ir * ldc + jr], ldc, mr, nr, accumulate,
+                         row_bias != NULL ? &row_bias[ir] : NULL, epilogue);
+        }
+    }
+}
+
+// For small shapes we use the i-k-j loop order. The inner loop walks along a row of B and C,
+// so at least the memory is accessed sequentially (unless B is transposed).
+static void gemm_small(size_t m, size_t n, size_t k, const GemmOperand *a, const GemmOperand *b,
+                       LAMP_FLOAT_TYPE *c, size_t ldc, bool accumulate, const LampGemmEpilogue *epilogue) {
+    const LAMP_FLOAT_TYPE *b_elements = b->elements;
+    bool b_full_precision = b->precision == LAMP_PRECISION_FP32;
+
+    for (size_t i = 0; i < m; ++i) {
+        LAMP_FLOAT_TYPE *c_row = &c[i * ldc];
+        if (!accumulate) {
+            memset(c_row, 0, n * sizeof(LAMP_FLOAT_TYPE));
+        }
+        for (size_t p = 0; p < k; ++p) {
+            LAMP_FLOAT_TYPE a_val = operand_element(a, i, p);
+            if (!b_full_precision) {
+                for (size_t j = 0; j < n; ++j) {
+                    c_row[j] += a_val * operand_element(b, p, j);
+                }
+            } else if (b->trans) {
+                for (size_t j = 0; j < n; ++j) {
+                    c_row[j] += a_val * b_elements[j * b->ld + p];
+                }
+            } else {
+                const LAMP_FLOAT_TYPE *b_row = &b_elements[p * b->ld];
+                for (size_t j = 0; j < n; ++j) {
+                    c_row[j] += a_val * b_row[j];
+                }
+            }
+        }
+
+        // The row was just written, so it is still in the cache
+        if (epilogue != NULL) {
+            if (epilogue->row_bias != NULL) {
+                for (size_t j = 0; j < n; ++j) {
+                    c_row[j] += epilogue->row_bias[i];
+                }
+            }
+            if (epilogue->activation != NULL) {
+                epilogue->activation(c_row, n);
+            }
+        }
+    }
+}
+
+static void gemm_serial(size_t m, size_t n, size_t k, const GemmOperand *a, const GemmOperand *b,
+                        LAMP_FLOAT_TYPE *c, size_t ldc, bool accumulate, const LampGemmEpilogue *epilogue) {
+    const LampSimdKernels *kernels = lamp_simd_kernels();
+    if (m * n * k <= LAMP_GEMM_SMALL_THRESHOLD) {
+        gemm_small(m, n, k, a, b, c, ldc, accumulate, epilogue);
+        return;
+    }
+
+    PackingBuffers *buffers = get_packing_buffers();
+
+    for (size_t jc = 0; jc < n; jc += LAMP_GEMM_NC) {
+        size_t nc = (n - jc) < LAMP_GEMM_NC ? (n - jc) : LAMP_GEMM_NC;
+        for (size_t pc = 0; pc < k; pc += LAMP_GEMM_KC) {
+            size_t kc = (k - pc) < LAMP_GEMM_KC ? (k - pc) : LAMP_GEMM_KC;
+            GemmOperand b_block = operand_block(b, pc, jc);
+            pack_b(kc, nc, &b_block, kernels->gemm_nr, buffers->b);
+
+            for (size_t ic = 0; ic < m; ic += LAMP_GEMM_MC) {
+                size_t mc = (m - ic) < LAMP_GEMM_MC ? (m - ic) : LAMP_GEMM_MC;
+                GemmOperand a_block = operand_block(a, ic, pc);
+                pack_a(mc, kc, &a_block, kernels->gemm_mr, buffers->a);
+                // The first block along k initializes C, all following ones add their contribution.
+                // Once the last block is added, the tiles of C are final and the epilogue can be applied.
+                bool last_block = pc + kc == k;
+                const LampGemmEpilogue *tile_epilogue = last_block ? epilogue : NULL;
+                const LAMP_FLOAT_TYPE *row_bias = (last_block && epilogue != NULL && epilogue->row_bias != NULL) ?
+                                                  &epilogue->row_bias[ic] : NULL;
+                macro_kernel(kernels, mc, nc, kc, buffers->a, buffers->b, &c[ic * ldc + jc], ldc,
+                             accumulate || pc != 0, row_bias, tile_epilogue);
+            }
+        }
+    }
+}
+
+// For multithreading C is split into blocks of whole rows or columns. Every task multiplies its block
+// independently, including the packing of its own operands.
+typedef struct {
+    size_t m;
+    size_t n;
+    size_t k;
+    GemmOperand a;
+    GemmOperand b;
+    LAMP_FLOAT_TYPE *c;
+    size_t ldc;
+    bool accumulate;
+    const LampGemmEpilogue *epilogue;
+    bool split_rows;
+    size_t block_size;
+} GemmJob;
+
+static void gemm_task(void *context, size_t task_index) {
+    const GemmJob *job = context;
+    size_t first = task_index * job->block_size;
+
+    if (job->split_rows) {
+        size_t rows = (job->m - first) < job->block_size ? (job->m - first) : job->block_size;
+        GemmOperand a = operand_block(&job->a, first, 0);
+
+        // The bias belongs to the rows of C, so the block needs its own part of it
+        LampGemmEpilogue block_epilogue;
+        const LampGemmEpilogue *epilogue = job->epilogue;
+        if (epilogue != NULL && epilogue->row_bias != NULL) {
+            block_epilogue = *epilogue;
+            block_epilogue.row_bias = &epilogue->row_bias[first];
+            epilogue = &block_epilogue;
+        }
+
+        gemm_serial(rows, job->n, job->k, &a, &job->b, &job->c[first * job->ldc], job->ldc, job->accumulate,
+                    epilogue);
+    } else {
+        size_t cols = (job->n - first) < job->block_size ? (job->n - first) : job->block_size;
+        GemmOperand b = operand_block(&job->b, 0, first);
+        gemm_serial(job->m, cols, job->k, &job->a, &b, &job->c[first], job->ldc, job->accumulate, job->epilogue);
+    }
+}
+
+static size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+void lamp_gemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+               const LAMP_FLOAT_TYPE *a, size_t lda,
+               const LAMP_FLOAT_TYPE *b, size_t ldb,
+               LAMP_FLOAT_TYPE *c, size_t ldc, bool accumulate, const LampGemmEpilogue *epilogue) {
+    lamp_gemm_mixed(trans_a, trans_b, m, n, k, a, LAMP_PRECISION_FP32, lda, b, LAMP_PRECISION_FP32, ldb,
+                    c, ldc, accumulate, epilogue);
+}
+
+void lamp_gemm_mixed(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                     const void *a, LampPrecision a_precision, size_t lda,
+                     const void *b, LampPrecision b_precision, size_t ldb,
+                     LAMP_FLOAT_TYPE *c, size_t ldc, bool accumulate, const LampGemmEpilogue *epilogue) {
+    assert(a != NULL && b != NULL && c != NULL);
+    assert(lda >= (trans_a ? m : k) && ldb >= (trans_b ? k : n) && ldc >= n);
+
+    GemmOperand op_a = {.elements = a, .precision = a_precision, .ld = lda, .trans = trans_a};
+    GemmOperand op_b = {.elements = b, .precision = b_precision, .ld = ldb, .trans = trans_b};
+
+    LampThreadPool *pool = lamp_threadpool_for_work(m * n * k);
+    if (pool == NULL) {
+        gemm_serial(m, n, k, &op_a, &op_b, c, ldc, accumulate, epilogue);
+        return;
+    }
+
+    // Split the longer dimension of C into blocks that are a multiple of the register tile.
+    // A few more blocks than threads help to balance the load.
+    size_t num_blocks = lamp_threadpool_num_threads(pool) * 2;
+    GemmJob job = {
+            .m = m, .n = n, .k = k, .a = op_a, .b = op_b, .c = c, .ldc = ldc,
+            .accumulate = accumulate, .epilogue = epilogue, .split_rows = m >= n
+    };
+    size_t length = job.split_rows ? m : n;
+    const LampSimdKernels *kernels = lamp_simd_kernels();
+    job.block_size = round_up((length + num_blocks - 1) / num_blocks,
+                              job.split_rows ? kernels->gemm_mr : kernels->gemm_nr);
+
+    lamp_threadpool_parallel_for(pool, (length + job.block_size - 1) / job.block_size, gemm_task, &job);
+}
@@ -0,0 +1,78 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_GEMM_H
+#define LAMP_LAMP_GEMM_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "lamp_matrix.h"
+#include "lamp_half.h"
+
+// Internal general matrix multiplication kernel working on raw row-major memory.
+// The leading dimensions (lda, ldb, ldc) are the distance between the beginning of two rows,
+// which allows to operate on parts of bigger matrices.
+//
+// Calculates C = op(A) * op(B) with op(A) of size [m, k], op(B) of size [k, n] and C of size [m, n].
+// op(X) is either X itself or - if the corresponding trans flag is set - its transpose. A transposed
+// operand is never materialized, the packing routines simply read it column by column.
+// If accumulate is set the product is added to C instead of overwriting it.
+//
+// An optional epilogue is applied to every finished tile of C, while it is still in the registers and L1 cache:
+// first the row bias is added to every element of row i of C, then the activation is applied in place.
+// Either part may be NULL. Passing NULL for the epilogue itself skips it completely.
+
+// Work on small matrices is not worth packing, below this amount of multiply-adds a simple loop is used
+#define LAMP_GEMM_SMALL_THRESHOLD (32 * 32 * 32)
+
+// The size of the register tile [MR, NR] depends on the vector registers and is taken from the gemm_tile kernel
+// of lamp_simd_kernels(). These are the largest tiles of all kernels.
+#define LAMP_GEMM_MAX_MR 14
+#define LAMP_GEMM_MAX_NR 32
+
+// Cache blocking sizes. A packed [MC, KC] block of A should stay in the L2 cache,
+// a packed [KC, NR] panel of B in the L1 cache, while the [KC, NC] block of B lives in L3.
+// MC is a multiple of all tile heights, so every panel of A but the last one of a matrix is full.
+#define LAMP_GEMM_MC 168
+#define LAMP_GEMM_KC 256
+#define LAMP_GEMM_NC 2048
+
+typedef struct {
+    const LAMP_FLOAT_TYPE *row_bias;
+
+    void (*activation)(LAMP_FLOAT_TYPE *values, size_t n);
+} LampGemmEpilogue;
+
+void lamp_gemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+               const LAMP_FLOAT_TYPE *a, size_t lda,
+               const LAMP_FLOAT_TYPE *b, size_t ldb,
+               LAMP_FLOAT_TYPE *c, size_t ldc, bool accumulate, const LampGemmEpilogue *epilogue);
+
+// Same as lamp_gemm, but A and B may be stored in reduced precision (as LampHalf elements). They are widened
+// while they are packed, so the micro kernel and the accumulation in C always use LAMP_FLOAT_TYPE.
+void lamp_gemm_mixed(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                     const void *a, LampPrecision a_precision, size_t lda,
+                     const void *b, LampPrecision b_precision, size_t ldb,
+                     LAMP_FLOAT_TYPE *c, size_t ldc, bool accumulate, const LampGemmEpilogue *epilogue);
+
+#endif //LAMP_LAMP_GEMM_H
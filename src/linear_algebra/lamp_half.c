@@ -0,0 +1,82 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <stdlib.h>
+#include "lamp_half.h"
+#include "lamp_gemm.h"
+#include "lamp_simd.h"
+
+LampHalfMatrix *lamp_half_mat_alloc(size_t rows, size_t cols, LampPrecision precision) {
+    assert(rows >= 1 && cols >= 1);
+    assert(precision == LAMP_PRECISION_FP16 || precision == LAMP_PRECISION_BF16);
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampHalfMatrix *mat = malloc(sizeof(LampHalfMatrix));
+    assert(mat != NULL);
+    mat->num_rows = rows;
+    mat->num_cols = cols;
+    mat->precision = precision;
+    mat->elements = malloc(sizeof(LampHalf) * rows * cols);
+    assert(mat->elements != NULL);
+
+    return mat;
+}
+
+void lamp_half_mat_free(LampHalfMatrix *mat) {
+    assert(mat != NULL);
+    free(mat->elements);
+    free(mat);
+}
+
+void lamp_half_mat_from_float(LampHalfMatrix *dst, const LampMatrix *src) {
+    assert(dst->num_rows == src->num_rows && dst->num_cols == src->num_cols);
+
+    size_t n = LAMP_MAT_NUM_ELEMENTS(src);
+    if (dst->precision == LAMP_PRECISION_FP16) {
+        lamp_simd_kernels()->fp16_from_float(dst->elements, src->elements, n);
+    } else {
+        lamp_simd_kernels()->bf16_from_float(dst->elements, src->elements, n);
+    }
+}
+
+void lamp_half_mat_to_float(LampMatrix *dst, const LampHalfMatrix *src) {
+    assert(dst->num_rows == src->num_rows && dst->num_cols == src->num_cols);
+
+    size_t n = LAMP_MAT_NUM_ELEMENTS(dst);
+    if (src->precision == LAMP_PRECISION_FP16) {
+        lamp_simd_kernels()->float_from_fp16(dst->elements, src->elements, n);
+    } else {
+        lamp_simd_kernels()->float_from_bf16(dst->elements, src->elements, n);
+    }
+}
+
+void lamp_half_mat_multiply_into(LampMatrix *dst, const LampHalfMatrix *m1, const LampHalfMatrix *m2) {
+    assert(m1->num_cols == m2->num_rows);
+    assert((dst->num_rows == m1->num_rows) && (dst->num_cols == m2->num_cols));
+
+    lamp_gemm_mixed(false, false, dst->num_rows, dst->num_cols, m1->num_cols,
+                    m1->elements, m1->precision, m1->num_cols,
+                    m2->elements, m2->precision, m2->num_cols,
+                    dst->elements, dst->num_cols, false, NULL);
+}
@@ -0,0 +1,160 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_HALF_H
+#define LAMP_LAMP_HALF_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "lamp_matrix.h"
+
+// Reduced precision storage. Values are stored in 16 bits, which halves the memory and bandwidth
+// needed for weights and activations, but all arithmetic still happens in LAMP_FLOAT_TYPE:
+// the operands are widened while they are loaded (e.g. while packing for a matrix multiplication).
+//
+// fp16 (IEEE 754 binary16): 5 exponent and 10 mantissa bits. Precise to about 3 decimal digits,
+//                           but limited to magnitudes below 65504.
+// bf16 (bfloat16):          the upper half of a float. Same range as a float with 8 mantissa bits,
+//                           so it is less precise but can not overflow.
+typedef enum {
+    LAMP_PRECISION_FP32 = 0,
+    LAMP_PRECISION_FP16,
+    LAMP_PRECISION_BF16
+} LampPrecision;
+
+typedef uint16_t LampHalf;
+
+// Relative rounding error of a conversion to the given precision (half of the distance between 1 and the
+// next representable value), e.g. to bound the error of calculations with reduced precision.
+#define LAMP_FP16_UNIT_ROUNDOFF (1.0f / 2048.0f)
+#define LAMP_BF16_UNIT_ROUNDOFF (1.0f / 256.0f)
+
+// The scalar conversions round to the nearest value (ties to even) and quiet NaNs like the hardware
+// conversions do, so they produce exactly the same bits as the vectorized kernels in lamp_simd.h.
+
+static inline LampHalf lamp_fp16_from_float(float value) {
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t abs = x & 0x7fffffffu;
+
+    if (abs > 0x7f800000u) { // NaN
+        return (LampHalf) (sign | 0x7e00u | ((abs >> 13) & 0x3ffu));
+    }
+    if (abs >= 0x477ff000u) { // Rounds to a magnitude above 65504 (or is infinite)
+        return (LampHalf) (sign | 0x7c00u);
+    }
+    if (abs < 0x38800000u) { // Below 2^-14, the result is subnormal
+        if (abs <= 0x33000000u) { // At most 2^-25, which rounds to zero
+            return (LampHalf) sign;
+        }
+        uint32_t exponent = abs >> 23;
+        uint32_t mantissa = (abs & 0x7fffffu) | 0x800000u;
+        uint32_t shift = 126 - exponent;
+        uint32_t result = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (result & 1u))) {
+            result++;
+        }
+        return (LampHalf) (sign | result);
+    }
+
+    // Rebias the exponent from 127 to 15. A carry of the rounding correctly moves into the exponent.
+    uint32_t result = (abs - 0x38000000u) >> 13;
+    uint32_t remainder = abs & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (result & 1u))) {
+        result++;
+    }
+    return (LampHalf) (sign | result);
+}
+
+static inline float lamp_float_from_fp16(LampHalf value) {
+    uint32_t sign = (uint32_t) (value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+    uint32_t x;
+
+    if (exponent == 0x1fu) {
+        x = sign | 0x7f800000u | (mantissa != 0 ? 0x400000u : 0) | (mantissa << 13);
+    } else if (exponent != 0) {
+        x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        x = sign;
+    } else {
+        // Subnormal fp16 values are normal floats, so the mantissa is shifted until its leading bit is found
+        exponent = 113;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        x = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+
+    float result;
+    memcpy(&result, &x, sizeof(result));
+    return result;
+}
+
+static inline LampHalf lamp_bf16_from_float(float value) {
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+    if ((x & 0x7fffffffu) > 0x7f800000u) {
+        return (LampHalf) ((x >> 16) | 0x40u);
+    }
+    x += 0x7fffu + ((x >> 16) & 1u);
+    return (LampHalf) (x >> 16);
+}
+
+static inline float lamp_float_from_bf16(LampHalf value) {
+    uint32_t x = (uint32_t) value << 16;
+    float result;
+    memcpy(&result, &x, sizeof(result));
+    return result;
+}
+
+// A matrix stored in reduced precision (fp16 or bf16), laid out like a LampMatrix
+typedef struct {
+    size_t num_rows;
+    size_t num_cols;
+    LampPrecision precision;
+    LampHalf *elements;
+} LampHalfMatrix;
+
+LampHalfMatrix *lamp_half_mat_alloc(size_t rows, size_t cols, LampPrecision precision);
+
+void lamp_half_mat_free(LampHalfMatrix *mat);
+
+// Round every element of src to the precision of dst
+// ATTENTION: Users must assure the dst and src matrices have the same dimensions
+void lamp_half_mat_from_float(LampHalfMatrix *dst, const LampMatrix *src);
+
+// Widen every element of src, which is exact
+void lamp_half_mat_to_float(LampMatrix *dst, const LampHalfMatrix *src);
+
+// dst = m1 * m2, where the operands are widened while they are packed and the products are accumulated
+// in LAMP_FLOAT_TYPE. The operands may use different precisions.
+void lamp_half_mat_multiply_into(LampMatrix *dst, const LampHalfMatrix *m1, const LampHalfMatrix *m2);
+
+#endif //LAMP_LAMP_HALF_H
@@ -27,6 +27,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include "lamp_matrix.h"
+#include "lamp_gemm.h"
+#include "lamp_simd.h"
+#include "../threading/lamp_threadpool.h"
 
 // Get a pseudo random floating point value between 0.0 and 1.0 inclusive
 static LAMP_FLOAT_TYPE rand_f_normalized(void) {
@@ -34,6 +37,64 @@ static LAMP_FLOAT_TYPE rand_f_normalized(void) {
            (LAMP_FLOAT_TYPE) RAND_MAX;
 }
 
+// Element-wise operations on big matrices are split into chunks, which are processed by the default
+// thread pool. Chunks are a multiple of a cache line, so threads never write to the same line.
+#define ELEMENTWISE_CHUNK_ALIGNMENT (64 / sizeof(LAMP_FLOAT_TYPE))
+
+typedef enum {
+    ELEMENTWISE_FILL,
+    ELEMENTWISE_ADD,
+    ELEMENTWISE_SIGMOID
+} ElementwiseOp;
+
+typedef struct {
+    ElementwiseOp op;
+    LAMP_FLOAT_TYPE *dst;
+    const LAMP_FLOAT_TYPE *src;
+    LAMP_FLOAT_TYPE value;
+    size_t num_elements;
+    size_t chunk_size;
+} ElementwiseJob;
+
+static void elementwise_run(const ElementwiseJob *job, size_t first, size_t count) {
+    const LampSimdKernels *kernels = lamp_simd_kernels();
+    switch (job->op) {
+        case ELEMENTWISE_FILL:
+            kernels->fill(&job->dst[first], job->value, count);
+            break;
+        case ELEMENTWISE_ADD:
+            kernels->add(&job->dst[first], &job->src[first], count);
+            break;
+        case ELEMENTWISE_SIGMOID:
+            kernels->sigmoid(&job->dst[first], count);
+            break;
+    }
+}
+
+static void elementwise_task(void *context, size_t task_index) {
+    const ElementwiseJob *job = context;
+    size_t first = task_index * job->chunk_size;
+    size_t remaining = job->num_elements - first;
+    elementwise_run(job, first, remaining < job->chunk_size ? remaining : job->chunk_size);
+}
+
+static void elementwise(ElementwiseOp op, LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *src, LAMP_FLOAT_TYPE value,
+                        size_t num_elements) {
+    ElementwiseJob job = {.op = op, .dst = dst, .src = src, .value = value, .num_elements = num_elements};
+
+    LampThreadPool *pool = lamp_threadpool_for_work(num_elements);
+    if (pool == NULL) {
+        elementwise_run(&job, 0, num_elements);
+        return;
+    }
+
+    size_t num_threads = lamp_threadpool_num_threads(pool);
+    job.chunk_size = (num_elements + num_threads - 1) / num_threads;
+    job.chunk_size = (job.chunk_size + ELEMENTWISE_CHUNK_ALIGNMENT - 1) / ELEMENTWISE_CHUNK_ALIGNMENT *
+                     ELEMENTWISE_CHUNK_ALIGNMENT;
+    lamp_threadpool_parallel_for(pool, (num_elements + job.chunk_size - 1) / job.chunk_size, elementwise_task, &job);
+}
+
 LampMatrix *lamp_mat_alloc(size_t rows, size_t cols) {
     assert(rows >= 1 && cols >= 1);
 
@@ -56,10 +117,7 @@ void lamp_mat_free(LampMatrix *mat) {
 
 void lamp_mat_fill_with(LampMatrix *mat, LAMP_FLOAT_TYPE filler) {
     assert(mat != NULL);
-
-    for (size_t i = 0; i < LAMP_MAT_NUM_ELEMENTS(mat); ++i) {
-        mat->elements[i] = filler;
-    }
+    elementwise(ELEMENTWISE_FILL, mat->elements, NULL, filler, LAMP_MAT_NUM_ELEMENTS(mat));
 }
 
 void lamp_mat_rand(LampMatrix *mat) {
@@ -68,31 +126,32 @@ void lamp_mat_rand(LampMatrix *mat) {
     }
 }
 
+void lamp_mat_identity_into(LampMatrix *mat) {
+    assert(mat != NULL);
+    assert(mat->num_rows == mat->num_cols);
+    lamp_mat_fill_with(mat, 0.0f);
+    for (size_t i = 0; i < mat->num_rows; ++i) {
+        LAMP_MAT_ELEMENT_AT(mat, i, i) = 1.0f;
+    }
+}
+
 LampMatrix *lamp_mat_alloc_identity(size_t size) {
     assert(size >= 1);
     LampMatrix *mi = lamp_mat_alloc(size, size);
-    for (size_t i = 0; i < LAMP_MAT_NUM_ELEMENTS(mi); ++i) {
-        size_t row = i / mi->num_rows;
-        size_t col = i % mi->num_rows;
-
-        if (row == col) {
-            mi->elements[i] = 1.0f;
-        } else {
-            mi->elements[i] = 0.0f;
-        }
-    }
-
+    lamp_mat_identity_into(mi);
     return mi;
 }
 
+void lamp_mat_from_array_into(LampMatrix *mat, const LAMP_FLOAT_TYPE *content) {
+    assert(mat != NULL && content != NULL);
+    // The array is stored row by row just like the matrix
+    memcpy(mat->elements, content, LAMP_MAT_NUM_ELEMENTS(mat) * sizeof(LAMP_FLOAT_TYPE));
+}
+
 // Allocate matrix of specified size with content of a flattened 1D array
 LampMatrix *lamp_mat_alloc_from_array(size_t rows, size_t cols, const LAMP_FLOAT_TYPE *content) {
     LampMatrix *mat = lamp_mat_alloc(rows, cols);
-    for (size_t i = 0; i < mat->num_rows; ++i) {
-        for (size_t j = 0; j < mat->num_cols; ++j) {
-            LAMP_MAT_ELEMENT_AT(mat, i, j) = content[i * mat->num_cols + j];
-        }
-    }
+    lamp_mat_from_array_into(mat, content);
     return mat;
 }
 
@@ -111,15 +170,7 @@ bool lamp_matrix_equal(const LampMatrix *m1, const LampMatrix *m2) {
     // For comparing the elements we unfortunately have to deal with floating point shenanigans,
     // so we assume a "reasonable" tolerable difference of the values.
     const LAMP_FLOAT_TYPE tolerance = 0.000001f;
-    for (size_t i = 0; i < m1->num_rows; ++i) {
-        for (size_t j = 0; j < m1->num_cols; ++j) {
-            if (LAMP_FABS(LAMP_MAT_ELEMENT_AT(m1, i, j) - LAMP_MAT_ELEMENT_AT(m2, i, j)) > tolerance) {
-                return false;
-            }
-        }
-    }
-
-    return true;
+    return lamp_simd_kernels()->all_close(m1->elements, m2->elements, LAMP_MAT_NUM_ELEMENTS(m1), tolerance);
 }
 
 void lamp_mat_copy_into(LampMatrix *dst, const LampMatrix *src) {
@@ -137,22 +188,23 @@ LampMatrix *lamp_mat_alloc_copy(const LampMatrix *m_to_copy) {
 }
 
 void lamp_mat_multiply_into(LampMatrix *dst, const LampMatrix *m1, const LampMatrix *m2) {
-    assert(m1->num_cols == m2->num_rows);
-    assert((dst->num_rows == m1->num_rows) && (dst->num_cols == m2->num_cols));
-
-    lamp_mat_fill_with(dst, 0.0f);
+    lamp_mat_multiply_trans_into(dst, m1, false, m2, false);
+}
 
-    // It is probably also not very efficient and the easiest to read, but at least for me, it is clear
-    // how the matrix multiplication is executed.
-    for (size_t i = 0; i < dst->num_rows; ++i) {
-        for (size_t j = 0; j < dst->num_cols; ++j) {
-            for (size_t k = 0; k < m1->num_cols; ++k) {
-                LAMP_FLOAT_TYPE elem1 = LAMP_MAT_ELEMENT_AT(m1, i, k);
-                LAMP_FLOAT_TYPE elem2 = LAMP_MAT_ELEMENT_AT(m2, k, j);
-                dst->elements[LAMP_MAT_ELEMENT_IDX(dst, i, j)] += elem1 * elem2;
-            }
-        }
-    }
+void lamp_mat_multiply_trans_into(LampMatrix *dst, const LampMatrix *m1, bool trans1, const LampMatrix *m2,
+                                  bool trans2) {
+    assert(dst != NULL && m1 != NULL && m2 != NULL);
+    size_t m = trans1 ? m1->num_cols : m1->num_rows;
+    size_t k = trans1 ? m1->num_rows : m1->num_cols;
+    size_t n = trans2 ? m2->num_rows : m2->num_cols;
+    assert(k == (trans2 ? m2->num_cols : m2->num_rows));
+    assert(dst->num_rows == m && dst->num_cols == n);
+
+    // The actual work is done by the blocked kernel, which also takes care of small matrices
+    lamp_gemm(trans1, trans2, m, n, k,
+              m1->elements, m1->num_cols,
+              m2->elements, m2->num_cols,
+              dst->elements, dst->num_cols, false, NULL);
 }
 
 LampMatrix *lamp_mat_alloc_multiply(const LampMatrix *m1, const LampMatrix *m2) {
@@ -169,32 +221,119 @@ void lamp_mat_add(LampMatrix *dst, const LampMatrix *src) {
     assert(src != NULL);
     assert(lamp_matrix_equal_dimensions(dst, src));
 
+    elementwise(ELEMENTWISE_ADD, dst->elements, src->elements, 0.0f, LAMP_MAT_NUM_ELEMENTS(dst));
+}
+
+void lamp_mat_add_column(LampMatrix *dst, const LampMatrix *col) {
+    assert(dst != NULL);
+    assert(col != NULL);
+    assert(col->num_rows == dst->num_rows && col->num_cols == 1);
+
     for (size_t i = 0; i < dst->num_rows; ++i) {
+        LAMP_FLOAT_TYPE value = col->elements[i];
+        LAMP_FLOAT_TYPE *row = &dst->elements[LAMP_MAT_ELEMENT_IDX(dst, i, 0)];
         for (size_t j = 0; j < dst->num_cols; ++j) {
-            LAMP_MAT_ELEMENT_AT(dst, i, j) += LAMP_MAT_ELEMENT_AT(src, i, j);
+            row[j] += value;
         }
     }
 }
 
+void lamp_mat_sum_into(LampMatrix *dst, const LampMatrix *src1, const LampMatrix *src2) {
+    assert(dst != NULL && src1 != NULL && src2 != NULL);
+    assert(lamp_matrix_equal_dimensions(src1, src2));
+
+    // Copying src1 into dst would overwrite src2 if they are the same, the addition is commutative anyway
+    if (dst->elements == src2->elements) {
+        const LampMatrix *swap = src1;
+        src1 = src2;
+        src2 = swap;
+    }
+    if (dst->elements != src1->elements) {
+        lamp_mat_copy_into(dst, src1);
+    }
+    lamp_mat_add(dst, src2);
+}
+
 LampMatrix *lamp_mat_alloc_sum(const LampMatrix *src1, const LampMatrix *src2) {
     assert(src1 != NULL);
     assert(src2 != NULL);
 
-    LampMatrix *sum = lamp_mat_alloc_copy(src1);
-    lamp_mat_add(sum, src2);
+    LampMatrix *sum = lamp_mat_alloc(src1->num_rows, src1->num_cols);
+    lamp_mat_sum_into(sum, src1, src2);
     return sum;
 }
 
-LampMatrix *lamp_mat_transpose(const LampMatrix *m) {
-    assert(m != NULL);
-    LampMatrix *mt = lamp_mat_alloc(m->num_cols, m->num_rows);
+void lamp_mat_sigmoid(LampMatrix *mat) {
+    assert(mat != NULL);
+    elementwise(ELEMENTWISE_SIGMOID, mat->elements, NULL, 0.0f, LAMP_MAT_NUM_ELEMENTS(mat));
+}
 
-    for (size_t i = 0; i < m->num_rows; ++i) {
-        for (size_t j = 0; j < m->num_cols; ++j) {
-            LAMP_MAT_ELEMENT_AT(mt, j, i) = LAMP_MAT_ELEMENT_AT(m, i, j);
+// A transpose reads rows and writes columns (or the other way around). Walking whole rows would touch a new
+// cache line of the columns with every element and evict it long before its neighbours are written.
+// So the longer side of the block is halved recursively until both sides fit in TRANSPOSE_TILE. This is
+// cache oblivious: at some depth the source and destination blocks fit in every level of the cache,
+// whatever their sizes are, without tuning a tile size per level.
+#define TRANSPOSE_TILE 16
+
+static void transpose_block(LAMP_FLOAT_TYPE *dst, size_t dst_stride, const LAMP_FLOAT_TYPE *src,
+                            size_t src_stride, size_t rows, size_t cols) {
+    while (rows > TRANSPOSE_TILE || cols > TRANSPOSE_TILE) {
+        if (rows >= cols) {
+            size_t half = rows / 2;
+            transpose_block(dst, dst_stride, src, src_stride, half, cols);
+            dst += half;
+            src += half * src_stride;
+            rows -= half;
+        } else {
+            size_t half = cols / 2;
+            transpose_block(dst, dst_stride, src, src_stride, rows, half);
+            dst += half * dst_stride;
+            src += half;
+            cols -= half;
+        }
+    }
+
+    for (size_t j = 0; j < cols; ++j) {
+        for (size_t i = 0; i < rows; ++i) {
+            dst[j * dst_stride + i] = src[i * src_stride + j];
+        }
+    }
+}
+
+void lamp_mat_transpose_into(LampMatrix *dst, const LampMatrix *src) {
+    assert(dst != NULL && src != NULL);
+    assert(dst->num_rows == src->num_cols && dst->num_cols == src->num_rows);
+    assert(dst->elements != src->elements);
+
+    transpose_block(dst->elements, dst->num_cols, src->elements, src->num_cols, src->num_rows, src->num_cols);
+}
+
+void lamp_mat_transpose_in_place(LampMatrix *mat) {
+    assert(mat != NULL);
+    assert(mat->num_rows == mat->num_cols);
+
+    // Tile (i0, j0) above the diagonal is swapped with tile (j0, i0) below it, transposing both on the way.
+    // The tiles on the diagonal are swapped with themselves, so only their upper half is walked.
+    size_t n = mat->num_rows;
+    for (size_t i0 = 0; i0 < n; i0 += TRANSPOSE_TILE) {
+        size_t i_end = i0 + TRANSPOSE_TILE < n ? i0 + TRANSPOSE_TILE : n;
+        for (size_t j0 = i0; j0 < n; j0 += TRANSPOSE_TILE) {
+            size_t j_end = j0 + TRANSPOSE_TILE < n ? j0 + TRANSPOSE_TILE : n;
+            for (size_t i = i0; i < i_end; ++i) {
+                for (size_t j = j0 == i0 ? i + 1 : j0; j < j_end; ++j) {
+                    LAMP_FLOAT_TYPE upper = LAMP_MAT_ELEMENT_AT(mat, i, j);
+                    LAMP_MAT_ELEMENT_AT(mat, i, j) = LAMP_MAT_ELEMENT_AT(mat, j, i);
+                    LAMP_MAT_ELEMENT_AT(mat, j, i) = upper;
+                }
+            }
         }
     }
+}
 
+LampMatrix *lamp_mat_transpose(const LampMatrix *m) {
+    assert(m != NULL);
+    LampMatrix *mt = lamp_mat_alloc(m->num_cols, m->num_rows);
+    lamp_mat_transpose_into(mt, m);
     return mt;
 }
 
@@ -209,4 +348,60 @@ void lamp_mat_print(const LampMatrix *m) {
         }
         printf("\n");
     }
-}
\ No newline at end of file
+}
+
+LampMatrixView lamp_mat_view(const LampMatrix *mat) {
+    assert(mat != NULL);
+    LampMatrixView view = {
+            .num_rows = mat->num_rows,
+            .num_cols = mat->num_cols,
+            .stride = mat->num_cols,
+            .elements = mat->elements
+    };
+    return view;
+}
+
+LampMatrixView lamp_mat_view_sub(const LampMatrixView *view, size_t first_row, size_t first_col,
+                                 size_t num_rows, size_t num_cols) {
+    assert(view != NULL);
+    assert(num_rows >= 1 && num_cols >= 1);
+    assert(first_row + num_rows <= view->num_rows && first_col + num_cols <= view->num_cols);
+
+    LampMatrixView sub = {
+            .num_rows = num_rows,
+            .num_cols = num_cols,
+            .stride = view->stride,
+            .elements = &LAMP_VIEW_ELEMENT_AT(view, first_row, first_col)
+    };
+    return sub;
+}
+
+LampMatrixView lamp_mat_view_rows(const LampMatrixView *view, size_t first_row, size_t num_rows) {
+    return lamp_mat_view_sub(view, first_row, 0, num_rows, view->num_cols);
+}
+
+LampMatrixView lamp_mat_view_cols(const LampMatrixView *view, size_t first_col, size_t num_cols) {
+    return lamp_mat_view_sub(view, 0, first_col, view->num_rows, num_cols);
+}
+
+void lamp_mat_view_multiply_into(const LampMatrixView *dst, const LampMatrixView *m1, const LampMatrixView *m2) {
+    assert(dst != NULL && m1 != NULL && m2 != NULL);
+    assert(m1->num_cols == m2->num_rows);
+    assert((dst->num_rows == m1->num_rows) && (dst->num_cols == m2->num_cols));
+
+    lamp_gemm(false, false, dst->num_rows, dst->num_cols, m1->num_cols,
+              m1->elements, m1->stride,
+              m2->elements, m2->stride,
+              dst->elements, dst->stride, false, NULL);
+}
+
+void lamp_mat_view_add(const LampMatrixView *dst, const LampMatrixView *src) {
+    assert(dst != NULL && src != NULL);
+    assert(dst->num_rows == src->num_rows && dst->num_cols == src->num_cols);
+
+    // Every row is contiguous, even if the rows themselves are not
+    for (size_t i = 0; i < dst->num_rows; ++i) {
+        elementwise(ELEMENTWISE_ADD, &LAMP_VIEW_ELEMENT_AT(dst, i, 0), &LAMP_VIEW_ELEMENT_AT(src, i, 0), 0.0f,
+                    dst->num_cols);
+    }
+}
@@ -36,9 +36,22 @@ typedef struct {
     LAMP_FLOAT_TYPE *elements;
 } LampMatrix;
 
-#define LAMP_MAT_NUM_ELEMENTS(p_M) (p_M->num_rows * p_M->num_cols)
-#define LAMP_MAT_ELEMENT_IDX(p_M, row, col) ((row * p_M->num_cols) + col)
-#define LAMP_MAT_ELEMENT_AT(p_M, row, col) (p_M->elements[LAMP_MAT_ELEMENT_IDX(p_M, row, col)])
+#define LAMP_MAT_NUM_ELEMENTS(p_M) ((p_M)->num_rows * (p_M)->num_cols)
+#define LAMP_MAT_ELEMENT_IDX(p_M, row, col) (((row) * (p_M)->num_cols) + (col))
+#define LAMP_MAT_ELEMENT_AT(p_M, row, col) ((p_M)->elements[LAMP_MAT_ELEMENT_IDX(p_M, row, col)])
+
+// A view references (a part of) the elements of a matrix without owning or copying them.
+// Consecutive rows of the view are stride elements apart, so rows, columns and sub matrices of
+// a bigger matrix can be described. Views are cheap to create and passed around by value.
+// ATTENTION: A view is only valid as long as the matrix it was created from
+typedef struct {
+    size_t num_rows;
+    size_t num_cols;
+    size_t stride;
+    LAMP_FLOAT_TYPE *elements;
+} LampMatrixView;
+
+#define LAMP_VIEW_ELEMENT_AT(p_V, row, col) ((p_V)->elements[((row) * (p_V)->stride) + (col)])
 
 LampMatrix *lamp_mat_alloc(size_t rows, size_t cols);
 
@@ -48,8 +61,17 @@ void lamp_mat_fill_with(LampMatrix *mat, LAMP_FLOAT_TYPE filler);
 
 void lamp_mat_rand(LampMatrix *mat);
 
+// Every lamp_mat_alloc_* function allocates a new matrix for its result. Functions ending in _into write into
+// a matrix of the caller instead, so loops can reuse their matrices and don't allocate at all.
+
+// ATTENTION: mat has to be square
+void lamp_mat_identity_into(LampMatrix *mat);
+
 LampMatrix *lamp_mat_alloc_identity(size_t size);
 
+// Copy the content of a flattened 1D array of LAMP_MAT_NUM_ELEMENTS(mat) values into mat
+void lamp_mat_from_array_into(LampMatrix *mat, const LAMP_FLOAT_TYPE *content);
+
 LampMatrix *lamp_mat_alloc_from_array(size_t rows, size_t cols, const LAMP_FLOAT_TYPE *content);
 
 bool lamp_matrix_equal_dimensions(const LampMatrix *m1, const LampMatrix *m2);
@@ -68,14 +90,59 @@ void lamp_mat_multiply_into(LampMatrix *dst, const LampMatrix *m1, const LampMat
 
 LampMatrix *lamp_mat_alloc_multiply(const LampMatrix *m1, const LampMatrix *m2);
 
+// dst = op(m1) * op(m2), where op(m) is m itself or - if the corresponding trans flag is set - its transpose.
+// Like the transA/transB arguments of BLAS sgemm, the transposes are never materialized: the multiplication
+// reads the transposed matrices column by column while packing them, which costs next to nothing.
+// E.g. backpropagation multiplies W^T * delta and delta * a^T this way.
+// ATTENTION: op(m1).n_cols == op(m2).n_rows && dst.n_rows == op(m1).n_rows && dst.n_cols == op(m2).n_cols
+void lamp_mat_multiply_trans_into(LampMatrix *dst, const LampMatrix *m1, bool trans1, const LampMatrix *m2,
+                                  bool trans2);
+
 // Add src to dst
 // ATTENTION: Matrix addition requires matrices of equal dimension
 void lamp_mat_add(LampMatrix *dst, const LampMatrix *src);
 
+// Add the column vector col to every column of dst
+// ATTENTION: col must be of dimension [dst.n_rows, 1]
+void lamp_mat_add_column(LampMatrix *dst, const LampMatrix *col);
+
+// dst = src1 + src2, where dst may be one of the sources
+// ATTENTION: Matrix addition requires matrices of equal dimension
+void lamp_mat_sum_into(LampMatrix *dst, const LampMatrix *src1, const LampMatrix *src2);
+
 LampMatrix *lamp_mat_alloc_sum(const LampMatrix *src1, const LampMatrix *src2);
 
+// Apply the sigmoid function 1 / (1 + e^-x) to every element
+void lamp_mat_sigmoid(LampMatrix *mat);
+
+// dst = src^T
+// ATTENTION: dst must be of dimension [src.n_cols, src.n_rows] and must not share its elements with src
+void lamp_mat_transpose_into(LampMatrix *dst, const LampMatrix *src);
+
+// Transpose a square matrix without a second buffer
+void lamp_mat_transpose_in_place(LampMatrix *mat);
+
 LampMatrix *lamp_mat_transpose(const LampMatrix *m);
 
 void lamp_mat_print(const LampMatrix *m);
 
+// View on the whole matrix
+LampMatrixView lamp_mat_view(const LampMatrix *mat);
+
+// View on num_rows x num_cols elements of a view, starting at [first_row, first_col]
+LampMatrixView lamp_mat_view_sub(const LampMatrixView *view, size_t first_row, size_t first_col,
+                                 size_t num_rows, size_t num_cols);
+
+// View on num_rows complete rows of a view, starting at first_row
+LampMatrixView lamp_mat_view_rows(const LampMatrixView *view, size_t first_row, size_t num_rows);
+
+// View on num_cols complete columns of a view, starting at first_col
+LampMatrixView lamp_mat_view_cols(const LampMatrixView *view, size_t first_col, size_t num_cols);
+
+// Same as lamp_mat_multiply_into() for views
+void lamp_mat_view_multiply_into(const LampMatrixView *dst, const LampMatrixView *m1, const LampMatrixView *m2);
+
+// Same as lamp_mat_add() for views
+void lamp_mat_view_add(const LampMatrixView *dst, const LampMatrixView *src);
+
 #endif //LAMP_LAMP_MATRIX_H
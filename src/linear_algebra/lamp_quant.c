@@ -0,0 +1,279 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "lamp_quant.h"
+#include "lamp_simd.h"
+#include "../threading/lamp_threadpool.h"
+
+// Steps of 4 features, that a depth of k is padded to
+static size_t quant_steps(size_t k) {
+    return (k + 3) / 4;
+}
+
+// Position of w[i][p] in the packed weights
+static size_t packed_index(const LampQuantMatrix *mat, size_t i, size_t p) {
+    size_t panel = i / mat->panel_rows;
+    size_t row = i % mat->panel_rows;
+    return (panel * quant_steps(mat->num_cols) + p / 4) * mat->panel_rows * 4 + row * 4 + p % 4;
+}
+
+// Position of x[p][j] in the packed activations
+static size_t packed_act_index(const LampQuantActivations *act, size_t p, size_t j) {
+    return p / 4 * act->stride + j * 4 + p % 4;
+}
+
+LampQuantMatrix *lamp_quant_mat_alloc(size_t rows, size_t cols) {
+    assert(rows >= 1 && cols >= 1);
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampQuantMatrix *mat = malloc(sizeof(LampQuantMatrix));
+    assert(mat != NULL);
+    mat->num_rows = rows;
+    mat->num_cols = cols;
+    mat->panel_rows = lamp_simd_kernels()->quant_mr;
+    // The padding of the last panel and of the last step stays zero
+    size_t panels = (rows + mat->panel_rows - 1) / mat->panel_rows;
+    mat->values = calloc(panels * mat->panel_rows * quant_steps(cols) * 4, sizeof(int8_t));
+    mat->scales = malloc(sizeof(LAMP_FLOAT_TYPE) * rows);
+    mat->row_sums = malloc(sizeof(int32_t) * rows);
+    assert(mat->values != NULL && mat->scales != NULL && mat->row_sums != NULL);
+
+    return mat;
+}
+
+void lamp_quant_mat_free(LampQuantMatrix *mat) {
+    assert(mat != NULL);
+    free(mat->values);
+    free(mat->scales);
+    free(mat->row_sums);
+    free(mat);
+}
+
+void lamp_quant_mat_from_float(LampQuantMatrix *dst, const LampMatrix *src) {
+    assert(dst->num_rows == src->num_rows && dst->num_cols == src->num_cols);
+
+    for (size_t i = 0; i < src->num_rows; ++i) {
+        const LAMP_FLOAT_TYPE *row = &src->elements[i * src->num_cols];
+        LAMP_FLOAT_TYPE max_abs = 0.0f;
+        for (size_t p = 0; p < src->num_cols; ++p) {
+            if (LAMP_FABS(row[p]) > max_abs) {
+                max_abs = LAMP_FABS(row[p]);
+            }
+        }
+        // A row of zeros can use any scale
+        LAMP_FLOAT_TYPE scale = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+
+        int32_t sum = 0;
+        for (size_t p = 0; p < src->num_cols; ++p) {
+            long value = lrintf(row[p] / scale);
+            value = value < -127 ? -127 : (value > 127 ? 127 : value);
+            dst->values[packed_index(dst, i, p)] = (int8_t) value;
+            sum += (int32_t) value;
+        }
+        dst->scales[i] = scale;
+        dst->row_sums[i] = sum;
+    }
+}
+
+void lamp_quant_mat_to_float(LampMatrix *dst, const LampQuantMatrix *src) {
+    assert(dst->num_rows == src->num_rows && dst->num_cols == src->num_cols);
+
+    for (size_t i = 0; i < src->num_rows; ++i) {
+        for (size_t p = 0; p < src->num_cols; ++p) {
+            LAMP_MAT_ELEMENT_AT(dst, i, p) = src->scales[i] * (LAMP_FLOAT_TYPE) src->values[packed_index(src, i, p)];
+        }
+    }
+}
+
+LampQuantActivations *lamp_quant_act_alloc(size_t max_samples, size_t max_features) {
+    assert(max_samples >= 1 && max_features >= 1);
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampQuantActivations *act = malloc(sizeof(LampQuantActivations));
+    assert(act != NULL);
+    size_t tile_width = lamp_simd_kernels()->quant_nr;
+    act->num_samples = max_samples;
+    act->num_features = max_features;
+    act->max_samples = max_samples;
+    act->max_features = max_features;
+    act->stride = (max_samples + tile_width - 1) / tile_width * tile_width * 4;
+    // The padding is read by the kernel, so it has to be initialized
+    act->values = calloc(quant_steps(max_features) * act->stride, sizeof(uint8_t));
+    act->scales = malloc(sizeof(LAMP_FLOAT_TYPE) * max_samples);
+    act->inverse_scales = malloc(sizeof(LAMP_FLOAT_TYPE) * max_samples);
+    act->zero_points = malloc(sizeof(int32_t) * max_samples);
+    assert(act->values != NULL && act->scales != NULL && act->inverse_scales != NULL && act->zero_points != NULL);
+
+    return act;
+}
+
+void lamp_quant_act_free(LampQuantActivations *act) {
+    assert(act != NULL);
+    free(act->values);
+    free(act->scales);
+    free(act->inverse_scales);
+    free(act->zero_points);
+    free(act);
+}
+
+void lamp_quant_act_from_float(LampQuantActivations *dst, const LampMatrix *src) {
+    assert(src->num_rows <= dst->max_features && src->num_cols <= dst->max_samples);
+    size_t n = src->num_cols;
+    dst->num_features = src->num_rows;
+    dst->num_samples = n;
+
+    // The rows hold the features of all samples, so the range of every sample is found in one pass over the
+    // contiguous rows. The range always includes zero, so zero (e.g. of a ReLU) is represented exactly.
+    LAMP_FLOAT_TYPE *min = dst->scales;
+    LAMP_FLOAT_TYPE *max = dst->inverse_scales;
+    for (size_t j = 0; j < n; ++j) {
+        min[j] = 0.0f;
+        max[j] = 0.0f;
+    }
+    for (size_t p = 0; p < dst->num_features; ++p) {
+        const LAMP_FLOAT_TYPE *row = &src->elements[p * n];
+        for (size_t j = 0; j < n; ++j) {
+            min[j] = row[j] < min[j] ? row[j] : min[j];
+            max[j] = row[j] > max[j] ? row[j] : max[j];
+        }
+    }
+    // A sample of zeros uses the scale 255 / 255, selected by arithmetic since a division of a selected value keeps
+    // the compiler from vectorizing the loop. The zero point -min / scale is in [0, 255], where adding and
+    // subtracting 1.5 * 2^23 rounds to the nearest even integer just like lrintf().
+    for (size_t j = 0; j < n; ++j) {
+        LAMP_FLOAT_TYPE range = max[j] - min[j];
+        LAMP_FLOAT_TYPE scale = (range + (LAMP_FLOAT_TYPE) (range == 0.0f) * 255.0f) / 255.0f;
+        LAMP_FLOAT_TYPE inverse_scale = 1.0f / scale;
+        dst->zero_points[j] = (int32_t) ((-min[j] * inverse_scale + 0x1.8p23f) - 0x1.8p23f);
+        dst->scales[j] = scale;
+        dst->inverse_scales[j] = inverse_scale;
+    }
+
+    // Groups of 4 rows are quantized and interleaved at once. The last group repeats the last row, which the
+    // zero padding of the weights cancels out.
+    const LampSimdKernels *kernels = lamp_simd_kernels();
+    for (size_t p = 0; p < dst->num_features; p += 4) {
+        const LAMP_FLOAT_TYPE *rows[4];
+        for (size_t q = 0; q < 4; ++q) {
+            size_t row = p + q < dst->num_features ? p + q : dst->num_features - 1;
+            rows[q] = &src->elements[row * n];
+        }
+        kernels->quantize_u8_x4(&dst->values[p / 4 * dst->stride], rows, dst->inverse_scales, dst->zero_points, n);
+    }
+}
+
+void lamp_quant_act_to_float(LampMatrix *dst, const LampQuantActivations *src) {
+    assert(dst->num_rows == src->num_features && dst->num_cols == src->num_samples);
+
+    for (size_t p = 0; p < src->num_features; ++p) {
+        for (size_t j = 0; j < src->num_samples; ++j) {
+            int32_t value = src->values[packed_act_index(src, p, j)] - src->zero_points[j];
+            LAMP_MAT_ELEMENT_AT(dst, p, j) = src->scales[j] * (LAMP_FLOAT_TYPE) value;
+        }
+    }
+}
+
+// Calculate the rows [first, last) of dst, where first is the beginning of a panel. Every panel of weights is
+// multiplied with the tiles of all samples while it stays in the L1 cache. The sums of a tile are dequantized
+// into the rows of dst right away, the activation is applied once the rows are finished.
+static void multiply_rows(LampMatrix *dst, const LampQuantMatrix *weights, const LampQuantActivations *input,
+                          const LampGemmEpilogue *epilogue, size_t first, size_t last) {
+    const LampSimdKernels *kernels = lamp_simd_kernels();
+    size_t mr = kernels->quant_mr, nr = kernels->quant_nr;
+    assert(mr == weights->panel_rows && first % mr == 0);
+    size_t kc = quant_steps(weights->num_cols);
+    size_t n = input->num_samples;
+    const LAMP_FLOAT_TYPE *row_bias = epilogue != NULL ? epilogue->row_bias : NULL;
+    int32_t tile[LAMP_QUANT_MAX_MR * LAMP_QUANT_MAX_NR];
+
+    for (size_t i = first; i < last; i += mr) {
+        size_t rows = last - i < mr ? last - i : mr;
+        const int8_t *panel = &weights->values[i * kc * 4];
+        for (size_t j = 0; j < n; j += nr) {
+            size_t cols = n - j < nr ? n - j : nr;
+            kernels->quant_tile(kc, panel, &input->values[j * 4], input->stride, tile, nr);
+
+            for (size_t r = 0; r < rows; ++r) {
+                const int32_t *sums = &tile[r * nr];
+                LAMP_FLOAT_TYPE *out = &dst->elements[(i + r) * dst->num_cols + j];
+                LAMP_FLOAT_TYPE scale = weights->scales[i + r];
+                LAMP_FLOAT_TYPE bias = row_bias != NULL ? row_bias[i + r] : 0.0f;
+                uint32_t row_sum = (uint32_t) weights->row_sums[i + r];
+                for (size_t c = 0; c < cols; ++c) {
+                    // The sum of the weights times the centered inputs fits into 32 bits, only the two parts of it
+                    // may not. The unsigned arithmetic wraps around, so the difference is still exact.
+                    uint32_t zero_point = (uint32_t) input->zero_points[j + c];
+                    int32_t sum = (int32_t) ((uint32_t) sums[c] - zero_point * row_sum);
+                    out[c] = scale * input->scales[j + c] * (LAMP_FLOAT_TYPE) sum + bias;
+                }
+            }
+        }
+
+        if (epilogue != NULL && epilogue->activation != NULL) {
+            for (size_t r = 0; r < rows; ++r) {
+                epilogue->activation(&dst->elements[(i + r) * dst->num_cols], dst->num_cols);
+            }
+        }
+    }
+}
+
+typedef struct {
+    LampMatrix *dst;
+    const LampQuantMatrix *weights;
+    const LampQuantActivations *input;
+    const LampGemmEpilogue *epilogue;
+    size_t block_size;
+} QuantMultiplyJob;
+
+static void multiply_task(void *context, size_t task_index) {
+    const QuantMultiplyJob *job = context;
+    size_t first = task_index * job->block_size;
+    size_t last = first + job->block_size < job->weights->num_rows ? first + job->block_size : job->weights->num_rows;
+    multiply_rows(job->dst, job->weights, job->input, job->epilogue, first, last);
+}
+
+void lamp_quant_mat_multiply_into(LampMatrix *dst, const LampQuantMatrix *weights, const LampQuantActivations *input,
+                                  const LampGemmEpilogue *epilogue) {
+    assert(weights->num_cols == input->num_features && weights->num_cols <= LAMP_QUANT_MAX_DEPTH);
+    assert(dst->num_rows == weights->num_rows && dst->num_cols == input->num_samples);
+
+    size_t m = weights->num_rows;
+    LampThreadPool *pool = lamp_threadpool_for_work(m * input->num_samples * weights->num_cols);
+    if (pool == NULL) {
+        multiply_rows(dst, weights, input, epilogue, 0, m);
+        return;
+    }
+
+    // Blocks of whole panels, a few more than threads to balance the load
+    size_t num_blocks = lamp_threadpool_num_threads(pool) * 2;
+    size_t block_size = (m + num_blocks - 1) / num_blocks;
+    block_size = (block_size + weights->panel_rows - 1) / weights->panel_rows * weights->panel_rows;
+    QuantMultiplyJob job = {
+            .dst = dst, .weights = weights, .input = input, .epilogue = epilogue, .block_size = block_size
+    };
+    lamp_threadpool_parallel_for(pool, (m + block_size - 1) / block_size, multiply_task, &job);
+}
@@ -0,0 +1,105 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_QUANT_H
+#define LAMP_LAMP_QUANT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lamp_matrix.h"
+#include "lamp_gemm.h"
+
+// 8 bit quantization for inference. A matrix multiplication of quantized operands multiplies bytes and
+// accumulates them exactly in 32 bit integers. The scales are applied once per element of the result.
+//
+// Weights are quantized symmetrically to signed integers with one scale per row (output neuron):
+//     w[i][p] ~ scales[i] * values[i][p]  with values in [-127, 127]
+// Activations are quantized asymmetrically to unsigned integers with a scale and zero point per sample,
+// because they are often not centered around zero (e.g. the output of a sigmoid or ReLU):
+//     x[p][j] ~ scales[j] * (values[j][p] - zero_points[j])  with values in [0, 255]
+// The product then becomes
+//     sum(w[i][p] * x[p][j]) ~ scales[i] * scales[j] * (sum(values[i][p] * values[j][p]) - zero_points[j] * row_sums[i])
+
+// The integer sums are exact as long as they fit into 32 bits
+#define LAMP_QUANT_MAX_DEPTH 65536
+
+// The multiplication works on register tiles like lamp_gemm(), whose size [quant_mr, quant_nr] is taken from the
+// quant_tile kernel of lamp_simd_kernels(). These are the largest tiles of all kernels.
+#define LAMP_QUANT_MAX_MR 8
+#define LAMP_QUANT_MAX_NR 32
+
+// The values are packed once for the kernel: panels of panel_rows rows, in which the weights of every row come in
+// groups of 4 features and the groups of all rows of the panel follow each other (see quant_tile in lamp_simd.h).
+// Rows beyond num_rows and features beyond num_cols are zero.
+typedef struct {
+    size_t num_rows;
+    size_t num_cols;
+    size_t panel_rows;
+    int8_t *values;
+    LAMP_FLOAT_TYPE *scales;
+    int32_t *row_sums;
+} LampQuantMatrix;
+
+// Activations of a [features, batch] matrix. They are packed for the kernel as well: every group of 4 features holds
+// the 4 values of each sample next to each other and the next group starts stride bytes later. There is room for
+// max_samples rounded up to a whole tile, the values beyond num_samples are never used.
+// inverse_scales are the reciprocals of scales, which the quantization multiplies with.
+typedef struct {
+    size_t num_samples;
+    size_t num_features;
+    size_t max_samples;
+    size_t max_features;
+    size_t stride;
+    uint8_t *values;
+    LAMP_FLOAT_TYPE *scales;
+    LAMP_FLOAT_TYPE *inverse_scales;
+    int32_t *zero_points;
+} LampQuantActivations;
+
+LampQuantMatrix *lamp_quant_mat_alloc(size_t rows, size_t cols);
+
+void lamp_quant_mat_free(LampQuantMatrix *mat);
+
+// ATTENTION: Users must assure the dst and src matrices have the same dimensions
+void lamp_quant_mat_from_float(LampQuantMatrix *dst, const LampMatrix *src);
+
+void lamp_quant_mat_to_float(LampMatrix *dst, const LampQuantMatrix *src);
+
+// Allocate room for up to max_samples samples of max_features features each
+LampQuantActivations *lamp_quant_act_alloc(size_t max_samples, size_t max_features);
+
+void lamp_quant_act_free(LampQuantActivations *act);
+
+// Quantize every column of src as one sample
+// ATTENTION: src must not have more rows (features) or columns (samples) than dst was allocated for
+void lamp_quant_act_from_float(LampQuantActivations *dst, const LampMatrix *src);
+
+// Dequantize into a [features, batch] matrix
+void lamp_quant_act_to_float(LampMatrix *dst, const LampQuantActivations *src);
+
+// dst = weights * input, where dst has a row per weight row and a column per sample of the input.
+// The optional epilogue is applied to the rows of dst like in lamp_gemm().
+void lamp_quant_mat_multiply_into(LampMatrix *dst, const LampQuantMatrix *weights, const LampQuantActivations *input,
+                                  const LampGemmEpilogue *epilogue);
+
+#endif //LAMP_LAMP_QUANT_H
@@ -0,0 +1,1854 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lamp_simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LAMP_SIMD_X86
+#include <immintrin.h>
+#define LAMP_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Portable variant
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void fill_scalar(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE value, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = value;
+    }
+}
+
+static void add_scalar(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+static void exp_scalar(LAMP_FLOAT_TYPE *dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = expf(dst[i]);
+    }
+}
+
+static void sigmoid_scalar(LAMP_FLOAT_TYPE *dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = 1.0f / (1.0f + expf(-dst[i]));
+    }
+}
+
+// Constants of the tanh approximation of the GELU: gelu(x) = x * sigmoid(GELU_K * (x + GELU_C * x^3))
+#define GELU_K 1.5957691216057308f
+#define GELU_C 0.044715f
+
+static void leaky_relu_scalar(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE alpha, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = dst[i] > 0.0f ? dst[i] : alpha * dst[i];
+    }
+}
+
+static void tanh_scalar(LAMP_FLOAT_TYPE *dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = tanhf(dst[i]);
+    }
+}
+
+static void gelu_scalar(LAMP_FLOAT_TYPE *dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        LAMP_FLOAT_TYPE x = dst[i];
+        dst[i] = x / (1.0f + expf(-GELU_K * (x + GELU_C * x * x * x)));
+    }
+}
+
+static void sigmoid_backward_scalar(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] *= y[i] * (1.0f - y[i]);
+    }
+}
+
+static void leaky_relu_backward_scalar(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, LAMP_FLOAT_TYPE alpha,
+                                       size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] *= y[i] > 0.0f ? 1.0f : alpha;
+    }
+}
+
+static void tanh_backward_scalar(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] *= 1.0f - y[i] * y[i];
+    }
+}
+
+// gelu'(x) = s + x * s * (1 - s) * GELU_K * (1 + 3 * GELU_C * x^2) with s = sigmoid(GELU_K * (x + GELU_C * x^3))
+static void gelu_backward_scalar(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *x, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        LAMP_FLOAT_TYPE x2 = x[i] * x[i];
+        LAMP_FLOAT_TYPE s = 1.0f / (1.0f + expf(-GELU_K * (x[i] + GELU_C * x2 * x[i])));
+        dst[i] *= s + x[i] * s * (1.0f - s) * GELU_K * (1.0f + 3.0f * GELU_C * x2);
+    }
+}
+
+static bool all_close_scalar(const LAMP_FLOAT_TYPE *a, const LAMP_FLOAT_TYPE *b, size_t n,
+                             LAMP_FLOAT_TYPE tolerance) {
+    for (size_t i = 0; i < n; ++i) {
+        if (LAMP_FABS(a[i] - b[i]) > tolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void fp16_from_float_scalar(LampHalf *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = lamp_fp16_from_float(src[i]);
+    }
+}
+
+static void float_from_fp16_scalar(LAMP_FLOAT_TYPE *dst, const LampHalf *src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = lamp_float_from_fp16(src[i]);
+    }
+}
+
+static void bf16_from_float_scalar(LampHalf *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = lamp_bf16_from_float(src[i]);
+    }
+}
+
+static void float_from_bf16_scalar(LAMP_FLOAT_TYPE *dst, const LampHalf *src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = lamp_float_from_bf16(src[i]);
+    }
+}
+
+// Without vector registers a small tile keeps the accumulators in the general purpose ones (or lets the compiler
+// vectorize it with the baseline instructions)
+#define GEMM_MR_SCALAR 4
+#define GEMM_NR_SCALAR 8
+
+static void gemm_tile_scalar(size_t kc, const LAMP_FLOAT_TYPE *restrict a, const LAMP_FLOAT_TYPE *restrict b,
+                             LAMP_FLOAT_TYPE *restrict c, size_t ldc, bool accumulate,
+                             const LAMP_FLOAT_TYPE *row_bias) {
+    LAMP_FLOAT_TYPE acc[GEMM_MR_SCALAR][GEMM_NR_SCALAR] = {{0}};
+    for (size_t p = 0; p < kc; ++p) {
+        for (size_t i = 0; i < GEMM_MR_SCALAR; ++i) {
+            for (size_t j = 0; j < GEMM_NR_SCALAR; ++j) {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+        a += GEMM_MR_SCALAR;
+        b += GEMM_NR_SCALAR;
+    }
+
+    for (size_t i = 0; i < GEMM_MR_SCALAR; ++i) {
+        LAMP_FLOAT_TYPE bias = row_bias != NULL ? row_bias[i] : 0.0f;
+        for (size_t j = 0; j < GEMM_NR_SCALAR; ++j) {
+            c[i * ldc + j] = (accumulate ? c[i * ldc + j] : 0.0f) + acc[i][j] + bias;
+        }
+    }
+}
+
+#define QUANT_MR_SCALAR 4
+#define QUANT_NR_SCALAR 4
+
+static void quant_tile_scalar(size_t kc, const int8_t *w, const uint8_t *x, size_t ldx, int32_t *c, size_t ldc) {
+    int32_t acc[QUANT_MR_SCALAR][QUANT_NR_SCALAR] = {{0}};
+    for (size_t p = 0; p < kc; ++p) {
+        for (size_t i = 0; i < QUANT_MR_SCALAR; ++i) {
+            for (size_t j = 0; j < QUANT_NR_SCALAR; ++j) {
+                for (size_t q = 0; q < 4; ++q) {
+                    acc[i][j] += (int32_t) w[i * 4 + q] * (int32_t) x[j * 4 + q];
+                }
+            }
+        }
+        w += QUANT_MR_SCALAR * 4;
+        x += ldx;
+    }
+    for (size_t i = 0; i < QUANT_MR_SCALAR; ++i) {
+        for (size_t j = 0; j < QUANT_NR_SCALAR; ++j) {
+            c[i * ldc + j] = acc[i][j];
+        }
+    }
+}
+
+// The products are limited to a range, that the conversion to 32 bit integers can not overflow, but which is far
+// beyond the bytes for any zero point. The comparisons match the vector max and min, which also turn NaN into
+// the lower limit.
+#define QUANT_LIMIT 0x1p24f
+
+static void quantize_u8_x4_scalar(uint8_t *dst, const LAMP_FLOAT_TYPE *const rows[4],
+                                  const LAMP_FLOAT_TYPE *inverse_scales, const int32_t *zero_points, size_t n) {
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t q = 0; q < 4; ++q) {
+            LAMP_FLOAT_TYPE product = rows[q][j] * inverse_scales[j];
+            product = product > -QUANT_LIMIT ? product : -QUANT_LIMIT;
+            product = product < QUANT_LIMIT ? product : QUANT_LIMIT;
+            long value = lrintf(product) + zero_points[j];
+            dst[j * 4 + q] = (uint8_t) (value < 0 ? 0 : (value > 255 ? 255 : value));
+        }
+    }
+}
+
+#define SPARSE_NR_SCALAR 8
+
+static void sparse_row_scalar(size_t count, const LAMP_FLOAT_TYPE *values, const uint32_t *cols,
+                              const LAMP_FLOAT_TYPE *b, size_t ldb, LAMP_FLOAT_TYPE *c) {
+    LAMP_FLOAT_TYPE acc[SPARSE_NR_SCALAR] = {0};
+    for (size_t e = 0; e < count; ++e) {
+        const LAMP_FLOAT_TYPE *row = &b[cols[e] * ldb];
+        for (size_t j = 0; j < SPARSE_NR_SCALAR; ++j) {
+            acc[j] += values[e] * row[j];
+        }
+    }
+    for (size_t j = 0; j < SPARSE_NR_SCALAR; ++j) {
+        c[j] = acc[j];
+    }
+}
+
+static void sgd_momentum_scalar(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *velocity,
+                                LAMP_FLOAT_TYPE learning_rate, LAMP_FLOAT_TYPE momentum, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        velocity[i] = momentum * velocity[i] + grads[i];
+        params[i] -= learning_rate * velocity[i];
+    }
+}
+
+static void adam_scalar(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *m, LAMP_FLOAT_TYPE *v,
+                        const LampAdamCoefficients *c, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        m[i] = c->beta1 * m[i] + (1.0f - c->beta1) * grads[i];
+        v[i] = c->beta2 * v[i] + (1.0f - c->beta2) * grads[i] * grads[i];
+        params[i] = c->decay * params[i] - c->step_size * m[i] / (sqrtf(v[i]) + c->epsilon);
+    }
+}
+
+static const LampSimdKernels kernels_scalar = {
+        .name = "scalar",
+        .fill = fill_scalar,
+        .add = add_scalar,
+        .exp = exp_scalar,
+        .sigmoid = sigmoid_scalar,
+        .leaky_relu = leaky_relu_scalar,
+        .tanh = tanh_scalar,
+        .gelu = gelu_scalar,
+        .sigmoid_backward = sigmoid_backward_scalar,
+        .leaky_relu_backward = leaky_relu_backward_scalar,
+        .tanh_backward = tanh_backward_scalar,
+        .gelu_backward = gelu_backward_scalar,
+        .all_close = all_close_scalar,
+        .fp16_from_float = fp16_from_float_scalar,
+        .float_from_fp16 = float_from_fp16_scalar,
+        .bf16_from_float = bf16_from_float_scalar,
+        .float_from_bf16 = float_from_bf16_scalar,
+        .gemm_mr = GEMM_MR_SCALAR,
+        .gemm_nr = GEMM_NR_SCALAR,
+        .gemm_tile = gemm_tile_scalar,
+        .quant_mr = QUANT_MR_SCALAR,
+        .quant_nr = QUANT_NR_SCALAR,
+        .quant_tile = quant_tile_scalar,
+        .quantize_u8_x4 = quantize_u8_x4_scalar,
+        .sparse_nr = SPARSE_NR_SCALAR,
+        .sparse_row = sparse_row_scalar,
+        .sgd_momentum = sgd_momentum_scalar,
+        .adam = adam_scalar,
+};
+
+#ifdef LAMP_SIMD_X86
+
+// The vector kernels are written for single precision floats
+_Static_assert(sizeof(LAMP_FLOAT_TYPE) == sizeof(float), "SIMD kernels require LAMP_FLOAT_TYPE to be float");
+
+// Vectorized exp() approximation as found in the Cephes library:
+// exp(x) = 2^n * exp(r) with n = round(x / ln(2)) and |r| <= ln(2) / 2.
+// exp(r) is approximated with a polynomial, 2^n is constructed directly in the exponent bits.
+// The maximum relative error is around 2 ulp in the clamped input range.
+#define EXP_HI 88.3762626647949f
+#define EXP_LO (-87.3365447504019f)
+#define EXP_LOG2E 1.44269504088896341f
+#define EXP_LN2_HI 0.693359375f
+#define EXP_LN2_LO (-2.12194440e-4f)
+#define EXP_P0 1.9875691500E-4f
+#define EXP_P1 1.3981999507E-3f
+#define EXP_P2 8.3334519073E-3f
+#define EXP_P3 4.1665795894E-2f
+#define EXP_P4 1.6666665459E-1f
+#define EXP_P5 5.0000001201E-1f
+
+// tanh(x) = 2 * sigmoid(2x) - 1 subtracts two values close to 1 for small |x|, which leaves only an absolute
+// precision of about 1e-7. Below TANH_SMALL the odd polynomial of Cephes' tanhf is used instead:
+// tanh(x) = x + x^3 * P(x^2) with a relative error of a few ulp.
+#define TANH_SMALL 0.625f
+#define TANH_P0 (-5.70498872745E-3f)
+#define TANH_P1 2.06390887954E-2f
+#define TANH_P2 (-5.37397155531E-2f)
+#define TANH_P3 1.33314422036E-1f
+#define TANH_P4 (-3.33332819422E-1f)
+
+// ---------------------------------------------------------------------------------------------------------------------
+// SSE4.1 variant - 4 floats per vector
+// ---------------------------------------------------------------------------------------------------------------------
+
+LAMP_TARGET("sse4.1")
+static inline __m128 exp_ps_sse(__m128 x) {
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(EXP_LO)), _mm_set1_ps(EXP_HI));
+    __m128 n = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(EXP_LN2_HI)));
+    r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(EXP_LN2_LO)));
+
+    __m128 p = _mm_set1_ps(EXP_P0);
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P1));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P2));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P3));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P4));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_P5));
+    __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, _mm_mul_ps(r, r)), r), _mm_set1_ps(1.0f));
+
+    __m128i e = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(y, _mm_castsi128_ps(e));
+}
+
+LAMP_TARGET("sse4.1")
+static inline __m128 sigmoid_ps_sse(__m128 x) {
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 e = exp_ps_sse(_mm_sub_ps(_mm_setzero_ps(), x));
+    return _mm_div_ps(one, _mm_add_ps(one, e));
+}
+
+LAMP_TARGET("sse4.1")
+static inline __m128 tanh_ps_sse(__m128 x) {
+    __m128 s = sigmoid_ps_sse(_mm_add_ps(x, x));
+    __m128 large = _mm_sub_ps(_mm_add_ps(s, s), _mm_set1_ps(1.0f));
+
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 p = _mm_set1_ps(TANH_P0);
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(TANH_P1));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(TANH_P2));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(TANH_P3));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(TANH_P4));
+    __m128 small = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), x), x);
+
+    __m128 abs = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+    return _mm_blendv_ps(large, small, _mm_cmplt_ps(abs, _mm_set1_ps(TANH_SMALL)));
+}
+
+LAMP_TARGET("sse4.1")
+static inline __m128 gelu_sigmoid_ps_sse(__m128 x) {
+    __m128 x3 = _mm_mul_ps(_mm_mul_ps(x, x), x);
+    __m128 u = _mm_mul_ps(_mm_set1_ps(GELU_K), _mm_add_ps(x, _mm_mul_ps(_mm_set1_ps(GELU_C), x3)));
+    return sigmoid_ps_sse(u);
+}
+
+LAMP_TARGET("sse4.1")
+static inline __m128 gelu_ps_sse(__m128 x) {
+    return _mm_mul_ps(x, gelu_sigmoid_ps_sse(x));
+}
+
+LAMP_TARGET("sse4.1")
+static void fill_sse(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE value, size_t n) {
+    __m128 v = _mm_set1_ps(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(&dst[i], v);
+    }
+    fill_scalar(&dst[i], value, n - i);
+}
+
+LAMP_TARGET("sse4.1")
+static void add_sse(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(&dst[i], _mm_add_ps(_mm_loadu_ps(&dst[i]), _mm_loadu_ps(&src[i])));
+    }
+    add_scalar(&dst[i], &src[i], n - i);
+}
+
+// The remaining elements that do not fill a whole vector are copied into a zero padded buffer,
+// so they are calculated with the same approximation as the rest.
+LAMP_TARGET("sse4.1")
+static void exp_sse(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(&dst[i], exp_ps_sse(_mm_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        float tail[4] = {0};
+        memcpy(tail, &dst[i], (n - i) * sizeof(float));
+        _mm_storeu_ps(tail, exp_ps_sse(_mm_loadu_ps(tail)));
+        memcpy(&dst[i], tail, (n - i) * sizeof(float));
+    }
+}
+
+LAMP_TARGET("sse4.1")
+static void sigmoid_sse(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(&dst[i], sigmoid_ps_sse(_mm_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        float tail[4] = {0};
+        memcpy(tail, &dst[i], (n - i) * sizeof(float));
+        _mm_storeu_ps(tail, sigmoid_ps_sse(_mm_loadu_ps(tail)));
+        memcpy(&dst[i], tail, (n - i) * sizeof(float));
+    }
+}
+
+LAMP_TARGET("sse4.1")
+static void leaky_relu_sse(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE alpha, size_t n) {
+    __m128 a = _mm_set1_ps(alpha);
+    __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(&dst[i]);
+        _mm_storeu_ps(&dst[i], _mm_blendv_ps(_mm_mul_ps(a, x), x, _mm_cmpgt_ps(x, zero)));
+    }
+    leaky_relu_scalar(&dst[i], alpha, n - i);
+}
+
+LAMP_TARGET("sse4.1")
+static void tanh_sse(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(&dst[i], tanh_ps_sse(_mm_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        float tail[4] = {0};
+        memcpy(tail, &dst[i], (n - i) * sizeof(float));
+        _mm_storeu_ps(tail, tanh_ps_sse(_mm_loadu_ps(tail)));
+        memcpy(&dst[i], tail, (n - i) * sizeof(float));
+    }
+}
+
+LAMP_TARGET("sse4.1")
+static void gelu_sse(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(&dst[i], gelu_ps_sse(_mm_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        float tail[4] = {0};
+        memcpy(tail, &dst[i], (n - i) * sizeof(float));
+        _mm_storeu_ps(tail, gelu_ps_sse(_mm_loadu_ps(tail)));
+        memcpy(&dst[i], tail, (n - i) * sizeof(float));
+    }
+}
+
+LAMP_TARGET("sse4.1")
+static void sigmoid_backward_sse(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n) {
+    __m128 one = _mm_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(&y[i]);
+        __m128 grad = _mm_mul_ps(v, _mm_sub_ps(one, v));
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_loadu_ps(&dst[i]), grad));
+    }
+    sigmoid_backward_scalar(&dst[i], &y[i], n - i);
+}
+
+LAMP_TARGET("sse4.1")
+static void leaky_relu_backward_sse(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, LAMP_FLOAT_TYPE alpha, size_t n) {
+    __m128 a = _mm_set1_ps(alpha);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 grad = _mm_blendv_ps(a, one, _mm_cmpgt_ps(_mm_loadu_ps(&y[i]), zero));
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_loadu_ps(&dst[i]), grad));
+    }
+    leaky_relu_backward_scalar(&dst[i], &y[i], alpha, n - i);
+}
+
+LAMP_TARGET("sse4.1")
+static void tanh_backward_sse(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n) {
+    __m128 one = _mm_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(&y[i]);
+        __m128 grad = _mm_sub_ps(one, _mm_mul_ps(v, v));
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_loadu_ps(&dst[i]), grad));
+    }
+    tanh_backward_scalar(&dst[i], &y[i], n - i);
+}
+
+LAMP_TARGET("sse4.1")
+static void gelu_backward_sse(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *x, size_t n) {
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 k = _mm_set1_ps(GELU_K);
+    __m128 c3 = _mm_set1_ps(3.0f * GELU_C);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(&x[i]);
+        __m128 s = gelu_sigmoid_ps_sse(v);
+        __m128 du = _mm_mul_ps(k, _mm_add_ps(one, _mm_mul_ps(c3, _mm_mul_ps(v, v))));
+        __m128 grad = _mm_add_ps(s, _mm_mul_ps(_mm_mul_ps(v, _mm_mul_ps(s, _mm_sub_ps(one, s))), du));
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_loadu_ps(&dst[i]), grad));
+    }
+    gelu_backward_scalar(&dst[i], &x[i], n - i);
+}
+
+LAMP_TARGET("sse4.1")
+static bool all_close_sse(const LAMP_FLOAT_TYPE *a, const LAMP_FLOAT_TYPE *b, size_t n, LAMP_FLOAT_TYPE tolerance) {
+    __m128 tol = _mm_set1_ps(tolerance);
+    __m128 sign_mask = _mm_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 diff = _mm_andnot_ps(sign_mask, _mm_sub_ps(_mm_loadu_ps(&a[i]), _mm_loadu_ps(&b[i])));
+        if (_mm_movemask_ps(_mm_cmpgt_ps(diff, tol)) != 0) {
+            return false;
+        }
+    }
+    return all_close_scalar(&a[i], &b[i], n - i, tolerance);
+}
+
+// 8 accumulators of 4 floats leave enough of the 16 registers for the row of B, the broadcast value of A and the
+// products, which need their own register without FMA
+#define GEMM_MR_SSE 4
+#define GEMM_NR_SSE 8
+
+LAMP_TARGET("sse4.1")
+static void gemm_tile_sse(size_t kc, const LAMP_FLOAT_TYPE *restrict a, const LAMP_FLOAT_TYPE *restrict b,
+                          LAMP_FLOAT_TYPE *restrict c, size_t ldc, bool accumulate, const LAMP_FLOAT_TYPE *row_bias) {
+    __m128 acc[GEMM_MR_SSE][2];
+    for (size_t i = 0; i < GEMM_MR_SSE; ++i) {
+        acc[i][0] = _mm_setzero_ps();
+        acc[i][1] = _mm_setzero_ps();
+    }
+    for (size_t p = 0; p < kc; ++p) {
+        __m128 b0 = _mm_loadu_ps(&b[0]);
+        __m128 b1 = _mm_loadu_ps(&b[4]);
+        for (size_t i = 0; i < GEMM_MR_SSE; ++i) {
+            __m128 ai = _mm_set1_ps(a[i]);
+            acc[i][0] = _mm_add_ps(acc[i][0], _mm_mul_ps(ai, b0));
+            acc[i][1] = _mm_add_ps(acc[i][1], _mm_mul_ps(ai, b1));
+        }
+        a += GEMM_MR_SSE;
+        b += GEMM_NR_SSE;
+    }
+
+    for (size_t i = 0; i < GEMM_MR_SSE; ++i) {
+        LAMP_FLOAT_TYPE *c_row = &c[i * ldc];
+        __m128 bias = _mm_set1_ps(row_bias != NULL ? row_bias[i] : 0.0f);
+        for (size_t v = 0; v < 2; ++v) {
+            __m128 result = _mm_add_ps(acc[i][v], bias);
+            if (accumulate) {
+                result = _mm_add_ps(result, _mm_loadu_ps(&c_row[4 * v]));
+            }
+            _mm_storeu_ps(&c_row[4 * v], result);
+        }
+    }
+}
+
+// The elements of A are consumed in pairs with 2 sets of 4 accumulators, so the additions of one element do not
+// wait for the ones of the element before it
+#define SPARSE_NR_SSE 16
+
+LAMP_TARGET("sse4.1")
+static void sparse_row_sse(size_t count, const LAMP_FLOAT_TYPE *values, const uint32_t *cols,
+                           const LAMP_FLOAT_TYPE *b, size_t ldb, LAMP_FLOAT_TYPE *c) {
+    __m128 acc[2][4];
+    for (size_t v = 0; v < 4; ++v) {
+        acc[0][v] = _mm_setzero_ps();
+        acc[1][v] = _mm_setzero_ps();
+    }
+    size_t e = 0;
+    for (; e + 2 <= count; e += 2) {
+        for (size_t u = 0; u < 2; ++u) {
+            const LAMP_FLOAT_TYPE *row = &b[cols[e + u] * ldb];
+            __m128 value = _mm_set1_ps(values[e + u]);
+            for (size_t v = 0; v < 4; ++v) {
+                acc[u][v] = _mm_add_ps(acc[u][v], _mm_mul_ps(value, _mm_loadu_ps(&row[4 * v])));
+            }
+        }
+    }
+    if (e < count) {
+        const LAMP_FLOAT_TYPE *row = &b[cols[e] * ldb];
+        __m128 value = _mm_set1_ps(values[e]);
+        for (size_t v = 0; v < 4; ++v) {
+            acc[0][v] = _mm_add_ps(acc[0][v], _mm_mul_ps(value, _mm_loadu_ps(&row[4 * v])));
+        }
+    }
+    for (size_t v = 0; v < 4; ++v) {
+        _mm_storeu_ps(&c[4 * v], _mm_add_ps(acc[0][v], acc[1][v]));
+    }
+}
+
+// The bytes are widened to 16 bits, so madd can multiply them and add pairs of products without saturating
+// (maddubs on the unsigned and signed bytes directly saturates once two products exceed 32767). A register of
+// widened activations holds the 4 features of 2 samples, whose two pairs are only added when the tile is stored.
+#define QUANT_MR_SSE 4
+#define QUANT_NR_SSE 4
+
+LAMP_TARGET("sse4.1")
+static void quant_tile_sse(size_t kc, const int8_t *w, const uint8_t *x, size_t ldx, int32_t *c, size_t ldc) {
+    __m128i acc[QUANT_MR_SSE][2];
+    for (size_t i = 0; i < QUANT_MR_SSE; ++i) {
+        acc[i][0] = _mm_setzero_si128();
+        acc[i][1] = _mm_setzero_si128();
+    }
+    for (size_t p = 0; p < kc; ++p) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) x);
+        __m128i x01 = _mm_cvtepu8_epi16(bytes);
+        __m128i x23 = _mm_cvtepu8_epi16(_mm_srli_si128(bytes, 8));
+        for (size_t i = 0; i < QUANT_MR_SSE; ++i) {
+            int32_t row;
+            memcpy(&row, &w[i * 4], sizeof(row));
+            __m128i weights = _mm_cvtepi8_epi16(_mm_set1_epi32(row));
+            acc[i][0] = _mm_add_epi32(acc[i][0], _mm_madd_epi16(x01, weights));
+            acc[i][1] = _mm_add_epi32(acc[i][1], _mm_madd_epi16(x23, weights));
+        }
+        w += QUANT_MR_SSE * 4;
+        x += ldx;
+    }
+    for (size_t i = 0; i < QUANT_MR_SSE; ++i) {
+        _mm_storeu_si128((__m128i *) &c[i * ldc], _mm_hadd_epi32(acc[i][0], acc[i][1]));
+    }
+}
+
+// The packs saturate the 32 bit values to bytes, which leaves the 4 samples of each feature next to each other.
+// The shuffle then gathers the 4 features of every sample.
+LAMP_TARGET("sse4.1")
+static void quantize_u8_x4_sse(uint8_t *dst, const LAMP_FLOAT_TYPE *const rows[4],
+                               const LAMP_FLOAT_TYPE *inverse_scales, const int32_t *zero_points, size_t n) {
+    const __m128i interleave = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m128 low = _mm_set1_ps(-QUANT_LIMIT);
+    const __m128 high = _mm_set1_ps(QUANT_LIMIT);
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m128 inverse = _mm_loadu_ps(&inverse_scales[j]);
+        __m128i zero = _mm_loadu_si128((const __m128i *) &zero_points[j]);
+        __m128i values[4];
+        for (size_t q = 0; q < 4; ++q) {
+            __m128 value = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&rows[q][j]), inverse), low), high);
+            values[q] = _mm_add_epi32(_mm_cvtps_epi32(value), zero);
+        }
+        __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(values[0], values[1]),
+                                         _mm_packs_epi32(values[2], values[3]));
+        _mm_storeu_si128((__m128i *) &dst[j * 4], _mm_shuffle_epi8(bytes, interleave));
+    }
+    const LAMP_FLOAT_TYPE *tail[4] = {&rows[0][j], &rows[1][j], &rows[2][j], &rows[3][j]};
+    quantize_u8_x4_scalar(&dst[j * 4], tail, &inverse_scales[j], &zero_points[j], n - j);
+}
+
+LAMP_TARGET("sse4.1")
+static void sgd_momentum_sse(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *velocity,
+                             LAMP_FLOAT_TYPE learning_rate, LAMP_FLOAT_TYPE momentum, size_t n) {
+    __m128 lr = _mm_set1_ps(learning_rate);
+    __m128 mu = _mm_set1_ps(momentum);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 vel = _mm_add_ps(_mm_mul_ps(mu, _mm_loadu_ps(&velocity[i])), _mm_loadu_ps(&grads[i]));
+        _mm_storeu_ps(&velocity[i], vel);
+        _mm_storeu_ps(&params[i], _mm_sub_ps(_mm_loadu_ps(&params[i]), _mm_mul_ps(lr, vel)));
+    }
+    sgd_momentum_scalar(&params[i], &grads[i], &velocity[i], learning_rate, momentum, n - i);
+}
+
+LAMP_TARGET("sse4.1")
+static void adam_sse(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *m, LAMP_FLOAT_TYPE *v,
+                     const LampAdamCoefficients *c, size_t n) {
+    __m128 beta1 = _mm_set1_ps(c->beta1);
+    __m128 beta2 = _mm_set1_ps(c->beta2);
+    __m128 one_minus_beta1 = _mm_set1_ps(1.0f - c->beta1);
+    __m128 one_minus_beta2 = _mm_set1_ps(1.0f - c->beta2);
+    __m128 step_size = _mm_set1_ps(c->step_size);
+    __m128 epsilon = _mm_set1_ps(c->epsilon);
+    __m128 decay = _mm_set1_ps(c->decay);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 g = _mm_loadu_ps(&grads[i]);
+        __m128 m_new = _mm_add_ps(_mm_mul_ps(beta1, _mm_loadu_ps(&m[i])), _mm_mul_ps(one_minus_beta1, g));
+        __m128 v_new = _mm_add_ps(_mm_mul_ps(beta2, _mm_loadu_ps(&v[i])), _mm_mul_ps(_mm_mul_ps(one_minus_beta2, g), g));
+        __m128 update = _mm_div_ps(_mm_mul_ps(step_size, m_new), _mm_add_ps(_mm_sqrt_ps(v_new), epsilon));
+        _mm_storeu_ps(&m[i], m_new);
+        _mm_storeu_ps(&v[i], v_new);
+        _mm_storeu_ps(&params[i], _mm_sub_ps(_mm_mul_ps(decay, _mm_loadu_ps(&params[i])), update));
+    }
+    adam_scalar(&params[i], &grads[i], &m[i], &v[i], c, n - i);
+}
+
+static const LampSimdKernels kernels_sse = {
+        .name = "sse4.1",
+        .fill = fill_sse,
+        .add = add_sse,
+        .exp = exp_sse,
+        .sigmoid = sigmoid_sse,
+        .leaky_relu = leaky_relu_sse,
+        .tanh = tanh_sse,
+        .gelu = gelu_sse,
+        .sigmoid_backward = sigmoid_backward_sse,
+        .leaky_relu_backward = leaky_relu_backward_sse,
+        .tanh_backward = tanh_backward_sse,
+        .gelu_backward = gelu_backward_sse,
+        .all_close = all_close_sse,
+        .fp16_from_float = fp16_from_float_scalar,
+        .float_from_fp16 = float_from_fp16_scalar,
+        .bf16_from_float = bf16_from_float_scalar,
+        .float_from_bf16 = float_from_bf16_scalar,
+        .gemm_mr = GEMM_MR_SSE,
+        .gemm_nr = GEMM_NR_SSE,
+        .gemm_tile = gemm_tile_sse,
+        .quant_mr = QUANT_MR_SSE,
+        .quant_nr = QUANT_NR_SSE,
+        .quant_tile = quant_tile_sse,
+        .quantize_u8_x4 = quantize_u8_x4_sse,
+        .sparse_nr = SPARSE_NR_SSE,
+        .sparse_row = sparse_row_sse,
+        .sgd_momentum = sgd_momentum_sse,
+        .adam = adam_sse,
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// AVX2 + FMA (+ F16C) variant - 8 floats per vector
+// ---------------------------------------------------------------------------------------------------------------------
+
+LAMP_TARGET("avx2,fma")
+static inline __m256 exp_ps_avx2(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_LO)), _mm256_set1_ps(EXP_HI));
+    __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(EXP_LOG2E)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(EXP_LN2_HI), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(EXP_LN2_LO), r);
+
+    __m256 p = _mm256_set1_ps(EXP_P0);
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P1));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P2));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P3));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P4));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_P5));
+    __m256 y = _mm256_add_ps(_mm256_fmadd_ps(p, _mm256_mul_ps(r, r), r), _mm256_set1_ps(1.0f));
+
+    __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(e));
+}
+
+LAMP_TARGET("avx2,fma")
+static inline __m256 sigmoid_ps_avx2(__m256 x) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 e = exp_ps_avx2(_mm256_sub_ps(_mm256_setzero_ps(), x));
+    return _mm256_div_ps(one, _mm256_add_ps(one, e));
+}
+
+LAMP_TARGET("avx2,fma")
+static inline __m256 tanh_ps_avx2(__m256 x) {
+    __m256 s = sigmoid_ps_avx2(_mm256_add_ps(x, x));
+    __m256 large = _mm256_sub_ps(_mm256_add_ps(s, s), _mm256_set1_ps(1.0f));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 p = _mm256_set1_ps(TANH_P0);
+    p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(TANH_P1));
+    p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(TANH_P2));
+    p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(TANH_P3));
+    p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(TANH_P4));
+    __m256 small = _mm256_fmadd_ps(_mm256_mul_ps(p, z), x, x);
+
+    __m256 abs = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+    return _mm256_blendv_ps(large, small, _mm256_cmp_ps(abs, _mm256_set1_ps(TANH_SMALL), _CMP_LT_OQ));
+}
+
+LAMP_TARGET("avx2,fma")
+static inline __m256 gelu_sigmoid_ps_avx2(__m256 x) {
+    __m256 x3 = _mm256_mul_ps(_mm256_mul_ps(x, x), x);
+    __m256 u = _mm256_mul_ps(_mm256_set1_ps(GELU_K), _mm256_fmadd_ps(_mm256_set1_ps(GELU_C), x3, x));
+    return sigmoid_ps_avx2(u);
+}
+
+LAMP_TARGET("avx2,fma")
+static inline __m256 gelu_ps_avx2(__m256 x) {
+    return _mm256_mul_ps(x, gelu_sigmoid_ps_avx2(x));
+}
+
+LAMP_TARGET("avx2,fma")
+static void fill_avx2(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE value, size_t n) {
+    __m256 v = _mm256_set1_ps(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(&dst[i], v);
+    }
+    fill_scalar(&dst[i], value, n - i);
+}
+
+LAMP_TARGET("avx2,fma")
+static void add_avx2(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(&dst[i], _mm256_add_ps(_mm256_loadu_ps(&dst[i]), _mm256_loadu_ps(&src[i])));
+    }
+    add_scalar(&dst[i], &src[i], n - i);
+}
+
+LAMP_TARGET("avx2,fma")
+static void exp_avx2(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(&dst[i], exp_ps_avx2(_mm256_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        float tail[8] = {0};
+        memcpy(tail, &dst[i], (n - i) * sizeof(float));
+        _mm256_storeu_ps(tail, exp_ps_avx2(_mm256_loadu_ps(tail)));
+        memcpy(&dst[i], tail, (n - i) * sizeof(float));
+    }
+}
+
+LAMP_TARGET("avx2,fma")
+static void sigmoid_avx2(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(&dst[i], sigmoid_ps_avx2(_mm256_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        float tail[8] = {0};
+        memcpy(tail, &dst[i], (n - i) * sizeof(float));
+        _mm256_storeu_ps(tail, sigmoid_ps_avx2(_mm256_loadu_ps(tail)));
+        memcpy(&dst[i], tail, (n - i) * sizeof(float));
+    }
+}
+
+LAMP_TARGET("avx2,fma")
+static void leaky_relu_avx2(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE alpha, size_t n) {
+    __m256 a = _mm256_set1_ps(alpha);
+    __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(&dst[i]);
+        _mm256_storeu_ps(&dst[i], _mm256_blendv_ps(_mm256_mul_ps(a, x), x, _mm256_cmp_ps(x, zero, _CMP_GT_OQ)));
+    }
+    leaky_relu_scalar(&dst[i], alpha, n - i);
+}
+
+LAMP_TARGET("avx2,fma")
+static void tanh_avx2(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(&dst[i], tanh_ps_avx2(_mm256_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        float tail[8] = {0};
+        memcpy(tail, &dst[i], (n - i) * sizeof(float));
+        _mm256_storeu_ps(tail, tanh_ps_avx2(_mm256_loadu_ps(tail)));
+        memcpy(&dst[i], tail, (n - i) * sizeof(float));
+    }
+}
+
+LAMP_TARGET("avx2,fma")
+static void gelu_avx2(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(&dst[i], gelu_ps_avx2(_mm256_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        float tail[8] = {0};
+        memcpy(tail, &dst[i], (n - i) * sizeof(float));
+        _mm256_storeu_ps(tail, gelu_ps_avx2(_mm256_loadu_ps(tail)));
+        memcpy(&dst[i], tail, (n - i) * sizeof(float));
+    }
+}
+
+LAMP_TARGET("avx2,fma")
+static void sigmoid_backward_avx2(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(&y[i]);
+        __m256 grad = _mm256_mul_ps(v, _mm256_sub_ps(one, v));
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_loadu_ps(&dst[i]), grad));
+    }
+    sigmoid_backward_scalar(&dst[i], &y[i], n - i);
+}
+
+LAMP_TARGET("avx2,fma")
+static void leaky_relu_backward_avx2(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, LAMP_FLOAT_TYPE alpha,
+                                     size_t n) {
+    __m256 a = _mm256_set1_ps(alpha);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 grad = _mm256_blendv_ps(a, one, _mm256_cmp_ps(_mm256_loadu_ps(&y[i]), zero, _CMP_GT_OQ));
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_loadu_ps(&dst[i]), grad));
+    }
+    leaky_relu_backward_scalar(&dst[i], &y[i], alpha, n - i);
+}
+
+LAMP_TARGET("avx2,fma")
+static void tanh_backward_avx2(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(&y[i]);
+        __m256 grad = _mm256_fnmadd_ps(v, v, one);
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_loadu_ps(&dst[i]), grad));
+    }
+    tanh_backward_scalar(&dst[i], &y[i], n - i);
+}
+
+LAMP_TARGET("avx2,fma")
+static void gelu_backward_avx2(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *x, size_t n) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 k = _mm256_set1_ps(GELU_K);
+    __m256 c3 = _mm256_set1_ps(3.0f * GELU_C);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(&x[i]);
+        __m256 s = gelu_sigmoid_ps_avx2(v);
+        __m256 du = _mm256_mul_ps(k, _mm256_fmadd_ps(c3, _mm256_mul_ps(v, v), one));
+        __m256 grad = _mm256_fmadd_ps(_mm256_mul_ps(v, _mm256_mul_ps(s, _mm256_sub_ps(one, s))), du, s);
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_loadu_ps(&dst[i]), grad));
+    }
+    gelu_backward_scalar(&dst[i], &x[i], n - i);
+}
+
+LAMP_TARGET("avx2,fma")
+static bool all_close_avx2(const LAMP_FLOAT_TYPE *a, const LAMP_FLOAT_TYPE *b, size_t n, LAMP_FLOAT_TYPE tolerance) {
+    __m256 tol = _mm256_set1_ps(tolerance);
+    __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 diff = _mm256_andnot_ps(sign_mask, _mm256_sub_ps(_mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i])));
+        if (_mm256_movemask_ps(_mm256_cmp_ps(diff, tol, _CMP_GT_OQ)) != 0) {
+            return false;
+        }
+    }
+    return all_close_scalar(&a[i], &b[i], n - i, tolerance);
+}
+
+// F16C converts to fp16 in hardware. There is no bf16 conversion before AVX-512 BF16, so it is done with
+// integer operations on the bits (which also works for the AVX-512 variant below).
+LAMP_TARGET("avx2,fma,f16c")
+static void fp16_from_float_avx2(LampHalf *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(&src[i]), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *) &dst[i], h);
+    }
+    fp16_from_float_scalar(&dst[i], &src[i], n - i);
+}
+
+LAMP_TARGET("avx2,fma,f16c")
+static void float_from_fp16_avx2(LAMP_FLOAT_TYPE *dst, const LampHalf *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(&dst[i], _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *) &src[i])));
+    }
+    float_from_fp16_scalar(&dst[i], &src[i], n - i);
+}
+
+// Rounds the upper 16 bits to the nearest even value, NaNs are quieted instead
+LAMP_TARGET("avx2,fma")
+static inline __m256i bf16_round_avx2(__m256 v) {
+    __m256i x = _mm256_castps_si256(v);
+    __m256i upper = _mm256_srli_epi32(x, 16);
+    __m256i bias = _mm256_add_epi32(_mm256_and_si256(upper, _mm256_set1_epi32(1)), _mm256_set1_epi32(0x7fff));
+    __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(x, bias), 16);
+    __m256i quiet_nan = _mm256_or_si256(upper, _mm256_set1_epi32(0x40));
+    __m256i is_nan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+    return _mm256_blendv_epi8(rounded, quiet_nan, is_nan);
+}
+
+LAMP_TARGET("avx2,fma")
+static void bf16_from_float_avx2(LampHalf *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i rounded = bf16_round_avx2(_mm256_loadu_ps(&src[i]));
+        // packus works within 128 bit lanes, so the two halves have to be gathered afterwards
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded, rounded), 0x08);
+        _mm_storeu_si128((__m128i *) &dst[i], _mm256_castsi256_si128(packed));
+    }
+    bf16_from_float_scalar(&dst[i], &src[i], n - i);
+}
+
+LAMP_TARGET("avx2,fma")
+static void float_from_bf16_avx2(LAMP_FLOAT_TYPE *dst, const LampHalf *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) &src[i]));
+        _mm256_storeu_ps(&dst[i], _mm256_castsi256_ps(_mm256_slli_epi32(x, 16)));
+    }
+    float_from_bf16_scalar(&dst[i], &src[i], n - i);
+}
+
+// 12 accumulators of 8 floats, 2 registers for the row of B and 1 for the broadcast value of A out of the 16
+#define GEMM_MR_AVX2 6
+#define GEMM_NR_AVX2 16
+
+LAMP_TARGET("avx2,fma")
+static void gemm_tile_avx2(size_t kc, const LAMP_FLOAT_TYPE *restrict a, const LAMP_FLOAT_TYPE *restrict b,
+                           LAMP_FLOAT_TYPE *restrict c, size_t ldc, bool accumulate, const LAMP_FLOAT_TYPE *row_bias) {
+    __m256 acc[GEMM_MR_AVX2][2];
+    for (size_t i = 0; i < GEMM_MR_AVX2; ++i) {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+    for (size_t p = 0; p < kc; ++p) {
+        __m256 b0 = _mm256_loadu_ps(&b[0]);
+        __m256 b1 = _mm256_loadu_ps(&b[8]);
+        for (size_t i = 0; i < GEMM_MR_AVX2; ++i) {
+            __m256 ai = _mm256_broadcast_ss(&a[i]);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += GEMM_MR_AVX2;
+        b += GEMM_NR_AVX2;
+    }
+
+    for (size_t i = 0; i < GEMM_MR_AVX2; ++i) {
+        LAMP_FLOAT_TYPE *c_row = &c[i * ldc];
+        __m256 bias = _mm256_set1_ps(row_bias != NULL ? row_bias[i] : 0.0f);
+        for (size_t v = 0; v < 2; ++v) {
+            __m256 result = _mm256_add_ps(acc[i][v], bias);
+            if (accumulate) {
+                result = _mm256_add_ps(result, _mm256_loadu_ps(&c_row[8 * v]));
+            }
+            _mm256_storeu_ps(&c_row[8 * v], result);
+        }
+    }
+}
+
+// Same as the SSE variant with 8 floats per vector
+#define SPARSE_NR_AVX2 32
+
+LAMP_TARGET("avx2,fma")
+static void sparse_row_avx2(size_t count, const LAMP_FLOAT_TYPE *values, const uint32_t *cols,
+                            const LAMP_FLOAT_TYPE *b, size_t ldb, LAMP_FLOAT_TYPE *c) {
+    __m256 acc[2][4];
+    for (size_t v = 0; v < 4; ++v) {
+        acc[0][v] = _mm256_setzero_ps();
+        acc[1][v] = _mm256_setzero_ps();
+    }
+    size_t e = 0;
+    for (; e + 2 <= count; e += 2) {
+        for (size_t u = 0; u < 2; ++u) {
+            const LAMP_FLOAT_TYPE *row = &b[cols[e + u] * ldb];
+            __m256 value = _mm256_set1_ps(values[e + u]);
+            for (size_t v = 0; v < 4; ++v) {
+                acc[u][v] = _mm256_fmadd_ps(value, _mm256_loadu_ps(&row[8 * v]), acc[u][v]);
+            }
+        }
+    }
+    if (e < count) {
+        const LAMP_FLOAT_TYPE *row = &b[cols[e] * ldb];
+        __m256 value = _mm256_set1_ps(values[e]);
+        for (size_t v = 0; v < 4; ++v) {
+            acc[0][v] = _mm256_fmadd_ps(value, _mm256_loadu_ps(&row[8 * v]), acc[0][v]);
+        }
+    }
+    for (size_t v = 0; v < 4; ++v) {
+        _mm256_storeu_ps(&c[8 * v], _mm256_add_ps(acc[0][v], acc[1][v]));
+    }
+}
+
+// Same as the SSE variant, with 4 samples in each register of widened activations. hadd works within the 128 bit
+// lanes, so the sums of samples 0, 1, 4, 5 end up in the lower lane and have to be put back in order.
+#define QUANT_MR_AVX2 6
+#define QUANT_NR_AVX2 8
+
+LAMP_TARGET("avx2,fma")
+static void quant_tile_avx2(size_t kc, const int8_t *w, const uint8_t *x, size_t ldx, int32_t *c, size_t ldc) {
+    __m256i acc[QUANT_MR_AVX2][2];
+    for (size_t i = 0; i < QUANT_MR_AVX2; ++i) {
+        acc[i][0] = _mm256_setzero_si256();
+        acc[i][1] = _mm256_setzero_si256();
+    }
+    for (size_t p = 0; p < kc; ++p) {
+        __m256i x03 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) x));
+        __m256i x47 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) &x[16]));
+        for (size_t i = 0; i < QUANT_MR_AVX2; ++i) {
+            int32_t row;
+            memcpy(&row, &w[i * 4], sizeof(row));
+            __m256i weights = _mm256_cvtepi8_epi16(_mm_set1_epi32(row));
+            acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(x03, weights));
+            acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(x47, weights));
+        }
+        w += QUANT_MR_AVX2 * 4;
+        x += ldx;
+    }
+    for (size_t i = 0; i < QUANT_MR_AVX2; ++i) {
+        __m256i sums = _mm256_hadd_epi32(acc[i][0], acc[i][1]);
+        _mm256_storeu_si256((__m256i *) &c[i * ldc], _mm256_permute4x64_epi64(sums, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+}
+
+// The packs and the shuffle work within the 128 bit lanes, so each lane interleaves 4 samples like the SSE variant
+LAMP_TARGET("avx2,fma")
+static void quantize_u8_x4_avx2(uint8_t *dst, const LAMP_FLOAT_TYPE *const rows[4],
+                                const LAMP_FLOAT_TYPE *inverse_scales, const int32_t *zero_points, size_t n) {
+    const __m256i interleave = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+                                                0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m256 low = _mm256_set1_ps(-QUANT_LIMIT);
+    const __m256 high = _mm256_set1_ps(QUANT_LIMIT);
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256 inverse = _mm256_loadu_ps(&inverse_scales[j]);
+        __m256i zero = _mm256_loadu_si256((const __m256i *) &zero_points[j]);
+        __m256i values[4];
+        for (size_t q = 0; q < 4; ++q) {
+            __m256 value = _mm256_mul_ps(_mm256_loadu_ps(&rows[q][j]), inverse);
+            value = _mm256_min_ps(_mm256_max_ps(value, low), high);
+            values[q] = _mm256_add_epi32(_mm256_cvtps_epi32(value), zero);
+        }
+        __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(values[0], values[1]),
+                                            _mm256_packs_epi32(values[2], values[3]));
+        _mm256_storeu_si256((__m256i *) &dst[j * 4], _mm256_shuffle_epi8(bytes, interleave));
+    }
+    const LAMP_FLOAT_TYPE *tail[4] = {&rows[0][j], &rows[1][j], &rows[2][j], &rows[3][j]};
+    quantize_u8_x4_scalar(&dst[j * 4], tail, &inverse_scales[j], &zero_points[j], n - j);
+}
+
+// The optimizer updates do not use FMA, so they round exactly like the scalar code
+LAMP_TARGET("avx2,fma")
+static void sgd_momentum_avx2(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *velocity,
+                              LAMP_FLOAT_TYPE learning_rate, LAMP_FLOAT_TYPE momentum, size_t n) {
+    __m256 lr = _mm256_set1_ps(learning_rate);
+    __m256 mu = _mm256_set1_ps(momentum);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 vel = _mm256_add_ps(_mm256_mul_ps(mu, _mm256_loadu_ps(&velocity[i])), _mm256_loadu_ps(&grads[i]));
+        _mm256_storeu_ps(&velocity[i], vel);
+        _mm256_storeu_ps(&params[i], _mm256_sub_ps(_mm256_loadu_ps(&params[i]), _mm256_mul_ps(lr, vel)));
+    }
+    sgd_momentum_scalar(&params[i], &grads[i], &velocity[i], learning_rate, momentum, n - i);
+}
+
+LAMP_TARGET("avx2,fma")
+static void adam_avx2(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *m, LAMP_FLOAT_TYPE *v,
+                      const LampAdamCoefficients *c, size_t n) {
+    __m256 beta1 = _mm256_set1_ps(c->beta1);
+    __m256 beta2 = _mm256_set1_ps(c->beta2);
+    __m256 one_minus_beta1 = _mm256_set1_ps(1.0f - c->beta1);
+    __m256 one_minus_beta2 = _mm256_set1_ps(1.0f - c->beta2);
+    __m256 step_size = _mm256_set1_ps(c->step_size);
+    __m256 epsilon = _mm256_set1_ps(c->epsilon);
+    __m256 decay = _mm256_set1_ps(c->decay);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 g = _mm256_loadu_ps(&grads[i]);
+        __m256 m_new = _mm256_add_ps(_mm256_mul_ps(beta1, _mm256_loadu_ps(&m[i])), _mm256_mul_ps(one_minus_beta1, g));
+        __m256 v_new = _mm256_add_ps(_mm256_mul_ps(beta2, _mm256_loadu_ps(&v[i])),
+                                     _mm256_mul_ps(_mm256_mul_ps(one_minus_beta2, g), g));
+        __m256 update = _mm256_div_ps(_mm256_mul_ps(step_size, m_new), _mm256_add_ps(_mm256_sqrt_ps(v_new), epsilon));
+        _mm256_storeu_ps(&m[i], m_new);
+        _mm256_storeu_ps(&v[i], v_new);
+        _mm256_storeu_ps(&params[i], _mm256_sub_ps(_mm256_mul_ps(decay, _mm256_loadu_ps(&params[i])), update));
+    }
+    adam_scalar(&params[i], &grads[i], &m[i], &v[i], c, n - i);
+}
+
+static const LampSimdKernels kernels_avx2 = {
+        .name = "avx2",
+        .fill = fill_avx2,
+        .add = add_avx2,
+        .exp = exp_avx2,
+        .sigmoid = sigmoid_avx2,
+        .leaky_relu = leaky_relu_avx2,
+        .tanh = tanh_avx2,
+        .gelu = gelu_avx2,
+        .sigmoid_backward = sigmoid_backward_avx2,
+        .leaky_relu_backward = leaky_relu_backward_avx2,
+        .tanh_backward = tanh_backward_avx2,
+        .gelu_backward = gelu_backward_avx2,
+        .all_close = all_close_avx2,
+        .fp16_from_float = fp16_from_float_avx2,
+        .float_from_fp16 = float_from_fp16_avx2,
+        .bf16_from_float = bf16_from_float_avx2,
+        .float_from_bf16 = float_from_bf16_avx2,
+        .gemm_mr = GEMM_MR_AVX2,
+        .gemm_nr = GEMM_NR_AVX2,
+        .gemm_tile = gemm_tile_avx2,
+        .quant_mr = QUANT_MR_AVX2,
+        .quant_nr = QUANT_NR_AVX2,
+        .quant_tile = quant_tile_avx2,
+        .quantize_u8_x4 = quantize_u8_x4_avx2,
+        .sparse_nr = SPARSE_NR_AVX2,
+        .sparse_row = sparse_row_avx2,
+        .sgd_momentum = sgd_momentum_avx2,
+        .adam = adam_avx2,
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// AVX-512 (F + BW) variant - 16 floats per vector. The remaining elements are handled with masked loads and stores.
+// ---------------------------------------------------------------------------------------------------------------------
+
+LAMP_TARGET("avx512f")
+static inline __mmask16 tail_mask_avx512(size_t remaining) {
+    return (__mmask16) ((1u << remaining) - 1u);
+}
+
+LAMP_TARGET("avx512f")
+static inline __m512 exp_ps_avx512(__m512 x) {
+    x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(EXP_LO)), _mm512_set1_ps(EXP_HI));
+    __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(EXP_LOG2E)),
+                                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(EXP_LN2_HI), x);
+    r = _mm512_fnmadd_ps(n, _mm512_set1_ps(EXP_LN2_LO), r);
+
+    __m512 p = _mm512_set1_ps(EXP_P0);
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(EXP_P1));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(EXP_P2));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(EXP_P3));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(EXP_P4));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(EXP_P5));
+    __m512 y = _mm512_add_ps(_mm512_fmadd_ps(p, _mm512_mul_ps(r, r), r), _mm512_set1_ps(1.0f));
+
+    __m512i e = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23);
+    return _mm512_mul_ps(y, _mm512_castsi512_ps(e));
+}
+
+LAMP_TARGET("avx512f")
+static inline __m512 sigmoid_ps_avx512(__m512 x) {
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 e = exp_ps_avx512(_mm512_sub_ps(_mm512_setzero_ps(), x));
+    return _mm512_div_ps(one, _mm512_add_ps(one, e));
+}
+
+LAMP_TARGET("avx512f")
+static inline __m512 tanh_ps_avx512(__m512 x) {
+    __m512 s = sigmoid_ps_avx512(_mm512_add_ps(x, x));
+    __m512 large = _mm512_sub_ps(_mm512_add_ps(s, s), _mm512_set1_ps(1.0f));
+
+    __m512 z = _mm512_mul_ps(x, x);
+    __m512 p = _mm512_set1_ps(TANH_P0);
+    p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(TANH_P1));
+    p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(TANH_P2));
+    p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(TANH_P3));
+    p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(TANH_P4));
+    __m512 small = _mm512_fmadd_ps(_mm512_mul_ps(p, z), x, x);
+
+    __mmask16 is_small = _mm512_cmp_ps_mask(_mm512_abs_ps(x), _mm512_set1_ps(TANH_SMALL), _CMP_LT_OQ);
+    return _mm512_mask_blend_ps(is_small, large, small);
+}
+
+LAMP_TARGET("avx512f")
+static inline __m512 gelu_sigmoid_ps_avx512(__m512 x) {
+    __m512 x3 = _mm512_mul_ps(_mm512_mul_ps(x, x), x);
+    __m512 u = _mm512_mul_ps(_mm512_set1_ps(GELU_K), _mm512_fmadd_ps(_mm512_set1_ps(GELU_C), x3, x));
+    return sigmoid_ps_avx512(u);
+}
+
+LAMP_TARGET("avx512f")
+static inline __m512 gelu_ps_avx512(__m512 x) {
+    return _mm512_mul_ps(x, gelu_sigmoid_ps_avx512(x));
+}
+
+LAMP_TARGET("avx512f")
+static inline __m512 leaky_relu_ps_avx512(__m512 x, __m512 alpha) {
+    __mmask16 negative = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_LE_OQ);
+    return _mm512_mask_mul_ps(x, negative, x, alpha);
+}
+
+LAMP_TARGET("avx512f")
+static inline __m512 leaky_relu_grad_ps_avx512(__m512 y, __m512 alpha) {
+    __mmask16 positive = _mm512_cmp_ps_mask(y, _mm512_setzero_ps(), _CMP_GT_OQ);
+    return _mm512_mask_blend_ps(positive, alpha, _mm512_set1_ps(1.0f));
+}
+
+LAMP_TARGET("avx512f")
+static inline __m512 gelu_grad_ps_avx512(__m512 x) {
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 s = gelu_sigmoid_ps_avx512(x);
+    __m512 du = _mm512_mul_ps(_mm512_set1_ps(GELU_K), _mm512_fmadd_ps(_mm512_set1_ps(3.0f * GELU_C),
+                                                                     _mm512_mul_ps(x, x), one));
+    return _mm512_fmadd_ps(_mm512_mul_ps(x, _mm512_mul_ps(s, _mm512_sub_ps(one, s))), du, s);
+}
+
+LAMP_TARGET("avx512f")
+static void fill_avx512(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE value, size_t n) {
+    __m512 v = _mm512_set1_ps(value);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(&dst[i], v);
+    }
+    if (i < n) {
+        _mm512_mask_storeu_ps(&dst[i], tail_mask_avx512(n - i), v);
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void add_avx512(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(&dst[i], _mm512_add_ps(_mm512_loadu_ps(&dst[i]), _mm512_loadu_ps(&src[i])));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 sum = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, &dst[i]), _mm512_maskz_loadu_ps(mask, &src[i]));
+        _mm512_mask_storeu_ps(&dst[i], mask, sum);
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void exp_avx512(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(&dst[i], exp_ps_avx512(_mm512_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        _mm512_mask_storeu_ps(&dst[i], mask, exp_ps_avx512(_mm512_maskz_loadu_ps(mask, &dst[i])));
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void sigmoid_avx512(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(&dst[i], sigmoid_ps_avx512(_mm512_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        _mm512_mask_storeu_ps(&dst[i], mask, sigmoid_ps_avx512(_mm512_maskz_loadu_ps(mask, &dst[i])));
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void leaky_relu_avx512(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE alpha, size_t n) {
+    __m512 a = _mm512_set1_ps(alpha);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(&dst[i], leaky_relu_ps_avx512(_mm512_loadu_ps(&dst[i]), a));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        _mm512_mask_storeu_ps(&dst[i], mask, leaky_relu_ps_avx512(_mm512_maskz_loadu_ps(mask, &dst[i]), a));
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void tanh_avx512(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(&dst[i], tanh_ps_avx512(_mm512_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        _mm512_mask_storeu_ps(&dst[i], mask, tanh_ps_avx512(_mm512_maskz_loadu_ps(mask, &dst[i])));
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void gelu_avx512(LAMP_FLOAT_TYPE *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(&dst[i], gelu_ps_avx512(_mm512_loadu_ps(&dst[i])));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        _mm512_mask_storeu_ps(&dst[i], mask, gelu_ps_avx512(_mm512_maskz_loadu_ps(mask, &dst[i])));
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void sigmoid_backward_avx512(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n) {
+    __m512 one = _mm512_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(&y[i]);
+        __m512 grad = _mm512_mul_ps(v, _mm512_sub_ps(one, v));
+        _mm512_storeu_ps(&dst[i], _mm512_mul_ps(_mm512_loadu_ps(&dst[i]), grad));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 v = _mm512_maskz_loadu_ps(mask, &y[i]);
+        __m512 grad = _mm512_mul_ps(v, _mm512_sub_ps(one, v));
+        _mm512_mask_storeu_ps(&dst[i], mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, &dst[i]), grad));
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void leaky_relu_backward_avx512(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, LAMP_FLOAT_TYPE alpha,
+                                       size_t n) {
+    __m512 a = _mm512_set1_ps(alpha);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(&y[i]);
+        __m512 grad = leaky_relu_grad_ps_avx512(v, a);
+        _mm512_storeu_ps(&dst[i], _mm512_mul_ps(_mm512_loadu_ps(&dst[i]), grad));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 v = _mm512_maskz_loadu_ps(mask, &y[i]);
+        __m512 grad = leaky_relu_grad_ps_avx512(v, a);
+        _mm512_mask_storeu_ps(&dst[i], mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, &dst[i]), grad));
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void tanh_backward_avx512(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n) {
+    __m512 one = _mm512_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(&y[i]);
+        __m512 grad = _mm512_fnmadd_ps(v, v, one);
+        _mm512_storeu_ps(&dst[i], _mm512_mul_ps(_mm512_loadu_ps(&dst[i]), grad));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 v = _mm512_maskz_loadu_ps(mask, &y[i]);
+        __m512 grad = _mm512_fnmadd_ps(v, v, one);
+        _mm512_mask_storeu_ps(&dst[i], mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, &dst[i]), grad));
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void gelu_backward_avx512(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *x, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(&x[i]);
+        __m512 grad = gelu_grad_ps_avx512(v);
+        _mm512_storeu_ps(&dst[i], _mm512_mul_ps(_mm512_loadu_ps(&dst[i]), grad));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 v = _mm512_maskz_loadu_ps(mask, &x[i]);
+        __m512 grad = gelu_grad_ps_avx512(v);
+        _mm512_mask_storeu_ps(&dst[i], mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, &dst[i]), grad));
+    }
+}
+
+LAMP_TARGET("avx512f")
+static bool all_close_avx512(const LAMP_FLOAT_TYPE *a, const LAMP_FLOAT_TYPE *b, size_t n,
+                             LAMP_FLOAT_TYPE tolerance) {
+    __m512 tol = _mm512_set1_ps(tolerance);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 diff = _mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(&a[i]), _mm512_loadu_ps(&b[i])));
+        if (_mm512_cmp_ps_mask(diff, tol, _CMP_GT_OQ) != 0) {
+            return false;
+        }
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 diff = _mm512_abs_ps(_mm512_sub_ps(_mm512_maskz_loadu_ps(mask, &a[i]),
+                                                  _mm512_maskz_loadu_ps(mask, &b[i])));
+        if (_mm512_cmp_ps_mask(diff, tol, _CMP_GT_OQ) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Masked loads and stores of 16 bit elements require AVX-512 BW, so the conversions handle the remaining
+// elements with the scalar code
+LAMP_TARGET("avx512f")
+static void fp16_from_float_avx512(LampHalf *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(&src[i]), _MM_FROUND_TO_NEAREST_INT);
+        _mm256_storeu_si256((__m256i *) &dst[i], h);
+    }
+    fp16_from_float_scalar(&dst[i], &src[i], n - i);
+}
+
+LAMP_TARGET("avx512f")
+static void float_from_fp16_avx512(LAMP_FLOAT_TYPE *dst, const LampHalf *src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(&dst[i], _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *) &src[i])));
+    }
+    float_from_fp16_scalar(&dst[i], &src[i], n - i);
+}
+
+LAMP_TARGET("avx512f")
+static void bf16_from_float_avx512(LampHalf *dst, const LAMP_FLOAT_TYPE *src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(&src[i]);
+        __m512i x = _mm512_castps_si512(v);
+        __m512i upper = _mm512_srli_epi32(x, 16);
+        __m512i bias = _mm512_add_epi32(_mm512_and_si512(upper, _mm512_set1_epi32(1)), _mm512_set1_epi32(0x7fff));
+        __m512i rounded = _mm512_srli_epi32(_mm512_add_epi32(x, bias), 16);
+        __mmask16 is_nan = _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+        rounded = _mm512_mask_or_epi32(rounded, is_nan, upper, _mm512_set1_epi32(0x40));
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm512_cvtepi32_epi16(rounded));
+    }
+    bf16_from_float_scalar(&dst[i], &src[i], n - i);
+}
+
+LAMP_TARGET("avx512f")
+static void float_from_bf16_avx512(LAMP_FLOAT_TYPE *dst, const LampHalf *src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *) &src[i]));
+        _mm512_storeu_ps(&dst[i], _mm512_castsi512_ps(_mm512_slli_epi32(x, 16)));
+    }
+    float_from_bf16_scalar(&dst[i], &src[i], n - i);
+}
+
+LAMP_TARGET("avx512f")
+static void sgd_momentum_avx512(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *velocity,
+                                LAMP_FLOAT_TYPE learning_rate, LAMP_FLOAT_TYPE momentum, size_t n) {
+    __m512 lr = _mm512_set1_ps(learning_rate);
+    __m512 mu = _mm512_set1_ps(momentum);
+    for (size_t i = 0; i < n; i += 16) {
+        __mmask16 mask = n - i >= 16 ? (__mmask16) 0xffff : tail_mask_avx512(n - i);
+        __m512 vel = _mm512_add_ps(_mm512_mul_ps(mu, _mm512_maskz_loadu_ps(mask, &velocity[i])),
+                                   _mm512_maskz_loadu_ps(mask, &grads[i]));
+        _mm512_mask_storeu_ps(&velocity[i], mask, vel);
+        __m512 p = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, &params[i]), _mm512_mul_ps(lr, vel));
+        _mm512_mask_storeu_ps(&params[i], mask, p);
+    }
+}
+
+LAMP_TARGET("avx512f")
+static void adam_avx512(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *m, LAMP_FLOAT_TYPE *v,
+                        const LampAdamCoefficients *c, size_t n) {
+    __m512 beta1 = _mm512_set1_ps(c->beta1);
+    __m512 beta2 = _mm512_set1_ps(c->beta2);
+    __m512 one_minus_beta1 = _mm512_set1_ps(1.0f - c->beta1);
+    __m512 one_minus_beta2 = _mm512_set1_ps(1.0f - c->beta2);
+    __m512 step_size = _mm512_set1_ps(c->step_size);
+    __m512 epsilon = _mm512_set1_ps(c->epsilon);
+    __m512 decay = _mm512_set1_ps(c->decay);
+    for (size_t i = 0; i < n; i += 16) {
+        __mmask16 mask = n - i >= 16 ? (__mmask16) 0xffff : tail_mask_avx512(n - i);
+        __m512 g = _mm512_maskz_loadu_ps(mask, &grads[i]);
+        __m512 m_new = _mm512_add_ps(_mm512_mul_ps(beta1, _mm512_maskz_loadu_ps(mask, &m[i])),
+                                     _mm512_mul_ps(one_minus_beta1, g));
+        __m512 v_new = _mm512_add_ps(_mm512_mul_ps(beta2, _mm512_maskz_loadu_ps(mask, &v[i])),
+                                     _mm512_mul_ps(_mm512_mul_ps(one_minus_beta2, g), g));
+        __m512 update = _mm512_div_ps(_mm512_mul_ps(step_size, m_new), _mm512_add_ps(_mm512_sqrt_ps(v_new), epsilon));
+        _mm512_mask_storeu_ps(&m[i], mask, m_new);
+        _mm512_mask_storeu_ps(&v[i], mask, v_new);
+        __m512 p = _mm512_sub_ps(_mm512_mul_ps(decay, _mm512_maskz_loadu_ps(mask, &params[i])), update);
+        _mm512_mask_storeu_ps(&params[i], mask, p);
+    }
+}
+
+// 28 accumulators of 16 floats, 2 registers for the row of B and 1 for the broadcast value of A out of the 32
+#define GEMM_MR_AVX512 14
+#define GEMM_NR_AVX512 32
+
+LAMP_TARGET("avx512f")
+static void gemm_tile_avx512(size_t kc, const LAMP_FLOAT_TYPE *restrict a, const LAMP_FLOAT_TYPE *restrict b,
+                             LAMP_FLOAT_TYPE *restrict c, size_t ldc, bool accumulate,
+                             const LAMP_FLOAT_TYPE *row_bias) {
+    __m512 acc[GEMM_MR_AVX512][2];
+    for (size_t i = 0; i < GEMM_MR_AVX512; ++i) {
+        acc[i][0] = _mm512_setzero_ps();
+        acc[i][1] = _mm512_setzero_ps();
+    }
+    for (size_t p = 0; p < kc; ++p) {
+        __m512 b0 = _mm512_loadu_ps(&b[0]);
+        __m512 b1 = _mm512_loadu_ps(&b[16]);
+        for (size_t i = 0; i < GEMM_MR_AVX512; ++i) {
+            __m512 ai = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += GEMM_MR_AVX512;
+        b += GEMM_NR_AVX512;
+    }
+
+    for (size_t i = 0; i < GEMM_MR_AVX512; ++i) {
+        LAMP_FLOAT_TYPE *c_row = &c[i * ldc];
+        __m512 bias = _mm512_set1_ps(row_bias != NULL ? row_bias[i] : 0.0f);
+        for (size_t v = 0; v < 2; ++v) {
+            __m512 result = _mm512_add_ps(acc[i][v], bias);
+            if (accumulate) {
+                result = _mm512_add_ps(result, _mm512_loadu_ps(&c_row[16 * v]));
+            }
+            _mm512_storeu_ps(&c_row[16 * v], result);
+        }
+    }
+}
+
+// Same as the SSE variant with 16 floats per vector
+#define SPARSE_NR_AVX512 64
+
+LAMP_TARGET("avx512f")
+static void sparse_row_avx512(size_t count, const LAMP_FLOAT_TYPE *values, const uint32_t *cols,
+                              const LAMP_FLOAT_TYPE *b, size_t ldb, LAMP_FLOAT_TYPE *c) {
+    __m512 acc[2][4];
+    for (size_t v = 0; v < 4; ++v) {
+        acc[0][v] = _mm512_setzero_ps();
+        acc[1][v] = _mm512_setzero_ps();
+    }
+    size_t e = 0;
+    for (; e + 2 <= count; e += 2) {
+        for (size_t u = 0; u < 2; ++u) {
+            const LAMP_FLOAT_TYPE *row = &b[cols[e + u] * ldb];
+            __m512 value = _mm512_set1_ps(values[e + u]);
+            for (size_t v = 0; v < 4; ++v) {
+                acc[u][v] = _mm512_fmadd_ps(value, _mm512_loadu_ps(&row[16 * v]), acc[u][v]);
+            }
+        }
+    }
+    if (e < count) {
+        const LAMP_FLOAT_TYPE *row = &b[cols[e] * ldb];
+        __m512 value = _mm512_set1_ps(values[e]);
+        for (size_t v = 0; v < 4; ++v) {
+            acc[0][v] = _mm512_fmadd_ps(value, _mm512_loadu_ps(&row[16 * v]), acc[0][v]);
+        }
+    }
+    for (size_t v = 0; v < 4; ++v) {
+        _mm512_storeu_ps(&c[16 * v], _mm512_add_ps(acc[0][v], acc[1][v]));
+    }
+}
+
+// Same as the AVX2 variant, with 8 samples in each register of widened activations. The two sums of every sample
+// are next to each other, so the even and the odd elements of two accumulators are added up in the end.
+#define QUANT_MR_AVX512 6
+#define QUANT_NR_AVX512 32
+
+LAMP_TARGET("avx512f,avx512bw")
+static void quant_tile_avx512(size_t kc, const int8_t *w, const uint8_t *x, size_t ldx, int32_t *c, size_t ldc) {
+    __m512i acc[QUANT_MR_AVX512][4];
+    for (size_t i = 0; i < QUANT_MR_AVX512; ++i) {
+        for (size_t v = 0; v < 4; ++v) {
+            acc[i][v] = _mm512_setzero_si512();
+        }
+    }
+    for (size_t p = 0; p < kc; ++p) {
+        __m512i inputs[4];
+        for (size_t v = 0; v < 4; ++v) {
+            inputs[v] = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *) &x[32 * v]));
+        }
+        for (size_t i = 0; i < QUANT_MR_AVX512; ++i) {
+            int32_t row;
+            memcpy(&row, &w[i * 4], sizeof(row));
+            __m512i weights = _mm512_cvtepi8_epi16(_mm256_set1_epi32(row));
+            for (size_t v = 0; v < 4; ++v) {
+                acc[i][v] = _mm512_add_epi32(acc[i][v], _mm512_madd_epi16(inputs[v], weights));
+            }
+        }
+        w += QUANT_MR_AVX512 * 4;
+        x += ldx;
+    }
+    const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    for (size_t i = 0; i < QUANT_MR_AVX512; ++i) {
+        for (size_t h = 0; h < 2; ++h) {
+            __m512i sums = _mm512_add_epi32(_mm512_permutex2var_epi32(acc[i][2 * h], even, acc[i][2 * h + 1]),
+                                            _mm512_permutex2var_epi32(acc[i][2 * h], odd, acc[i][2 * h + 1]));
+            _mm512_storeu_si512(&c[i * ldc + 16 * h], sums);
+        }
+    }
+}
+
+// Each of the four 128 bit lanes interleaves 4 samples like the SSE variant
+LAMP_TARGET("avx512f,avx512bw")
+static void quantize_u8_x4_avx512(uint8_t *dst, const LAMP_FLOAT_TYPE *const rows[4],
+                                  const LAMP_FLOAT_TYPE *inverse_scales, const int32_t *zero_points, size_t n) {
+    const __m512i interleave = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13,
+                                                                    2, 6, 10, 14, 3, 7, 11, 15));
+    const __m512 low = _mm512_set1_ps(-QUANT_LIMIT);
+    const __m512 high = _mm512_set1_ps(QUANT_LIMIT);
+    size_t j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m512 inverse = _mm512_loadu_ps(&inverse_scales[j]);
+        __m512i zero = _mm512_loadu_si512(&zero_points[j]);
+        __m512i values[4];
+        for (size_t q = 0; q < 4; ++q) {
+            __m512 value = _mm512_mul_ps(_mm512_loadu_ps(&rows[q][j]), inverse);
+            value = _mm512_min_ps(_mm512_max_ps(value, low), high);
+            values[q] = _mm512_add_epi32(_mm512_cvtps_epi32(value), zero);
+        }
+        __m512i bytes = _mm512_packus_epi16(_mm512_packs_epi32(values[0], values[1]),
+                                            _mm512_packs_epi32(values[2], values[3]));
+        _mm512_storeu_si512(&dst[j * 4], _mm512_shuffle_epi8(bytes, interleave));
+    }
+    const LAMP_FLOAT_TYPE *tail[4] = {&rows[0][j], &rows[1][j], &rows[2][j], &rows[3][j]};
+    quantize_u8_x4_scalar(&dst[j * 4], tail, &inverse_scales[j], &zero_points[j], n - j);
+}
+
+static const LampSimdKernels kernels_avx512 = {
+        .name = "avx512",
+        .fill = fill_avx512,
+        .add = add_avx512,
+        .exp = exp_avx512,
+        .sigmoid = sigmoid_avx512,
+        .leaky_relu = leaky_relu_avx512,
+        .tanh = tanh_avx512,
+        .gelu = gelu_avx512,
+        .sigmoid_backward = sigmoid_backward_avx512,
+        .leaky_relu_backward = leaky_relu_backward_avx512,
+        .tanh_backward = tanh_backward_avx512,
+        .gelu_backward = gelu_backward_avx512,
+        .all_close = all_close_avx512,
+        .fp16_from_float = fp16_from_float_avx512,
+        .float_from_fp16 = float_from_fp16_avx512,
+        .bf16_from_float = bf16_from_float_avx512,
+        .float_from_bf16 = float_from_bf16_avx512,
+        .gemm_mr = GEMM_MR_AVX512,
+        .gemm_nr = GEMM_NR_AVX512,
+        .gemm_tile = gemm_tile_avx512,
+        .quant_mr = QUANT_MR_AVX512,
+        .quant_nr = QUANT_NR_AVX512,
+        .quant_tile = quant_tile_avx512,
+        .quantize_u8_x4 = quantize_u8_x4_avx512,
+        .sparse_nr = SPARSE_NR_AVX512,
+        .sparse_row = sparse_row_avx512,
+        .sgd_momentum = sgd_momentum_avx512,
+        .adam = adam_avx512,
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// AVX-512 VNNI variant - the AVX-512 kernels with vpdpbusd for the 8 bit matrix multiplication. It multiplies
+// 64 unsigned with 64 signed bytes and adds groups of four products to 32 bit accumulators in one instruction.
+// ---------------------------------------------------------------------------------------------------------------------
+
+// 16 accumulators of 16 samples, the weights of a row are broadcast as one 32 bit value
+#define QUANT_MR_AVX512_VNNI 8
+#define QUANT_NR_AVX512_VNNI 32
+
+LAMP_TARGET("avx512f,avx512bw,avx512vnni")
+static void quant_tile_avx512_vnni(size_t kc, const int8_t *w, const uint8_t *x, size_t ldx, int32_t *c,
+                                   size_t ldc) {
+    __m512i acc[QUANT_MR_AVX512_VNNI][2];
+    for (size_t i = 0; i < QUANT_MR_AVX512_VNNI; ++i) {
+        acc[i][0] = _mm512_setzero_si512();
+        acc[i][1] = _mm512_setzero_si512();
+    }
+    for (size_t p = 0; p < kc; ++p) {
+        __m512i x0 = _mm512_loadu_si512(x);
+        __m512i x1 = _mm512_loadu_si512(&x[64]);
+        for (size_t i = 0; i < QUANT_MR_AVX512_VNNI; ++i) {
+            int32_t row;
+            memcpy(&row, &w[i * 4], sizeof(row));
+            __m512i weights = _mm512_set1_epi32(row);
+            acc[i][0] = _mm512_dpbusd_epi32(acc[i][0], x0, weights);
+            acc[i][1] = _mm512_dpbusd_epi32(acc[i][1], x1, weights);
+        }
+        w += QUANT_MR_AVX512_VNNI * 4;
+        x += ldx;
+    }
+    for (size_t i = 0; i < QUANT_MR_AVX512_VNNI; ++i) {
+        _mm512_storeu_si512(&c[i * ldc], acc[i][0]);
+        _mm512_storeu_si512(&c[i * ldc + 16], acc[i][1]);
+    }
+}
+
+static const LampSimdKernels kernels_avx512_vnni = {
+        .name = "avx512vnni",
+        .fill = fill_avx512,
+        .add = add_avx512,
+        .exp = exp_avx512,
+        .sigmoid = sigmoid_avx512,
+        .leaky_relu = leaky_relu_avx512,
+        .tanh = tanh_avx512,
+        .gelu = gelu_avx512,
+        .sigmoid_backward = sigmoid_backward_avx512,
+        .leaky_relu_backward = leaky_relu_backward_avx512,
+        .tanh_backward = tanh_backward_avx512,
+        .gelu_backward = gelu_backward_avx512,
+        .all_close = all_close_avx512,
+        .fp16_from_float = fp16_from_float_avx512,
+        .float_from_fp16 = float_from_fp16_avx512,
+        .bf16_from_float = bf16_from_float_avx512,
+        .float_from_bf16 = float_from_bf16_avx512,
+        .gemm_mr = GEMM_MR_AVX512,
+        .gemm_nr = GEMM_NR_AVX512,
+        .gemm_tile = gemm_tile_avx512,
+        .quant_mr = QUANT_MR_AVX512_VNNI,
+        .quant_nr = QUANT_NR_AVX512_VNNI,
+        .quant_tile = quant_tile_avx512_vnni,
+        .quantize_u8_x4 = quantize_u8_x4_avx512,
+        .sparse_nr = SPARSE_NR_AVX512,
+        .sparse_row = sparse_row_avx512,
+        .sgd_momentum = sgd_momentum_avx512,
+        .adam = adam_avx512,
+};
+
+#endif // LAMP_SIMD_X86
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------------------------------------------------
+
+static const char *level_names[LAMP_SIMD_LEVEL_COUNT] = {"scalar", "sse4.1", "avx2", "avx512", "avx512vnni"};
+
+static const LampSimdKernels *selected_kernels = NULL;
+
+LampSimdLevel lamp_simd_detect(void) {
+#ifdef LAMP_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vnni")) {
+        return LAMP_SIMD_AVX512_VNNI;
+    }
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return LAMP_SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) {
+        return LAMP_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return LAMP_SIMD_SSE4_1;
+    }
+#endif
+    return LAMP_SIMD_SCALAR;
+}
+
+const LampSimdKernels *lamp_simd_kernels_for(LampSimdLevel level) {
+    assert(level < LAMP_SIMD_LEVEL_COUNT);
+    if (level > lamp_simd_detect()) {
+        return NULL;
+    }
+
+    switch (level) {
+#ifdef LAMP_SIMD_X86
+        case LAMP_SIMD_AVX512_VNNI:
+            return &kernels_avx512_vnni;
+        case LAMP_SIMD_AVX512:
+            return &kernels_avx512;
+        case LAMP_SIMD_AVX2:
+            return &kernels_avx2;
+        case LAMP_SIMD_SSE4_1:
+            return &kernels_sse;
+#endif
+        default:
+            return &kernels_scalar;
+    }
+}
+
+static void select_kernels(void) {
+    LampSimdLevel level = lamp_simd_detect();
+
+    const char *requested = getenv("LAMP_SIMD");
+    if (requested != NULL) {
+        for (int i = 0; i < LAMP_SIMD_LEVEL_COUNT; ++i) {
+            if (strcmp(requested, level_names[i]) == 0 && (LampSimdLevel) i < level) {
+                level = (LampSimdLevel) i;
+            }
+        }
+    }
+
+    selected_kernels = lamp_simd_kernels_for(level);
+}
+
+#ifdef __GNUC__
+// Select the kernels before main() is entered, so there is no need to synchronize the selection later on
+__attribute__((constructor)) static void lamp_simd_init(void) {
+    select_kernels();
+}
+#endif
+
+const LampSimdKernels *lamp_simd_kernels(void) {
+    if (selected_kernels == NULL) {
+        select_kernels();
+    }
+    return selected_kernels;
+}
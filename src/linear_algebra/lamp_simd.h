@@ -0,0 +1,164 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_SIMD_H
+#define LAMP_LAMP_SIMD_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "lamp_matrix.h"
+#include "lamp_half.h"
+
+// Element-wise kernels operating on flat arrays. There are multiple implementations of every kernel
+// using different instruction set extensions. The best variant supported by the CPU is selected once
+// at startup, so the same binary can run on any x86 machine (and every other architecture using the
+// portable variant).
+
+typedef enum {
+    LAMP_SIMD_SCALAR = 0,
+    LAMP_SIMD_SSE4_1,
+    LAMP_SIMD_AVX2,
+    LAMP_SIMD_AVX512,
+    LAMP_SIMD_AVX512_VNNI,
+    LAMP_SIMD_LEVEL_COUNT
+} LampSimdLevel;
+
+// Coefficients of one Adam step, that are the same for every parameter. The bias correction of both moments
+// is folded into step_size and epsilon, so the kernel does not need to divide by it for every element.
+typedef struct {
+    LAMP_FLOAT_TYPE step_size;
+    LAMP_FLOAT_TYPE beta1;
+    LAMP_FLOAT_TYPE beta2;
+    LAMP_FLOAT_TYPE epsilon;
+    // Every parameter is multiplied with decay before the update, which implements the decoupled weight decay
+    // of AdamW. Adam uses a decay of 1.
+    LAMP_FLOAT_TYPE decay;
+} LampAdamCoefficients;
+
+typedef struct {
+    const char *name;
+
+    // dst[i] = value
+    void (*fill)(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE value, size_t n);
+
+    // dst[i] += src[i]
+    void (*add)(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *src, size_t n);
+
+    // dst[i] = exp(dst[i])
+    void (*exp)(LAMP_FLOAT_TYPE *dst, size_t n);
+
+    // dst[i] = 1 / (1 + exp(-dst[i]))
+    void (*sigmoid)(LAMP_FLOAT_TYPE *dst, size_t n);
+
+    // dst[i] = dst[i] > 0 ? dst[i] : alpha * dst[i] - an alpha of 0 results in the ReLU
+    void (*leaky_relu)(LAMP_FLOAT_TYPE *dst, LAMP_FLOAT_TYPE alpha, size_t n);
+
+    // dst[i] = tanh(dst[i])
+    void (*tanh)(LAMP_FLOAT_TYPE *dst, size_t n);
+
+    // dst[i] = gelu(dst[i]) using the tanh approximation x * sigmoid(2 * sqrt(2 / pi) * (x + 0.044715 * x^3))
+    void (*gelu)(LAMP_FLOAT_TYPE *dst, size_t n);
+
+    // The derivatives multiply the gradient in dst with the derivative of the function at every element.
+    // Where possible the derivative is expressed with the result y of the function.
+
+    // dst[i] *= y[i] * (1 - y[i])
+    void (*sigmoid_backward)(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n);
+
+    // dst[i] *= y[i] > 0 ? 1 : alpha
+    void (*leaky_relu_backward)(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, LAMP_FLOAT_TYPE alpha, size_t n);
+
+    // dst[i] *= 1 - y[i]^2
+    void (*tanh_backward)(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *y, size_t n);
+
+    // dst[i] *= gelu'(x[i]) - the GELU can not be inverted, so this needs the input x of the function
+    void (*gelu_backward)(LAMP_FLOAT_TYPE *dst, const LAMP_FLOAT_TYPE *x, size_t n);
+
+    // true if |a[i] - b[i]| <= tolerance for all elements
+    bool (*all_close)(const LAMP_FLOAT_TYPE *a, const LAMP_FLOAT_TYPE *b, size_t n, LAMP_FLOAT_TYPE tolerance);
+
+    // Conversions to and from reduced precision, bit-exact with the scalar conversions in lamp_half.h
+    void (*fp16_from_float)(LampHalf *dst, const LAMP_FLOAT_TYPE *src, size_t n);
+    void (*float_from_fp16)(LAMP_FLOAT_TYPE *dst, const LampHalf *src, size_t n);
+    void (*bf16_from_float)(LampHalf *dst, const LAMP_FLOAT_TYPE *src, size_t n);
+    void (*float_from_bf16)(LAMP_FLOAT_TYPE *dst, const LampHalf *src, size_t n);
+
+    // Register tile of the matrix multiplication (see lamp_gemm.c): a [gemm_mr, gemm_nr] tile of C is computed from
+    // kc steps of packed panels, each step holding gemm_mr values of A and gemm_nr values of B next to each other.
+    // C[i * ldc + j] = sum(a[p * gemm_mr + i] * b[p * gemm_nr + j]) + row_bias[i] - plus the previous value of C
+    // if accumulate is set. row_bias may be NULL.
+    size_t gemm_mr;
+    size_t gemm_nr;
+    void (*gemm_tile)(size_t kc, const LAMP_FLOAT_TYPE *a, const LAMP_FLOAT_TYPE *b, LAMP_FLOAT_TYPE *c, size_t ldc,
+                      bool accumulate, const LAMP_FLOAT_TYPE *row_bias);
+
+    // Register tile of the 8 bit matrix multiplication (see lamp_quant.c): a [quant_mr, quant_nr] tile of exact
+    // 32 bit sums of unsigned activations times signed weights is computed from kc steps of 4 features each.
+    // A step of the packed weights holds 4 bytes of each of the quant_mr rows, a step of the activations 4 bytes of
+    // every sample and the next step starts ldx bytes later.
+    // c[i * ldc + j] = sum(w[(p * quant_mr + i) * 4 + q] * x[p * ldx + j * 4 + q]) over all steps p and q < 4
+    size_t quant_mr;
+    size_t quant_nr;
+    void (*quant_tile)(size_t kc, const int8_t *w, const uint8_t *x, size_t ldx, int32_t *c, size_t ldc);
+
+    // Quantize n samples of 4 features, each feature is one of the rows, and interleave them like the activations
+    // of quant_tile:
+    // dst[j * 4 + q] = clamp(round(rows[q][j] * inverse_scales[j]) + zero_points[j], 0, 255)
+    // Rounds to the nearest even integer like lrintf(), so all variants give the same bytes. Products beyond 2^24
+    // (and NaN) are limited first, so they can not overflow the conversion to integers.
+    void (*quantize_u8_x4)(uint8_t *dst, const LAMP_FLOAT_TYPE *const rows[4], const LAMP_FLOAT_TYPE *inverse_scales,
+                           const int32_t *zero_points, size_t n);
+
+    // Row of the sparse matrix multiplication (see lamp_sparse.c): sparse_nr columns of a row of C are computed from
+    // the count stored elements of the row of A. Every element scales the row of B given by its column, the rows of
+    // B start ldb floats after each other and hold (at least) sparse_nr values.
+    // c[j] = sum(values[e] * b[cols[e] * ldb + j]) over all e < count
+    size_t sparse_nr;
+    void (*sparse_row)(size_t count, const LAMP_FLOAT_TYPE *values, const uint32_t *cols, const LAMP_FLOAT_TYPE *b,
+                       size_t ldb, LAMP_FLOAT_TYPE *c);
+
+    // Fused optimizer updates, reading every parameter, its gradient and its state only once.
+
+    // velocity[i] = momentum * velocity[i] + grads[i]
+    // params[i] -= learning_rate * velocity[i]
+    void (*sgd_momentum)(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *velocity,
+                         LAMP_FLOAT_TYPE learning_rate, LAMP_FLOAT_TYPE momentum, size_t n);
+
+    // m[i] = beta1 * m[i] + (1 - beta1) * grads[i]
+    // v[i] = beta2 * v[i] + (1 - beta2) * grads[i]^2
+    // params[i] = decay * params[i] - step_size * m[i] / (sqrt(v[i]) + epsilon)
+    void (*adam)(LAMP_FLOAT_TYPE *params, const LAMP_FLOAT_TYPE *grads, LAMP_FLOAT_TYPE *m, LAMP_FLOAT_TYPE *v,
+                 const LampAdamCoefficients *coefficients, size_t n);
+} LampSimdKernels;
+
+// Highest level supported by the CPU we are running on
+LampSimdLevel lamp_simd_detect(void);
+
+// Kernels of a specific level or NULL if the level is not supported by the CPU (or this build)
+const LampSimdKernels *lamp_simd_kernels_for(LampSimdLevel level);
+
+// Kernels of the selected level. The selection can be limited by setting the environment variable
+// LAMP_SIMD to one of "scalar", "sse4.1", "avx2", "avx512" or "avx512vnni".
+const LampSimdKernels *lamp_simd_kernels(void);
+
+#endif //LAMP_LAMP_SIMD_H
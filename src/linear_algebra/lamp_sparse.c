@@ -0,0 +1,341 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lamp_sparse.h"
+#include "lamp_simd.h"
+#include "../threading/lamp_threadpool.h"
+
+#define LAMP_SPARSE_ALIGNMENT 64
+
+// The panels of B (see lamp_sparse_gemm()) are packed by the calling thread into its own buffer, which grows with
+// the largest B and is reused for all multiplications. It is registered with a thread specific key, so it is
+// released once the thread exits.
+typedef struct {
+    LAMP_FLOAT_TYPE *elements;
+    size_t num_elements;
+} PackingBuffer;
+
+static _Thread_local PackingBuffer *packing_buffer = NULL;
+static pthread_key_t packing_buffer_key;
+static pthread_once_t packing_buffer_key_once = PTHREAD_ONCE_INIT;
+
+static void free_packing_buffer(void *buffer) {
+    PackingBuffer *pb = buffer;
+    free(pb->elements);
+    free(pb);
+}
+
+static void create_packing_buffer_key(void) {
+    pthread_key_create(&packing_buffer_key, free_packing_buffer);
+}
+
+static LAMP_FLOAT_TYPE *get_packing_buffer(size_t num_elements) {
+    if (packing_buffer == NULL) {
+        pthread_once(&packing_buffer_key_once, create_packing_buffer_key);
+        // TODO: Propagate memory allocation error instead of asserting here
+        packing_buffer = calloc(1, sizeof(PackingBuffer));
+        assert(packing_buffer != NULL);
+        pthread_setspecific(packing_buffer_key, packing_buffer);
+    }
+    if (packing_buffer->num_elements < num_elements) {
+        // aligned_alloc requires the size to be a multiple of the alignment
+        size_t size = num_elements * sizeof(LAMP_FLOAT_TYPE);
+        size = (size + LAMP_SPARSE_ALIGNMENT - 1) / LAMP_SPARSE_ALIGNMENT * LAMP_SPARSE_ALIGNMENT;
+        free(packing_buffer->elements);
+        // TODO: Propagate memory allocation error instead of asserting here
+        packing_buffer->elements = aligned_alloc(LAMP_SPARSE_ALIGNMENT, size);
+        assert(packing_buffer->elements != NULL);
+        packing_buffer->num_elements = num_elements;
+    }
+    return packing_buffer->elements;
+}
+
+LampSparseMatrix *lamp_sparse_mat_alloc_from_dense(const LampMatrix *src) {
+    assert(src != NULL);
+    assert(src->num_cols <= UINT32_MAX);
+
+    size_t num_nonzeros = 0;
+    for (size_t i = 0; i < LAMP_MAT_NUM_ELEMENTS(src); ++i) {
+        num_nonzeros += src->elements[i] != 0.0f;
+    }
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampSparseMatrix *mat = malloc(sizeof(LampSparseMatrix));
+    assert(mat != NULL);
+    mat->num_rows = src->num_rows;
+    mat->num_cols = src->num_cols;
+    mat->num_nonzeros = num_nonzeros;
+    mat->external = false;
+    mat->row_offsets = malloc(sizeof(size_t) * (src->num_rows + 1));
+    // Keep the allocations valid, even if there is not a single non-zero element
+    mat->col_indices = malloc(sizeof(uint32_t) * (num_nonzeros > 0 ? num_nonzeros : 1));
+    mat->values = malloc(sizeof(LAMP_FLOAT_TYPE) * (num_nonzeros > 0 ? num_nonzeros : 1));
+    assert(mat->row_offsets != NULL && mat->col_indices != NULL && mat->values != NULL);
+
+    size_t next = 0;
+    for (size_t i = 0; i < src->num_rows; ++i) {
+        mat->row_offsets[i] = next;
+        for (size_t p = 0; p < src->num_cols; ++p) {
+            LAMP_FLOAT_TYPE value = LAMP_MAT_ELEMENT_AT(src, i, p);
+            if (value != 0.0f) {
+                mat->col_indices[next] = (uint32_t) p;
+                mat->values[next] = value;
+                next++;
+            }
+        }
+    }
+    mat->row_offsets[src->num_rows] = next;
+
+    return mat;
+}
+
+LampSparseMatrix *lamp_sparse_mat_alloc_copy(const LampSparseMatrix *src) {
+    assert(src != NULL);
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampSparseMatrix *mat = malloc(sizeof(LampSparseMatrix));
+    assert(mat != NULL);
+    *mat = *src;
+    mat->external = false;
+    size_t stored = src->num_nonzeros > 0 ? src->num_nonzeros : 1;
+    mat->row_offsets = malloc(sizeof(size_t) * (src->num_rows + 1));
+    mat->col_indices = malloc(sizeof(uint32_t) * stored);
+    mat->values = malloc(sizeof(LAMP_FLOAT_TYPE) * stored);
+    assert(mat->row_offsets != NULL && mat->col_indices != NULL && mat->values != NULL);
+
+    memcpy(mat->row_offsets, src->row_offsets, sizeof(size_t) * (src->num_rows + 1));
+    memcpy(mat->col_indices, src->col_indices, sizeof(uint32_t) * src->num_nonzeros);
+    memcpy(mat->values, src->values, sizeof(LAMP_FLOAT_TYPE) * src->num_nonzeros);
+    return mat;
+}
+
+LampSparseMatrix *lamp_sparse_mat_alloc_external(size_t num_rows, size_t num_cols, size_t num_nonzeros,
+                                                 const uint64_t row_offsets[], uint32_t col_indices[],
+                                                 LAMP_FLOAT_TYPE values[]) {
+    assert(row_offsets != NULL && col_indices != NULL && values != NULL);
+
+    bool valid = row_offsets[0] == 0 && row_offsets[num_rows] == num_nonzeros;
+    for (size_t i = 0; i < num_rows && valid; ++i) {
+        valid = row_offsets[i] <= row_offsets[i + 1] && row_offsets[i + 1] <= num_nonzeros;
+        for (size_t e = (size_t) row_offsets[i]; e < row_offsets[i + 1] && valid; ++e) {
+            valid = col_indices[e] < num_cols && (e == row_offsets[i] || col_indices[e - 1] < col_indices[e]);
+        }
+    }
+    if (!valid) {
+        return NULL;
+    }
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampSparseMatrix *mat = malloc(sizeof(LampSparseMatrix));
+    assert(mat != NULL);
+    mat->num_rows = num_rows;
+    mat->num_cols = num_cols;
+    mat->num_nonzeros = num_nonzeros;
+    mat->external = true;
+    mat->row_offsets = malloc(sizeof(size_t) * (num_rows + 1));
+    assert(mat->row_offsets != NULL);
+    for (size_t i = 0; i <= num_rows; ++i) {
+        mat->row_offsets[i] = (size_t) row_offsets[i];
+    }
+    mat->col_indices = col_indices;
+    mat->values = values;
+    return mat;
+}
+
+void lamp_sparse_mat_free(LampSparseMatrix *mat) {
+    assert(mat != NULL);
+    free(mat->row_offsets);
+    if (!mat->external) {
+        free(mat->col_indices);
+        free(mat->values);
+    }
+    free(mat);
+}
+
+void lamp_sparse_mat_sync_from_dense(LampSparseMatrix *dst, LampMatrix *src) {
+    assert(dst != NULL && src != NULL);
+    assert(dst->num_rows == src->num_rows && dst->num_cols == src->num_cols);
+
+    for (size_t i = 0; i < dst->num_rows; ++i) {
+        LAMP_FLOAT_TYPE *row = &src->elements[i * src->num_cols];
+        size_t next_col = 0;
+        for (size_t e = dst->row_offsets[i]; e < dst->row_offsets[i + 1]; ++e) {
+            size_t col = dst->col_indices[e];
+            for (; next_col < col; ++next_col) {
+                if (row[next_col] != 0.0f) {
+                    row[next_col] = 0.0f;
+                }
+            }
+            dst->values[e] = row[col];
+            next_col = col + 1;
+        }
+        for (; next_col < dst->num_cols; ++next_col) {
+            if (row[next_col] != 0.0f) {
+                row[next_col] = 0.0f;
+            }
+        }
+    }
+}
+
+void lamp_sparse_mat_to_dense(LampMatrix *dst, const LampSparseMatrix *src) {
+    assert(dst != NULL && src != NULL);
+    assert(dst->num_rows == src->num_rows && dst->num_cols == src->num_cols);
+
+    memset(dst->elements, 0, sizeof(LAMP_FLOAT_TYPE) * LAMP_MAT_NUM_ELEMENTS(dst));
+    for (size_t i = 0; i < src->num_rows; ++i) {
+        for (size_t e = src->row_offsets[i]; e < src->row_offsets[i + 1]; ++e) {
+            LAMP_MAT_ELEMENT_AT(dst, i, src->col_indices[e]) = src->values[e];
+        }
+    }
+}
+
+typedef struct {
+    bool trans_b;
+    size_t n;
+    const LampSparseMatrix *a;
+    const LAMP_FLOAT_TYPE *b;
+    size_t ldb;
+    const LAMP_FLOAT_TYPE *packed;
+    LAMP_FLOAT_TYPE *c;
+    size_t ldc;
+    const LampGemmEpilogue *epilogue;
+    size_t block_size;
+} SparseGemmJob;
+
+// Panel j0 / nr of B holds the columns j0 ... j0 + nr - 1 of op(B) as [k, nr] values, the columns beyond n are zero.
+static void pack_panel(size_t k, size_t n, size_t nr, bool trans_b, const LAMP_FLOAT_TYPE *b, size_t ldb, size_t j0,
+                       LAMP_FLOAT_TYPE *restrict dst) {
+    size_t count = n - j0 < nr ? n - j0 : nr;
+    if (trans_b) {
+        // The samples are the rows of B, each one becomes a column of the panel. The panel is written row by row,
+        // while the cache lines of all samples are read one after another.
+        const LAMP_FLOAT_TYPE *samples = &b[j0 * ldb];
+        for (size_t p = 0; p < k; ++p) {
+            for (size_t j = 0; j < count; ++j) {
+                dst[p * nr + j] = samples[j * ldb + p];
+            }
+        }
+    } else {
+        for (size_t p = 0; p < k; ++p) {
+            memcpy(&dst[p * nr], &b[p * ldb + j0], sizeof(LAMP_FLOAT_TYPE) * count);
+        }
+    }
+    for (size_t p = 0; p < k && count < nr; ++p) {
+        memset(&dst[p * nr + count], 0, sizeof(LAMP_FLOAT_TYPE) * (nr - count));
+    }
+}
+
+// Every stored element of a row of A scales the row of B selected by its column, so the sparse_row kernel adds
+// scaled rows of a panel in vector registers. Full panels of an untransposed B are read in place, all others are
+// packed. All rows of the block are multiplied with one panel before moving on, so it stays in the cache.
+static void multiply_block(const SparseGemmJob *job, size_t first, size_t last) {
+    const LampSimdKernels *kernels = lamp_simd_kernels();
+    const LampSparseMatrix *a = job->a;
+    size_t nr = kernels->sparse_nr;
+    LAMP_FLOAT_TYPE tile[LAMP_SPARSE_MAX_NR];
+
+    for (size_t j0 = 0; j0 < job->n; j0 += nr) {
+        size_t count = job->n - j0 < nr ? job->n - j0 : nr;
+        bool in_place = !job->trans_b && count == nr;
+        const LAMP_FLOAT_TYPE *panel = in_place ? &job->b[j0] : &job->packed[j0 * a->num_cols];
+        size_t ld_panel = in_place ? job->ldb : nr;
+        for (size_t i = first; i < last; ++i) {
+            size_t begin = a->row_offsets[i];
+            LAMP_FLOAT_TYPE *dst = &job->c[i * job->ldc + j0];
+            LAMP_FLOAT_TYPE *row = count == nr ? dst : tile;
+            kernels->sparse_row(a->row_offsets[i + 1] - begin, &a->values[begin], &a->col_indices[begin], panel,
+                                ld_panel, row);
+            if (row != dst) {
+                memcpy(dst, row, sizeof(LAMP_FLOAT_TYPE) * count);
+            }
+        }
+    }
+
+    if (job->epilogue != NULL) {
+        for (size_t i = first; i < last; ++i) {
+            LAMP_FLOAT_TYPE *row = &job->c[i * job->ldc];
+            if (job->epilogue->row_bias != NULL) {
+                for (size_t j = 0; j < job->n; ++j) {
+                    row[j] += job->epilogue->row_bias[i];
+                }
+            }
+            if (job->epilogue->activation != NULL) {
+                job->epilogue->activation(row, job->n);
+            }
+        }
+    }
+}
+
+static void multiply_task(void *context, size_t task_index) {
+    const SparseGemmJob *job = context;
+    size_t first = task_index * job->block_size;
+    size_t last = first + job->block_size < job->a->num_rows ? first + job->block_size : job->a->num_rows;
+    multiply_block(job, first, last);
+}
+
+void lamp_sparse_gemm(bool trans_b, size_t n, const LampSparseMatrix *a, const LAMP_FLOAT_TYPE *b, size_t ldb,
+                      LAMP_FLOAT_TYPE *c, size_t ldc, const LampGemmEpilogue *epilogue) {
+    assert(a != NULL && b != NULL && c != NULL);
+
+    // op(B) is split into panels of sparse_nr columns. A transposed B is packed completely, an untransposed one
+    // only if its last panel is not full, which is then the only panel read from the packed copy.
+    size_t m = a->num_rows;
+    size_t k = a->num_cols;
+    size_t nr = lamp_simd_kernels()->sparse_nr;
+    size_t panels = (n + nr - 1) / nr;
+    SparseGemmJob job = {
+            .trans_b = trans_b, .n = n, .a = a, .b = b, .ldb = ldb, .packed = NULL, .c = c, .ldc = ldc,
+            .epilogue = epilogue,
+    };
+    if (trans_b || n % nr != 0) {
+        LAMP_FLOAT_TYPE *packed = get_packing_buffer(panels * k * nr);
+        for (size_t panel = trans_b ? 0 : n / nr; panel < panels; ++panel) {
+            pack_panel(k, n, nr, trans_b, b, ldb, panel * nr, &packed[panel * k * nr]);
+        }
+        job.packed = packed;
+    }
+
+    LampThreadPool *pool = lamp_threadpool_for_work(a->num_nonzeros * n);
+    if (pool == NULL) {
+        multiply_block(&job, 0, m);
+        return;
+    }
+
+    // A few more blocks than threads to balance rows with different numbers of non-zero elements
+    size_t num_blocks = lamp_threadpool_num_threads(pool) * 4;
+    job.block_size = (m + num_blocks - 1) / num_blocks;
+    lamp_threadpool_parallel_for(pool, (m + job.block_size - 1) / job.block_size, multiply_task, &job);
+}
+
+void lamp_sparse_mat_multiply_into(LampMatrix *dst, const LampSparseMatrix *a, const LampMatrix *b,
+                                   const LampGemmEpilogue *epilogue) {
+    assert(dst != NULL && a != NULL && b != NULL);
+    assert(a->num_cols == b->num_rows);
+    assert(dst->num_rows == a->num_rows && dst->num_cols == b->num_cols);
+    lamp_sparse_gemm(false, b->num_cols, a, b->elements, b->num_cols, dst->elements, dst->num_cols, epilogue);
+}
@@ -0,0 +1,86 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_SPARSE_H
+#define LAMP_LAMP_SPARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lamp_matrix.h"
+#include "lamp_gemm.h"
+
+// The number of columns of C computed at once depends on the vector registers and is taken from the sparse_row
+// kernel of lamp_simd_kernels(). This is the largest one of all kernels.
+#define LAMP_SPARSE_MAX_NR 64
+
+// Sparse matrix in the compressed sparse row (CSR) format, meant for pruned weights, where most elements are zero.
+// Only the non-zero elements are stored, row after row: the elements of row i are
+//     values[row_offsets[i] ... row_offsets[i + 1] - 1]
+// and col_indices holds the column of each of them (in ascending order). A multiplication only touches the
+// stored elements, so its work and memory traffic shrink with the share of zeros.
+// The col_indices and values of an external matrix belong to someone else (e.g. a mapped model file) and are not
+// freed with it.
+typedef struct {
+    size_t num_rows;
+    size_t num_cols;
+    size_t num_nonzeros;
+    size_t *row_offsets;
+    uint32_t *col_indices;
+    LAMP_FLOAT_TYPE *values;
+    bool external;
+} LampSparseMatrix;
+
+// Store the non-zero elements of src
+LampSparseMatrix *lamp_sparse_mat_alloc_from_dense(const LampMatrix *src);
+
+LampSparseMatrix *lamp_sparse_mat_alloc_copy(const LampSparseMatrix *src);
+
+// Allocate an external matrix, that points to col_indices and values without copying them. Only the row offsets
+// are copied. The arrays may come from an untrusted file, so NULL is returned if they do not describe a valid
+// matrix: the row offsets have to rise from 0 to num_nonzeros and the columns of every row have to be ascending
+// and smaller than num_cols.
+LampSparseMatrix *lamp_sparse_mat_alloc_external(size_t num_rows, size_t num_cols, size_t num_nonzeros,
+                                                 const uint64_t row_offsets[], uint32_t col_indices[],
+                                                 LAMP_FLOAT_TYPE values[]);
+
+void lamp_sparse_mat_free(LampSparseMatrix *mat);
+
+// Keep the positions of the stored elements of dst, but take their values from src. The elements of src outside
+// of these positions are set to zero, so both matrices hold the same values afterwards. Elements, that are zero
+// already, are not written, so the pages of a mapped src are only copied if something changed.
+// ATTENTION: Users must assure the dst and src matrices have the same dimensions
+void lamp_sparse_mat_sync_from_dense(LampSparseMatrix *dst, LampMatrix *src);
+
+// ATTENTION: Users must assure the dst and src matrices have the same dimensions
+void lamp_sparse_mat_to_dense(LampMatrix *dst, const LampSparseMatrix *src);
+
+// C = A * op(B) for the sparse A of size [m, k] and the dense op(B) of size [k, n], stored like the operands of
+// lamp_gemm(). The optional epilogue is applied to the rows of C like in lamp_gemm().
+void lamp_sparse_gemm(bool trans_b, size_t n, const LampSparseMatrix *a, const LAMP_FLOAT_TYPE *b, size_t ldb,
+                      LAMP_FLOAT_TYPE *c, size_t ldc, const LampGemmEpilogue *epilogue);
+
+// dst = a * b
+void lamp_sparse_mat_multiply_into(LampMatrix *dst, const LampSparseMatrix *a, const LampMatrix *b,
+                                   const LampGemmEpilogue *epilogue);
+
+#endif //LAMP_LAMP_SPARSE_H
@@ -1,8 +1,10 @@
 #include <assert.h>
 #include <stdio.h>
 #include <malloc.h>
+#include <stdlib.h>
 #include <time.h>
 #include "neural_network/lamp_nn.h"
+#include "neural_network/lamp_optimizer.h"
 
 // We create a 2x2x1 network
 // 2 inputs, 2 hidden nodes and one output
@@ -14,7 +16,7 @@
 #define NUM_OUTPUT_NODES 1
 
 #define LEARNING_RATE 1e-1f
-#define FINITE_DIFF_STEP 1e-1f
+#define MOMENTUM 0.9f
 
 int main() {
     // Try learning behavior of logic gates - because everybody does this in the beginning ;)
@@ -39,16 +41,20 @@ int main() {
         lamp_mat_rand(nn->connections[i].bias);
     }
 
-    for (int e = 0; e < 10 * 1000; ++e) {
-        lamp_nn_apply_finite_diff_gradients(nn, input, target, FINITE_DIFF_STEP, LEARNING_RATE);
+    LampOptimizerConfig config = lamp_optimizer_sgd(LEARNING_RATE, MOMENTUM);
+    LampOptimizer *optimizer = lamp_optimizer_alloc(nn, &config);
+    for (int e = 0; e < 1000; ++e) {
+        lamp_nn_backprop(nn, input, target);
+        lamp_optimizer_step(optimizer, nn);
         LAMP_FLOAT_TYPE loss = lamp_nn_loss(nn, input, target);
         printf("Loss %f\n", loss);
     }
 
+    LampMatrixView samples = lamp_mat_view(input);
+
     for (int it = 0; it < input->num_rows; ++it) {
-        LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 0, 0) = LAMP_MAT_ELEMENT_AT(input, it, 0);
-        LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 1, 0) = LAMP_MAT_ELEMENT_AT(input, it, 1);
-        lamp_nn_forward(nn);
+        LampMatrixView sample = lamp_mat_view_rows(&samples, it, 1);
+        lamp_nn_forward_view(nn, &sample);
         printf("[%f, %f] -> [%f] (%f)\n",
                LAMP_MAT_ELEMENT_AT(input, it, 0),
                LAMP_MAT_ELEMENT_AT(input, it, 1),
@@ -56,6 +62,7 @@ int main() {
                LAMP_MAT_ELEMENT_AT(target, it, 0));
     }
 
+    lamp_optimizer_free(optimizer);
     lamp_nn_free(nn);
 
     return 0;
@@ -0,0 +1,44 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_ALLOC_COUNT_H
+#define LAMP_LAMP_ALLOC_COUNT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Counter of all heap allocations of the process, to verify that the hot paths - e.g. the forward pass or a
+// training step - don't allocate anymore, once they are warmed up.
+// The linker redirects malloc, calloc, realloc and aligned_alloc to the wrappers in lamp_alloc_count.c, so
+// every allocation made by the code of the program and the library is counted without touching a single call.
+// Targets enable it by defining LAMP_COUNT_ALLOCATIONS and linking with
+// --wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=aligned_alloc (see CMakeLists.txt).
+// Otherwise the count always stays 0.
+
+// Whether allocations are counted in this build
+bool lamp_alloc_counting(void);
+
+// Number of allocations since the start of the process
+size_t lamp_alloc_count(void);
+
+#endif //LAMP_LAMP_ALLOC_COUNT_H
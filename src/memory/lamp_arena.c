@@ -0,0 +1,63 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "lamp_arena.h"
+
+LampArena *lamp_arena_alloc(size_t capacity) {
+    assert(capacity > 0);
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampArena *arena = malloc(sizeof(LampArena));
+    assert(arena != NULL);
+
+    arena->capacity = LAMP_ARENA_ALIGNED_SIZE(capacity);
+    arena->used = 0;
+    // calloc takes big blocks as fresh zero pages from the system, which only become resident once they are
+    // written, so parts of the arena, that are never used (e.g. the gradients of a network, that only infers),
+    // cost no memory. It does not align them, so the base is moved to the next aligned address.
+    arena->allocation = calloc(arena->capacity + LAMP_ARENA_ALIGNMENT, 1);
+    assert(arena->allocation != NULL);
+    uintptr_t address = (uintptr_t) arena->allocation;
+    arena->base = arena->allocation + (LAMP_ARENA_ALIGNMENT - address % LAMP_ARENA_ALIGNMENT) % LAMP_ARENA_ALIGNMENT;
+
+    return arena;
+}
+
+void lamp_arena_free(LampArena *arena) {
+    assert(arena != NULL);
+    free(arena->allocation);
+    free(arena);
+}
+
+void *lamp_arena_push(LampArena *arena, size_t size) {
+    assert(arena != NULL);
+    size_t aligned_size = LAMP_ARENA_ALIGNED_SIZE(size);
+    assert(arena->capacity - arena->used >= aligned_size);
+
+    void *ptr = arena->base + arena->used;
+    arena->used += aligned_size;
+    return ptr;
+}
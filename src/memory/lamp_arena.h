@@ -0,0 +1,56 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_ARENA_H
+#define LAMP_LAMP_ARENA_H
+
+#include <stddef.h>
+
+// A simple bump allocator on top of one contiguous block of memory.
+// Allocations are handed out one after another and can not be freed individually,
+// instead the whole arena is released at once.
+typedef struct {
+    unsigned char *allocation;
+    unsigned char *base;
+    size_t capacity;
+    size_t used;
+} LampArena;
+
+// All allocations of the arena start at a cache line boundary, which also suits every SIMD load
+#define LAMP_ARENA_ALIGNMENT 64
+
+// Size of an allocation including the padding to the next aligned allocation.
+// Useful to calculate the capacity an arena needs in advance.
+#define LAMP_ARENA_ALIGNED_SIZE(size) (((size) + LAMP_ARENA_ALIGNMENT - 1) / LAMP_ARENA_ALIGNMENT * LAMP_ARENA_ALIGNMENT)
+
+// Allocate an arena with the given capacity in bytes. The memory is zero initialized, but big arenas only take
+// physical memory for the pages, that are written.
+LampArena *lamp_arena_alloc(size_t capacity);
+
+void lamp_arena_free(LampArena *arena);
+
+// Take the next size bytes of the arena
+// ATTENTION: The arena must have enough capacity left
+void *lamp_arena_push(LampArena *arena, size_t size);
+
+#endif //LAMP_LAMP_ARENA_H
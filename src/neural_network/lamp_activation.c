@@ -0,0 +1,204 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include "lamp_activation.h"
+#include "../linear_algebra/lamp_simd.h"
+
+// The softmax works on columns, which are strided in memory. Instead of walking every column on its own,
+// we process a chunk of neighbouring columns row by row, so the element-wise kernels see contiguous values.
+#define SOFTMAX_CHUNK 64
+
+static const char *activation_names[LAMP_ACTIVATION_COUNT] = {
+        "sigmoid", "relu", "leaky_relu", "tanh", "softmax", "gelu", "linear"
+};
+
+static void sigmoid_kernel(LAMP_FLOAT_TYPE *values, size_t n) {
+    lamp_simd_kernels()->sigmoid(values, n);
+}
+
+static void relu_kernel(LAMP_FLOAT_TYPE *values, size_t n) {
+    lamp_simd_kernels()->leaky_relu(values, 0.0f, n);
+}
+
+static void leaky_relu_kernel(LAMP_FLOAT_TYPE *values, size_t n) {
+    lamp_simd_kernels()->leaky_relu(values, LAMP_LEAKY_RELU_ALPHA, n);
+}
+
+static void tanh_kernel(LAMP_FLOAT_TYPE *values, size_t n) {
+    lamp_simd_kernels()->tanh(values, n);
+}
+
+static void gelu_kernel(LAMP_FLOAT_TYPE *values, size_t n) {
+    lamp_simd_kernels()->gelu(values, n);
+}
+
+const char *lamp_activation_name(LampActivation activation) {
+    assert(activation < LAMP_ACTIVATION_COUNT);
+    return activation_names[activation];
+}
+
+LampActivationKernel lamp_activation_kernel(LampActivation activation) {
+    switch (activation) {
+        case LAMP_ACTIVATION_SIGMOID:
+            return sigmoid_kernel;
+        case LAMP_ACTIVATION_RELU:
+            return relu_kernel;
+        case LAMP_ACTIVATION_LEAKY_RELU:
+            return leaky_relu_kernel;
+        case LAMP_ACTIVATION_TANH:
+            return tanh_kernel;
+        case LAMP_ACTIVATION_GELU:
+            return gelu_kernel;
+        case LAMP_ACTIVATION_SOFTMAX:
+        case LAMP_ACTIVATION_LINEAR:
+            return NULL;
+        default:
+            assert(false && "Unknown activation");
+            return NULL;
+    }
+}
+
+bool lamp_activation_needs_input(LampActivation activation) {
+    assert(activation < LAMP_ACTIVATION_COUNT);
+    return activation == LAMP_ACTIVATION_GELU;
+}
+
+// a_i = e^(z_i - max(z)) / sum_j e^(z_j - max(z)) for every column. Subtracting the maximum keeps e^x from
+// overflowing without changing the result.
+static void softmax_forward(LampMatrix *mat) {
+    const LampSimdKernels *kernels = lamp_simd_kernels();
+    LAMP_FLOAT_TYPE column_max[SOFTMAX_CHUNK];
+    LAMP_FLOAT_TYPE column_sum[SOFTMAX_CHUNK];
+
+    for (size_t first = 0; first < mat->num_cols; first += SOFTMAX_CHUNK) {
+        size_t width = mat->num_cols - first < SOFTMAX_CHUNK ? mat->num_cols - first : SOFTMAX_CHUNK;
+
+        for (size_t j = 0; j < width; ++j) {
+            column_max[j] = LAMP_MAT_ELEMENT_AT(mat, 0, first + j);
+            column_sum[j] = 0.0f;
+        }
+        for (size_t i = 1; i < mat->num_rows; ++i) {
+            const LAMP_FLOAT_TYPE *row = &LAMP_MAT_ELEMENT_AT(mat, i, first);
+            for (size_t j = 0; j < width; ++j) {
+                column_max[j] = row[j] > column_max[j] ? row[j] : column_max[j];
+            }
+        }
+
+        for (size_t i = 0; i < mat->num_rows; ++i) {
+            LAMP_FLOAT_TYPE *row = &LAMP_MAT_ELEMENT_AT(mat, i, first);
+            for (size_t j = 0; j < width; ++j) {
+                row[j] -= column_max[j];
+            }
+            kernels->exp(row, width);
+            for (size_t j = 0; j < width; ++j) {
+                column_sum[j] += row[j];
+            }
+        }
+
+        for (size_t j = 0; j < width; ++j) {
+            column_sum[j] = 1.0f / column_sum[j];
+        }
+        for (size_t i = 0; i < mat->num_rows; ++i) {
+            LAMP_FLOAT_TYPE *row = &LAMP_MAT_ELEMENT_AT(mat, i, first);
+            for (size_t j = 0; j < width; ++j) {
+                row[j] *= column_sum[j];
+            }
+        }
+    }
+}
+
+// Every output of the softmax depends on every input of its column, so the Jacobian is not diagonal:
+// dL/dz_i = a_i * (dL/da_i - sum_j a_j * dL/da_j)
+static void softmax_backward(LampMatrix *deltas, const LampMatrix *outputs) {
+    LAMP_FLOAT_TYPE column_dot[SOFTMAX_CHUNK];
+
+    for (size_t first = 0; first < deltas->num_cols; first += SOFTMAX_CHUNK) {
+        size_t width = deltas->num_cols - first < SOFTMAX_CHUNK ? deltas->num_cols - first : SOFTMAX_CHUNK;
+
+        for (size_t j = 0; j < width; ++j) {
+            column_dot[j] = 0.0f;
+        }
+        for (size_t i = 0; i < deltas->num_rows; ++i) {
+            const LAMP_FLOAT_TYPE *d = &LAMP_MAT_ELEMENT_AT(deltas, i, first);
+            const LAMP_FLOAT_TYPE *a = &LAMP_MAT_ELEMENT_AT(outputs, i, first);
+            for (size_t j = 0; j < width; ++j) {
+                column_dot[j] += a[j] * d[j];
+            }
+        }
+
+        for (size_t i = 0; i < deltas->num_rows; ++i) {
+            LAMP_FLOAT_TYPE *d = &LAMP_MAT_ELEMENT_AT(deltas, i, first);
+            const LAMP_FLOAT_TYPE *a = &LAMP_MAT_ELEMENT_AT(outputs, i, first);
+            for (size_t j = 0; j < width; ++j) {
+                d[j] = a[j] * (d[j] - column_dot[j]);
+            }
+        }
+    }
+}
+
+void lamp_activation_forward(LampActivation activation, LampMatrix *mat) {
+    assert(mat != NULL);
+    if (activation == LAMP_ACTIVATION_SOFTMAX) {
+        softmax_forward(mat);
+        return;
+    }
+    if (activation == LAMP_ACTIVATION_LINEAR) {
+        return;
+    }
+    lamp_activation_kernel(activation)(mat->elements, LAMP_MAT_NUM_ELEMENTS(mat));
+}
+
+void lamp_activation_backward(LampActivation activation, LampMatrix *deltas, const LampMatrix *outputs,
+                              const LampMatrix *inputs) {
+    assert(deltas != NULL && outputs != NULL);
+    assert(deltas->num_rows == outputs->num_rows && deltas->num_cols == outputs->num_cols);
+
+    const LampSimdKernels *kernels = lamp_simd_kernels();
+    size_t n = LAMP_MAT_NUM_ELEMENTS(deltas);
+    switch (activation) {
+        case LAMP_ACTIVATION_SIGMOID:
+            kernels->sigmoid_backward(deltas->elements, outputs->elements, n);
+            break;
+        case LAMP_ACTIVATION_RELU:
+            kernels->leaky_relu_backward(deltas->elements, outputs->elements, 0.0f, n);
+            break;
+        case LAMP_ACTIVATION_LEAKY_RELU:
+            kernels->leaky_relu_backward(deltas->elements, outputs->elements, LAMP_LEAKY_RELU_ALPHA, n);
+            break;
+        case LAMP_ACTIVATION_TANH:
+            kernels->tanh_backward(deltas->elements, outputs->elements, n);
+            break;
+        case LAMP_ACTIVATION_SOFTMAX:
+            softmax_backward(deltas, outputs);
+            break;
+        case LAMP_ACTIVATION_GELU:
+            assert(inputs != NULL && LAMP_MAT_NUM_ELEMENTS(inputs) == n);
+            kernels->gelu_backward(deltas->elements, inputs->elements, n);
+            break;
+        case LAMP_ACTIVATION_LINEAR:
+            break;
+        default:
+            assert(false && "Unknown activation");
+    }
+}
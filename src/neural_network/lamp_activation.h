@@ -0,0 +1,71 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_ACTIVATION_H
+#define LAMP_LAMP_ACTIVATION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../linear_algebra/lamp_matrix.h"
+
+// Activation functions, that turn the weighted input z of a layer into its activations a = f(z).
+// Every connection of a network chooses its own activation. They all work in place on matrices of
+// [neurons, batch size], so one column holds the values of one sample.
+typedef enum {
+    LAMP_ACTIVATION_SIGMOID = 0, // Default of a freshly allocated network
+    LAMP_ACTIVATION_RELU,
+    LAMP_ACTIVATION_LEAKY_RELU,
+    LAMP_ACTIVATION_TANH,
+    LAMP_ACTIVATION_SOFTMAX,     // Normalizes every column (sample) to a probability distribution
+    LAMP_ACTIVATION_GELU,
+    LAMP_ACTIVATION_LINEAR,      // Keeps the weighted input as it is, e.g. for pooling
+    LAMP_ACTIVATION_COUNT
+} LampActivation;
+
+// Slope of the leaky ReLU for negative inputs
+#define LAMP_LEAKY_RELU_ALPHA 0.01f
+
+// Applies an element-wise activation to n contiguous values in place
+typedef void (*LampActivationKernel)(LAMP_FLOAT_TYPE *values, size_t n);
+
+const char *lamp_activation_name(LampActivation activation);
+
+// Element-wise kernel of the activation, e.g. for the epilogue of a fused matrix multiplication.
+// NULL for the softmax, which needs the whole column and can't be applied to single elements, and for the linear
+// activation, which has nothing to do.
+LampActivationKernel lamp_activation_kernel(LampActivation activation);
+
+// True if the derivative has to be calculated from the weighted input z instead of the activations a.
+// This is the case for the GELU, which can not be inverted.
+bool lamp_activation_needs_input(LampActivation activation);
+
+// a = f(a) for every element (or column for the softmax) of mat
+void lamp_activation_forward(LampActivation activation, LampMatrix *mat);
+
+// Turn the derivative of the loss with respect to the activations (dL/da) stored in deltas into the derivative
+// with respect to the weighted input (dL/dz). outputs holds the activations a of the forward pass, inputs the
+// weighted input z. inputs is only read if lamp_activation_needs_input() is true and may be NULL otherwise.
+void lamp_activation_backward(LampActivation activation, LampMatrix *deltas, const LampMatrix *outputs,
+                              const LampMatrix *inputs);
+
+#endif //LAMP_LAMP_ACTIVATION_H
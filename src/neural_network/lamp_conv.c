@@ -0,0 +1,399 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <string.h>
+#include "lamp_conv.h"
+#include "../threading/lamp_threadpool.h"
+
+size_t lamp_conv2d_out_height(const LampConv2dShape *shape) {
+    assert(shape != NULL && shape->stride >= 1);
+    assert(shape->in_height + 2 * shape->padding >= shape->kernel_size);
+    return (shape->in_height + 2 * shape->padding - shape->kernel_size) / shape->stride + 1;
+}
+
+size_t lamp_conv2d_out_width(const LampConv2dShape *shape) {
+    assert(shape != NULL && shape->stride >= 1);
+    assert(shape->in_width + 2 * shape->padding >= shape->kernel_size);
+    return (shape->in_width + 2 * shape->padding - shape->kernel_size) / shape->stride + 1;
+}
+
+size_t lamp_conv2d_workspace_size(const LampConv2dShape *shape, size_t batch) {
+    return shape->in_channels * shape->kernel_size * shape->kernel_size *
+           lamp_conv2d_out_height(shape) * lamp_conv2d_out_width(shape) * batch;
+}
+
+// Position of kernel element k in the input for output position o along one axis. Returns false if it falls
+// into the padding.
+static bool input_position(const LampConv2dShape *shape, size_t o, size_t k, size_t size, size_t *position) {
+    size_t padded = o * shape->stride + k;
+    if (padded < shape->padding || padded - shape->padding >= size) {
+        return false;
+    }
+    *position = padded - shape->padding;
+    return true;
+}
+
+// Neuron of pixel (y, x) of channel c
+static size_t input_neuron(const LampConv2dShape *shape, size_t c, size_t y, size_t x) {
+    return (c * shape->in_height + y) * shape->in_width + x;
+}
+
+// Row (c, ky, kx) of the column matrix holds input pixel (y + ky, x + kx) of channel c for every output pixel
+// (y, x), each as batch consecutive samples. The rows have the layout of an output channel, so the product of
+// the weights with it is the output already.
+static void im2col(const LampConv2dShape *shape, size_t batch, const LampConvInput *input, LAMP_FLOAT_TYPE *cols) {
+    size_t k = shape->kernel_size;
+    size_t out_height = lamp_conv2d_out_height(shape);
+    size_t out_width = lamp_conv2d_out_width(shape);
+    size_t row_length = out_height * out_width * batch;
+
+    for (size_t c = 0; c < shape->in_channels; ++c) {
+        for (size_t ky = 0; ky < k; ++ky) {
+            for (size_t kx = 0; kx < k; ++kx) {
+                LAMP_FLOAT_TYPE *row = &cols[((c * k + ky) * k + kx) * row_length];
+                for (size_t oy = 0; oy < out_height; ++oy) {
+                    size_t y, x;
+                    bool y_valid = input_position(shape, oy, ky, shape->in_height, &y);
+                    for (size_t ox = 0; ox < out_width; ++ox) {
+                        LAMP_FLOAT_TYPE *dst = &row[(oy * out_width + ox) * batch];
+                        if (!y_valid || !input_position(shape, ox, kx, shape->in_width, &x)) {
+                            memset(dst, 0, sizeof(LAMP_FLOAT_TYPE) * batch);
+                            continue;
+                        }
+                        const LAMP_FLOAT_TYPE *src = &input->elements[input_neuron(shape, c, y, x) *
+                                                                      input->neuron_stride];
+                        if (input->sample_stride == 1) {
+                            memcpy(dst, src, sizeof(LAMP_FLOAT_TYPE) * batch);
+                        } else {
+                            for (size_t s = 0; s < batch; ++s) {
+                                dst[s] = src[s * input->sample_stride];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Inverse of im2col: every element of the columns is added to the input pixel it was copied from
+static void col2im(const LampConv2dShape *shape, size_t batch, const LAMP_FLOAT_TYPE *cols,
+                   LAMP_FLOAT_TYPE *input_deltas) {
+    size_t k = shape->kernel_size;
+    size_t out_height = lamp_conv2d_out_height(shape);
+    size_t out_width = lamp_conv2d_out_width(shape);
+    size_t row_length = out_height * out_width * batch;
+
+    memset(input_deltas, 0, sizeof(LAMP_FLOAT_TYPE) * shape->in_channels * shape->in_height * shape->in_width * batch);
+    for (size_t c = 0; c < shape->in_channels; ++c) {
+        for (size_t ky = 0; ky < k; ++ky) {
+            for (size_t kx = 0; kx < k; ++kx) {
+                const LAMP_FLOAT_TYPE *row = &cols[((c * k + ky) * k + kx) * row_length];
+                for (size_t oy = 0; oy < out_height; ++oy) {
+                    size_t y, x;
+                    if (!input_position(shape, oy, ky, shape->in_height, &y)) {
+                        continue;
+                    }
+                    for (size_t ox = 0; ox < out_width; ++ox) {
+                        if (!input_position(shape, ox, kx, shape->in_width, &x)) {
+                            continue;
+                        }
+                        const LAMP_FLOAT_TYPE *restrict src = &row[(oy * out_width + ox) * batch];
+                        LAMP_FLOAT_TYPE *restrict dst = &input_deltas[input_neuron(shape, c, y, x) * batch];
+                        for (size_t s = 0; s < batch; ++s) {
+                            dst[s] += src[s];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void apply_epilogue(const LampGemmEpilogue *epilogue, LAMP_FLOAT_TYPE *plane, size_t n, size_t channel) {
+    if (epilogue == NULL) {
+        return;
+    }
+    if (epilogue->row_bias != NULL) {
+        for (size_t i = 0; i < n; ++i) {
+            plane[i] += epilogue->row_bias[channel];
+        }
+    }
+    if (epilogue->activation != NULL) {
+        epilogue->activation(plane, n);
+    }
+}
+
+typedef struct {
+    const LampConv2dShape *shape;
+    size_t batch;
+    const LampConvInput *input;
+    const LAMP_FLOAT_TYPE *weights;
+    LAMP_FLOAT_TYPE *output;
+    const LampGemmEpilogue *epilogue;
+} DirectConvJob;
+
+// Every weight adds the input pixels it touches, scaled by itself, to the output channel. The output channel
+// (all pixels of all samples) stays in the cache while all input channels are added to it.
+static void direct_forward_task(void *context, size_t out_channel) {
+    const DirectConvJob *job = context;
+    const LampConv2dShape *shape = job->shape;
+    size_t k = shape->kernel_size;
+    size_t depth = shape->in_channels * k * k;
+    size_t out_height = lamp_conv2d_out_height(shape);
+    size_t out_width = lamp_conv2d_out_width(shape);
+    size_t plane_size = out_height * out_width * job->batch;
+    size_t sample_stride = job->input->sample_stride;
+    LAMP_FLOAT_TYPE *plane = &job->output[out_channel * plane_size];
+
+    memset(plane, 0, sizeof(LAMP_FLOAT_TYPE) * plane_size);
+    for (size_t c = 0; c < shape->in_channels; ++c) {
+        for (size_t ky = 0; ky < k; ++ky) {
+            for (size_t kx = 0; kx < k; ++kx) {
+                LAMP_FLOAT_TYPE weight = job->weights[out_channel * depth + (c * k + ky) * k + kx];
+                for (size_t oy = 0; oy < out_height; ++oy) {
+                    size_t y, x;
+                    if (!input_position(shape, oy, ky, shape->in_height, &y)) {
+                        continue;
+                    }
+                    for (size_t ox = 0; ox < out_width; ++ox) {
+                        if (!input_position(shape, ox, kx, shape->in_width, &x)) {
+                            continue;
+                        }
+                        LAMP_FLOAT_TYPE *restrict dst = &plane[(oy * out_width + ox) * job->batch];
+                        const LAMP_FLOAT_TYPE *restrict src = &job->input->elements[input_neuron(shape, c, y, x) *
+                                                                                    job->input->neuron_stride];
+                        if (sample_stride == 1) {
+                            for (size_t s = 0; s < job->batch; ++s) {
+                                dst[s] += weight * src[s];
+                            }
+                        } else {
+                            for (size_t s = 0; s < job->batch; ++s) {
+                                dst[s] += weight * src[s * sample_stride];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    apply_epilogue(job->epilogue, plane, plane_size, out_channel);
+}
+
+void lamp_conv2d_forward(LampConvAlgorithm algorithm, const LampConv2dShape *shape, size_t batch,
+                         const LampConvInput *input, const LAMP_FLOAT_TYPE *weights, LAMP_FLOAT_TYPE *output,
+                         LAMP_FLOAT_TYPE *workspace, const LampGemmEpilogue *epilogue) {
+    assert(shape != NULL && input != NULL && weights != NULL && output != NULL);
+
+    size_t depth = shape->in_channels * shape->kernel_size * shape->kernel_size;
+    size_t n = lamp_conv2d_out_height(shape) * lamp_conv2d_out_width(shape) * batch;
+    if (algorithm == LAMP_CONV_IM2COL) {
+        assert(workspace != NULL);
+        im2col(shape, batch, input, workspace);
+        lamp_gemm(false, false, shape->out_channels, n, depth, weights, depth, workspace, n, output, n, false,
+                  epilogue);
+        return;
+    }
+
+    DirectConvJob job = {
+            .shape = shape, .batch = batch, .input = input, .weights = weights, .output = output, .epilogue = epilogue
+    };
+    LampThreadPool *pool = lamp_threadpool_for_work(shape->out_channels * depth * n);
+    lamp_threadpool_parallel_for(pool, shape->out_channels, direct_forward_task, &job);
+}
+
+// Mirrors direct_forward_task(): every weight collects the products of the deltas with the input pixels it
+// touched and passes the deltas scaled by itself back to these pixels
+static void direct_backward(const LampConv2dShape *shape, size_t batch, const LampConvInput *input,
+                            const LAMP_FLOAT_TYPE *weights, const LAMP_FLOAT_TYPE *deltas,
+                            LAMP_FLOAT_TYPE *weights_grad, LAMP_FLOAT_TYPE *input_deltas) {
+    size_t k = shape->kernel_size;
+    size_t depth = shape->in_channels * k * k;
+    size_t out_height = lamp_conv2d_out_height(shape);
+    size_t out_width = lamp_conv2d_out_width(shape);
+    size_t plane_size = out_height * out_width * batch;
+    size_t sample_stride = input->sample_stride;
+
+    if (input_deltas != NULL) {
+        memset(input_deltas, 0,
+               sizeof(LAMP_FLOAT_TYPE) * shape->in_channels * shape->in_height * shape->in_width * batch);
+    }
+    for (size_t oc = 0; oc < shape->out_channels; ++oc) {
+        const LAMP_FLOAT_TYPE *plane = &deltas[oc * plane_size];
+        for (size_t c = 0; c < shape->in_channels; ++c) {
+            for (size_t ky = 0; ky < k; ++ky) {
+                for (size_t kx = 0; kx < k; ++kx) {
+                    size_t w = oc * depth + (c * k + ky) * k + kx;
+                    LAMP_FLOAT_TYPE grad = 0.0f;
+                    for (size_t oy = 0; oy < out_height; ++oy) {
+                        size_t y, x;
+                        if (!input_position(shape, oy, ky, shape->in_height, &y)) {
+                            continue;
+                        }
+                        for (size_t ox = 0; ox < out_width; ++ox) {
+                            if (!input_position(shape, ox, kx, shape->in_width, &x)) {
+                                continue;
+                            }
+                            const LAMP_FLOAT_TYPE *d = &plane[(oy * out_width + ox) * batch];
+                            size_t neuron = input_neuron(shape, c, y, x);
+                            const LAMP_FLOAT_TYPE *src = &input->elements[neuron * input->neuron_stride];
+                            for (size_t s = 0; s < batch; ++s) {
+                                grad += d[s] * src[s * sample_stride];
+                            }
+                            if (input_deltas != NULL) {
+                                LAMP_FLOAT_TYPE *restrict dst = &input_deltas[neuron * batch];
+                                for (size_t s = 0; s < batch; ++s) {
+                                    dst[s] += weights[w] * d[s];
+                                }
+                            }
+                        }
+                    }
+                    weights_grad[w] += grad;
+                }
+            }
+        }
+    }
+}
+
+void lamp_conv2d_backward(LampConvAlgorithm algorithm, const LampConv2dShape *shape, size_t batch,
+                          const LampConvInput *input, const LAMP_FLOAT_TYPE *weights, const LAMP_FLOAT_TYPE *deltas,
+                          LAMP_FLOAT_TYPE *weights_grad, LAMP_FLOAT_TYPE *bias_grad, LAMP_FLOAT_TYPE *input_deltas,
+                          LAMP_FLOAT_TYPE *workspace) {
+    assert(shape != NULL && input != NULL && weights != NULL && deltas != NULL);
+    assert(weights_grad != NULL && bias_grad != NULL);
+
+    size_t depth = shape->in_channels * shape->kernel_size * shape->kernel_size;
+    size_t n = lamp_conv2d_out_height(shape) * lamp_conv2d_out_width(shape) * batch;
+    for (size_t oc = 0; oc < shape->out_channels; ++oc) {
+        LAMP_FLOAT_TYPE sum = 0.0f;
+        for (size_t i = 0; i < n; ++i) {
+            sum += deltas[oc * n + i];
+        }
+        bias_grad[oc] += sum;
+    }
+
+    if (algorithm == LAMP_CONV_DIRECT) {
+        direct_backward(shape, batch, input, weights, deltas, weights_grad, input_deltas);
+        return;
+    }
+
+    // weights_grad += deltas * cols^T, afterwards the workspace is reused for the deltas of the columns
+    assert(workspace != NULL);
+    im2col(shape, batch, input, workspace);
+    lamp_gemm(false, true, shape->out_channels, depth, n, deltas, n, workspace, n, weights_grad, depth, true, NULL);
+    if (input_deltas != NULL) {
+        lamp_gemm(true, false, depth, n, shape->out_channels, weights, depth, deltas, n, workspace, n, false, NULL);
+        col2im(shape, batch, workspace, input_deltas);
+    }
+}
+
+void lamp_pool2d_forward(LampPooling pooling, const LampConv2dShape *shape, size_t batch, const LampConvInput *input,
+                         LAMP_FLOAT_TYPE *output) {
+    assert(shape != NULL && input != NULL && output != NULL);
+    assert(shape->padding == 0);
+
+    size_t k = shape->kernel_size;
+    size_t out_height = lamp_conv2d_out_height(shape);
+    size_t out_width = lamp_conv2d_out_width(shape);
+    LAMP_FLOAT_TYPE scale = 1.0f / (LAMP_FLOAT_TYPE) (k * k);
+
+    for (size_t c = 0; c < shape->in_channels; ++c) {
+        for (size_t oy = 0; oy < out_height; ++oy) {
+            for (size_t ox = 0; ox < out_width; ++ox) {
+                LAMP_FLOAT_TYPE *restrict dst = &output[((c * out_height + oy) * out_width + ox) * batch];
+                for (size_t ky = 0; ky < k; ++ky) {
+                    for (size_t kx = 0; kx < k; ++kx) {
+                        size_t neuron = input_neuron(shape, c, oy * shape->stride + ky, ox * shape->stride + kx);
+                        const LAMP_FLOAT_TYPE *src = &input->elements[neuron * input->neuron_stride];
+                        bool first = ky == 0 && kx == 0;
+                        for (size_t s = 0; s < batch; ++s) {
+                            LAMP_FLOAT_TYPE value = src[s * input->sample_stride];
+                            if (first) {
+                                dst[s] = value;
+                            } else if (pooling == LAMP_POOLING_MAX) {
+                                dst[s] = value > dst[s] ? value : dst[s];
+                            } else {
+                                dst[s] += value;
+                            }
+                        }
+                    }
+                }
+                if (pooling == LAMP_POOLING_AVERAGE) {
+                    for (size_t s = 0; s < batch; ++s) {
+                        dst[s] *= scale;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void lamp_pool2d_backward(LampPooling pooling, const LampConv2dShape *shape, size_t batch, const LampConvInput *input,
+                          const LAMP_FLOAT_TYPE *deltas, LAMP_FLOAT_TYPE *input_deltas) {
+    assert(shape != NULL && input != NULL && deltas != NULL && input_deltas != NULL);
+    assert(shape->padding == 0);
+
+    size_t k = shape->kernel_size;
+    size_t out_height = lamp_conv2d_out_height(shape);
+    size_t out_width = lamp_conv2d_out_width(shape);
+    LAMP_FLOAT_TYPE scale = 1.0f / (LAMP_FLOAT_TYPE) (k * k);
+
+    memset(input_deltas, 0, sizeof(LAMP_FLOAT_TYPE) * shape->in_channels * shape->in_height * shape->in_width * batch);
+    for (size_t c = 0; c < shape->in_channels; ++c) {
+        for (size_t oy = 0; oy < out_height; ++oy) {
+            for (size_t ox = 0; ox < out_width; ++ox) {
+                const LAMP_FLOAT_TYPE *d = &deltas[((c * out_height + oy) * out_width + ox) * batch];
+                size_t y0 = oy * shape->stride;
+                size_t x0 = ox * shape->stride;
+
+                if (pooling == LAMP_POOLING_AVERAGE) {
+                    for (size_t ky = 0; ky < k; ++ky) {
+                        for (size_t kx = 0; kx < k; ++kx) {
+                            LAMP_FLOAT_TYPE *restrict dst = &input_deltas[input_neuron(shape, c, y0 + ky, x0 + kx) *
+                                                                          batch];
+                            for (size_t s = 0; s < batch; ++s) {
+                                dst[s] += d[s] * scale;
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                for (size_t s = 0; s < batch; ++s) {
+                    size_t best = input_neuron(shape, c, y0, x0);
+                    for (size_t ky = 0; ky < k; ++ky) {
+                        for (size_t kx = 0; kx < k; ++kx) {
+                            size_t neuron = input_neuron(shape, c, y0 + ky, x0 + kx);
+                            if (input->elements[neuron * input->neuron_stride + s * input->sample_stride] >
+                                input->elements[best * input->neuron_stride + s * input->sample_stride]) {
+                                best = neuron;
+                            }
+                        }
+                    }
+                    input_deltas[best * batch + s] += d[s];
+                }
+            }
+        }
+    }
+}
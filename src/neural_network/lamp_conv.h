@@ -0,0 +1,104 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_CONV_H
+#define LAMP_LAMP_CONV_H
+
+#include <stddef.h>
+#include "../linear_algebra/lamp_matrix.h"
+#include "../linear_algebra/lamp_gemm.h"
+
+// 2D convolution and pooling kernels for layers, that hold images.
+//
+// A layer of a network is a column of neurons per sample. An image layer stores its channels one after another
+// and every channel row by row (CHW), so neuron (c, y, x) is the row (c * height + y) * width + x of the
+// [neurons, batch] activations. The samples of one pixel are therefore next to each other, which is the
+// innermost, vectorized dimension of all kernels.
+//
+// The weights of a convolution are a [out_channels, in_channels * kernel_size * kernel_size] matrix, every row
+// holding the kernels of one output channel for all input channels (again channel by channel, row by row).
+// There is one bias per output channel.
+
+typedef struct {
+    size_t in_channels;
+    size_t in_height;
+    size_t in_width;
+    size_t out_channels; // Ignored by the pooling, which keeps the channels
+    size_t kernel_size;
+    size_t stride;
+    size_t padding;      // Zeros around the input image, the pooling does not support padding
+} LampConv2dShape;
+
+// im2col copies every receptive field of the input into a column of a matrix, so the whole convolution of a batch
+// becomes one matrix multiplication. This runs at the speed of lamp_gemm(), but needs a workspace of
+// kernel_size^2 times the input. The direct convolution needs no workspace and walks the input image in place.
+typedef enum {
+    LAMP_CONV_IM2COL = 0,
+    LAMP_CONV_DIRECT,
+} LampConvAlgorithm;
+
+typedef enum {
+    LAMP_POOLING_MAX = 0,
+    LAMP_POOLING_AVERAGE,
+} LampPooling;
+
+// The input of a layer is either the [neurons, batch] activations of the previous layer or - for the first
+// layer - the rows of a matrix view with one sample per row. Neuron n of sample s is at
+// elements[n * neuron_stride + s * sample_stride].
+typedef struct {
+    const LAMP_FLOAT_TYPE *elements;
+    size_t neuron_stride;
+    size_t sample_stride;
+} LampConvInput;
+
+size_t lamp_conv2d_out_height(const LampConv2dShape *shape);
+
+size_t lamp_conv2d_out_width(const LampConv2dShape *shape);
+
+// Number of elements of the workspace needed by the im2col algorithm for up to batch samples
+size_t lamp_conv2d_workspace_size(const LampConv2dShape *shape, size_t batch);
+
+// output = weights (*) input for every sample, stored as [out_channels * out_height * out_width, batch].
+// The optional epilogue is applied to every output channel (all of its pixels and samples) like in lamp_gemm().
+// The workspace is only used by LAMP_CONV_IM2COL and may be NULL for LAMP_CONV_DIRECT.
+void lamp_conv2d_forward(LampConvAlgorithm algorithm, const LampConv2dShape *shape, size_t batch,
+                         const LampConvInput *input, const LAMP_FLOAT_TYPE *weights, LAMP_FLOAT_TYPE *output,
+                         LAMP_FLOAT_TYPE *workspace, const LampGemmEpilogue *epilogue);
+
+// Add the gradients of the weights and bias for the deltas of the output ([out neurons, batch]) to weights_grad
+// and bias_grad. If input_deltas is not NULL, it is overwritten with the deltas of the input ([in neurons, batch]).
+void lamp_conv2d_backward(LampConvAlgorithm algorithm, const LampConv2dShape *shape, size_t batch,
+                          const LampConvInput *input, const LAMP_FLOAT_TYPE *weights, const LAMP_FLOAT_TYPE *deltas,
+                          LAMP_FLOAT_TYPE *weights_grad, LAMP_FLOAT_TYPE *bias_grad, LAMP_FLOAT_TYPE *input_deltas,
+                          LAMP_FLOAT_TYPE *workspace);
+
+// output = maximum or average of every kernel_size x kernel_size window of every channel
+void lamp_pool2d_forward(LampPooling pooling, const LampConv2dShape *shape, size_t batch, const LampConvInput *input,
+                         LAMP_FLOAT_TYPE *output);
+
+// Overwrite input_deltas with the deltas of the input. The maximum pooling passes every delta to the (first)
+// maximum of its window, the average pooling spreads it evenly over the window.
+void lamp_pool2d_backward(LampPooling pooling, const LampConv2dShape *shape, size_t batch, const LampConvInput *input,
+                          const LAMP_FLOAT_TYPE *deltas, LAMP_FLOAT_TYPE *input_deltas);
+
+#endif //LAMP_LAMP_CONV_H
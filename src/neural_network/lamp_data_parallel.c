@@ -0,0 +1,138 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <stdlib.h>
+#include "lamp_data_parallel.h"
+#include "../linear_algebra/lamp_simd.h"
+
+// The gradients of a pair are added in chunks, so big networks are reduced by all threads even in the last
+// rounds with only a few pairs left. A chunk is a multiple of a cache line.
+#define REDUCE_CHUNK_SIZE (16 * 1024)
+
+LampDataParallel *lamp_data_parallel_alloc(LampNN *nn, LampThreadPool *pool) {
+    assert(nn != NULL);
+    assert(lamp_nn_trainable(nn));
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampDataParallel *parallel = malloc(sizeof(LampDataParallel));
+    assert(parallel != NULL);
+    parallel->nn = nn;
+    parallel->pool = pool;
+    parallel->num_workers = pool != NULL ? lamp_threadpool_num_threads(pool) : 1;
+    parallel->replicas = malloc(sizeof(LampNN *) * parallel->num_workers);
+    assert(parallel->replicas != NULL);
+
+    parallel->replicas[0] = nn;
+    for (size_t i = 1; i < parallel->num_workers; ++i) {
+        parallel->replicas[i] = lamp_nn_alloc_replica(nn, nn->max_batch_size);
+    }
+    return parallel;
+}
+
+void lamp_data_parallel_free(LampDataParallel *parallel) {
+    assert(parallel != NULL);
+    for (size_t i = 1; i < parallel->num_workers; ++i) {
+        lamp_nn_free(parallel->replicas[i]);
+    }
+    free(parallel->replicas);
+    free(parallel);
+}
+
+typedef struct {
+    LampDataParallel *parallel;
+    const LampMatrixView *input;
+    const LampMatrixView *target;
+    size_t num_workers;
+    size_t stride;
+    size_t num_chunks;
+} DataParallelJob;
+
+// Worker w gets the rows [w * n / workers, (w + 1) * n / workers), so the parts differ by one row at most
+static size_t worker_first_row(const DataParallelJob *job, size_t worker) {
+    return worker * job->input->num_rows / job->num_workers;
+}
+
+static void backprop_task(void *context, size_t task_index) {
+    const DataParallelJob *job = context;
+    size_t first = worker_first_row(job, task_index);
+    size_t count = worker_first_row(job, task_index + 1) - first;
+    LampMatrixView input = lamp_mat_view_rows(job->input, first, count);
+    LampMatrixView target = lamp_mat_view_rows(job->target, first, count);
+    lamp_nn_backprop_view_scaled(job->parallel->replicas[task_index], &input, &target,
+                                 1.0f / (LAMP_FLOAT_TYPE) job->input->num_rows);
+}
+
+// Task i adds one chunk of the gradients of the worker stride to the right of the i-th pair
+static void reduce_task(void *context, size_t task_index) {
+    const DataParallelJob *job = context;
+    size_t pair = task_index / job->num_chunks;
+    size_t chunk = task_index % job->num_chunks;
+    size_t dst_worker = pair * 2 * job->stride;
+    size_t src_worker = dst_worker + job->stride;
+
+    size_t params_size = job->parallel->nn->params_size;
+    size_t first = chunk * REDUCE_CHUNK_SIZE;
+    size_t count = params_size - first < REDUCE_CHUNK_SIZE ? params_size - first : REDUCE_CHUNK_SIZE;
+    lamp_simd_kernels()->add(&job->parallel->replicas[dst_worker]->grads[first],
+                             &job->parallel->replicas[src_worker]->grads[first], count);
+}
+
+void lamp_data_parallel_backprop(LampDataParallel *parallel, const LampMatrix *input, const LampMatrix *target) {
+    assert(input != NULL && target != NULL);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView target_view = lamp_mat_view(target);
+    lamp_data_parallel_backprop_view(parallel, &input_view, &target_view);
+}
+
+void lamp_data_parallel_backprop_view(LampDataParallel *parallel, const LampMatrixView *input,
+                                      const LampMatrixView *target) {
+    assert(parallel != NULL && input != NULL && target != NULL);
+    assert(input->num_rows == target->num_rows && input->num_rows > 0);
+
+    if (parallel->num_workers == 1) {
+        lamp_nn_backprop_view(parallel->nn, input, target);
+        return;
+    }
+
+    // Workers without a single row would only add zeros, so small batches use fewer workers
+    DataParallelJob job = {
+            .parallel = parallel,
+            .input = input,
+            .target = target,
+            .num_workers = input->num_rows < parallel->num_workers ? input->num_rows : parallel->num_workers,
+            .num_chunks = (parallel->nn->params_size + REDUCE_CHUNK_SIZE - 1) / REDUCE_CHUNK_SIZE,
+    };
+    // Every worker drops other neurons in the dropouts, as if the whole batch ran through one network
+    for (size_t i = 1; i < job.num_workers; ++i) {
+        parallel->replicas[i]->seed = parallel->nn->seed + i;
+        parallel->replicas[i]->step = parallel->nn->step;
+    }
+    lamp_threadpool_parallel_for(parallel->pool, job.num_workers, backprop_task, &job);
+
+    for (job.stride = 1; job.stride < job.num_workers; job.stride *= 2) {
+        // Pairs (w, w + stride) for every w that is a multiple of 2 * stride and has a partner
+        size_t num_pairs = (job.num_workers - job.stride + 2 * job.stride - 1) / (2 * job.stride);
+        lamp_threadpool_parallel_for(parallel->pool, num_pairs * job.num_chunks, reduce_task, &job);
+    }
+}
@@ -0,0 +1,63 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_DATA_PARALLEL_H
+#define LAMP_LAMP_DATA_PARALLEL_H
+
+#include <stddef.h>
+#include "lamp_nn.h"
+#include "../threading/lamp_threadpool.h"
+
+// Data parallel training splits every batch into one part per thread of a pool. Each worker runs
+// backpropagation for its part on a replica of the network (see lamp_nn_alloc_replica()), which reads the
+// same parameters but writes its own activations, deltas and gradients, so the workers never wait for each other.
+// Afterwards the gradients of all workers are summed up in a tree: in the first round every even worker adds
+// the gradients of its right neighbour, in the next round every fourth worker the ones of the worker two steps
+// to the right and so on. That takes log2(workers) rounds, in which all pairs (and parts of the gradients) are
+// added in parallel. The first worker is the network itself, so its gradients end up holding the gradients of
+// the whole batch and can be applied by lamp_nn_apply_gradients() or an optimizer as usual.
+//
+// The result is the same as the one of lamp_nn_backprop() up to rounding, since the sums are formed in a
+// different order. For the same number of workers it is always the same.
+typedef struct {
+    LampNN *nn;
+    LampNN **replicas;
+    size_t num_workers;
+    LampThreadPool *pool;
+} LampDataParallel;
+
+// Allocate one worker per thread of the pool, the first of them uses nn itself.
+// Without a pool (NULL) there is only one worker and the backpropagation is the same as lamp_nn_backprop().
+// ATTENTION: nn and the pool must stay alive as long as the data parallel trainer is used
+LampDataParallel *lamp_data_parallel_alloc(LampNN *nn, LampThreadPool *pool);
+
+void lamp_data_parallel_free(LampDataParallel *parallel);
+
+// Calculate the gradients of the loss over all samples (rows) of the input and store them in the network.
+// Every worker processes a contiguous part of the rows.
+void lamp_data_parallel_backprop(LampDataParallel *parallel, const LampMatrix *input, const LampMatrix *target);
+
+void lamp_data_parallel_backprop_view(LampDataParallel *parallel, const LampMatrixView *input,
+                                      const LampMatrixView *target);
+
+#endif //LAMP_LAMP_DATA_PARALLEL_H
@@ -0,0 +1,111 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lamp_gradient_check.h"
+
+typedef struct {
+    const LampNN *nn;
+    const LampMatrixView *input;
+    const LampMatrixView *target;
+    LAMP_FLOAT_TYPE step;
+    LAMP_FLOAT_TYPE *grads;
+    size_t num_params;
+    size_t num_workers;
+} FiniteDiffJob;
+
+// The parameters are numbered in the order of the matrices in params, skipping the padding between them.
+// Worker w probes the parameters [w * n / workers, (w + 1) * n / workers).
+static void finite_diff_task(void *context, size_t task_index) {
+    const FiniteDiffJob *job = context;
+    size_t first = task_index * job->num_params / job->num_workers;
+    size_t last = (task_index + 1) * job->num_params / job->num_workers;
+    LampNN *probe = lamp_nn_alloc_copy(job->nn, job->nn->max_batch_size);
+    // Backpropagation computes the gradients of the dense weights, so the probe perturbs and multiplies those -
+    // its pruned connections are switched back to dense, while their pruned weights stay zero
+    for (size_t i = 0; i < probe->connection_count; ++i) {
+        if (probe->connections[i].sparse_weights != NULL) {
+            lamp_nn_prune(probe, i, 0.0f);
+        }
+    }
+
+    size_t index = 0;
+    for (size_t i = 0; i < probe->connection_count && index < last; ++i) {
+        LampMatrix *matrices[] = {probe->connections[i].weights, probe->connections[i].bias};
+        for (size_t m = 0; m < 2 && index < last; ++m) {
+            size_t count = LAMP_MAT_NUM_ELEMENTS(matrices[m]);
+            size_t begin = first > index ? first - index : 0;
+            size_t end = last - index < count ? last - index : count;
+            size_t offset = (size_t) (matrices[m]->elements - probe->params);
+
+            for (size_t e = begin; e < end; ++e) {
+                LAMP_FLOAT_TYPE *param = &matrices[m]->elements[e];
+                LAMP_FLOAT_TYPE original = *param;
+                // p + step and p - step are rounded, so divide by the distance that was actually probed
+                LAMP_FLOAT_TYPE up = original + job->step;
+                LAMP_FLOAT_TYPE down = original - job->step;
+
+                *param = up;
+                LAMP_FLOAT_TYPE loss_up = lamp_nn_loss_view(probe, job->input, job->target);
+                *param = down;
+                LAMP_FLOAT_TYPE loss_down = lamp_nn_loss_view(probe, job->input, job->target);
+                *param = original;
+
+                job->grads[offset + e] = (loss_up - loss_down) / (up - down);
+            }
+            index += count;
+        }
+    }
+
+    lamp_nn_free(probe);
+}
+
+void lamp_nn_finite_diff_gradients(const LampNN *nn, const LampMatrixView *input, const LampMatrixView *target,
+                                   LAMP_FLOAT_TYPE step, LampThreadPool *pool, LAMP_FLOAT_TYPE *grads) {
+    assert(nn != NULL && input != NULL && target != NULL && grads != NULL);
+    assert(input->num_rows == target->num_rows && input->num_rows > 0);
+    assert(fabsf(step) > 1e-6);
+    assert(lamp_nn_trainable(nn));
+
+    FiniteDiffJob job = {
+            .nn = nn,
+            .input = input,
+            .target = target,
+            .step = step,
+            .grads = grads,
+            .num_params = 0,
+    };
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        job.num_params += LAMP_MAT_NUM_ELEMENTS(nn->connections[i].weights);
+        job.num_params += LAMP_MAT_NUM_ELEMENTS(nn->connections[i].bias);
+    }
+
+    size_t num_threads = pool != NULL ? lamp_threadpool_num_threads(pool) : 1;
+    job.num_workers = job.num_params < num_threads ? job.num_params : num_threads;
+
+    memset(grads, 0, sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    lamp_threadpool_parallel_for(pool, job.num_workers, finite_diff_task, &job);
+}
@@ -0,0 +1,45 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_GRADIENT_CHECK_H
+#define LAMP_LAMP_GRADIENT_CHECK_H
+
+#include "lamp_nn.h"
+#include "../threading/lamp_threadpool.h"
+
+// Approximate the gradient of lamp_nn_loss() with respect to every weight and bias by central differences
+// grad = (loss(p + step) - loss(p - step)) / (2 * step), which is exact up to the third derivative, instead of
+// the second one of the one sided differences used by lamp_nn_apply_finite_diff_gradients().
+//
+// Every parameter costs two full passes over the input, so the parameters are split into one contiguous slice
+// per thread of the pool. Each worker probes its slice on a private copy of the network, so the network itself
+// is never changed and the workers never see the perturbations of each other. Without a pool (NULL) all
+// parameters are probed by the calling thread.
+//
+// The result is written to grads, which has the layout of nn->grads (params_size elements, the padding is set
+// to zero). So it can be compared element by element with the gradients of lamp_nn_backprop() or be written to
+// nn->grads itself.
+void lamp_nn_finite_diff_gradients(const LampNN *nn, const LampMatrixView *input, const LampMatrixView *target,
+                                   LAMP_FLOAT_TYPE step, LampThreadPool *pool, LAMP_FLOAT_TYPE *grads);
+
+#endif //LAMP_LAMP_GRADIENT_CHECK_H
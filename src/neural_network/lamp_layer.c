@@ -0,0 +1,497 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "lamp_layer.h"
+
+// Added to the variance of a layer normalization, so constant samples don't divide by zero
+#define LAYER_NORM_EPSILON 1e-5f
+
+// Element (neuron, sample) of the input of a connection
+static LAMP_FLOAT_TYPE input_at(const LampLayerInput *input, size_t neuron, size_t sample) {
+    return input->transposed ? input->elements[sample * input->stride + neuron] :
+           input->elements[neuron * input->stride + sample];
+}
+
+// The convolution kernels take the strides of both dimensions instead
+static LampConvInput conv_input(const LampLayerInput *input) {
+    LampConvInput conv_input = {
+            .elements = input->elements,
+            .neuron_stride = input->transposed ? 1 : input->stride,
+            .sample_stride = input->transposed ? input->stride : 1,
+    };
+    return conv_input;
+}
+
+// The rest of the forward pass after dst holds the weighted input: keep it, if the activation needs it later,
+// and apply the activation unless the epilogue of a matrix multiplication did already
+static void finish_forward(LampActivation activation, LampMatrix *dst, LampMatrix *weighted_inputs, bool activated) {
+    if (weighted_inputs != NULL && lamp_activation_needs_input(activation)) {
+        assert(!activated);
+        lamp_mat_copy_into(weighted_inputs, dst);
+    }
+    if (!activated) {
+        lamp_activation_forward(activation, dst);
+    }
+}
+
+// Epilogue of a matrix multiplication or convolution, that applies the bias and - if nothing else needs the
+// weighted input - the activation
+static LampGemmEpilogue fused_epilogue(LampActivation activation, const LampMatrix *bias,
+                                       const LampMatrix *weighted_inputs) {
+    bool keep_input = weighted_inputs != NULL && lamp_activation_needs_input(activation);
+    LampGemmEpilogue epilogue = {
+            .row_bias = bias->elements,
+            .activation = keep_input ? NULL : lamp_activation_kernel(activation),
+    };
+    return epilogue;
+}
+
+static size_t same_outputs(const LampNNConnectionSpec *spec, size_t inputs) {
+    (void) spec;
+    return inputs;
+}
+
+static void no_params(const LampNNConnectionSpec *spec, size_t inputs, size_t *rows, size_t *cols) {
+    (void) spec;
+    (void) inputs;
+    *rows = 0;
+    *cols = 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Dense
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lamp_nn_layer_dense_forward(LampMatrix *dst, const LampMatrix *weights, const LampSparseMatrix *sparse_weights,
+                                 const LampLayerInput *input, const LampMatrix *bias, LampActivation activation,
+                                 LampMatrix *weighted_inputs) {
+    assert(bias->num_rows == dst->num_rows && bias->num_cols == 1);
+
+    // The weighted input has to be copied before the activation overwrites it, so it can't be fused then
+    LampGemmEpilogue epilogue = fused_epilogue(activation, bias, weighted_inputs);
+    if (sparse_weights != NULL) {
+        lamp_sparse_gemm(input->transposed, dst->num_cols, sparse_weights, input->elements, input->stride,
+                         dst->elements, dst->num_cols, &epilogue);
+    } else {
+        lamp_gemm(false, input->transposed, dst->num_rows, dst->num_cols, weights->num_cols,
+                  weights->elements, weights->num_cols,
+                  input->elements, input->stride,
+                  dst->elements, dst->num_cols, false, &epilogue);
+    }
+    finish_forward(activation, dst, weighted_inputs, epilogue.activation != NULL);
+}
+
+static bool dense_valid(const LampNNConnectionSpec *spec, size_t inputs) {
+    size_t weights = spec->outputs;
+    return spec->outputs > 0 && lamp_nn_size_mul(&weights, inputs);
+}
+
+static size_t dense_outputs(const LampNNConnectionSpec *spec, size_t inputs) {
+    (void) inputs;
+    return spec->outputs;
+}
+
+static void dense_params(const LampNNConnectionSpec *spec, size_t inputs, size_t *rows, size_t *cols) {
+    *rows = spec->outputs;
+    *cols = inputs;
+}
+
+// Training multiplies the dense weights, which are the ones backpropagation computes the gradients for and the
+// updates change. Their pruned elements are zero, so this is the same network as the sparse weights.
+static void dense_forward(const LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                          LampMatrix *dst, LampMatrix *weighted_inputs) {
+    const LampSparseMatrix *sparse_weights = ctx->training ? NULL : conn->sparse_weights;
+    lamp_nn_layer_dense_forward(dst, conn->weights, sparse_weights, input, conn->bias, conn->activation,
+                                weighted_inputs);
+}
+
+static void dense_backward(LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                           LampMatrix *d_begin) {
+    (void) ctx;
+    const LampMatrix *d_end = conn->layer_end->deltas;
+    size_t count = d_end->num_cols;
+
+    // bias_grad += sum of d_end over all samples
+    for (size_t j = 0; j < d_end->num_rows; ++j) {
+        for (size_t s = 0; s < count; ++s) {
+            LAMP_MAT_ELEMENT_AT(conn->bias_grad, j, 0) += LAMP_MAT_ELEMENT_AT(d_end, j, s);
+        }
+    }
+
+    // weights_grad += d_end * input^T - an input with one sample per row is transposed already
+    lamp_gemm(false, !input->transposed, conn->weights->num_rows, conn->weights->num_cols, count,
+              d_end->elements, d_end->num_cols,
+              input->elements, input->stride,
+              conn->weights_grad->elements, conn->weights_grad->num_cols, true, NULL);
+
+    // d_begin = weights^T * d_end
+    if (d_begin != NULL) {
+        lamp_gemm(true, false, d_begin->num_rows, count, conn->weights->num_rows,
+                  conn->weights->elements, conn->weights->num_cols,
+                  d_end->elements, d_end->num_cols,
+                  d_begin->elements, d_begin->num_cols, false, NULL);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Convolution and pooling
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The products of a shape are checked for overflows, so the sizes computed from it can be trusted afterwards.
+// Pooling never produces more outputs than it has inputs.
+static bool image_valid(const LampConv2dShape *shape, size_t inputs) {
+    size_t size = shape->in_channels;
+    return shape->in_channels > 0 && shape->in_height > 0 && shape->in_width > 0 &&
+           lamp_nn_size_mul(&size, shape->in_height) && lamp_nn_size_mul(&size, shape->in_width) && size == inputs &&
+           shape->kernel_size > 0 && shape->stride > 0 &&
+           shape->in_height + 2 * shape->padding >= shape->kernel_size &&
+           shape->in_width + 2 * shape->padding >= shape->kernel_size;
+}
+
+// Besides the outputs the weights and the unfolded columns of one sample must have a size
+static bool conv_valid(const LampNNConnectionSpec *spec, size_t inputs) {
+    if (!image_valid(&spec->shape, inputs) || spec->shape.out_channels == 0) {
+        return false;
+    }
+    size_t positions = lamp_conv2d_out_height(&spec->shape);
+    size_t outputs = spec->shape.out_channels, weights = spec->shape.out_channels;
+    size_t columns = spec->shape.in_channels;
+    return lamp_nn_size_mul(&positions, lamp_conv2d_out_width(&spec->shape)) &&
+           lamp_nn_size_mul(&outputs, positions) &&
+           lamp_nn_size_mul(&columns, spec->shape.kernel_size) &&
+           lamp_nn_size_mul(&columns, spec->shape.kernel_size) &&
+           lamp_nn_size_mul(&weights, columns) &&
+           lamp_nn_size_mul(&columns, positions);
+}
+
+static size_t conv_outputs(const LampNNConnectionSpec *spec, size_t inputs) {
+    (void) inputs;
+    return spec->shape.out_channels * lamp_conv2d_out_height(&spec->shape) * lamp_conv2d_out_width(&spec->shape);
+}
+
+static void conv_params(const LampNNConnectionSpec *spec, size_t inputs, size_t *rows, size_t *cols) {
+    (void) inputs;
+    *rows = spec->shape.out_channels;
+    *cols = spec->shape.in_channels * spec->shape.kernel_size * spec->shape.kernel_size;
+}
+
+static size_t conv_workspace_size(const LampNNConnectionSpec *spec, size_t inputs, size_t max_batch_size) {
+    (void) inputs;
+    return lamp_conv2d_workspace_size(&spec->shape, max_batch_size);
+}
+
+static void conv_forward(const LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                         LampMatrix *dst, LampMatrix *weighted_inputs) {
+    LampConvInput src = conv_input(input);
+    LampGemmEpilogue epilogue = fused_epilogue(conn->activation, conn->bias, weighted_inputs);
+    lamp_conv2d_forward(conn->conv_algorithm, &conn->shape, dst->num_cols, &src, conn->weights->elements,
+                        dst->elements, ctx->workspace, &epilogue);
+    finish_forward(conn->activation, dst, weighted_inputs, epilogue.activation != NULL);
+}
+
+static void conv_backward(LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                          LampMatrix *d_begin) {
+    const LampMatrix *d_end = conn->layer_end->deltas;
+    LampConvInput src = conv_input(input);
+    lamp_conv2d_backward(conn->conv_algorithm, &conn->shape, d_end->num_cols, &src, conn->weights->elements,
+                         d_end->elements, conn->weights_grad->elements, conn->bias_grad->elements,
+                         d_begin != NULL ? d_begin->elements : NULL, ctx->workspace);
+}
+
+static bool pool_valid(const LampNNConnectionSpec *spec, size_t inputs) {
+    return image_valid(&spec->shape, inputs) && spec->shape.padding == 0;
+}
+
+static size_t pool_outputs(const LampNNConnectionSpec *spec, size_t inputs) {
+    (void) inputs;
+    return spec->shape.in_channels * lamp_conv2d_out_height(&spec->shape) * lamp_conv2d_out_width(&spec->shape);
+}
+
+static LampPooling connection_pooling(const LampNNConnection *conn) {
+    return conn->kind == LAMP_CONNECTION_MAX_POOL ? LAMP_POOLING_MAX : LAMP_POOLING_AVERAGE;
+}
+
+static void pool_forward(const LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                         LampMatrix *dst, LampMatrix *weighted_inputs) {
+    (void) ctx;
+    LampConvInput src = conv_input(input);
+    lamp_pool2d_forward(connection_pooling(conn), &conn->shape, dst->num_cols, &src, dst->elements);
+    finish_forward(conn->activation, dst, weighted_inputs, false);
+}
+
+static void pool_backward(LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                          LampMatrix *d_begin) {
+    (void) ctx;
+    if (d_begin != NULL) {
+        const LampMatrix *d_end = conn->layer_end->deltas;
+        LampConvInput src = conv_input(input);
+        lamp_pool2d_backward(connection_pooling(conn), &conn->shape, d_end->num_cols, &src, d_end->elements,
+                             d_begin->elements);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Layer normalization
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool layer_norm_valid(const LampNNConnectionSpec *spec, size_t inputs) {
+    (void) spec;
+    return inputs > 0;
+}
+
+static void layer_norm_params(const LampNNConnectionSpec *spec, size_t inputs, size_t *rows, size_t *cols) {
+    (void) spec;
+    *rows = inputs;
+    *cols = 1;
+}
+
+// Mean and reciprocal standard deviation of every sample, followed by two sums of the backward pass
+static size_t layer_norm_workspace_size(const LampNNConnectionSpec *spec, size_t inputs, size_t max_batch_size) {
+    (void) spec;
+    (void) inputs;
+    return 4 * max_batch_size;
+}
+
+// A gain of one keeps the normalized values as they are
+static void layer_norm_init(LampNNConnection *conn) {
+    lamp_mat_fill_with(conn->weights, 1.0f);
+}
+
+// The statistics are gathered row by row, so the samples stay the inner (contiguous) loop
+static void layer_norm_statistics(const LampLayerInput *input, size_t neurons, size_t count, LAMP_FLOAT_TYPE *mean,
+                                  LAMP_FLOAT_TYPE *inv_std) {
+    memset(mean, 0, sizeof(LAMP_FLOAT_TYPE) * count);
+    memset(inv_std, 0, sizeof(LAMP_FLOAT_TYPE) * count);
+    for (size_t j = 0; j < neurons; ++j) {
+        for (size_t s = 0; s < count; ++s) {
+            mean[s] += input_at(input, j, s);
+        }
+    }
+    for (size_t s = 0; s < count; ++s) {
+        mean[s] /= (LAMP_FLOAT_TYPE) neurons;
+    }
+    for (size_t j = 0; j < neurons; ++j) {
+        for (size_t s = 0; s < count; ++s) {
+            LAMP_FLOAT_TYPE diff = input_at(input, j, s) - mean[s];
+            inv_std[s] += diff * diff;
+        }
+    }
+    for (size_t s = 0; s < count; ++s) {
+        inv_std[s] = 1.0f / sqrtf(inv_std[s] / (LAMP_FLOAT_TYPE) neurons + LAYER_NORM_EPSILON);
+    }
+}
+
+static void layer_norm_forward(const LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                               LampMatrix *dst, LampMatrix *weighted_inputs) {
+    size_t count = dst->num_cols;
+    LAMP_FLOAT_TYPE *mean = ctx->workspace;
+    LAMP_FLOAT_TYPE *inv_std = ctx->workspace + count;
+    layer_norm_statistics(input, dst->num_rows, count, mean, inv_std);
+
+    for (size_t j = 0; j < dst->num_rows; ++j) {
+        LAMP_FLOAT_TYPE gain = conn->weights->elements[j];
+        LAMP_FLOAT_TYPE bias = conn->bias->elements[j];
+        for (size_t s = 0; s < count; ++s) {
+            LAMP_MAT_ELEMENT_AT(dst, j, s) = gain * (input_at(input, j, s) - mean[s]) * inv_std[s] + bias;
+        }
+    }
+    finish_forward(conn->activation, dst, weighted_inputs, false);
+}
+
+// With the normalized input x^ = (x - mean) * inv_std and g = gain * d_end of a sample:
+// dL/dx = inv_std * (g - mean(g) - x^ * mean(g * x^))
+static void layer_norm_backward(LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                                LampMatrix *d_begin) {
+    const LampMatrix *d_end = conn->layer_end->deltas;
+    size_t neurons = d_end->num_rows;
+    size_t count = d_end->num_cols;
+    LAMP_FLOAT_TYPE *mean = ctx->workspace;
+    LAMP_FLOAT_TYPE *inv_std = ctx->workspace + count;
+    LAMP_FLOAT_TYPE *sum_g = ctx->workspace + 2 * count;
+    LAMP_FLOAT_TYPE *sum_gx = ctx->workspace + 3 * count;
+    layer_norm_statistics(input, neurons, count, mean, inv_std);
+
+    memset(sum_g, 0, sizeof(LAMP_FLOAT_TYPE) * count);
+    memset(sum_gx, 0, sizeof(LAMP_FLOAT_TYPE) * count);
+    for (size_t j = 0; j < neurons; ++j) {
+        LAMP_FLOAT_TYPE gain = conn->weights->elements[j];
+        LAMP_FLOAT_TYPE gain_grad = 0.0f, bias_grad = 0.0f;
+        for (size_t s = 0; s < count; ++s) {
+            LAMP_FLOAT_TYPE normalized = (input_at(input, j, s) - mean[s]) * inv_std[s];
+            LAMP_FLOAT_TYPE delta = LAMP_MAT_ELEMENT_AT(d_end, j, s);
+            gain_grad += delta * normalized;
+            bias_grad += delta;
+            sum_g[s] += gain * delta;
+            sum_gx[s] += gain * delta * normalized;
+        }
+        conn->weights_grad->elements[j] += gain_grad;
+        conn->bias_grad->elements[j] += bias_grad;
+    }
+
+    if (d_begin == NULL) {
+        return;
+    }
+    for (size_t j = 0; j < neurons; ++j) {
+        LAMP_FLOAT_TYPE gain = conn->weights->elements[j];
+        for (size_t s = 0; s < count; ++s) {
+            LAMP_FLOAT_TYPE normalized = (input_at(input, j, s) - mean[s]) * inv_std[s];
+            LAMP_MAT_ELEMENT_AT(d_begin, j, s) = inv_std[s] * (gain * LAMP_MAT_ELEMENT_AT(d_end, j, s) -
+                                                               (sum_g[s] + normalized * sum_gx[s]) /
+                                                               (LAMP_FLOAT_TYPE) neurons);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Dropout
+// ---------------------------------------------------------------------------------------------------------------------
+
+// splitmix64, a cheap hash with good avalanche, turns a counter into a random number. The mask of a batch is a pure
+// function of the seed, so the backward pass recomputes it instead of storing it.
+static uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+uint64_t lamp_nn_layer_seed(uint64_t seed, uint64_t step, size_t connection) {
+    return mix(mix(mix(seed) ^ step) ^ (uint64_t) connection);
+}
+
+// Factor of a neuron of a sample: 0 if it is dropped, otherwise 1 / (1 - rate), so the expected value of every
+// neuron stays the same and inference needs no scaling
+static LAMP_FLOAT_TYPE dropout_scale(const LampNNConnection *conn, uint64_t seed, size_t neuron, size_t sample) {
+    uint64_t bits = mix(seed ^ ((uint64_t) neuron << 32 | (uint64_t) sample));
+    LAMP_FLOAT_TYPE uniform = (LAMP_FLOAT_TYPE) (bits >> 40) * (1.0f / (LAMP_FLOAT_TYPE) (1u << 24));
+    return uniform < conn->rate ? 0.0f : 1.0f / (1.0f - conn->rate);
+}
+
+static bool dropout_valid(const LampNNConnectionSpec *spec, size_t inputs) {
+    return inputs > 0 && spec->rate >= 0.0f && spec->rate < 1.0f;
+}
+
+static void dropout_forward(const LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                            LampMatrix *dst, LampMatrix *weighted_inputs) {
+    bool drop = ctx->training && conn->rate > 0.0f;
+    for (size_t j = 0; j < dst->num_rows; ++j) {
+        for (size_t s = 0; s < dst->num_cols; ++s) {
+            LAMP_FLOAT_TYPE value = input_at(input, j, s);
+            LAMP_MAT_ELEMENT_AT(dst, j, s) = drop ? value * dropout_scale(conn, ctx->seed, j, s) : value;
+        }
+    }
+    finish_forward(conn->activation, dst, weighted_inputs, false);
+}
+
+static void dropout_backward(LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                             LampMatrix *d_begin) {
+    (void) input;
+    if (d_begin == NULL) {
+        return;
+    }
+    const LampMatrix *d_end = conn->layer_end->deltas;
+    bool drop = ctx->training && conn->rate > 0.0f;
+    for (size_t j = 0; j < d_end->num_rows; ++j) {
+        for (size_t s = 0; s < d_end->num_cols; ++s) {
+            LAMP_FLOAT_TYPE delta = LAMP_MAT_ELEMENT_AT(d_end, j, s);
+            LAMP_MAT_ELEMENT_AT(d_begin, j, s) = drop ? delta * dropout_scale(conn, ctx->seed, j, s) : delta;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Activation
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool activation_valid(const LampNNConnectionSpec *spec, size_t inputs) {
+    (void) spec;
+    return inputs > 0;
+}
+
+static void activation_forward(const LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                               LampMatrix *dst, LampMatrix *weighted_inputs) {
+    (void) ctx;
+    for (size_t j = 0; j < dst->num_rows; ++j) {
+        if (!input->transposed) {
+            memcpy(&LAMP_MAT_ELEMENT_AT(dst, j, 0), &input->elements[j * input->stride],
+                   sizeof(LAMP_FLOAT_TYPE) * dst->num_cols);
+            continue;
+        }
+        for (size_t s = 0; s < dst->num_cols; ++s) {
+            LAMP_MAT_ELEMENT_AT(dst, j, s) = input_at(input, j, s);
+        }
+    }
+    finish_forward(conn->activation, dst, weighted_inputs, false);
+}
+
+// The derivative of the activation was applied to the deltas of layer_end already
+static void activation_backward(LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                                LampMatrix *d_begin) {
+    (void) ctx;
+    (void) input;
+    if (d_begin != NULL) {
+        lamp_mat_copy_into(d_begin, conn->layer_end->deltas);
+    }
+}
+
+static const LampNNLayerOps layer_ops[LAMP_CONNECTION_KIND_COUNT] = {
+        [LAMP_CONNECTION_DENSE] = {
+                .name = "dense", .default_activation = LAMP_ACTIVATION_SIGMOID, .valid = dense_valid,
+                .outputs = dense_outputs, .params = dense_params, .forward = dense_forward, .backward = dense_backward
+        },
+        [LAMP_CONNECTION_CONV2D] = {
+                .name = "conv2d", .default_activation = LAMP_ACTIVATION_SIGMOID, .valid = conv_valid,
+                .outputs = conv_outputs, .params = conv_params, .workspace_size = conv_workspace_size,
+                .forward = conv_forward, .backward = conv_backward
+        },
+        [LAMP_CONNECTION_MAX_POOL] = {
+                .name = "max pool", .default_activation = LAMP_ACTIVATION_LINEAR, .valid = pool_valid,
+                .outputs = pool_outputs, .params = no_params, .forward = pool_forward, .backward = pool_backward
+        },
+        [LAMP_CONNECTION_AVG_POOL] = {
+                .name = "avg pool", .default_activation = LAMP_ACTIVATION_LINEAR, .valid = pool_valid,
+                .outputs = pool_outputs, .params = no_params, .forward = pool_forward, .backward = pool_backward
+        },
+        [LAMP_CONNECTION_LAYER_NORM] = {
+                .name = "layer norm", .default_activation = LAMP_ACTIVATION_LINEAR, .valid = layer_norm_valid,
+                .outputs = same_outputs, .params = layer_norm_params, .workspace_size = layer_norm_workspace_size,
+                .init = layer_norm_init, .forward = layer_norm_forward, .backward = layer_norm_backward
+        },
+        [LAMP_CONNECTION_DROPOUT] = {
+                .name = "dropout", .default_activation = LAMP_ACTIVATION_LINEAR, .valid = dropout_valid,
+                .outputs = same_outputs, .params = no_params, .forward = dropout_forward, .backward = dropout_backward
+        },
+        [LAMP_CONNECTION_ACTIVATION] = {
+                .name = "activation", .default_activation = LAMP_ACTIVATION_SIGMOID, .valid = activation_valid,
+                .outputs = same_outputs, .params = no_params, .forward = activation_forward,
+                .backward = activation_backward
+        },
+};
+
+const LampNNLayerOps *lamp_nn_layer_ops(LampConnectionKind kind) {
+    assert(kind < LAMP_CONNECTION_KIND_COUNT);
+    return &layer_ops[kind];
+}
@@ -0,0 +1,106 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_LAYER_H
+#define LAMP_LAMP_LAYER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lamp_nn.h"
+
+// The interface every kind of connection implements. The network only chains connections and never looks at
+// their kind, so a new kind of layer only needs its own LampNNLayerOps in lamp_layer.c.
+//
+// The forward pass of a connection turns the activations of layer_begin into the activations of layer_end (already
+// passed through the activation function of the connection). The backward pass gets the deltas of layer_end - the
+// derivative of the loss with respect to its weighted input - adds the gradients of the parameters to weights_grad
+// and bias_grad and stores the derivative with respect to the activations of layer_begin in d_begin.
+
+// The input of a connection: either the [neurons, batch] activations of layer_begin or - for the first connection -
+// the rows of a matrix view with one sample per row (transposed). stride is the distance of two rows.
+typedef struct {
+    const LAMP_FLOAT_TYPE *elements;
+    size_t stride;
+    bool transposed;
+} LampLayerInput;
+
+// State of the pass, that is shared by all connections. workspace holds at least as many elements as the
+// workspace_size of the connection asked for. Only backpropagation runs in training mode. seed determines all
+// random decisions of the connection for the current batch, the forward and backward pass get the same seed.
+typedef struct {
+    LAMP_FLOAT_TYPE *workspace;
+    bool training;
+    uint64_t seed;
+} LampLayerContext;
+
+typedef struct {
+    const char *name;
+    // Activation function of a freshly allocated connection
+    LampActivation default_activation;
+    // Check the spec of a connection, that starts at a layer of inputs neurons, without asserting, so it can also
+    // be used to validate model files
+    bool (*valid)(const LampNNConnectionSpec *spec, size_t inputs);
+    // Neurons of the layer at the end of the connection
+    size_t (*outputs)(const LampNNConnectionSpec *spec, size_t inputs);
+    // The weights are a [rows, cols] matrix and the bias is [rows, 1], so the connection has rows * (cols + 1)
+    // parameters. Connections without parameters return 0 rows.
+    void (*params)(const LampNNConnectionSpec *spec, size_t inputs, size_t *rows, size_t *cols);
+    // Elements of scratch memory needed by the forward or backward pass of up to max_batch_size samples.
+    // NULL if the connection needs none.
+    size_t (*workspace_size)(const LampNNConnectionSpec *spec, size_t inputs, size_t max_batch_size);
+    // Initialize parameters, that can not start at zero. NULL if zero is fine.
+    void (*init)(LampNNConnection *conn);
+    // Calculate dst = f(layer(input)) for all dst->num_cols samples. If weighted_inputs is given, the values before
+    // the activation are kept there for activations, that need them during backpropagation.
+    void (*forward)(const LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                    LampMatrix *dst, LampMatrix *weighted_inputs);
+    // Accumulate the gradients for the deltas of layer_end and - unless d_begin is NULL - overwrite d_begin with
+    // the derivative of the loss with respect to the input
+    void (*backward)(LampNNConnection *conn, const LampLayerContext *ctx, const LampLayerInput *input,
+                     LampMatrix *d_begin);
+} LampNNLayerOps;
+
+const LampNNLayerOps *lamp_nn_layer_ops(LampConnectionKind kind);
+
+// Seed of the random decisions of a connection for one batch, derived from the seed of the network and the number
+// of batches it has seen
+uint64_t lamp_nn_layer_seed(uint64_t seed, uint64_t step, size_t connection);
+
+// product *= factor, unless the result does not fit into a size_t. The sizes in model files are untrusted, so
+// whatever is computed from them is multiplied with this while the file is validated.
+static inline bool lamp_nn_size_mul(size_t *product, size_t factor) {
+    if (factor != 0 && *product > SIZE_MAX / factor) {
+        return false;
+    }
+    *product *= factor;
+    return true;
+}
+
+// dst = f(weights * input + bias), where bias and element-wise activations are applied by the GEMM epilogue.
+// If sparse_weights is given, it is multiplied instead of the dense weights.
+void lamp_nn_layer_dense_forward(LampMatrix *dst, const LampMatrix *weights, const LampSparseMatrix *sparse_weights,
+                                 const LampLayerInput *input, const LampMatrix *bias, LampActivation activation,
+                                 LampMatrix *weighted_inputs);
+
+#endif //LAMP_LAMP_LAYER_H
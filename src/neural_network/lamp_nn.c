@@ -22,115 +22,981 @@
 //
 
 #include <assert.h>
+#include <fcntl.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "lamp_nn.h"
+#include "lamp_layer.h"
+#include "../linear_algebra/lamp_gemm.h"
+#include "../linear_algebra/lamp_simd.h"
 
 LampNN *lamp_nn_alloc(const size_t architecture[], size_t layer_count) {
+    return lamp_nn_alloc_batched(architecture, layer_count, 1);
+}
+
+static LampNN *nn_alloc(size_t inputs, const LampNNConnectionSpec specs[], size_t connection_count,
+                        size_t max_batch_size, const bool sparse_only[], LAMP_FLOAT_TYPE *external_params);
+
+// All memory of the network lives in one arena, laid out as
+// [LampNN | layers | connections | matrix headers | parameters | gradients | activations and deltas | workspace].
+// Every matrix starts at a cache line, the parameters (and gradients) of all connections follow each other.
+// The parameters may also live outside of the arena, e.g. in a mapped model file.
+// Connections, that keep only their sparse weights (sparse_only, NULL if there are none), have no dense weights
+// and weight gradients in the blocks.
+// Besides weights, bias and their gradients every connection owns the weighted inputs of the layer it ends in.
+#define MATRICES_PER_LAYER 2
+#define MATRICES_PER_CONNECTION 5
+
+static size_t matrix_arena_size(size_t rows, size_t cols) {
+    return LAMP_ARENA_ALIGNED_SIZE(sizeof(LAMP_FLOAT_TYPE) * rows * cols);
+}
+
+// Check a connection, that starts at a layer of inputs neurons, without asserting, so it can also be used to
+// validate model files
+static bool connection_spec_valid(const LampNNConnectionSpec *spec, size_t inputs) {
+    return spec->kind < LAMP_CONNECTION_KIND_COUNT && lamp_nn_layer_ops(spec->kind)->valid(spec, inputs);
+}
+
+// Neurons of the layer at the end of a connection, that starts at a layer of inputs neurons
+static size_t connection_outputs(const LampNNConnectionSpec *spec, size_t inputs) {
+    return lamp_nn_layer_ops(spec->kind)->outputs(spec, inputs);
+}
+
+// Size of the parameter block, which is the same for the gradients
+static size_t lamp_nn_params_bytes(size_t inputs, const LampNNConnectionSpec specs[], size_t connection_count,
+                                   const bool sparse_only[]) {
+    size_t size = 0;
+    for (size_t i = 0; i < connection_count; ++i) {
+        size_t rows, cols;
+        lamp_nn_layer_ops(specs[i].kind)->params(&specs[i], inputs, &rows, &cols);
+        bool dense = sparse_only == NULL || !sparse_only[i];
+        size += (dense ? matrix_arena_size(rows, cols) : 0) + matrix_arena_size(rows, 1);
+        inputs = connection_outputs(&specs[i], inputs);
+    }
+    return size;
+}
+
+// Elements of the workspace. Only one connection runs at a time, so it is the most any connection needs.
+static size_t lamp_nn_workspace_size(size_t inputs, const LampNNConnectionSpec specs[], size_t connection_count,
+                                     size_t max_batch_size) {
+    size_t size = 0;
+    for (size_t i = 0; i < connection_count; ++i) {
+        const LampNNLayerOps *ops = lamp_nn_layer_ops(specs[i].kind);
+        if (ops->workspace_size != NULL) {
+            size_t connection_size = ops->workspace_size(&specs[i], inputs, max_batch_size);
+            size = connection_size > size ? connection_size : size;
+        }
+        inputs = connection_outputs(&specs[i], inputs);
+    }
+    return size;
+}
+
+static size_t lamp_nn_arena_size(size_t inputs, const LampNNConnectionSpec specs[], size_t connection_count,
+                                 size_t max_batch_size, const bool sparse_only[], bool external_params) {
+    size_t layer_count = connection_count + 1;
+    size_t size = LAMP_ARENA_ALIGNED_SIZE(sizeof(LampNN)) +
+                  LAMP_ARENA_ALIGNED_SIZE(sizeof(LampNNLayer) * layer_count) +
+                  LAMP_ARENA_ALIGNED_SIZE(sizeof(LampNNConnection) * connection_count) +
+                  LAMP_ARENA_ALIGNED_SIZE(sizeof(LampMatrix) * (MATRICES_PER_LAYER * layer_count +
+                                                                MATRICES_PER_CONNECTION * connection_count));
+
+    // Parameters and gradients
+    size += (external_params ? 1 : 2) * lamp_nn_params_bytes(inputs, specs, connection_count, sparse_only);
+    // Activations and deltas, all layers except the input layer also have weighted inputs
+    size += 2 * matrix_arena_size(inputs, max_batch_size);
+    for (size_t i = 0, neurons = inputs; i < connection_count; ++i) {
+        neurons = connection_outputs(&specs[i], neurons);
+        size += 3 * matrix_arena_size(neurons, max_batch_size);
+    }
+    size += matrix_arena_size(lamp_nn_workspace_size(inputs, specs, connection_count, max_batch_size), 1);
+    return size;
+}
+
+// Take the next unused matrix header and let it point to freshly pushed elements
+static LampMatrix *arena_matrix(LampArena *arena, LampMatrix **headers, size_t rows, size_t cols) {
+    LampMatrix *mat = (*headers)++;
+    mat->num_rows = rows;
+    mat->num_cols = cols;
+    mat->elements = lamp_arena_push(arena, sizeof(LAMP_FLOAT_TYPE) * rows * cols);
+    return mat;
+}
+
+// Take the next unused matrix header and let it point to the next elements of a parameter or gradient block.
+// The block uses the same padding as the arena.
+static LampMatrix *external_matrix(LAMP_FLOAT_TYPE **next, LampMatrix **headers, size_t rows, size_t cols) {
+    LampMatrix *mat = (*headers)++;
+    mat->num_rows = rows;
+    mat->num_cols = cols;
+    mat->elements = *next;
+    *next += matrix_arena_size(rows, cols) / sizeof(LAMP_FLOAT_TYPE);
+    return mat;
+}
+
+// Take the next unused matrix header for a matrix, whose elements are not stored, i.e. the dense weights of a
+// connection, that keeps only its sparse weights
+static LampMatrix *absent_matrix(LampMatrix **headers, size_t rows, size_t cols) {
+    LampMatrix *mat = (*headers)++;
+    mat->num_rows = rows;
+    mat->num_cols = cols;
+    mat->elements = NULL;
+    return mat;
+}
+
+LampNN *lamp_nn_alloc_batched(const size_t architecture[], size_t layer_count, size_t max_batch_size) {
     assert(architecture != NULL);
     assert(layer_count >= 2); // Require at least 1 input and 1 output layer
 
-    LampNN *nn = malloc(sizeof(LampNN));
-    assert(nn != NULL);
-
-    nn->layer_count = layer_count;
-    nn->connection_count = layer_count - 1; // 2 layers are connected by 1 connection
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampNNConnectionSpec *specs = calloc(layer_count - 1, sizeof(LampNNConnectionSpec));
+    assert(specs != NULL);
+    for (size_t i = 0; i + 1 < layer_count; ++i) {
+        specs[i].kind = LAMP_CONNECTION_DENSE;
+        specs[i].outputs = architecture[i + 1];
+    }
+    LampNN *nn = nn_alloc(architecture[0], specs, layer_count - 1, max_batch_size, NULL, NULL);
+    free(specs);
+    return nn;
+}
 
-    nn->layers = malloc(sizeof(LampNNLayer) * nn->layer_count);
-    nn->connections = malloc(sizeof(LampNNConnection) * nn->connection_count);
+LampNN *lamp_nn_alloc_layers(size_t inputs, const LampNNConnectionSpec connections[], size_t connection_count,
+                             size_t max_batch_size) {
+    return nn_alloc(inputs, connections, connection_count, max_batch_size, NULL, NULL);
+}
 
-    for (size_t i = 0; i < nn->layer_count; i++) {
-        nn->layers[i].activations = lamp_mat_alloc(architecture[i], 1);
+static LampNN *nn_alloc(size_t inputs, const LampNNConnectionSpec specs[], size_t connection_count,
+                        size_t max_batch_size, const bool sparse_only[], LAMP_FLOAT_TYPE *external_params) {
+    assert(specs != NULL);
+    assert(inputs >= 1 && connection_count >= 1); // Require at least 1 input and 1 output layer
+    assert(max_batch_size >= 1);
+    for (size_t i = 0, neurons = inputs; i < connection_count; ++i) {
+        assert(connection_spec_valid(&specs[i], neurons));
+        assert(sparse_only == NULL || !sparse_only[i] || specs[i].kind == LAMP_CONNECTION_DENSE);
+        neurons = connection_outputs(&specs[i], neurons);
     }
 
-    for (size_t j = 0; j < nn->connection_count; ++j) {
+    bool external = external_params != NULL;
+    LampArena *arena = lamp_arena_alloc(lamp_nn_arena_size(inputs, specs, connection_count, max_batch_size,
+                                                           sparse_only, external));
+
+    LampNN *nn = lamp_arena_push(arena, sizeof(LampNN));
+    nn->arena = arena;
+    nn->layer_count = connection_count + 1; // 2 layers are connected by 1 connection
+    nn->connection_count = connection_count;
+    nn->max_batch_size = max_batch_size;
+
+    nn->layers = lamp_arena_push(arena, sizeof(LampNNLayer) * nn->layer_count);
+    nn->connections = lamp_arena_push(arena, sizeof(LampNNConnection) * nn->connection_count);
+    LampMatrix *headers = lamp_arena_push(arena, sizeof(LampMatrix) * (MATRICES_PER_LAYER * nn->layer_count +
+                                                                      MATRICES_PER_CONNECTION * nn->connection_count));
+
+    nn->params_size = lamp_nn_params_bytes(inputs, specs, connection_count, sparse_only) / sizeof(LAMP_FLOAT_TYPE);
+    nn->params = external ? external_params : lamp_arena_push(arena, nn->params_size * sizeof(LAMP_FLOAT_TYPE));
+    LAMP_FLOAT_TYPE *next_param = nn->params;
+    for (size_t j = 0, neurons = inputs; j < nn->connection_count; ++j) {
         LampNNConnection *conn = &nn->connections[j];
         conn->layer_begin = &nn->layers[j];
         conn->layer_end = &nn->layers[j + 1];
-        conn->weights = lamp_mat_alloc(conn->layer_end->activations->num_rows,
-                                       conn->layer_begin->activations->num_rows);
-        conn->bias = lamp_mat_alloc(nn->layers[j + 1].activations->num_rows, 1);
+        conn->kind = specs[j].kind;
+        conn->shape = specs[j].shape;
+        conn->rate = specs[j].rate;
+        const LampNNLayerOps *ops = lamp_nn_layer_ops(conn->kind);
+        conn->activation = ops->default_activation;
+
+        size_t rows, cols;
+        ops->params(&specs[j], neurons, &rows, &cols);
+        bool dense = sparse_only == NULL || !sparse_only[j];
+        conn->weights = dense ? external_matrix(&next_param, &headers, rows, cols) :
+                        absent_matrix(&headers, rows, cols);
+        conn->bias = external_matrix(&next_param, &headers, rows, 1);
+        // External parameters were initialized by whoever owns them
+        if (!external && ops->init != NULL) {
+            ops->init(conn);
+        }
+        neurons = connection_outputs(&specs[j], neurons);
+    }
+
+    // The gradients mirror the layout of the parameters
+    nn->grads = lamp_arena_push(arena, nn->params_size * sizeof(LAMP_FLOAT_TYPE));
+    LAMP_FLOAT_TYPE *next_grad = nn->grads;
+    for (size_t j = 0; j < nn->connection_count; ++j) {
+        LampNNConnection *conn = &nn->connections[j];
+        size_t rows = conn->weights->num_rows, cols = conn->weights->num_cols;
+        conn->weights_grad = conn->weights->elements != NULL ? external_matrix(&next_grad, &headers, rows, cols) :
+                             absent_matrix(&headers, rows, cols);
+        conn->bias_grad = external_matrix(&next_grad, &headers, conn->bias->num_rows, conn->bias->num_cols);
     }
 
+    for (size_t i = 0, neurons = inputs; i < nn->layer_count; i++) {
+        neurons = i == 0 ? inputs : connection_outputs(&specs[i - 1], neurons);
+        nn->layers[i].activations = arena_matrix(arena, &headers, neurons, max_batch_size);
+        nn->layers[i].deltas = arena_matrix(arena, &headers, neurons, max_batch_size);
+        nn->layers[i].weighted_inputs = i == 0 ? NULL : arena_matrix(arena, &headers, neurons, max_batch_size);
+    }
+
+    size_t workspace_size = lamp_nn_workspace_size(inputs, specs, connection_count, max_batch_size);
+    nn->workspace = workspace_size > 0 ? lamp_arena_push(arena, sizeof(LAMP_FLOAT_TYPE) * workspace_size) : NULL;
+
+    assert(arena->used == arena->capacity);
     return nn;
 }
 
+// The specs, that nn was allocated with
+static LampNNConnectionSpec *connection_specs(const LampNN *nn) {
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampNNConnectionSpec *specs = malloc(sizeof(LampNNConnectionSpec) * nn->connection_count);
+    assert(specs != NULL);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        specs[i].kind = nn->connections[i].kind;
+        specs[i].outputs = nn->connections[i].layer_end->activations->num_rows;
+        specs[i].shape = nn->connections[i].shape;
+        specs[i].rate = nn->connections[i].rate;
+    }
+    return specs;
+}
+
+// The settings, that are not part of the specs
+static void copy_connection_settings(LampNN *dst, const LampNN *src) {
+    dst->seed = src->seed;
+    for (size_t i = 0; i < src->connection_count; ++i) {
+        dst->connections[i].activation = src->connections[i].activation;
+        dst->connections[i].conv_algorithm = src->connections[i].conv_algorithm;
+    }
+}
+
+// Whether each connection of nn keeps only its sparse weights. With drop_dense all pruned connections do.
+static bool *sparse_only_connections(const LampNN *nn, bool drop_dense) {
+    // TODO: Propagate memory allocation error instead of asserting here
+    bool *sparse_only = malloc(sizeof(bool) * nn->connection_count);
+    assert(sparse_only != NULL);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        const LampNNConnection *conn = &nn->connections[i];
+        sparse_only[i] = conn->weights->elements == NULL || (drop_dense && conn->sparse_weights != NULL);
+    }
+    return sparse_only;
+}
+
+// Allocate a network with its own copy of the parameters and sparse weights of nn
+static LampNN *nn_alloc_copy(const LampNN *nn, size_t max_batch_size, bool drop_dense) {
+    assert(nn != NULL);
+
+    LampNNConnectionSpec *specs = connection_specs(nn);
+    bool *sparse_only = sparse_only_connections(nn, drop_dense);
+    LampNN *copy = nn_alloc(nn->layers[0].activations->num_rows, specs, nn->connection_count, max_batch_size,
+                            sparse_only, NULL);
+    free(specs);
+    free(sparse_only);
+
+    copy_connection_settings(copy, nn);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        const LampNNConnection *src = &nn->connections[i];
+        LampNNConnection *dst = &copy->connections[i];
+        if (dst->weights->elements != NULL) {
+            memcpy(dst->weights->elements, src->weights->elements,
+                   sizeof(LAMP_FLOAT_TYPE) * LAMP_MAT_NUM_ELEMENTS(src->weights));
+        }
+        memcpy(dst->bias->elements, src->bias->elements, sizeof(LAMP_FLOAT_TYPE) * LAMP_MAT_NUM_ELEMENTS(src->bias));
+        if (src->sparse_weights != NULL) {
+            dst->sparse_weights = lamp_sparse_mat_alloc_copy(src->sparse_weights);
+        }
+    }
+    return copy;
+}
+
+LampNN *lamp_nn_alloc_copy(const LampNN *nn, size_t max_batch_size) {
+    return nn_alloc_copy(nn, max_batch_size, false);
+}
+
+LampNN *lamp_nn_alloc_inference_copy(const LampNN *nn, size_t max_batch_size) {
+    return nn_alloc_copy(nn, max_batch_size, true);
+}
+
+LampNN *lamp_nn_alloc_replica(const LampNN *nn, size_t max_batch_size) {
+    assert(nn != NULL);
+
+    LampNNConnectionSpec *specs = connection_specs(nn);
+    bool *sparse_only = sparse_only_connections(nn, false);
+    LampNN *replica = nn_alloc(nn->layers[0].activations->num_rows, specs, nn->connection_count, max_batch_size,
+                               sparse_only, nn->params);
+    free(specs);
+    free(sparse_only);
+
+    copy_connection_settings(replica, nn);
+    replica->replica = true;
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        replica->connections[i].sparse_weights = nn->connections[i].sparse_weights;
+    }
+    return replica;
+}
+
+bool lamp_nn_trainable(const LampNN *nn) {
+    assert(nn != NULL);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        if (nn->connections[i].weights->elements == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void lamp_nn_free(LampNN *nn) {
     assert(nn != NULL);
+    for (size_t i = 0; i < nn->connection_count && !nn->replica; ++i) {
+        if (nn->connections[i].sparse_weights != NULL) {
+            lamp_sparse_mat_free(nn->connections[i].sparse_weights);
+        }
+    }
+    if (nn->mapping != NULL) {
+        munmap(nn->mapping, nn->mapping_size);
+    }
+    // The network itself lives in the arena, so this releases everything
+    lamp_arena_free(nn->arena);
+}
+
+// Layout of a model file. All values use the byte order of the machine, that saved the model, which is
+// recorded by byte_order, so a file from a machine with a different one is rejected instead of misread.
+// The header is followed by the architecture (layer_count uint64 values), a LampNNFileConnection for each
+// connection and - at params_offset - the parameter block of the network exactly as it is found in memory.
+// The sparse blocks of the connections, that keep only their sparse weights, follow it in the order of the
+// connections. params_offset is aligned, so the matrices of a mapped file are aligned just like the ones in the
+// arena.
+#define LAMP_NN_FILE_MAGIC "LAMPNN\0"
+#define LAMP_NN_FILE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t float_size;
+    uint32_t byte_order;
+    uint32_t layer_count;
+    uint64_t params_offset;
+    uint64_t params_size;
+    uint8_t reserved[24];
+} LampNNFileHeader;
+
+_Static_assert(sizeof(LampNNFileHeader) == LAMP_ARENA_ALIGNMENT, "The file header has to fill one cache line");
+
+// How a connection stores its weights
+typedef enum {
+    LAMP_NN_FILE_DENSE = 0,
+    // Pruned, the sparse weights are built from the non-zero dense weights again when the file is loaded
+    LAMP_NN_FILE_PRUNED,
+    // Only the sparse weights are stored, in the sparse block at sparse_offset
+    LAMP_NN_FILE_SPARSE,
+    LAMP_NN_FILE_STORAGE_COUNT
+} LampNNFileStorage;
+
+// Kind, activation, the shape of convolutions and poolings and the rate of dropouts (zero for all other kinds).
+// storage is a LampNNFileStorage, num_nonzeros and sparse_offset are only used by LAMP_NN_FILE_SPARSE.
+typedef struct {
+    uint32_t activation;
+    uint32_t kind;
+    uint32_t in_channels;
+    uint32_t in_height;
+    uint32_t in_width;
+    uint32_t out_channels;
+    uint32_t kernel_size;
+    uint32_t stride;
+    uint32_t padding;
+    float rate;
+    uint32_t storage;
+    uint32_t reserved;
+    uint64_t num_nonzeros;
+    uint64_t sparse_offset;
+} LampNNFileConnection;
+
+_Static_assert(sizeof(LampNNFileConnection) == LAMP_ARENA_ALIGNMENT, "A connection has to fill one cache line");
+
+static uint64_t lamp_nn_file_params_offset(size_t layer_count) {
+    return LAMP_ARENA_ALIGNED_SIZE(sizeof(LampNNFileHeader) + sizeof(uint64_t) * layer_count +
+                                   sizeof(LampNNFileConnection) * (layer_count - 1));
+}
+
+// A sparse block holds the row offsets (num_rows + 1 uint64 values), the column indices and the values of a
+// sparse matrix, each padded to a cache line
+static uint64_t lamp_nn_file_sparse_size(size_t rows, size_t nonzeros) {
+    return LAMP_ARENA_ALIGNED_SIZE(sizeof(uint64_t) * (rows + 1)) +
+           LAMP_ARENA_ALIGNED_SIZE(sizeof(uint32_t) * nonzeros) +
+           LAMP_ARENA_ALIGNED_SIZE(sizeof(LAMP_FLOAT_TYPE) * nonzeros);
+}
+
+static LampNNFileStorage file_storage(const LampNNConnection *conn) {
+    if (conn->sparse_weights == NULL) {
+        return LAMP_NN_FILE_DENSE;
+    }
+    return conn->weights->elements != NULL ? LAMP_NN_FILE_PRUNED : LAMP_NN_FILE_SPARSE;
+}
+
+// Write the zeros, that pad size bytes to a cache line
+static bool write_padding(FILE *file, size_t size) {
+    static const unsigned char zeros[LAMP_ARENA_ALIGNMENT] = {0};
+    size_t padding = LAMP_ARENA_ALIGNED_SIZE(size) - size;
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+static bool write_sparse_block(FILE *file, const LampSparseMatrix *mat) {
+    bool success = true;
+    for (size_t i = 0; i <= mat->num_rows && success; ++i) {
+        uint64_t offset = mat->row_offsets[i];
+        success = fwrite(&offset, sizeof(offset), 1, file) == 1;
+    }
+    return success && write_padding(file, sizeof(uint64_t) * (mat->num_rows + 1)) &&
+           fwrite(mat->col_indices, sizeof(uint32_t), mat->num_nonzeros, file) == mat->num_nonzeros &&
+           write_padding(file, sizeof(uint32_t) * mat->num_nonzeros) &&
+           fwrite(mat->values, sizeof(LAMP_FLOAT_TYPE), mat->num_nonzeros, file) == mat->num_nonzeros &&
+           write_padding(file, sizeof(LAMP_FLOAT_TYPE) * mat->num_nonzeros);
+}
+
+bool lamp_nn_save(const LampNN *nn, const char *path) {
+    assert(nn != NULL && path != NULL);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    LampNNFileHeader header = {
+            .version = LAMP_NN_FILE_VERSION,
+            .float_size = sizeof(LAMP_FLOAT_TYPE),
+            .byte_order = LAMP_NN_FILE_BYTE_ORDER,
+            .layer_count = (uint32_t) nn->layer_count,
+            .params_offset = lamp_nn_file_params_offset(nn->layer_count),
+            .params_size = nn->params_size,
+    };
+    memcpy(header.magic, LAMP_NN_FILE_MAGIC, sizeof(header.magic));
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (size_t i = 0; i < nn->layer_count && success; ++i) {
+        uint64_t neurons = nn->layers[i].activations->num_rows;
+        success = fwrite(&neurons, sizeof(neurons), 1, file) == 1;
+    }
+    // The sparse blocks follow the parameter block, whose size is a multiple of the alignment
+    uint64_t next_sparse = header.params_offset + sizeof(LAMP_FLOAT_TYPE) * nn->params_size;
+    for (size_t i = 0; i < nn->connection_count && success; ++i) {
+        const LampNNConnection *conn = &nn->connections[i];
+        LampNNFileConnection record = {
+                .activation = conn->activation,
+                .kind = conn->kind,
+                .in_channels = (uint32_t) conn->shape.in_channels,
+                .in_height = (uint32_t) conn->shape.in_height,
+                .in_width = (uint32_t) conn->shape.in_width,
+                .out_channels = (uint32_t) conn->shape.out_channels,
+                .kernel_size = (uint32_t) conn->shape.kernel_size,
+                .stride = (uint32_t) conn->shape.stride,
+                .padding = (uint32_t) conn->shape.padding,
+                .rate = (float) conn->rate,
+                .storage = file_storage(conn),
+        };
+        if (record.storage == LAMP_NN_FILE_SPARSE) {
+            record.num_nonzeros = conn->sparse_weights->num_nonzeros;
+            record.sparse_offset = next_sparse;
+            next_sparse += lamp_nn_file_sparse_size(conn->sparse_weights->num_rows, record.num_nonzeros);
+        }
+        success = fwrite(&record, sizeof(record), 1, file) == 1;
+    }
+
+    // Pad up to the aligned parameter block
+    if (success) {
+        long position = ftell(file);
+        success = position >= 0 && LAMP_ARENA_ALIGNED_SIZE((uint64_t) position) == header.params_offset &&
+                  write_padding(file, (size_t) position);
+    }
+    success = success && fwrite(nn->params, sizeof(LAMP_FLOAT_TYPE), nn->params_size, file) == nn->params_size;
+    for (size_t i = 0; i < nn->connection_count && success; ++i) {
+        if (file_storage(&nn->connections[i]) == LAMP_NN_FILE_SPARSE) {
+            success = write_sparse_block(file, nn->connections[i].sparse_weights);
+        }
+    }
+
+    return fclose(file) == 0 && success;
+}
+
+// Check, that the memory nn_alloc sizes for a connection of a model file can be computed without overflowing.
+// Its parameters have to fit into the params_left elements of the parameter block, that are not taken by the
+// connections before it, a sparse_only connection has no dense weights there. Its layer and workspace for
+// max_batch_size samples must not exceed limit elements. The workspace grows linearly with the batch size. The
+// spec has to be valid already.
+static bool file_connection_fits(const LampNNConnectionSpec *spec, size_t inputs, size_t max_batch_size,
+                                 size_t limit, bool sparse_only, size_t *params_left) {
+    const LampNNLayerOps *ops = lamp_nn_layer_ops(spec->kind);
+    size_t rows, cols;
+    ops->params(spec, inputs, &rows, &cols);
+    size_t weights = rows;
+    if (!lamp_nn_size_mul(&weights, cols)) {
+        return false;
+    }
+    weights = sparse_only ? 0 : weights;
+    if (weights > *params_left || rows > *params_left - weights) {
+        return false;
+    }
+    *params_left -= weights + rows;
+
+    size_t layer = connection_outputs(spec, inputs);
+    size_t workspace = ops->workspace_size != NULL ? ops->workspace_size(spec, inputs, 1) : 0;
+    return lamp_nn_size_mul(&layer, max_batch_size) && layer <= limit &&
+           lamp_nn_size_mul(&workspace, max_batch_size) && workspace <= limit;
+}
+
+// Check, that the sparse block of a connection with [rows, cols] weights starts at next and fits into the file of
+// size bytes, and move next behind it. It must not have more elements than the dense weights. rows * cols has to
+// be checked already.
+static bool file_sparse_fits(const LampNNFileConnection *record, size_t rows, size_t cols, size_t size,
+                             uint64_t *next) {
+    // Bound the sizes by the file before the size of the block is computed from them
+    if (record->sparse_offset != *next || *next > size || record->num_nonzeros > rows * cols ||
+        rows >= (size - *next) / sizeof(uint64_t) ||
+        record->num_nonzeros > (size - *next) / (sizeof(uint32_t) + sizeof(LAMP_FLOAT_TYPE))) {
+        return false;
+    }
+    *next += lamp_nn_file_sparse_size(rows, (size_t) record->num_nonzeros);
+    return *next <= size;
+}
+
+// Point the sparse weights of a loaded connection to its sparse block in the mapping. Returns NULL for an invalid
+// block.
+static LampSparseMatrix *mapped_sparse_weights(unsigned char *mapping, const LampNNFileConnection *record,
+                                               size_t rows, size_t cols) {
+    size_t nonzeros = (size_t) record->num_nonzeros;
+    const uint64_t *row_offsets = (const uint64_t *) (mapping + record->sparse_offset);
+    unsigned char *col_indices = (unsigned char *) row_offsets + LAMP_ARENA_ALIGNED_SIZE(sizeof(uint64_t) * (rows + 1));
+    unsigned char *values = col_indices + LAMP_ARENA_ALIGNED_SIZE(sizeof(uint32_t) * nonzeros);
+    return lamp_sparse_mat_alloc_external(rows, cols, nonzeros, row_offsets, (uint32_t *) col_indices,
+                                          (LAMP_FLOAT_TYPE *) values);
+}
+
+LampNN *lamp_nn_load(const char *path, size_t max_batch_size) {
+    assert(path != NULL);
+    assert(max_batch_size >= 1);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(LampNNFileHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    // A private mapping shares the physical pages with every other process mapping the same file. Pages are only
+    // copied, once the network writes to them - e.g. when it is trained further. The file itself never changes.
+    size_t size = (size_t) info.st_size;
+    unsigned char *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
 
-    for (size_t i = 0; i < nn->connection_count; i++) {
-        lamp_mat_free(nn->connections[i].weights);
-        lamp_mat_free(nn->connections[i].bias);
+    const LampNNFileHeader *header = (const LampNNFileHeader *) mapping;
+    bool valid = memcmp(header->magic, LAMP_NN_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == LAMP_NN_FILE_VERSION &&
+                 header->float_size == sizeof(LAMP_FLOAT_TYPE) &&
+                 header->byte_order == LAMP_NN_FILE_BYTE_ORDER &&
+                 header->layer_count >= 2 &&
+                 // Bound the layer count by the file before anything is computed from it
+                 header->layer_count <= (size - sizeof(LampNNFileHeader)) /
+                                        (sizeof(uint64_t) + sizeof(LampNNFileConnection)) &&
+                 header->params_offset == lamp_nn_file_params_offset(header->layer_count) &&
+                 header->params_offset <= size &&
+                 header->params_size <= (size - header->params_offset) / sizeof(LAMP_FLOAT_TYPE);
+
+    size_t layer_count = valid ? header->layer_count : 0;
+    LampNNConnectionSpec *specs = valid ? calloc(layer_count - 1, sizeof(LampNNConnectionSpec)) : NULL;
+    bool *sparse_only = valid ? calloc(layer_count - 1, sizeof(bool)) : NULL;
+    // TODO: Propagate memory allocation error instead of asserting here
+    assert(!valid || (specs != NULL && sparse_only != NULL));
+    const uint64_t *neurons = (const uint64_t *) (mapping + sizeof(LampNNFileHeader));
+    const LampNNFileConnection *records = (const LampNNFileConnection *) (neurons + layer_count);
+    // Every layer is allocated three times (activations, deltas and weighted inputs), so with this limit on the
+    // elements of each layer and the workspace the size of the arena can not overflow
+    size_t limit = SIZE_MAX / (4 * sizeof(LAMP_FLOAT_TYPE) * (layer_count + 1));
+    size_t params_left = valid ? (size_t) header->params_size : 0;
+    size_t input_layer = valid ? (size_t) neurons[0] : 0;
+    valid = valid && neurons[0] > 0 && input_layer == neurons[0] && lamp_nn_size_mul(&input_layer, max_batch_size) &&
+            input_layer <= limit;
+    for (size_t i = 0; i + 1 < layer_count && valid; ++i) {
+        const LampNNFileConnection *record = &records[i];
+        specs[i] = (LampNNConnectionSpec) {
+                .kind = (LampConnectionKind) record->kind,
+                .outputs = (size_t) neurons[i + 1],
+                .shape = {
+                        .in_channels = record->in_channels,
+                        .in_height = record->in_height,
+                        .in_width = record->in_width,
+                        .out_channels = record->out_channels,
+                        .kernel_size = record->kernel_size,
+                        .stride = record->stride,
+                        .padding = record->padding,
+                },
+                .rate = record->rate,
+        };
+        sparse_only[i] = record->storage == LAMP_NN_FILE_SPARSE;
+        // The size of every layer follows from the connection before it, but is stored to validate the file
+        valid = record->activation < LAMP_ACTIVATION_COUNT && record->kind < LAMP_CONNECTION_KIND_COUNT &&
+                record->storage < LAMP_NN_FILE_STORAGE_COUNT &&
+                (record->storage == LAMP_NN_FILE_DENSE || record->kind == LAMP_CONNECTION_DENSE) &&
+                connection_spec_valid(&specs[i], (size_t) neurons[i]) &&
+                connection_outputs(&specs[i], (size_t) neurons[i]) == neurons[i + 1] &&
+                file_connection_fits(&specs[i], (size_t) neurons[i], max_batch_size, limit, sparse_only[i],
+                                     &params_left);
+    }
+    valid = valid && lamp_nn_params_bytes((size_t) neurons[0], specs, layer_count - 1, sparse_only) ==
+                     header->params_size * sizeof(LAMP_FLOAT_TYPE);
+    uint64_t next_sparse = valid ? header->params_offset + header->params_size * sizeof(LAMP_FLOAT_TYPE) : 0;
+    for (size_t i = 0; i + 1 < layer_count && valid; ++i) {
+        if (sparse_only[i]) {
+            valid = file_sparse_fits(&records[i], (size_t) neurons[i + 1], (size_t) neurons[i], size, &next_sparse);
+        }
     }
 
-    for (size_t j = 0; j < nn->layer_count; ++j) {
-        lamp_mat_free(nn->layers[j].activations);
+    LampNN *nn = NULL;
+    if (valid) {
+        nn = nn_alloc((size_t) neurons[0], specs, layer_count - 1, max_batch_size, sparse_only,
+                      (LAMP_FLOAT_TYPE *) (mapping + header->params_offset));
+        nn->mapping = mapping;
+        nn->mapping_size = size;
+    }
+    for (size_t i = 0; nn != NULL && i < nn->connection_count && valid; ++i) {
+        LampNNConnection *conn = &nn->connections[i];
+        conn->activation = (LampActivation) records[i].activation;
+        if (records[i].storage == LAMP_NN_FILE_PRUNED) {
+            conn->sparse_weights = lamp_sparse_mat_alloc_from_dense(conn->weights);
+        } else if (records[i].storage == LAMP_NN_FILE_SPARSE) {
+            // The column indices and values are only checked now, they are used right from the mapping
+            conn->sparse_weights = mapped_sparse_weights(mapping, &records[i], conn->weights->num_rows,
+                                                         conn->weights->num_cols);
+            valid = conn->sparse_weights != NULL;
+        }
+    }
+    free(specs);
+    free(sparse_only);
+
+    if (!valid) {
+        if (nn != NULL) {
+            // Also unmaps the file
+            lamp_nn_free(nn);
+        } else {
+            munmap(mapping, size);
+        }
+        return NULL;
     }
+    return nn;
+}
+
+void lamp_nn_set_batch_size(LampNN *nn, size_t batch_size) {
+    assert(nn != NULL);
+    assert(batch_size >= 1 && batch_size <= nn->max_batch_size);
+
+    // The matrices are allocated for max_batch_size columns, so we can simply use less of them
+    for (size_t i = 0; i < nn->layer_count; ++i) {
+        nn->layers[i].activations->num_cols = batch_size;
+        nn->layers[i].deltas->num_cols = batch_size;
+        if (nn->layers[i].weighted_inputs != NULL) {
+            nn->layers[i].weighted_inputs->num_cols = batch_size;
+        }
+    }
+}
 
-    free(nn->connections);
-    free(nn->layers);
-    free(nn);
+void lamp_nn_set_activation(LampNN *nn, size_t connection, LampActivation activation) {
+    assert(nn != NULL && connection < nn->connection_count);
+    assert(activation < LAMP_ACTIVATION_COUNT);
+    nn->connections[connection].activation = activation;
 }
 
-// TODO: Design a way to specify activation function instead of hard coding it here.
-#define LAMP_EXP(x) expf(x)
+void lamp_nn_set_conv_algorithm(LampNN *nn, size_t connection, LampConvAlgorithm algorithm) {
+    assert(nn != NULL && connection < nn->connection_count);
+    assert(nn->connections[connection].kind == LAMP_CONNECTION_CONV2D);
+    assert(algorithm == LAMP_CONV_IM2COL || algorithm == LAMP_CONV_DIRECT);
+    nn->connections[connection].conv_algorithm = algorithm;
+}
+
+// Input of a connection with one sample per row, i.e. the input of the first connection
+static LampLayerInput rows_input(const LampMatrixView *samples) {
+    LampLayerInput input = {.elements = samples->elements, .stride = samples->stride, .transposed = true};
+    return input;
+}
+
+// Input of a connection with one sample per column, i.e. the activations of the layer before it
+static LampLayerInput columns_input(const LampMatrix *activations) {
+    LampLayerInput input = {.elements = activations->elements, .stride = activations->num_cols, .transposed = false};
+    return input;
+}
 
-static // Use sigmoid because it is easy and convenient for this test
-LAMP_FLOAT_TYPE sigmoidf(LAMP_FLOAT_TYPE x) {
-    return 1.0f / (1 + LAMP_EXP(-x));
+void lamp_nn_dense_forward(LampMatrix *dst, const LampMatrix *weights, const LampMatrix *input,
+                           const LampMatrix *bias, LampActivation activation) {
+    assert(dst != NULL && weights != NULL && input != NULL && bias != NULL);
+    assert(weights->num_cols == input->num_rows);
+    assert(dst->num_rows == weights->num_rows && dst->num_cols == input->num_cols);
+    LampLayerInput layer_input = columns_input(input);
+    lamp_nn_layer_dense_forward(dst, weights, NULL, &layer_input, bias, activation, NULL);
+}
+
+void lamp_nn_dense_forward_half(LampMatrix *dst, const LampHalfMatrix *weights, const LampHalfMatrix *input,
+                                const LampMatrix *bias, LampActivation activation) {
+    assert(dst != NULL && weights != NULL && input != NULL && bias != NULL);
+    assert(weights->num_cols == input->num_rows);
+    assert(dst->num_rows == weights->num_rows && dst->num_cols == input->num_cols);
+    assert(bias->num_rows == dst->num_rows && bias->num_cols == 1);
+
+    LampGemmEpilogue epilogue = {
+            .row_bias = bias->elements,
+            .activation = lamp_activation_kernel(activation),
+    };
+    lamp_gemm_mixed(false, false, dst->num_rows, dst->num_cols, weights->num_cols,
+                    weights->elements, weights->precision, weights->num_cols,
+                    input->elements, input->precision, input->num_cols,
+                    dst->elements, dst->num_cols, false, &epilogue);
+
+    if (epilogue.activation == NULL) {
+        lamp_activation_forward(activation, dst);
+    }
+}
+
+// The first connection reads the samples from the rows of a matrix view, all others the activations of layer_begin
+static LampLayerInput connection_input(const LampNNConnection *conn, const LampMatrixView *first_input) {
+    return first_input != NULL ? rows_input(first_input) : columns_input(conn->layer_begin->activations);
+}
+
+// Run the connections from first_connection on. If input is given, the first connection reads it instead of the
+// input layer. Only backpropagation trains, its random decisions depend on the step of the network.
+static void lamp_nn_forward_from(LampNN *nn, size_t first_connection, const LampMatrixView *input, bool training) {
+    LampLayerContext ctx = {.workspace = nn->workspace, .training = training};
+    for (size_t i = first_connection; i < nn->connection_count; ++i) {
+        LampNNConnection *conn = &nn->connections[i];
+        LampLayerInput layer_input = connection_input(conn, i == first_connection ? input : NULL);
+        ctx.seed = lamp_nn_layer_seed(nn->seed, nn->step, i);
+        lamp_nn_layer_ops(conn->kind)->forward(conn, &ctx, &layer_input, conn->layer_end->activations,
+                                               conn->layer_end->weighted_inputs);
+    }
 }
 
 void lamp_nn_forward(LampNN *nn) {
     assert(nn != NULL);
     // In the forward pass we perform
-    // [w.rows, w.cols] * [in.rows, in.cols] + [b] = [a]
+    // [w.rows, w.cols] * [in.rows, batch] + [b] = [a]
     // weights * layer_begin + bias = activation
-    // for each layer
+    // for each layer, where the bias is added to every column (sample) of the batch.
+    // Other kinds of connections (see lamp_layer.h) calculate their activations in their own way.
+    lamp_nn_forward_from(nn, 0, NULL, false);
+}
 
-    for (size_t i = 0; i < nn->connection_count; ++i) {
-        LampNNConnection *conn = &nn->connections[i];
-        lamp_mat_multiply_into(conn->layer_end->activations, conn->weights,
-                               conn->layer_begin->activations);
-        lamp_mat_add(conn->layer_end->activations, conn->bias);
-        // TODO: Maybe introduce something like lamp_mat_sigmoid()?
-        for (size_t j = 0; j < conn->layer_end->activations->num_rows; ++j) {
-            for (size_t k = 0; k < conn->layer_end->activations->num_cols; ++k) {
-                LAMP_MAT_ELEMENT_AT(conn->layer_end->activations, j, k) = sigmoidf(
-                        LAMP_MAT_ELEMENT_AT(conn->layer_end->activations, j, k));
+void lamp_nn_forward_view(LampNN *nn, const LampMatrixView *input) {
+    assert(nn != NULL && input != NULL);
+    assert(input->num_cols == nn->layers[0].activations->num_rows);
+
+    lamp_nn_set_batch_size(nn, input->num_rows);
+
+    // The samples are stored in the rows of the input, so the first connection multiplies
+    // with the transposed input instead of the activations of the input layer
+    lamp_nn_forward_from(nn, 0, input, false);
+}
+
+LampNNContext *lamp_nn_context_alloc(const LampNN *nn, size_t max_batch_size) {
+    assert(nn != NULL);
+    assert(max_batch_size >= 1);
+
+    size_t count = nn->layer_count - 1;
+    size_t size = LAMP_ARENA_ALIGNED_SIZE(sizeof(LampNNContext)) + LAMP_ARENA_ALIGNED_SIZE(sizeof(LampMatrix) * count);
+    for (size_t i = 1; i < nn->layer_count; ++i) {
+        size += matrix_arena_size(nn->layers[i].activations->num_rows, max_batch_size);
+    }
+    LampNNConnectionSpec *specs = connection_specs(nn);
+    size_t workspace_size = lamp_nn_workspace_size(nn->layers[0].activations->num_rows, specs, nn->connection_count,
+                                                   max_batch_size);
+    free(specs);
+    size += matrix_arena_size(workspace_size, 1);
+
+    LampArena *arena = lamp_arena_alloc(size);
+    LampNNContext *ctx = lamp_arena_push(arena, sizeof(LampNNContext));
+    ctx->arena = arena;
+    ctx->layer_count = nn->layer_count;
+    ctx->max_batch_size = max_batch_size;
+    ctx->activations = lamp_arena_push(arena, sizeof(LampMatrix) * count);
+    LampMatrix *headers = ctx->activations;
+    for (size_t i = 1; i < nn->layer_count; ++i) {
+        arena_matrix(arena, &headers, nn->layers[i].activations->num_rows, max_batch_size);
+    }
+    ctx->workspace = workspace_size > 0 ? lamp_arena_push(arena, sizeof(LAMP_FLOAT_TYPE) * workspace_size) : NULL;
+
+    assert(arena->used == arena->capacity);
+    return ctx;
+}
+
+void lamp_nn_context_free(LampNNContext *ctx) {
+    assert(ctx != NULL);
+    // The context lives in its own arena
+    lamp_arena_free(ctx->arena);
+}
+
+void lamp_nn_infer(const LampNN *nn, LampNNContext *ctx, const LampMatrixView *input, const LampMatrixView *output) {
+    assert(nn != NULL && ctx != NULL && input != NULL && output != NULL);
+    assert(ctx->layer_count == nn->layer_count);
+    assert(input->num_cols == nn->layers[0].activations->num_rows);
+    assert(output->num_rows == input->num_rows);
+    assert(output->num_cols == nn->layers[nn->layer_count - 1].activations->num_rows);
+
+    LampMatrix *out_activations = &ctx->activations[ctx->layer_count - 2];
+    LampLayerContext layer_ctx = {.workspace = ctx->workspace, .training = false};
+    for (size_t first = 0; first < input->num_rows; first += ctx->max_batch_size) {
+        size_t count = input->num_rows - first < ctx->max_batch_size ? input->num_rows - first : ctx->max_batch_size;
+        LampMatrixView batch = lamp_mat_view_rows(input, first, count);
+
+        // Same as lamp_nn_forward_view(), the first connection reads the samples from the rows of the input
+        for (size_t i = 0; i < nn->connection_count; ++i) {
+            const LampNNConnection *conn = &nn->connections[i];
+            LampMatrix *dst = &ctx->activations[i];
+            assert(dst->num_rows == conn->layer_end->activations->num_rows);
+            dst->num_cols = count;
+            LampLayerInput layer_input = i == 0 ? rows_input(&batch) : columns_input(&ctx->activations[i - 1]);
+            lamp_nn_layer_ops(conn->kind)->forward(conn, &layer_ctx, &layer_input, dst, NULL);
+        }
+
+        // The activations hold one sample per column, the output one per row
+        for (size_t s = 0; s < count; ++s) {
+            for (size_t j = 0; j < out_activations->num_rows; ++j) {
+                LAMP_VIEW_ELEMENT_AT(output, first + s, j) = LAMP_MAT_ELEMENT_AT(out_activations, j, s);
             }
         }
     }
 }
 
 LAMP_FLOAT_TYPE lamp_nn_loss(LampNN *nn, const LampMatrix *input, const LampMatrix *target) {
+    assert(input != NULL && target != NULL);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView target_view = lamp_mat_view(target);
+    return lamp_nn_loss_view(nn, &input_view, &target_view);
+}
+
+LAMP_FLOAT_TYPE lamp_nn_loss_view(LampNN *nn, const LampMatrixView *input, const LampMatrixView *target) {
     assert(nn != NULL && input != NULL && target != NULL);
     assert(input->num_rows == target->num_rows);
-    assert(target->num_cols == nn->layers[nn->layer_count - 1].activations->num_cols);
+    assert(target->num_cols == nn->layers[nn->layer_count - 1].activations->num_rows);
 
     // Loss calculation using mean squared error
     // Loss describes the difference of the calculated value of the nn and the target value out
+    const LampMatrix *out_activations = nn->layers[nn->layer_count - 1].activations;
     LAMP_FLOAT_TYPE loss = 0;
-    for (size_t i = 0; i < input->num_rows; ++i) {
-        // TODO: Find mechanism to assign subsets of matrices to others,
-        //       so we do not have to do this assignment all the time.
-        LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 0, 0) = LAMP_MAT_ELEMENT_AT(input, i, 0);
-        LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, 1, 0) = LAMP_MAT_ELEMENT_AT(input, i, 1);
+    for (size_t first = 0; first < input->num_rows; first += nn->max_batch_size) {
+        size_t count = input->num_rows - first < nn->max_batch_size ? input->num_rows - first : nn->max_batch_size;
+        LampMatrixView batch = lamp_mat_view_rows(input, first, count);
+        lamp_nn_forward_view(nn, &batch);
 
-        lamp_nn_forward(nn);
         for (size_t j = 0; j < target->num_cols; ++j) {
-            LAMP_FLOAT_TYPE diff = LAMP_MAT_ELEMENT_AT(nn->layers[nn->layer_count - 1].activations, 0, j) -
-                                   LAMP_MAT_ELEMENT_AT(target, i, j);
-            loss += diff * diff;
+            for (size_t s = 0; s < count; ++s) {
+                LAMP_FLOAT_TYPE diff = LAMP_MAT_ELEMENT_AT(out_activations, j, s) -
+                                       LAMP_VIEW_ELEMENT_AT(target, first + s, j);
+                loss += diff * diff;
+            }
         }
     }
     return loss / (LAMP_FLOAT_TYPE) input->num_rows;
 }
 
+// Multiply the deltas of the layer at the end of the connection with the derivative of its activation
+static void activation_backward(const LampNNConnection *conn) {
+    LampNNLayer *layer = conn->layer_end;
+    lamp_activation_backward(conn->activation, layer->deltas, layer->activations, layer->weighted_inputs);
+}
+
+void lamp_nn_backprop(LampNN *nn, const LampMatrix *input, const LampMatrix *target) {
+    assert(input != NULL && target != NULL);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView target_view = lamp_mat_view(target);
+    lamp_nn_backprop_view(nn, &input_view, &target_view);
+}
+
+void lamp_nn_backprop_view(LampNN *nn, const LampMatrixView *input, const LampMatrixView *target) {
+    assert(input != NULL);
+    // The loss is the mean over all samples, so every sample contributes 1/n of its own gradient
+    lamp_nn_backprop_view_scaled(nn, input, target, 1.0f / (LAMP_FLOAT_TYPE) input->num_rows);
+}
+
+void lamp_nn_backprop_view_scaled(LampNN *nn, const LampMatrixView *input, const LampMatrixView *target,
+                                  LAMP_FLOAT_TYPE sample_scale) {
+    assert(nn != NULL && input != NULL && target != NULL);
+    assert(input->num_rows == target->num_rows);
+    assert(target->num_cols == nn->layers[nn->layer_count - 1].activations->num_rows);
+    assert(lamp_nn_trainable(nn));
+
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_fill_with(nn->connections[i].weights_grad, 0.0f);
+        lamp_mat_fill_with(nn->connections[i].bias_grad, 0.0f);
+    }
+
+    LampNNLayer *out_layer = &nn->layers[nn->layer_count - 1];
+
+    for (size_t first = 0; first < input->num_rows; first += nn->max_batch_size) {
+        size_t count = input->num_rows - first < nn->max_batch_size ? input->num_rows - first : nn->max_batch_size;
+        LampMatrixView batch = lamp_mat_view_rows(input, first, count);
+        lamp_nn_set_batch_size(nn, count);
+        lamp_nn_forward_from(nn, 0, &batch, true);
+
+        // Deltas of the output layer: d(diff^2)/da * da/dz
+        for (size_t j = 0; j < out_layer->activations->num_rows; ++j) {
+            for (size_t s = 0; s < count; ++s) {
+                LAMP_FLOAT_TYPE diff = LAMP_MAT_ELEMENT_AT(out_layer->activations, j, s) -
+                                       LAMP_VIEW_ELEMENT_AT(target, first + s, j);
+                LAMP_MAT_ELEMENT_AT(out_layer->deltas, j, s) = 2.0f * diff * sample_scale;
+            }
+        }
+        activation_backward(&nn->connections[nn->connection_count - 1]);
+
+        // Walk the connections backwards. The deltas of layer_end are known, so we can accumulate the
+        // gradients of the connection and calculate the deltas of layer_begin from them.
+        // The input layer has no weighted input, so the first connection has no deltas to propagate.
+        LampLayerContext ctx = {.workspace = nn->workspace, .training = true};
+        for (size_t c = nn->connection_count; c-- > 0;) {
+            LampNNConnection *conn = &nn->connections[c];
+            LampLayerInput layer_input = connection_input(conn, c == 0 ? &batch : NULL);
+            LampMatrix *d_begin = c == 0 ? NULL : conn->layer_begin->deltas;
+            ctx.seed = lamp_nn_layer_seed(nn->seed, nn->step, c);
+            lamp_nn_layer_ops(conn->kind)->backward(conn, &ctx, &layer_input, d_begin);
+
+            // d_begin = dL/da_begin (*) f'(z_begin), f being the activation of the previous connection
+            if (c > 0) {
+                activation_backward(&nn->connections[c - 1]);
+            }
+        }
+        nn->step++;
+    }
+}
+
+void lamp_nn_apply_gradients(LampNN *nn, LAMP_FLOAT_TYPE learning_rate) {
+    assert(nn != NULL);
+    assert(lamp_nn_trainable(nn));
+
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampNNConnection *conn = &nn->connections[i];
+        for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(conn->weights); ++j) {
+            conn->weights->elements[j] -= learning_rate * conn->weights_grad->elements[j];
+        }
+        for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(conn->bias); ++j) {
+            conn->bias->elements[j] -= learning_rate * conn->bias_grad->elements[j];
+        }
+    }
+    lamp_nn_apply_pruning(nn);
+}
+
 void lamp_nn_apply_finite_diff_gradients(LampNN *nn, const LampMatrix *input, const LampMatrix *target,
                                          LAMP_FLOAT_TYPE finite_diff_step, LAMP_FLOAT_TYPE learning_rate) {
     assert(nn != NULL && input != NULL && target != NULL);
     assert(fabsf(finite_diff_step) > 1e-6 && fabsf(learning_rate) > 1e-6);
+    assert(lamp_nn_trainable(nn));
+
+    // Like backpropagation, the differences are taken for the dense weights of pruned connections, so the sparse
+    // weights are put aside until the update is done
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampSparseMatrix **sparse_weights = malloc(sizeof(LampSparseMatrix *) * nn->connection_count);
+    assert(sparse_weights != NULL);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        sparse_weights[i] = nn->connections[i].sparse_weights;
+        nn->connections[i].sparse_weights = NULL;
+    }
 
     LAMP_FLOAT_TYPE init_loss = lamp_nn_loss(nn, input, target);
     LAMP_FLOAT_TYPE original_value;
@@ -160,6 +1026,134 @@ void lamp_nn_apply_finite_diff_gradients(LampNN *nn, const LampMatrix *input, co
             }
         }
     }
+
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        nn->connections[i].sparse_weights = sparse_weights[i];
+    }
+    free(sparse_weights);
+    lamp_nn_apply_pruning(nn);
+}
+
+static int compare_floats(const void *a, const void *b) {
+    LAMP_FLOAT_TYPE x = *(const LAMP_FLOAT_TYPE *) a;
+    LAMP_FLOAT_TYPE y = *(const LAMP_FLOAT_TYPE *) b;
+    return (x > y) - (x < y);
+}
+
+void lamp_nn_prune(LampNN *nn, size_t connection, LAMP_FLOAT_TYPE sparsity) {
+    assert(nn != NULL && connection < nn->connection_count);
+    assert(sparsity >= 0.0f && sparsity <= 1.0f);
+
+    LampNNConnection *conn = &nn->connections[connection];
+    assert(conn->kind == LAMP_CONNECTION_DENSE);
+    assert(conn->weights->elements != NULL);
+    if (conn->sparse_weights != NULL) {
+        lamp_sparse_mat_free(conn->sparse_weights);
+        conn->sparse_weights = NULL;
+    }
+    if (sparsity == 0.0f) {
+        return;
+    }
+
+    // Every weight smaller than the pruned_count-th smallest magnitude is removed. Weights of the same magnitude
+    // are either all kept or all removed, so a few less may be pruned.
+    size_t count = LAMP_MAT_NUM_ELEMENTS(conn->weights);
+    size_t pruned_count = (size_t) ((double) sparsity * (double) count);
+    LAMP_FLOAT_TYPE threshold = INFINITY;
+    if (pruned_count < count) {
+        // TODO: Propagate memory allocation error instead of asserting here
+        LAMP_FLOAT_TYPE *magnitudes = malloc(sizeof(LAMP_FLOAT_TYPE) * count);
+        assert(magnitudes != NULL);
+        for (size_t i = 0; i < count; ++i) {
+            magnitudes[i] = LAMP_FABS(conn->weights->elements[i]);
+        }
+        qsort(magnitudes, count, sizeof(LAMP_FLOAT_TYPE), compare_floats);
+        threshold = magnitudes[pruned_count];
+        free(magnitudes);
+    }
+
+    // Weights, that are zero already, are not written. Pruning a loaded model, that was pruned before it was saved,
+    // does not write to the mapped file at all then, so its pages are not copied.
+    for (size_t i = 0; i < count; ++i) {
+        LAMP_FLOAT_TYPE weight = conn->weights->elements[i];
+        if (weight != 0.0f && LAMP_FABS(weight) < threshold) {
+            conn->weights->elements[i] = 0.0f;
+        }
+    }
+    conn->sparse_weights = lamp_sparse_mat_alloc_from_dense(conn->weights);
+}
+
+void lamp_nn_apply_pruning(LampNN *nn) {
+    assert(nn != NULL);
+    assert(lamp_nn_trainable(nn));
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampNNConnection *conn = &nn->connections[i];
+        if (conn->sparse_weights != NULL) {
+            lamp_sparse_mat_sync_from_dense(conn->sparse_weights, conn->weights);
+        }
+    }
+}
+
+LampNNQuantized *lamp_nn_quantize(const LampNN *nn) {
+    assert(nn != NULL);
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampNNQuantized *quantized = malloc(sizeof(LampNNQuantized));
+    assert(quantized != NULL);
+    quantized->connection_count = nn->connection_count;
+    quantized->weights = malloc(sizeof(LampQuantMatrix *) * nn->connection_count);
+    assert(quantized->weights != NULL);
+
+    size_t max_features = 0;
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        const LampNNConnection *conn = &nn->connections[i];
+        assert(conn->kind == LAMP_CONNECTION_DENSE);
+        const LampMatrix *weights = conn->weights;
+        quantized->weights[i] = lamp_quant_mat_alloc(weights->num_rows, weights->num_cols);
+        if (weights->elements != NULL) {
+            lamp_quant_mat_from_float(quantized->weights[i], weights);
+        } else {
+            // Only the sparse weights are kept, the dense ones are restored for the time of the quantization
+            LampMatrix *dense = lamp_mat_alloc(weights->num_rows, weights->num_cols);
+            lamp_sparse_mat_to_dense(dense, conn->sparse_weights);
+            lamp_quant_mat_from_float(quantized->weights[i], dense);
+            lamp_mat_free(dense);
+        }
+        max_features = weights->num_cols > max_features ? weights->num_cols : max_features;
+    }
+    quantized->input = lamp_quant_act_alloc(nn->max_batch_size, max_features);
+
+    return quantized;
+}
+
+void lamp_nn_quantized_free(LampNNQuantized *quantized) {
+    assert(quantized != NULL);
+    for (size_t i = 0; i < quantized->connection_count; ++i) {
+        lamp_quant_mat_free(quantized->weights[i]);
+    }
+    free(quantized->weights);
+    lamp_quant_act_free(quantized->input);
+    free(quantized);
+}
+
+void lamp_nn_forward_quantized(LampNN *nn, LampNNQuantized *quantized) {
+    assert(nn != NULL && quantized != NULL);
+    assert(quantized->connection_count == nn->connection_count);
+
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampNNConnection *conn = &nn->connections[i];
+        LampMatrix *output = conn->layer_end->activations;
+        LampGemmEpilogue epilogue = {
+                .row_bias = conn->bias->elements,
+                .activation = lamp_activation_kernel(conn->activation),
+        };
+
+        lamp_quant_act_from_float(quantized->input, conn->layer_begin->activations);
+        lamp_quant_mat_multiply_into(output, quantized->weights[i], quantized->input, &epilogue);
+        if (epilogue.activation == NULL) {
+            lamp_activation_forward(conn->activation, output);
+        }
+    }
 }
 
 void lamp_nn_print(const LampNN *nn) {
@@ -171,11 +1165,12 @@ void lamp_nn_print(const LampNN *nn) {
     for (size_t i = 0; i < nn->connection_count; ++i) {
         LampNNConnection *con = &nn->connections[i];
 
+        printf("\tc%zu (%s)\n", i + 1, lamp_nn_layer_ops(con->kind)->name);
         printf("\tw%zu\n", i + 1);
         lamp_mat_print(con->weights);
         printf("\tb%zu\n", i + 1);
         lamp_mat_print(con->bias);
-        printf("\ta%zu\n", i + 1);
+        printf("\ta%zu (%s)\n", i + 1, lamp_activation_name(con->activation));
         lamp_mat_print(con->layer_end->activations);
     }
     printf("\n");
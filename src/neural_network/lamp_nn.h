@@ -24,36 +24,149 @@
 #ifndef LAMP_LAMP_NN_H
 #define LAMP_LAMP_NN_H
 
+#include <stdint.h>
 #include "../linear_algebra/lamp_matrix.h"
+#include "../linear_algebra/lamp_half.h"
+#include "../linear_algebra/lamp_quant.h"
+#include "../linear_algebra/lamp_sparse.h"
+#include "../memory/lamp_arena.h"
+#include "lamp_activation.h"
+#include "lamp_conv.h"
 
 // Basic building block of the nn that defines its "structure".
 // A layer contains artificial neurons - most of the time depicted as circles.
 // These neurons are "activated". For our purpose activation describes a value
 // between 0 (not activated) and 1 (fully activated).
+// To process multiple samples at once the activations are stored as a matrix of [neurons, batch size],
+// where every column holds the activations of one sample.
+// During backpropagation every layer additionally stores its deltas - the derivative of the loss with
+// respect to the weighted input of its neurons. It has the same shape as the activations.
+// Activation functions that can not be inverted (see lamp_activation_needs_input()) additionally keep the
+// weighted input of the forward pass. The input layer has no weighted input, so it is NULL there.
 typedef struct {
     LampMatrix *activations;
+    LampMatrix *deltas;
+    LampMatrix *weighted_inputs;
 } LampNNLayer;
 
+// Kind of a connection. A dense connection connects every neuron of layer_end with every neuron of layer_begin.
+// Convolutions and poolings treat both layers as images (see lamp_conv.h): a convolution slides small kernels over
+// the image, which share their weights across all pixels, and a pooling keeps the maximum or average of every window.
+// The remaining kinds keep the size of the layer: a layer normalization scales every sample to zero mean and unit
+// variance and applies a learned gain (the weights) and bias per neuron, a dropout randomly zeroes neurons during
+// training and an activation connection only applies its activation function.
+// Everything, that depends on the kind, is implemented by the layer operations in lamp_layer.h.
+// Poolings, normalizations and dropouts use the linear activation by default.
+typedef enum {
+    LAMP_CONNECTION_DENSE = 0,
+    LAMP_CONNECTION_CONV2D,
+    LAMP_CONNECTION_MAX_POOL,
+    LAMP_CONNECTION_AVG_POOL,
+    LAMP_CONNECTION_LAYER_NORM,
+    LAMP_CONNECTION_DROPOUT,
+    LAMP_CONNECTION_ACTIVATION,
+    LAMP_CONNECTION_KIND_COUNT
+} LampConnectionKind;
+
+// Description of a connection for lamp_nn_alloc_layers(). Dense connections only need the number of outputs,
+// convolutions and poolings only the shape, from which the size of the layer at their end follows. Dropouts need
+// the rate, the probability of a neuron to be dropped. Normalizations and activations need nothing.
+typedef struct {
+    LampConnectionKind kind;
+    size_t outputs;
+    LampConv2dShape shape;
+    LAMP_FLOAT_TYPE rate;
+} LampNNConnectionSpec;
+
 // A connection in this context describes the - well - connection between two layers.
 // Those are mostly depicted as simple straight lines from one node of a layer to all other nodes of another layer.
 // For the ease of understanding we think of the layers as a beginning and end point of the connection.
+// The gradient buffers have the same shape as the weights and bias and are filled by lamp_nn_backprop().
+// The activation function turns the weighted input into the activations of layer_end (sigmoid by default).
+// A connection pruned by lamp_nn_prune() additionally keeps its remaining weights in sparse_weights, which the
+// inference uses instead of the dense weights. Training multiplies the dense weights, whose pruned elements are
+// zero as well. Dense connections leave it NULL. The connections of an inference copy (see
+// lamp_nn_alloc_inference_copy()) keep only the sparse weights, the elements of their weights and weights_grad
+// are NULL then.
+// Convolutions and poolings store their geometry in shape, the weights of a convolution are laid out as described
+// in lamp_conv.h. The weights of a layer normalization are its gains ([neurons, 1]) and the connections without
+// parameters have empty weights and bias. rate is the rate of a dropout.
 typedef struct {
     LampNNLayer *layer_begin;
     LampNNLayer *layer_end;
     LampMatrix *weights;
     LampMatrix *bias;
+    LampMatrix *weights_grad;
+    LampMatrix *bias_grad;
+    LampSparseMatrix *sparse_weights;
+    LampActivation activation;
+    LampConnectionKind kind;
+    LampConv2dShape shape;
+    LampConvAlgorithm conv_algorithm;
+    LAMP_FLOAT_TYPE rate;
 } LampNNConnection;
 
 // The neural network combining layers and connections in one convenient structure.
 // For easy reference we also store the number of individual layers, as well as the
-// amount of connections.
+// amount of connections and the maximum number of samples, that can be processed by one forward pass.
+//
+// The whole network - including all matrices - is stored in one contiguous arena. The weights and biases
+// of all connections follow each other in params, so they can be saved, restored or reset at once.
+// params_size also counts the (always zero) padding that aligns every matrix to a cache line.
+// grads has the same layout and contains the weights_grad and bias_grad matrices.
+// workspace is the scratch memory of the connections, e.g. the columns of the im2col convolutions (see lamp_conv.h).
+// It is only used during the forward or backward pass of one connection, so all of them share it. Its size is
+// planned once by the allocation for the connection, that needs the most, so neither the forward pass nor
+// backpropagation allocate. It is NULL, if no connection needs scratch memory.
+// The dropout masks of a batch are derived from seed and step, the number of batches backpropagated so far.
+// A network loaded by lamp_nn_load() keeps its params in the mapped model file instead of the arena.
+// A replica (see lamp_nn_alloc_replica()) points to the params and sparse weights of the network it was allocated
+// from, which keeps owning them.
+// ATTENTION: The matrices of a network must not be freed with lamp_mat_free()
 typedef struct {
     LampNNLayer *layers;
     size_t layer_count;
     LampNNConnection *connections;
     size_t connection_count;
+    size_t max_batch_size;
+    LampArena *arena;
+    LAMP_FLOAT_TYPE *params;
+    LAMP_FLOAT_TYPE *grads;
+    size_t params_size;
+    LAMP_FLOAT_TYPE *workspace;
+    uint64_t seed;
+    uint64_t step;
+    void *mapping;
+    size_t mapping_size;
+    bool replica;
 } LampNN;
 
+// The activations of one thread for lamp_nn_infer(). The forward pass of lamp_nn_forward() writes into the
+// layers of the network, so only one thread may use a network at a time. lamp_nn_infer() only reads the
+// network and writes into a context instead. Any number of threads can share the weights of one network
+// without locking, as long as every thread uses its own context.
+// activations[i] holds the activations of layer i + 1 as [neurons, max_batch_size], the input layer is read
+// directly from the input. workspace is the scratch memory of the context, like the one of the network.
+typedef struct {
+    LampMatrix *activations;
+    size_t layer_count;
+    size_t max_batch_size;
+    LAMP_FLOAT_TYPE *workspace;
+    LampArena *arena;
+} LampNNContext;
+
+// The weights of a network quantized to 8 bit integers (see lamp_quant.h) for a faster forward pass.
+// Only the weights are stored, the topology, biases and activation functions are taken from the network.
+// input holds the quantized activations of the layer, that is currently multiplied.
+typedef struct {
+    LampQuantMatrix **weights;
+    size_t connection_count;
+    LampQuantActivations *input;
+} LampNNQuantized;
+
+// Version of the binary model format written by lamp_nn_save()
+#define LAMP_NN_FILE_VERSION 4
+
 // Allocate neural network with specified architecture.
 // The architecture is specified by an array of values, that describe the number of neurons
 // of their corresponding layer.
@@ -63,15 +176,139 @@ typedef struct {
 //       explicitly and providing the hidden layer description separately?
 LampNN *lamp_nn_alloc(const size_t architecture[], size_t layer_count);
 
+// Allocate neural network, that processes up to max_batch_size samples in one forward pass.
+// lamp_nn_alloc() is equivalent to a max_batch_size of 1.
+LampNN *lamp_nn_alloc_batched(const size_t architecture[], size_t layer_count, size_t max_batch_size);
+
+// Allocate a network of connection_count connections of any kind, whose input layer has inputs neurons.
+// Every connection has to fit to the layer before it, i.e. the input shape of a convolution or pooling has to
+// have as many pixels as the layer has neurons.
+LampNN *lamp_nn_alloc_layers(size_t inputs, const LampNNConnectionSpec connections[], size_t connection_count,
+                             size_t max_batch_size);
+// Allocate a network with the same layers, activation functions and seed as nn and a copy of its parameters
+LampNN *lamp_nn_alloc_copy(const LampNN *nn, size_t max_batch_size);
+// Same as lamp_nn_alloc_copy(), but the pruned connections of the copy keep only their sparse weights, so a
+// pruned network takes less memory than a dense one. The copy can only be used for inference, it can not be
+// trained or pruned again (see lamp_nn_trainable()).
+LampNN *lamp_nn_alloc_inference_copy(const LampNN *nn, size_t max_batch_size);
+// Allocate a network, that shares the parameters of nn, but has its own activations, deltas and gradients.
+// This is the scratch space of one thread, which runs a part of a batch through the same weights (see
+// lamp_data_parallel.h). The activation functions are copied, changing them later is not shared.
+// ATTENTION: The replica has to be freed before nn, since it points to the parameters of nn. It also shares the
+//            sparse weights of pruned connections, so pruning nn again requires a new replica.
+LampNN *lamp_nn_alloc_replica(const LampNN *nn, size_t max_batch_size);
+
 void lamp_nn_free(LampNN *nn);
 
+// false for networks, whose pruned connections keep only their sparse weights (see lamp_nn_alloc_inference_copy())
+bool lamp_nn_trainable(const LampNN *nn);
+
+// Save architecture (including the kind and shape of every connection), activations, weights and biases of the
+// network in a binary model file. Pruned connections stay pruned, the ones of an inference copy only store their
+// sparse weights.
+// Returns false if the file could not be written.
+bool lamp_nn_save(const LampNN *nn, const char *path);
+
+// Load a network saved by lamp_nn_save(), that processes up to max_batch_size samples in one forward pass.
+// The file is mapped into memory and the weights, biases and sparse weights point directly into the mapping, so
+// nothing is copied and processes loading the same model share one physical copy of it. Changing the parameters
+// (e.g. by training) only changes the memory of this network, not the file.
+// Returns NULL if the file can not be read or is not a valid model of this version. The file is untrusted: a
+// truncated file or sizes, that do not fit into the file or overflow, are rejected as well.
+LampNN *lamp_nn_load(const char *path, size_t max_batch_size);
+
+// Set the number of samples (columns of the activations) processed by the next forward pass.
+// ATTENTION: batch_size must not exceed the max_batch_size the network was allocated with
+void lamp_nn_set_batch_size(LampNN *nn, size_t batch_size);
+
+// Choose the activation function of a connection, i.e. of the layer at its end
+void lamp_nn_set_activation(LampNN *nn, size_t connection, LampActivation activation);
+// Choose how a convolution is computed (im2col by default). Both give the same results up to rounding.
+void lamp_nn_set_conv_algorithm(LampNN *nn, size_t connection, LampConvAlgorithm algorithm);
+
+// Evaluate a single dense layer dst = f(weights * input + bias) for every column (sample) of the input.
+// Bias and activation are fused into the matrix multiplication and applied to each tile of dst while it is
+// still in the cache, instead of running two more passes over dst. Only the softmax needs a second pass,
+// because it normalizes whole columns.
+void lamp_nn_dense_forward(LampMatrix *dst, const LampMatrix *weights, const LampMatrix *input,
+                           const LampMatrix *bias, LampActivation activation);
+
+// Same as lamp_nn_dense_forward, but weights and input are stored in reduced precision (fp16 or bf16).
+// They are widened while the multiplication packs them, the accumulation, bias and activation use full precision.
+// Store dst with lamp_half_mat_from_float() to feed it into the next layer in reduced precision again.
+void lamp_nn_dense_forward_half(LampMatrix *dst, const LampHalfMatrix *weights, const LampHalfMatrix *input,
+                                const LampMatrix *bias, LampActivation activation);
+
+// Calculate the activations of all layers for every sample (column) of the input layer.
+// Each connection is evaluated as one matrix multiplication for the whole batch.
 void lamp_nn_forward(LampNN *nn);
 
+// Calculate the activations for the samples stored in the rows of input, e.g. a view on some rows of a dataset.
+// The input is read directly from the view, the activations of the input layer are not used.
+// Like every forward pass outside of backpropagation this runs in inference mode, so dropouts keep all neurons.
+// ATTENTION: The number of rows must not exceed max_batch_size
+void lamp_nn_forward_view(LampNN *nn, const LampMatrixView *input);
+
+// Allocate a context for networks with the architecture of nn, that processes up to max_batch_size samples at once
+LampNNContext *lamp_nn_context_alloc(const LampNN *nn, size_t max_batch_size);
+
+void lamp_nn_context_free(LampNNContext *ctx);
+
+// Calculate the outputs for the samples stored in the rows of input and store them in the rows of output.
+// Inputs with more rows than the max_batch_size of the context are processed in several batches.
+// The network is not changed, so it can be used by several threads at the same time (see LampNNContext).
+void lamp_nn_infer(const LampNN *nn, LampNNContext *ctx, const LampMatrixView *input, const LampMatrixView *output);
+
+// Mean squared error of the network output for every sample (row) of the input compared to the target
 LAMP_FLOAT_TYPE lamp_nn_loss(LampNN *nn, const LampMatrix *input, const LampMatrix *target);
 
+LAMP_FLOAT_TYPE lamp_nn_loss_view(LampNN *nn, const LampMatrixView *input, const LampMatrixView *target);
+
+// Calculate the gradient of lamp_nn_loss() with respect to every weight and bias of the network using
+// backpropagation. The input is passed forward and its error propagated backwards in batches of
+// max_batch_size samples. Every batch drops other neurons in the dropouts and advances the step of the network.
+// The result is stored in the weights_grad and bias_grad matrices of the connections, the parameters
+// themselves are not changed.
+void lamp_nn_backprop(LampNN *nn, const LampMatrix *input, const LampMatrix *target);
+
+void lamp_nn_backprop_view(LampNN *nn, const LampMatrixView *input, const LampMatrixView *target);
+
+// Same as lamp_nn_backprop_view(), but every sample contributes sample_scale times its own gradient instead of
+// the mean over the input. Splitting a batch of n samples into parts, that are each passed with a sample_scale
+// of 1/n, results in gradients that sum up to the ones of the whole batch.
+void lamp_nn_backprop_view_scaled(LampNN *nn, const LampMatrixView *input, const LampMatrixView *target,
+                                  LAMP_FLOAT_TYPE sample_scale);
+
+// Apply the gradients calculated by lamp_nn_backprop() using plain gradient descent
+void lamp_nn_apply_gradients(LampNN *nn, LAMP_FLOAT_TYPE learning_rate);
+
+// Approximate the gradients by probing every single parameter and immediately apply them.
+// This is very slow and mainly kept to verify the results of lamp_nn_backprop().
+// See lamp_nn_finite_diff_gradients() in lamp_gradient_check.h for a parallel check, that keeps the parameters.
 void lamp_nn_apply_finite_diff_gradients(LampNN *nn, const LampMatrix *input, const LampMatrix *target,
                                          LAMP_FLOAT_TYPE finite_diff_step, LAMP_FLOAT_TYPE learning_rate);
 
+// Magnitude pruning: set the smallest sparsity * weights (by absolute value) of a connection to zero and store
+// the remaining ones in a sparse matrix, which the forward pass (and lamp_nn_infer()) multiplies instead.
+// The pruned weights also stay zero in the dense weights, which training keeps that way (see
+// lamp_nn_apply_pruning()). A sparsity of 0 switches the connection back to dense.
+// ATTENTION: Only dense connections of trainable networks can be pruned.
+void lamp_nn_prune(LampNN *nn, size_t connection, LAMP_FLOAT_TYPE sparsity);
+// Set the pruned weights of all pruned connections back to zero and copy the remaining ones into their sparse
+// weights. lamp_nn_apply_gradients() and the optimizers call this after every update, so a pruned network stays
+// pruned while it is trained and the inference multiplies the updated weights. Call it after changing the
+// weights in any other way.
+void lamp_nn_apply_pruning(LampNN *nn);
+// Quantize the weights of all connections (post-training quantization). Changing the weights of the network
+// afterwards (e.g. by training) requires quantizing it again. All connections have to be dense.
+LampNNQuantized *lamp_nn_quantize(const LampNN *nn);
+
+void lamp_nn_quantized_free(LampNNQuantized *quantized);
+
+// Same as lamp_nn_forward(), but every connection multiplies the quantized weights with its input quantized
+// to 8 bits. This is meant for inference, the weighted inputs needed for training are not kept.
+void lamp_nn_forward_quantized(LampNN *nn, LampNNQuantized *quantized);
+
 void lamp_nn_print(const LampNN *nn);
 
 #endif //LAMP_LAMP_NN_H
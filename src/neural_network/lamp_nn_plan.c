@@ -0,0 +1,263 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "lamp_nn_plan.h"
+#include "lamp_layer.h"
+
+// Dense connections are only multiplied into one, if the product has at most as many weights as both of them,
+// which is what the forward pass multiplies for every sample
+static bool dense_fold_cheaper(const LampMatrix *first, const LampMatrix *second) {
+    return second->num_rows * first->num_cols <=
+           first->num_rows * first->num_cols + second->num_rows * second->num_cols;
+}
+
+// Try to merge conn into the step before it. Returns false if conn needs a step of its own.
+static bool fold_into_previous(LampNNPlanStep *prev, const LampNNConnection *conn, size_t outputs) {
+    LampNNConnection *prev_conn = &prev->connection;
+    if (prev_conn->activation != LAMP_ACTIVATION_LINEAR) {
+        return false;
+    }
+
+    if (conn->kind == LAMP_CONNECTION_ACTIVATION) {
+        prev_conn->activation = conn->activation;
+        return true;
+    }
+
+    if (conn->kind != LAMP_CONNECTION_DENSE || prev_conn->kind != LAMP_CONNECTION_DENSE ||
+        conn->sparse_weights != NULL || prev_conn->sparse_weights != NULL ||
+        !dense_fold_cheaper(prev_conn->weights, conn->weights)) {
+        return false;
+    }
+
+    // W2 * (W1 * x + b1) + b2 = (W2 * W1) * x + (W2 * b1 + b2)
+    LampMatrix *weights = lamp_mat_alloc_multiply(conn->weights, prev_conn->weights);
+    LampMatrix *bias = lamp_mat_alloc_multiply(conn->weights, prev_conn->bias);
+    lamp_mat_add(bias, conn->bias);
+    if (prev->folded_weights != NULL) {
+        lamp_mat_free(prev->folded_weights);
+        lamp_mat_free(prev->folded_bias);
+    }
+    prev->folded_weights = weights;
+    prev->folded_bias = bias;
+    prev_conn->weights = weights;
+    prev_conn->bias = bias;
+    prev_conn->activation = conn->activation;
+    prev->output.num_rows = outputs;
+    return true;
+}
+
+// A tensor of the plan, that takes size bytes of the buffer from step first to step last (both included)
+typedef struct {
+    size_t size;
+    size_t first;
+    size_t last;
+    size_t index;
+} PlanTensor;
+
+// Largest tensors first, the rest in the order of the steps
+static int compare_tensors(const void *a, const void *b) {
+    const PlanTensor *x = a;
+    const PlanTensor *y = b;
+    if (x->size != y->size) {
+        return x->size < y->size ? 1 : -1;
+    }
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static bool tensors_overlap(const PlanTensor *a, const PlanTensor *b) {
+    return a->size > 0 && b->size > 0 && a->first <= b->last && b->first <= a->last;
+}
+
+// Assign an offset in the buffer to every tensor, so that tensors needed at the same time never share memory.
+// This colors the interval graph of the lifetimes with offsets instead of colors: the tensors are placed from the
+// largest to the smallest, each one into the lowest gap between the tensors it overlaps with, that fits.
+// For a chain of layers every output only overlaps with its neighbours, which results in the ping-pong of two
+// buffers. Returns the size of the buffer.
+static size_t plan_offsets(PlanTensor *tensors, size_t count, size_t *offsets) {
+    qsort(tensors, count, sizeof(PlanTensor), compare_tensors);
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    size_t *neighbours = malloc(sizeof(size_t) * (count > 0 ? count : 1));
+    assert(neighbours != NULL);
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        // The placed tensors, that overlap with this one, sorted by their offset
+        size_t neighbour_count = 0;
+        for (size_t j = 0; j < i; ++j) {
+            if (!tensors_overlap(&tensors[i], &tensors[j])) {
+                continue;
+            }
+            size_t k = neighbour_count++;
+            for (; k > 0 && offsets[tensors[neighbours[k - 1]].index] > offsets[tensors[j].index]; --k) {
+                neighbours[k] = neighbours[k - 1];
+            }
+            neighbours[k] = j;
+        }
+
+        size_t offset = 0;
+        for (size_t k = 0; k < neighbour_count; ++k) {
+            const PlanTensor *neighbour = &tensors[neighbours[k]];
+            size_t neighbour_offset = offsets[neighbour->index];
+            if (offset + tensors[i].size <= neighbour_offset) {
+                break;
+            }
+            offset = neighbour_offset + neighbour->size > offset ? neighbour_offset + neighbour->size : offset;
+        }
+        offsets[tensors[i].index] = offset;
+        total = offset + tensors[i].size > total ? offset + tensors[i].size : total;
+    }
+    free(neighbours);
+    return total;
+}
+
+LampNNPlan *lamp_nn_compile(const LampNN *nn, size_t max_batch_size) {
+    assert(nn != NULL);
+    assert(max_batch_size >= 1);
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampNNPlan *plan = malloc(sizeof(LampNNPlan));
+    assert(plan != NULL);
+    plan->steps = calloc(nn->connection_count, sizeof(LampNNPlanStep));
+    assert(plan->steps != NULL);
+    plan->inputs = nn->layers[0].activations->num_rows;
+    plan->max_batch_size = max_batch_size;
+
+    size_t count = 0;
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        // The forward pass of a connection only reads its parameters and settings, not its layers
+        LampNNConnection conn = nn->connections[i];
+        conn.layer_begin = NULL;
+        conn.layer_end = NULL;
+        size_t outputs = nn->connections[i].layer_end->activations->num_rows;
+
+        // A dropout only applies its activation during inference
+        if (conn.kind == LAMP_CONNECTION_DROPOUT) {
+            conn.kind = LAMP_CONNECTION_ACTIVATION;
+        }
+        LampNNPlanStep *prev = count > 0 ? &plan->steps[count - 1] : NULL;
+        if (prev != NULL && conn.kind == LAMP_CONNECTION_ACTIVATION && conn.activation == LAMP_ACTIVATION_LINEAR) {
+            continue;
+        }
+        if (prev != NULL && fold_into_previous(prev, &conn, outputs)) {
+            continue;
+        }
+
+        LampNNPlanStep *step = &plan->steps[count++];
+        step->connection = conn;
+        step->output.num_rows = outputs;
+        step->output.num_cols = max_batch_size;
+    }
+    plan->step_count = count;
+
+    // The output of a step is needed until the next step has read it - the one of the last step until it is
+    // copied to the output - the workspace only during the step itself
+    PlanTensor *tensors = malloc(sizeof(PlanTensor) * 2 * count);
+    size_t *sizes = malloc(sizeof(size_t) * 2 * count);
+    size_t *offsets = malloc(sizeof(size_t) * 2 * count);
+    assert(tensors != NULL && sizes != NULL && offsets != NULL);
+    size_t largest_workspace = 0;
+    plan->unplanned_size = 0;
+    for (size_t i = 0, inputs = plan->inputs; i < count; ++i) {
+        const LampNNConnection *conn = &plan->steps[i].connection;
+        const LampNNLayerOps *ops = lamp_nn_layer_ops(conn->kind);
+        LampNNConnectionSpec spec = {
+                .kind = conn->kind, .outputs = plan->steps[i].output.num_rows, .shape = conn->shape, .rate = conn->rate
+        };
+        size_t workspace_size = ops->workspace_size != NULL ? ops->workspace_size(&spec, inputs, max_batch_size) : 0;
+
+        size_t output_size = LAMP_ARENA_ALIGNED_SIZE(sizeof(LAMP_FLOAT_TYPE) * spec.outputs * max_batch_size);
+        workspace_size = LAMP_ARENA_ALIGNED_SIZE(sizeof(LAMP_FLOAT_TYPE) * workspace_size);
+        sizes[2 * i] = output_size;
+        sizes[2 * i + 1] = workspace_size;
+        tensors[2 * i] = (PlanTensor) {.size = output_size, .first = i, .last = i + 1, .index = 2 * i};
+        tensors[2 * i + 1] = (PlanTensor) {.size = workspace_size, .first = i, .last = i, .index = 2 * i + 1};
+        plan->unplanned_size += output_size;
+        largest_workspace = workspace_size > largest_workspace ? workspace_size : largest_workspace;
+        inputs = spec.outputs;
+    }
+    plan->unplanned_size += largest_workspace;
+    plan->buffer_size = plan_offsets(tensors, 2 * count, offsets);
+
+    plan->buffer = lamp_arena_alloc(plan->buffer_size);
+    unsigned char *base = lamp_arena_push(plan->buffer, plan->buffer_size);
+    for (size_t i = 0; i < count; ++i) {
+        LampNNPlanStep *step = &plan->steps[i];
+        step->output.elements = (LAMP_FLOAT_TYPE *) (base + offsets[2 * i]);
+        step->workspace = sizes[2 * i + 1] > 0 ? (LAMP_FLOAT_TYPE *) (base + offsets[2 * i + 1]) : NULL;
+    }
+
+    free(tensors);
+    free(sizes);
+    free(offsets);
+    return plan;
+}
+
+void lamp_nn_plan_free(LampNNPlan *plan) {
+    assert(plan != NULL);
+    for (size_t i = 0; i < plan->step_count; ++i) {
+        if (plan->steps[i].folded_weights != NULL) {
+            lamp_mat_free(plan->steps[i].folded_weights);
+            lamp_mat_free(plan->steps[i].folded_bias);
+        }
+    }
+    lamp_arena_free(plan->buffer);
+    free(plan->steps);
+    free(plan);
+}
+
+void lamp_nn_plan_infer(LampNNPlan *plan, const LampMatrixView *input, const LampMatrixView *output) {
+    assert(plan != NULL && input != NULL && output != NULL);
+    assert(input->num_cols == plan->inputs);
+    assert(output->num_rows == input->num_rows);
+
+    const LampMatrix *out_activations = &plan->steps[plan->step_count - 1].output;
+    assert(output->num_cols == out_activations->num_rows);
+
+    for (size_t first = 0; first < input->num_rows; first += plan->max_batch_size) {
+        size_t count = input->num_rows - first < plan->max_batch_size ? input->num_rows - first : plan->max_batch_size;
+        LampMatrixView batch = lamp_mat_view_rows(input, first, count);
+
+        // The first step reads the samples from the rows of the input, every other one the output before it
+        for (size_t i = 0; i < plan->step_count; ++i) {
+            LampNNPlanStep *step = &plan->steps[i];
+            step->output.num_cols = count;
+            LampLayerInput layer_input = {.elements = batch.elements, .stride = batch.stride, .transposed = true};
+            if (i > 0) {
+                const LampMatrix *src = &plan->steps[i - 1].output;
+                layer_input = (LampLayerInput) {.elements = src->elements, .stride = src->num_cols};
+            }
+            LampLayerContext ctx = {.workspace = step->workspace, .training = false};
+            lamp_nn_layer_ops(step->connection.kind)->forward(&step->connection, &ctx, &layer_input, &step->output,
+                                                              NULL);
+        }
+
+        for (size_t s = 0; s < count; ++s) {
+            for (size_t j = 0; j < out_activations->num_rows; ++j) {
+                LAMP_VIEW_ELEMENT_AT(output, first + s, j) = LAMP_MAT_ELEMENT_AT(out_activations, j, s);
+            }
+        }
+    }
+}
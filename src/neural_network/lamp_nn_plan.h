@@ -0,0 +1,78 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_NN_PLAN_H
+#define LAMP_LAMP_NN_PLAN_H
+
+#include <stddef.h>
+#include "lamp_nn.h"
+
+// A network compiled for inference. The network keeps the activations, deltas and weighted inputs of every layer
+// for training, while inference only needs the output of a layer until the next one has read it. Compiling
+// analyses how long every intermediate result is needed and packs all of them into one shared buffer, so a deep
+// network runs in about the memory of its two largest neighbouring layers.
+//
+// Compiling also simplifies the network for inference:
+// * Dropouts keep all neurons during inference, so they are removed.
+// * An activation connection behind a connection with the linear activation becomes the activation of that
+//   connection, which applies it in the epilogue of its matrix multiplication.
+// * Two dense connections with a linear activation between them are multiplied into one, if that is cheaper:
+//   W = W2 * W1 and b = W2 * b1 + b2.
+//
+// Every step of a plan runs one (possibly folded) connection. It reads the output of the step before it - the
+// first one reads the samples from the rows of the input - and writes its output as [neurons, batch] into the
+// shared buffer. workspace is its scratch memory in the same buffer.
+// folded_weights and folded_bias hold the parameters of a folded dense connection and are owned by the plan,
+// all other steps use the parameters of the network.
+typedef struct {
+    LampNNConnection connection;
+    LampMatrix output;
+    LAMP_FLOAT_TYPE *workspace;
+    LampMatrix *folded_weights;
+    LampMatrix *folded_bias;
+} LampNNPlanStep;
+
+// buffer_size is the size of the shared buffer in bytes. unplanned_size is what the same outputs and workspaces
+// take without sharing any memory, like in a LampNNContext.
+typedef struct {
+    LampNNPlanStep *steps;
+    size_t step_count;
+    size_t inputs;
+    size_t max_batch_size;
+    size_t buffer_size;
+    size_t unplanned_size;
+    LampArena *buffer;
+} LampNNPlan;
+
+// Compile the network for inference of up to max_batch_size samples at once.
+// The plan uses the parameters of the network, that are not folded, so it has to be freed before the network.
+// ATTENTION: Compile again after changing the parameters, the folded ones are copies
+LampNNPlan *lamp_nn_compile(const LampNN *nn, size_t max_batch_size);
+
+void lamp_nn_plan_free(LampNNPlan *plan);
+
+// Same as lamp_nn_infer(), but runs the compiled steps. The plan writes into its own buffer, so only one thread
+// may use a plan at a time. Threads, that infer at the same time, compile their own plan.
+void lamp_nn_plan_infer(LampNNPlan *plan, const LampMatrixView *input, const LampMatrixView *output);
+
+#endif //LAMP_LAMP_NN_PLAN_H
@@ -0,0 +1,159 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lamp_optimizer.h"
+#include "../linear_algebra/lamp_simd.h"
+#include "../threading/lamp_threadpool.h"
+
+// Big networks are updated by the default thread pool. Chunks are a multiple of a cache line, so threads
+// never write to the same line of the params or the state.
+#define OPTIMIZER_CHUNK_ALIGNMENT (64 / sizeof(LAMP_FLOAT_TYPE))
+
+LampOptimizerConfig lamp_optimizer_sgd(LAMP_FLOAT_TYPE learning_rate, LAMP_FLOAT_TYPE momentum) {
+    LampOptimizerConfig config = {
+            .type = LAMP_OPTIMIZER_SGD,
+            .learning_rate = learning_rate,
+            .momentum = momentum,
+    };
+    return config;
+}
+
+LampOptimizerConfig lamp_optimizer_adam(LAMP_FLOAT_TYPE learning_rate) {
+    LampOptimizerConfig config = {
+            .type = LAMP_OPTIMIZER_ADAM,
+            .learning_rate = learning_rate,
+            .beta1 = LAMP_ADAM_BETA1,
+            .beta2 = LAMP_ADAM_BETA2,
+            .epsilon = LAMP_ADAM_EPSILON,
+    };
+    return config;
+}
+
+LampOptimizerConfig lamp_optimizer_adamw(LAMP_FLOAT_TYPE learning_rate, LAMP_FLOAT_TYPE weight_decay) {
+    LampOptimizerConfig config = lamp_optimizer_adam(learning_rate);
+    config.type = LAMP_OPTIMIZER_ADAMW;
+    config.weight_decay = weight_decay;
+    return config;
+}
+
+LampOptimizer *lamp_optimizer_alloc(const LampNN *nn, const LampOptimizerConfig *config) {
+    assert(nn != NULL && config != NULL);
+    assert(config->type < LAMP_OPTIMIZER_COUNT);
+
+    // TODO: Propagate memory allocation error instead of asserting here
+    LampOptimizer *optimizer = malloc(sizeof(LampOptimizer));
+    assert(optimizer != NULL);
+    optimizer->config = *config;
+    optimizer->step = 0;
+    optimizer->size = nn->params_size;
+
+    size_t state_count = config->type == LAMP_OPTIMIZER_SGD ? 1 : 2;
+    size_t state_size = LAMP_ARENA_ALIGNED_SIZE(nn->params_size * sizeof(LAMP_FLOAT_TYPE));
+    optimizer->arena = lamp_arena_alloc(state_count * state_size);
+    optimizer->first_moment = lamp_arena_push(optimizer->arena, state_size);
+    optimizer->second_moment = state_count == 2 ? lamp_arena_push(optimizer->arena, state_size) : NULL;
+
+    return optimizer;
+}
+
+void lamp_optimizer_free(LampOptimizer *optimizer) {
+    assert(optimizer != NULL);
+    lamp_arena_free(optimizer->arena);
+    free(optimizer);
+}
+
+void lamp_optimizer_reset(LampOptimizer *optimizer) {
+    assert(optimizer != NULL);
+    optimizer->step = 0;
+    memset(optimizer->arena->base, 0, optimizer->arena->used);
+}
+
+typedef struct {
+    const LampOptimizer *optimizer;
+    LAMP_FLOAT_TYPE *params;
+    const LAMP_FLOAT_TYPE *grads;
+    LampAdamCoefficients adam;
+    size_t chunk_size;
+} OptimizerJob;
+
+static void optimizer_run(const OptimizerJob *job, size_t first, size_t count) {
+    const LampSimdKernels *kernels = lamp_simd_kernels();
+    const LampOptimizer *optimizer = job->optimizer;
+    if (optimizer->config.type == LAMP_OPTIMIZER_SGD) {
+        kernels->sgd_momentum(&job->params[first], &job->grads[first], &optimizer->first_moment[first],
+                              optimizer->config.learning_rate, optimizer->config.momentum, count);
+    } else {
+        kernels->adam(&job->params[first], &job->grads[first], &optimizer->first_moment[first],
+                      &optimizer->second_moment[first], &job->adam, count);
+    }
+}
+
+static void optimizer_task(void *context, size_t task_index) {
+    const OptimizerJob *job = context;
+    size_t first = task_index * job->chunk_size;
+    size_t remaining = job->optimizer->size - first;
+    optimizer_run(job, first, remaining < job->chunk_size ? remaining : job->chunk_size);
+}
+
+void lamp_optimizer_step(LampOptimizer *optimizer, LampNN *nn) {
+    assert(optimizer != NULL && nn != NULL);
+    assert(optimizer->size == nn->params_size);
+    assert(lamp_nn_trainable(nn));
+
+    const LampOptimizerConfig *config = &optimizer->config;
+    OptimizerJob job = {.optimizer = optimizer, .params = nn->params, .grads = nn->grads};
+    optimizer->step++;
+
+    if (config->type != LAMP_OPTIMIZER_SGD) {
+        // Both moments start at zero and are biased towards it in the first steps. Instead of correcting
+        // them for every parameter, m / (1 - beta1^t) / (sqrt(v / (1 - beta2^t)) + epsilon) is rearranged
+        // so the corrections only scale the step size and epsilon.
+        double correction1 = 1.0 - pow(config->beta1, (double) optimizer->step);
+        double correction2 = sqrt(1.0 - pow(config->beta2, (double) optimizer->step));
+        job.adam.step_size = (LAMP_FLOAT_TYPE) (config->learning_rate * correction2 / correction1);
+        job.adam.beta1 = config->beta1;
+        job.adam.beta2 = config->beta2;
+        job.adam.epsilon = (LAMP_FLOAT_TYPE) (config->epsilon * correction2);
+        // The decay does not depend on the gradient, so it is not scaled by the adaptive step of Adam
+        job.adam.decay = config->type == LAMP_OPTIMIZER_ADAMW ? 1.0f - config->learning_rate * config->weight_decay
+                                                              : 1.0f;
+    }
+
+    LampThreadPool *pool = lamp_threadpool_for_work(optimizer->size);
+    if (pool == NULL) {
+        optimizer_run(&job, 0, optimizer->size);
+    } else {
+        size_t num_threads = lamp_threadpool_num_threads(pool);
+        job.chunk_size = (optimizer->size + num_threads - 1) / num_threads;
+        job.chunk_size = (job.chunk_size + OPTIMIZER_CHUNK_ALIGNMENT - 1) / OPTIMIZER_CHUNK_ALIGNMENT *
+                         OPTIMIZER_CHUNK_ALIGNMENT;
+        lamp_threadpool_parallel_for(pool, (optimizer->size + job.chunk_size - 1) / job.chunk_size, optimizer_task,
+                                     &job);
+    }
+    // The update moves the pruned weights as well
+    lamp_nn_apply_pruning(nn);
+}
@@ -0,0 +1,89 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_OPTIMIZER_H
+#define LAMP_LAMP_OPTIMIZER_H
+
+#include <stddef.h>
+#include "lamp_nn.h"
+
+// Optimizers update the parameters of a network with the gradients calculated by lamp_nn_backprop().
+// Besides plain gradient descent (lamp_nn_apply_gradients()) they keep some state for every parameter,
+// which usually lets them converge in far fewer steps.
+typedef enum {
+    LAMP_OPTIMIZER_SGD = 0, // Gradient descent with momentum
+    LAMP_OPTIMIZER_ADAM,    // Adaptive moment estimation
+    LAMP_OPTIMIZER_ADAMW,   // Adam with decoupled weight decay
+    LAMP_OPTIMIZER_COUNT
+} LampOptimizerType;
+
+// Defaults recommended by the Adam paper, which work well for most problems
+#define LAMP_ADAM_BETA1 0.9f
+#define LAMP_ADAM_BETA2 0.999f
+#define LAMP_ADAM_EPSILON 1e-8f
+
+// Hyperparameters of an optimizer. Each type only uses the ones it needs:
+// SGD uses learning_rate and momentum (a momentum of 0 is plain gradient descent),
+// Adam uses learning_rate, beta1, beta2 and epsilon, AdamW additionally the weight_decay.
+typedef struct {
+    LampOptimizerType type;
+    LAMP_FLOAT_TYPE learning_rate;
+    LAMP_FLOAT_TYPE momentum;
+    LAMP_FLOAT_TYPE beta1;
+    LAMP_FLOAT_TYPE beta2;
+    LAMP_FLOAT_TYPE epsilon;
+    LAMP_FLOAT_TYPE weight_decay;
+} LampOptimizerConfig;
+
+// The state has exactly the layout of the params of the network: the state of a parameter is found at the
+// same offset as the parameter itself. So the state of every connection follows the one of the connection
+// before, and the update walks params, grads and state front to back in a single pass.
+// first_moment holds the velocity of SGD or the first moment of Adam, second_moment is only used by Adam.
+typedef struct {
+    LampOptimizerConfig config;
+    size_t step;
+    size_t size;
+    LampArena *arena;
+    LAMP_FLOAT_TYPE *first_moment;
+    LAMP_FLOAT_TYPE *second_moment;
+} LampOptimizer;
+
+LampOptimizerConfig lamp_optimizer_sgd(LAMP_FLOAT_TYPE learning_rate, LAMP_FLOAT_TYPE momentum);
+
+LampOptimizerConfig lamp_optimizer_adam(LAMP_FLOAT_TYPE learning_rate);
+
+LampOptimizerConfig lamp_optimizer_adamw(LAMP_FLOAT_TYPE learning_rate, LAMP_FLOAT_TYPE weight_decay);
+
+// Allocate an optimizer for the parameters of nn. The state starts at zero.
+LampOptimizer *lamp_optimizer_alloc(const LampNN *nn, const LampOptimizerConfig *config);
+
+void lamp_optimizer_free(LampOptimizer *optimizer);
+
+// Forget the state, e.g. before training the network again from new parameters
+void lamp_optimizer_reset(LampOptimizer *optimizer);
+
+// Apply the gradients calculated by lamp_nn_backprop() to the parameters of nn
+// ATTENTION: nn must be the network (or one with the same architecture) the optimizer was allocated for
+void lamp_optimizer_step(LampOptimizer *optimizer, LampNN *nn);
+
+#endif //LAMP_LAMP_OPTIMIZER_H
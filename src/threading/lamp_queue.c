@@ -0,0 +1,79 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <stddef.h>
+#include "lamp_queue.h"
+
+// The algorithm is the intrusive MPSC queue by Dmitry Vyukov.
+
+void lamp_queue_init(LampQueue *queue) {
+    assert(queue != NULL);
+    atomic_init(&queue->stub.next, NULL);
+    atomic_init(&queue->head, &queue->stub);
+    queue->tail = &queue->stub;
+}
+
+void lamp_queue_push(LampQueue *queue, LampQueueNode *node) {
+    assert(queue != NULL && node != NULL);
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    // Claim the place at the head first, then link the previous head to the node. The release publishes the
+    // element to the consumer, which reads next with acquire.
+    LampQueueNode *prev = atomic_exchange_explicit(&queue->head, node, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+LampQueueNode *lamp_queue_pop(LampQueue *queue) {
+    assert(queue != NULL);
+    LampQueueNode *tail = queue->tail;
+    LampQueueNode *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    // Skip the stub, it is not an element
+    if (tail == &queue->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&next->next, memory_order_acquire);
+    }
+
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+
+    // tail is the last linked node. If it is not the head, a producer has claimed the head, but not linked it yet.
+    if (tail != atomic_load_explicit(&queue->head, memory_order_acquire)) {
+        return NULL;
+    }
+
+    // tail is the only element. It can only be removed with a successor, so push the stub behind it.
+    lamp_queue_push(queue, &queue->stub);
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+    return NULL;
+}
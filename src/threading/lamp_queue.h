@@ -0,0 +1,61 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_QUEUE_H
+#define LAMP_LAMP_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Lock-free queue with many producers and a single consumer (MPSC).
+// Any number of threads may push at the same time, but only one thread may pop.
+// The queue is intrusive: it does not allocate, instead every element embeds a LampQueueNode, which links it
+// to the next one. Place the node at the beginning of the element to cast between them.
+//
+// A push is a single atomic exchange followed by a store, so producers never wait for each other or the
+// consumer. The price is a short window in which a pushed node is not reachable yet: if the consumer
+// catches a producer between both steps, pop returns NULL although the queue is not empty. The consumer
+// simply has to try again later.
+typedef struct LampQueueNode {
+    _Atomic(struct LampQueueNode *) next;
+} LampQueueNode;
+
+// Producers push at head, the consumer pops at tail. The stub node keeps the list from ever becoming empty,
+// so pushing never has to touch the tail.
+// ATTENTION: The queue must not be copied or moved after lamp_queue_init(), since the nodes point to the stub
+typedef struct {
+    _Atomic(LampQueueNode *) head;
+    LampQueueNode *tail;
+    LampQueueNode stub;
+} LampQueue;
+
+void lamp_queue_init(LampQueue *queue);
+
+// Append a node. Can be called from any thread.
+// ATTENTION: The node must stay alive and must not be pushed again, until it is popped
+void lamp_queue_push(LampQueue *queue, LampQueueNode *node);
+
+// Remove the oldest node, or return NULL if there is none (see above). Must only be called from one thread.
+LampQueueNode *lamp_queue_pop(LampQueue *queue);
+
+#endif //LAMP_LAMP_QUEUE_H
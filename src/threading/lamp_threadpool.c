@@ -0,0 +1,212 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "lamp_threadpool.h"
+
+struct LampThreadPool {
+    pthread_t *workers;
+    size_t worker_count;
+
+    // Only one thread at a time can hand out work to the pool
+    pthread_mutex_t submit_lock;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;
+    pthread_cond_t work_done;
+    bool shutdown;
+    size_t generation; // Incremented for every submitted job, so workers can tell new work apart
+    size_t busy_workers;
+
+    // Current job
+    LampThreadPoolTask task;
+    void *context;
+    size_t num_tasks;
+    atomic_size_t next_task;
+};
+
+// Set while a thread is executing tasks, so nested calls do not wait for the pool they are running on
+static _Thread_local bool in_pool_task = false;
+
+static LampThreadPool *default_pool = NULL;
+static size_t default_threshold = LAMP_THREADPOOL_DEFAULT_THRESHOLD;
+
+static void run_tasks(LampThreadPool *pool) {
+    in_pool_task = true;
+    for (;;) {
+        size_t idx = atomic_fetch_add(&pool->next_task, 1);
+        if (idx >= pool->num_tasks) {
+            break;
+        }
+        pool->task(pool->context, idx);
+    }
+    in_pool_task = false;
+}
+
+static void *worker_main(void *arg) {
+    LampThreadPool *pool = arg;
+    size_t seen_generation = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen_generation && !pool->shutdown) {
+            pthread_cond_wait(&pool->work_available, &pool->lock);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        seen_generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_tasks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy_workers == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+LampThreadPool *lamp_threadpool_alloc(size_t num_threads) {
+    if (num_threads == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cores > 0 ? (size_t) cores : 1;
+    }
+
+    LampThreadPool *pool = malloc(sizeof(LampThreadPool));
+    assert(pool != NULL);
+
+    pool->worker_count = num_threads - 1;
+    pool->workers = malloc(sizeof(pthread_t) * (pool->worker_count > 0 ? pool->worker_count : 1));
+    assert(pool->workers != NULL);
+
+    pthread_mutex_init(&pool->submit_lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    pool->shutdown = false;
+    pool->generation = 0;
+    pool->busy_workers = 0;
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->num_tasks = 0;
+    atomic_init(&pool->next_task, 0);
+
+    for (size_t i = 0; i < pool->worker_count; ++i) {
+        int rc = pthread_create(&pool->workers[i], NULL, worker_main, pool);
+        assert(rc == 0);
+        (void) rc;
+    }
+
+    return pool;
+}
+
+void lamp_threadpool_free(LampThreadPool *pool) {
+    assert(pool != NULL);
+    if (default_pool == pool) {
+        default_pool = NULL;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->worker_count; ++i) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_available);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->submit_lock);
+    free(pool->workers);
+    free(pool);
+}
+
+size_t lamp_threadpool_num_threads(const LampThreadPool *pool) {
+    assert(pool != NULL);
+    return pool->worker_count + 1;
+}
+
+static void run_serial(size_t num_tasks, LampThreadPoolTask task, void *context) {
+    for (size_t i = 0; i < num_tasks; ++i) {
+        task(context, i);
+    }
+}
+
+void lamp_threadpool_parallel_for(LampThreadPool *pool, size_t num_tasks, LampThreadPoolTask task, void *context) {
+    assert(task != NULL);
+    if (num_tasks == 0) {
+        return;
+    }
+
+    if (pool == NULL || pool->worker_count == 0 || num_tasks == 1 || in_pool_task ||
+        pthread_mutex_trylock(&pool->submit_lock) != 0) {
+        run_serial(num_tasks, task, context);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->num_tasks = num_tasks;
+    atomic_store(&pool->next_task, 0);
+    pool->busy_workers = pool->worker_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool);
+
+    // Even if all tasks are taken, workers may still be executing theirs
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy_workers > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->submit_lock);
+}
+
+void lamp_threadpool_set_default(LampThreadPool *pool) {
+    default_pool = pool;
+}
+
+void lamp_threadpool_set_threshold(size_t min_work) {
+    default_threshold = min_work;
+}
+
+LampThreadPool *lamp_threadpool_for_work(size_t work) {
+    if (default_pool == NULL || work < default_threshold) {
+        return NULL;
+    }
+    return default_pool;
+}
@@ -0,0 +1,65 @@
+//
+// Created by Jan Thieme on 16.10.2026.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#ifndef LAMP_LAMP_THREADPOOL_H
+#define LAMP_LAMP_THREADPOOL_H
+
+#include <stddef.h>
+
+// A pool of worker threads, that are created once and wait for work afterwards.
+// Work is submitted as a number of independent tasks, which are distributed dynamically over the workers
+// and the submitting thread. The submitting thread returns once all tasks are finished.
+typedef struct LampThreadPool LampThreadPool;
+
+// A task receives the context given to lamp_threadpool_parallel_for() and its index in [0, num_tasks)
+typedef void (*LampThreadPoolTask)(void *context, size_t task_index);
+
+// Allocate a pool using num_threads threads in total. The submitting thread takes part in the work,
+// so num_threads - 1 worker threads are started. A value of 0 uses one thread per available CPU core.
+LampThreadPool *lamp_threadpool_alloc(size_t num_threads);
+
+void lamp_threadpool_free(LampThreadPool *pool);
+
+size_t lamp_threadpool_num_threads(const LampThreadPool *pool);
+
+// Execute task(context, i) for every i in [0, num_tasks) and wait until all of them are done.
+// If the pool is busy with the work of another thread or the call is made from within a task,
+// all tasks are executed on the calling thread instead.
+void lamp_threadpool_parallel_for(LampThreadPool *pool, size_t num_tasks, LampThreadPoolTask task, void *context);
+
+// The matrix operations (and everything built on top of them) distribute their work over this pool.
+// By default there is no pool and everything runs on the calling thread. Pass NULL to disable it again.
+// ATTENTION: The pool must stay alive as long as it is set
+void lamp_threadpool_set_default(LampThreadPool *pool);
+
+// Operations with less work than the threshold stay single threaded, since the synchronization would cost
+// more than it saves. The work is measured in multiply-adds for matrix multiplications and in elements for
+// element-wise operations.
+#define LAMP_THREADPOOL_DEFAULT_THRESHOLD (1 << 18)
+
+void lamp_threadpool_set_threshold(size_t min_work);
+
+// The default pool if the amount of work is worth distributing, NULL otherwise
+LampThreadPool *lamp_threadpool_for_work(size_t work);
+
+#endif //LAMP_LAMP_THREADPOOL_H
@@ -1,8 +1,25 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #include "../src/linear_algebra/lamp_matrix.h"
+#include "../src/linear_algebra/lamp_simd.h"
+#include "../src/linear_algebra/lamp_half.h"
+#include "../src/linear_algebra/lamp_quant.h"
+#include "../src/linear_algebra/lamp_sparse.h"
+#include "../src/data/lamp_dataset.h"
+#include "../src/memory/lamp_alloc_count.h"
 #include "../src/neural_network/lamp_nn.h"
+#include "../src/neural_network/lamp_optimizer.h"
+#include "../src/neural_network/lamp_data_parallel.h"
+#include "../src/neural_network/lamp_gradient_check.h"
+#include "../src/neural_network/lamp_nn_plan.h"
+#include "../src/threading/lamp_threadpool.h"
+#include "../src/threading/lamp_queue.h"
 
 #define LAMP_TEST_FAILED 0x00
 #define LAMP_TEST_PASSED 0x01
@@ -166,6 +183,38 @@ bool test_matrix_multiplication(void) {
     return LAMP_TEST_PASSED;
 }
 
+// Verify the blocked multiplication against a naive reference with shapes, that do not fit
+// the register tiles and cache blocks evenly
+bool test_matrix_multiplication_large(void) {
+    const size_t m = 131;
+    const size_t k = 300;
+    const size_t n = 2100;
+    LampMatrix *m1 = lamp_mat_alloc(m, k);
+    LampMatrix *m2 = lamp_mat_alloc(k, n);
+    lamp_mat_rand(m1);
+    lamp_mat_rand(m2);
+
+    LampMatrix *mt = lamp_mat_alloc_multiply(m1, m2);
+
+    bool result = LAMP_TEST_PASSED;
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double expected = 0.0;
+            for (size_t p = 0; p < k; ++p) {
+                expected += (double) LAMP_MAT_ELEMENT_AT(m1, i, p) * (double) LAMP_MAT_ELEMENT_AT(m2, p, j);
+            }
+            if (fabs(expected - LAMP_MAT_ELEMENT_AT(mt, i, j)) > 1e-4 * expected) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+    }
+
+    lamp_mat_free(m1);
+    lamp_mat_free(m2);
+    lamp_mat_free(mt);
+    return result;
+}
+
 bool test_matrix_allocation(void) {
     LampMatrix *m = lamp_mat_alloc_identity(2);
     if (m == NULL) {
@@ -203,17 +252,780 @@ bool test_matrix_transpose(void) {
         lamp_mat_free(m2);
         return LAMP_TEST_FAILED;
     }
+    lamp_mat_free(m1);
+    lamp_mat_free(m2);
+
+    // Sizes, that are no multiple of the tiles
+    bool result = true;
+    const size_t shapes[][2] = {{1, 1}, {67, 45}, {45, 67}, {100, 100}, {300, 7}, {3, 517}};
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); ++s) {
+        LampMatrix *m = lamp_mat_alloc(shapes[s][0], shapes[s][1]);
+        LampMatrix *mt = lamp_mat_alloc(shapes[s][1], shapes[s][0]);
+        lamp_mat_rand(m);
+        lamp_mat_transpose_into(mt, m);
+        for (size_t i = 0; i < m->num_rows; ++i) {
+            for (size_t j = 0; j < m->num_cols; ++j) {
+                if (LAMP_MAT_ELEMENT_AT(mt, j, i) != LAMP_MAT_ELEMENT_AT(m, i, j)) {
+                    result = LAMP_TEST_FAILED;
+                }
+            }
+        }
+        if (m->num_rows == m->num_cols) {
+            lamp_mat_transpose_in_place(m);
+            if (memcmp(m->elements, mt->elements, sizeof(LAMP_FLOAT_TYPE) * LAMP_MAT_NUM_ELEMENTS(m)) != 0) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+        lamp_mat_free(m);
+        lamp_mat_free(mt);
+    }
+    return result;
+}
+
+bool test_matrix_into_variants(void) {
+    LAMP_FLOAT_TYPE content[] = {1, 2, 3, 4, 5, 6};
+    LampMatrix *m = lamp_mat_alloc(2, 3);
+    lamp_mat_from_array_into(m, content);
+    LampMatrix *expected = lamp_mat_alloc_from_array(2, 3, content);
+    bool result = lamp_matrix_equal(m, expected);
+
+    // The destination may be any of the sources
+    LampMatrix *other = lamp_mat_alloc(2, 3);
+    lamp_mat_fill_with(other, 0.5f);
+    LampMatrix *sum = lamp_mat_alloc_sum(m, other);
+    lamp_mat_sum_into(other, m, other);
+    lamp_mat_sum_into(m, m, m);
+    for (size_t i = 0; i < 6; ++i) {
+        if (sum->elements[i] != content[i] + 0.5f || other->elements[i] != content[i] + 0.5f ||
+            m->elements[i] != 2.0f * content[i]) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    LampMatrix *identity = lamp_mat_alloc(3, 3);
+    lamp_mat_fill_with(identity, 7.0f);
+    lamp_mat_identity_into(identity);
+    LampMatrix *product = lamp_mat_alloc(2, 3);
+    lamp_mat_multiply_into(product, expected, identity);
+    if (!lamp_matrix_equal(product, expected)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    lamp_mat_free(m);
+    lamp_mat_free(expected);
+    lamp_mat_free(other);
+    lamp_mat_free(sum);
+    lamp_mat_free(identity);
+    lamp_mat_free(product);
+    return result;
+}
+
+static bool relative_close(const LAMP_FLOAT_TYPE *expected, const LAMP_FLOAT_TYPE *actual, size_t n,
+                           LAMP_FLOAT_TYPE tolerance) {
+    for (size_t i = 0; i < n; ++i) {
+        if (LAMP_FABS(expected[i] - actual[i]) > tolerance * fmaxf(1.0f, LAMP_FABS(expected[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool test_matrix_multiply_transposed(void) {
+    // Odd sizes so the packed GEMM has to handle partial blocks for every operand layout
+    const size_t m = 37;
+    const size_t k = 53;
+    const size_t n = 19;
+    LampMatrix *a = lamp_mat_alloc(m, k);
+    LampMatrix *at = lamp_mat_alloc(k, m);
+    LampMatrix *b = lamp_mat_alloc(k, n);
+    LampMatrix *bt = lamp_mat_alloc(n, k);
+    lamp_mat_rand(a);
+    lamp_mat_rand(b);
+    lamp_mat_transpose_into(at, a);
+    lamp_mat_transpose_into(bt, b);
+
+    LampMatrix *expected = lamp_mat_alloc(m, n);
+    LampMatrix *product = lamp_mat_alloc(m, n);
+    lamp_mat_multiply_into(expected, a, b);
+
+    bool result = LAMP_TEST_PASSED;
+    for (int trans_a = 0; trans_a < 2; ++trans_a) {
+        for (int trans_b = 0; trans_b < 2; ++trans_b) {
+            lamp_mat_fill_with(product, -1.0f);
+            lamp_mat_multiply_trans_into(product, trans_a ? at : a, trans_a, trans_b ? bt : b, trans_b);
+            if (!relative_close(expected->elements, product->elements, m * n, 1e-5f)) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+    }
+
+    lamp_mat_free(a);
+    lamp_mat_free(at);
+    lamp_mat_free(b);
+    lamp_mat_free(bt);
+    lamp_mat_free(expected);
+    lamp_mat_free(product);
+    return result;
+}
+
+// Compare every vector kernel supported by this CPU against the portable implementation.
+// The sizes are chosen so all variants also have to handle remaining elements.
+// 2 * sqrt(2 / pi), the scale of the tanh approximation of the GELU
+#define GELU_REFERENCE_K 1.5957691216057308
+
+bool test_matrix_simd_kernels(void) {
+    const LampSimdKernels *reference = lamp_simd_kernels_for(LAMP_SIMD_SCALAR);
+    const size_t max_n = 67;
+    LAMP_FLOAT_TYPE in[67], expected[67], actual[67];
+    for (size_t i = 0; i < max_n; ++i) {
+        in[i] = ((LAMP_FLOAT_TYPE) i - 33.0f) * 0.75f;
+    }
+
+    for (int level = 0; level < LAMP_SIMD_LEVEL_COUNT; ++level) {
+        const LampSimdKernels *kernels = lamp_simd_kernels_for((LampSimdLevel) level);
+        if (kernels == NULL) {
+            continue;
+        }
+
+        // Near 0 tanh and GELU are about as small as their input, so they have to keep the relative precision
+        LAMP_FLOAT_TYPE small[32], small_tanh[32], small_gelu[32];
+        for (size_t i = 0; i < 32; ++i) {
+            small[i] = (i % 2 ? -1.0f : 1.0f) * powf(10.0f, -7.0f + 0.22f * (LAMP_FLOAT_TYPE) i);
+            small_tanh[i] = small_gelu[i] = small[i];
+        }
+        kernels->tanh(small_tanh, 32);
+        kernels->gelu(small_gelu, 32);
+        for (size_t i = 0; i < 32; ++i) {
+            double x = small[i];
+            double gelu = x / (1.0 + exp(-GELU_REFERENCE_K * (x + 0.044715 * x * x * x)));
+            if (fabs(small_tanh[i] - tanh(x)) > 1e-6 * fabs(tanh(x)) ||
+                fabs(small_gelu[i] - gelu) > 1e-6 * fabs(gelu)) {
+                return LAMP_TEST_FAILED;
+            }
+        }
+
+        for (size_t n = 0; n <= max_n; ++n) {
+            kernels->fill(actual, 1.5f, n);
+            for (size_t i = 0; i < n; ++i) {
+                if (actual[i] != 1.5f) {
+                    return LAMP_TEST_FAILED;
+                }
+            }
+
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->add(expected, in, n);
+            kernels->add(actual, in, n);
+            if (!reference->all_close(expected, actual, max_n, 0.0f) || !kernels->all_close(expected, actual, n, 0.0f)) {
+                return LAMP_TEST_FAILED;
+            }
+
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->sigmoid(expected, n);
+            kernels->sigmoid(actual, n);
+            if (!reference->all_close(expected, actual, max_n, 1e-6f)) {
+                return LAMP_TEST_FAILED;
+            }
+
+            for (int relu = 0; relu < 2; ++relu) {
+                LAMP_FLOAT_TYPE alpha = relu ? 0.0f : 0.01f;
+                memcpy(expected, in, sizeof(in));
+                memcpy(actual, in, sizeof(in));
+                reference->leaky_relu(expected, alpha, n);
+                kernels->leaky_relu(actual, alpha, n);
+                if (!reference->all_close(expected, actual, max_n, 0.0f)) {
+                    return LAMP_TEST_FAILED;
+                }
+            }
+
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->tanh(expected, n);
+            kernels->tanh(actual, n);
+            if (!reference->all_close(expected, actual, max_n, 1e-6f)) {
+                return LAMP_TEST_FAILED;
+            }
+
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->gelu(expected, n);
+            kernels->gelu(actual, n);
+            for (size_t i = 0; i < n; ++i) {
+                if (LAMP_FABS(expected[i] - actual[i]) > 1e-6f * fmaxf(1.0f, LAMP_FABS(expected[i]))) {
+                    return LAMP_TEST_FAILED;
+                }
+            }
+
+            // The derivatives scale an incoming gradient, we use the inputs for that as well
+            LAMP_FLOAT_TYPE y[67];
+            memcpy(y, in, sizeof(in));
+            reference->sigmoid(y, max_n);
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->sigmoid_backward(expected, y, n);
+            kernels->sigmoid_backward(actual, y, n);
+            if (!reference->all_close(expected, actual, max_n, 1e-6f)) {
+                return LAMP_TEST_FAILED;
+            }
+
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->leaky_relu_backward(expected, in, 0.01f, n);
+            kernels->leaky_relu_backward(actual, in, 0.01f, n);
+            if (!reference->all_close(expected, actual, max_n, 0.0f)) {
+                return LAMP_TEST_FAILED;
+            }
+
+            memcpy(y, in, sizeof(in));
+            reference->tanh(y, max_n);
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->tanh_backward(expected, y, n);
+            kernels->tanh_backward(actual, y, n);
+            if (!reference->all_close(expected, actual, max_n, 1e-6f)) {
+                return LAMP_TEST_FAILED;
+            }
+
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->gelu_backward(expected, in, n);
+            kernels->gelu_backward(actual, in, n);
+            for (size_t i = 0; i < n; ++i) {
+                if (LAMP_FABS(expected[i] - actual[i]) > 1e-5f * fmaxf(1.0f, LAMP_FABS(expected[i]))) {
+                    return LAMP_TEST_FAILED;
+                }
+            }
+
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->exp(expected, n);
+            kernels->exp(actual, n);
+            for (size_t i = 0; i < n; ++i) {
+                if (LAMP_FABS(expected[i] - actual[i]) > 1e-6f * expected[i]) {
+                    return LAMP_TEST_FAILED;
+                }
+            }
+
+            // Ties have to round to even like lrintf(), values outside of [0, 255] are clamped. in[i] * 2 is a
+            // multiple of 0.5 and the zero points move the results from far below 0 to far beyond 255.
+            LAMP_FLOAT_TYPE inverse_scales[67];
+            int32_t zero_points[67];
+            for (size_t i = 0; i < max_n; ++i) {
+                inverse_scales[i] = (i % 3 == 0) ? 2.0f : 1.0f / 3.0f;
+                zero_points[i] = (int32_t) (i * 97 % 331);
+            }
+            const LAMP_FLOAT_TYPE *quant_rows[4] = {in, y, expected, actual};
+            uint8_t expected_bytes[4 * 67], actual_bytes[4 * 67];
+            reference->quantize_u8_x4(expected_bytes, quant_rows, inverse_scales, zero_points, n);
+            kernels->quantize_u8_x4(actual_bytes, quant_rows, inverse_scales, zero_points, n);
+            if (memcmp(expected_bytes, actual_bytes, 4 * n) != 0) {
+                return LAMP_TEST_FAILED;
+            }
+
+            // A tile of the 8 bit multiplication with the extreme values of both operands and n / 8 steps
+            size_t kc = n / 8, mr = kernels->quant_mr, nr = kernels->quant_nr, ldx = nr * 4 + 12;
+            int8_t tile_weights[8 * LAMP_QUANT_MAX_MR * 4];
+            uint8_t tile_inputs[8 * (LAMP_QUANT_MAX_NR * 4 + 12)];
+            for (size_t i = 0; i < sizeof(tile_weights); ++i) {
+                tile_weights[i] = (int8_t) (i % 7 == 0 ? -127 : (int) ((i * 37) % 255) - 127);
+            }
+            for (size_t i = 0; i < sizeof(tile_inputs); ++i) {
+                tile_inputs[i] = (uint8_t) (i % 5 == 0 ? 255 : (i * 59) % 256);
+            }
+            int32_t tile[LAMP_QUANT_MAX_MR * (LAMP_QUANT_MAX_NR + 3)];
+            kernels->quant_tile(kc, tile_weights, tile_inputs, ldx, tile, nr + 3);
+            for (size_t i = 0; i < mr; ++i) {
+                for (size_t j = 0; j < nr; ++j) {
+                    int32_t sum = 0;
+                    for (size_t p = 0; p < kc * 4; ++p) {
+                        sum += tile_weights[(p / 4 * mr + i) * 4 + p % 4] * tile_inputs[p / 4 * ldx + j * 4 + p % 4];
+                    }
+                    if (tile[i * (nr + 3) + j] != sum) {
+                        return LAMP_TEST_FAILED;
+                    }
+                }
+            }
+
+            // A row of the sparse multiplication with n % 9 elements, which scale rows of B in any order
+            size_t count = n % 9, ldb = kernels->sparse_nr + 5;
+            uint32_t sparse_cols[8];
+            LAMP_FLOAT_TYPE sparse_b[9 * (LAMP_SPARSE_MAX_NR + 5)];
+            LAMP_FLOAT_TYPE expected_row[LAMP_SPARSE_MAX_NR], actual_row[LAMP_SPARSE_MAX_NR];
+            for (size_t e = 0; e < count; ++e) {
+                sparse_cols[e] = (uint32_t) (e * 5 % 9);
+            }
+            for (size_t i = 0; i < 9 * ldb; ++i) {
+                sparse_b[i] = (LAMP_FLOAT_TYPE) (i * 37 % 101) * 0.25f - 12.0f;
+            }
+            for (size_t j = 0; j < kernels->sparse_nr; ++j) {
+                expected_row[j] = 0.0f;
+                for (size_t e = 0; e < count; ++e) {
+                    expected_row[j] += in[e] * sparse_b[sparse_cols[e] * ldb + j];
+                }
+            }
+            kernels->sparse_row(count, in, sparse_cols, sparse_b, ldb, actual_row);
+            if (!relative_close(expected_row, actual_row, kernels->sparse_nr, 1e-5f)) {
+                return LAMP_TEST_FAILED;
+            }
+
+            // The compiler may contract the updates into FMA in the wider variants, so allow a last bit of rounding
+            LAMP_FLOAT_TYPE expected_state[2][67], actual_state[2][67];
+            for (size_t i = 0; i < max_n; ++i) {
+                expected_state[0][i] = actual_state[0][i] = in[i] * 0.1f;
+                expected_state[1][i] = actual_state[1][i] = in[i] * in[i];
+            }
+            memcpy(expected, in, sizeof(in));
+            memcpy(actual, in, sizeof(in));
+            reference->sgd_momentum(expected, y, expected_state[0], 0.1f, 0.9f, n);
+            kernels->sgd_momentum(actual, y, actual_state[0], 0.1f, 0.9f, n);
+            if (!relative_close(expected, actual, max_n, 1e-6f) ||
+                !relative_close(expected_state[0], actual_state[0], max_n, 1e-6f)) {
+                return LAMP_TEST_FAILED;
+            }
+            LampAdamCoefficients adam = {.step_size = 0.01f, .beta1 = 0.9f, .beta2 = 0.999f, .epsilon = 1e-8f,
+                                         .decay = 0.999f};
+            reference->adam(expected, in, expected_state[0], expected_state[1], &adam, n);
+            kernels->adam(actual, in, actual_state[0], actual_state[1], &adam, n);
+            if (!relative_close(expected, actual, max_n, 1e-6f) ||
+                !relative_close(expected_state[0], actual_state[0], max_n, 1e-6f) ||
+                !relative_close(expected_state[1], actual_state[1], max_n, 1e-6f)) {
+                return LAMP_TEST_FAILED;
+            }
+
+            // A single differing element has to be detected at every position
+            for (size_t i = 0; i < n; ++i) {
+                memcpy(actual, in, sizeof(in));
+                actual[i] += 0.5f;
+                if (kernels->all_close(in, actual, n, 0.25f)) {
+                    return LAMP_TEST_FAILED;
+                }
+            }
+        }
+    }
+    return LAMP_TEST_PASSED;
+}
+
+// The register tile of every level computes the product of two packed panels, with and without the bias and the
+// previous content of C. C has a larger leading dimension than the tile, like a tile inside a matrix.
+bool test_matrix_gemm_tiles(void) {
+    const size_t kc = 37;
+    const size_t ldc = 40;
+    LAMP_FLOAT_TYPE a[37 * 14], b[37 * 32], c[14 * 40], before[14 * 40], bias[14];
+    for (size_t i = 0; i < sizeof(a) / sizeof(a[0]); ++i) {
+        a[i] = (LAMP_FLOAT_TYPE) ((int) (i * 7 % 23) - 11) * 0.125f;
+    }
+    for (size_t i = 0; i < sizeof(b) / sizeof(b[0]); ++i) {
+        b[i] = (LAMP_FLOAT_TYPE) ((int) (i * 5 % 19) - 9) * 0.25f;
+    }
+    for (size_t i = 0; i < sizeof(before) / sizeof(before[0]); ++i) {
+        before[i] = (LAMP_FLOAT_TYPE) i * 0.5f;
+    }
+    for (size_t i = 0; i < 14; ++i) {
+        bias[i] = (LAMP_FLOAT_TYPE) i - 7.0f;
+    }
+
+    for (int level = 0; level < LAMP_SIMD_LEVEL_COUNT; ++level) {
+        const LampSimdKernels *kernels = lamp_simd_kernels_for((LampSimdLevel) level);
+        if (kernels == NULL) {
+            continue;
+        }
+        size_t mr = kernels->gemm_mr;
+        size_t nr = kernels->gemm_nr;
+        if (mr > 14 || nr > 32) {
+            return LAMP_TEST_FAILED;
+        }
+
+        for (int variant = 0; variant < 4; ++variant) {
+            bool accumulate = variant & 1;
+            const LAMP_FLOAT_TYPE *row_bias = variant & 2 ? bias : NULL;
+            memcpy(c, before, sizeof(c));
+            kernels->gemm_tile(kc, a, b, c, ldc, accumulate, row_bias);
+            for (size_t i = 0; i < mr; ++i) {
+                for (size_t j = 0; j < ldc; ++j) {
+                    // Everything right of the tile stays untouched
+                    double expected = before[i * ldc + j];
+                    if (j < nr) {
+                        expected = (accumulate ? expected : 0.0) + (row_bias != NULL ? row_bias[i] : 0.0);
+                        for (size_t p = 0; p < kc; ++p) {
+                            expected += (double) a[p * mr + i] * (double) b[p * nr + j];
+                        }
+                    }
+                    if (fabs(expected - c[i * ldc + j]) > 1e-5 * fmax(1.0, fabs(expected))) {
+                        return LAMP_TEST_FAILED;
+                    }
+                }
+            }
+        }
+    }
+    return LAMP_TEST_PASSED;
+}
+
+static bool same_bits(float a, float b) {
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+bool test_matrix_half_conversions(void) {
+    // Exactly representable values, ties that round to even, overflow and the subnormal range
+    static const struct {
+        float value;
+        LampHalf fp16;
+        LampHalf bf16;
+    } known[] = {
+            {1.0f,                  0x3c00, 0x3f80},
+            {-2.5f,                 0xc100, 0xc020},
+            {65504.0f,              0x7bff, 0x4780},
+            {65520.0f,              0x7c00, 0x4780},
+            {1.0f + 0x1p-11f,       0x3c00, 0x3f80},
+            {1.0f + 0x3p-11f,       0x3c02, 0x3f80},
+            {1.0f + 0x1p-8f,        0x3c04, 0x3f80},
+            {1.0f + 0x3p-8f,        0x3c0c, 0x3f82},
+            {0x1p-24f,              0x0001, 0x3380},
+            {0x1p-25f,              0x0000, 0x3300},
+            {0x3p-26f,              0x0001, 0x3340},
+            {0x1p-14f - 0x1p-25f,   0x0400, 0x3880},
+            {INFINITY,              0x7c00, 0x7f80},
+            {1e30f,                 0x7c00, 0x714a},
+    };
+    for (size_t i = 0; i < sizeof(known) / sizeof(known[0]); ++i) {
+        if (lamp_fp16_from_float(known[i].value) != known[i].fp16 ||
+            lamp_bf16_from_float(known[i].value) != known[i].bf16 ||
+            lamp_fp16_from_float(-known[i].value) != (known[i].fp16 ^ 0x8000)) {
+            return LAMP_TEST_FAILED;
+        }
+    }
+
+    // Widening is exact, so narrowing again has to restore every value that is not a NaN
+    static float widened[2][65536];
+    for (uint32_t bits = 0; bits < 65536; ++bits) {
+        LampHalf h = (LampHalf) bits;
+        widened[0][bits] = lamp_float_from_fp16(h);
+        widened[1][bits] = lamp_float_from_bf16(h);
+        if ((!isnan(widened[0][bits]) && lamp_fp16_from_float(widened[0][bits]) != h) ||
+            (!isnan(widened[1][bits]) && lamp_bf16_from_float(widened[1][bits]) != h)) {
+            return LAMP_TEST_FAILED;
+        }
+    }
+
+    // Values between the representable ones, including every exponent of a float and NaNs with payload
+    static float values[65536];
+    uint32_t state = 12345;
+    for (size_t i = 0; i < 65536; ++i) {
+        state = state * 1664525u + 1013904223u;
+        uint32_t bits = state;
+        memcpy(&values[i], &bits, sizeof(float));
+    }
+
+    // The vector kernels have to produce exactly the same bits as the scalar conversions
+    static LampHalf narrowed[65536];
+    static float actual[65536];
+    for (int level = 0; level < LAMP_SIMD_LEVEL_COUNT; ++level) {
+        const LampSimdKernels *kernels = lamp_simd_kernels_for((LampSimdLevel) level);
+        if (kernels == NULL) {
+            continue;
+        }
+
+        static LampHalf patterns[65536];
+        for (uint32_t bits = 0; bits < 65536; ++bits) {
+            patterns[bits] = (LampHalf) bits;
+        }
+        // An odd count covers the remaining elements after the last full vector
+        kernels->float_from_fp16(actual, patterns, 65535);
+        for (size_t i = 0; i < 65535; ++i) {
+            if (!same_bits(actual[i], widened[0][i])) {
+                return LAMP_TEST_FAILED;
+            }
+        }
+        kernels->float_from_bf16(actual, patterns, 65535);
+        for (size_t i = 0; i < 65535; ++i) {
+            if (!same_bits(actual[i], widened[1][i])) {
+                return LAMP_TEST_FAILED;
+            }
+        }
+
+        const float *inputs[] = {values, widened[0], widened[1]};
+        for (size_t set = 0; set < 3; ++set) {
+            kernels->fp16_from_float(narrowed, inputs[set], 65533);
+            for (size_t i = 0; i < 65533; ++i) {
+                if (narrowed[i] != lamp_fp16_from_float(inputs[set][i])) {
+                    return LAMP_TEST_FAILED;
+                }
+            }
+            kernels->bf16_from_float(narrowed, inputs[set], 65533);
+            for (size_t i = 0; i < 65533; ++i) {
+                if (narrowed[i] != lamp_bf16_from_float(inputs[set][i])) {
+                    return LAMP_TEST_FAILED;
+                }
+            }
+        }
+    }
+    return LAMP_TEST_PASSED;
+}
+
+// The product of operands stored in reduced precision has to be exactly the product of the widened operands,
+// and compared to the full precision operands each product of the sum may only be off by the rounding of its factors
+static bool half_multiplication_matches(size_t m, size_t k, size_t n, LampPrecision precision) {
+    LampMatrix *m1 = lamp_mat_alloc(m, k);
+    LampMatrix *m2 = lamp_mat_alloc(k, n);
+    lamp_mat_rand(m1);
+    lamp_mat_rand(m2);
+
+    LampHalfMatrix *h1 = lamp_half_mat_alloc(m, k, precision);
+    LampHalfMatrix *h2 = lamp_half_mat_alloc(k, n, precision);
+    lamp_half_mat_from_float(h1, m1);
+    lamp_half_mat_from_float(h2, m2);
+    LampMatrix *product = lamp_mat_alloc(m, n);
+    lamp_half_mat_multiply_into(product, h1, h2);
+
+    LampMatrix *w1 = lamp_mat_alloc(m, k);
+    LampMatrix *w2 = lamp_mat_alloc(k, n);
+    lamp_half_mat_to_float(w1, h1);
+    lamp_half_mat_to_float(w2, h2);
+    LampMatrix *widened_product = lamp_mat_alloc_multiply(w1, w2);
+    bool result = lamp_matrix_equal(product, widened_product);
+
+    // lamp_mat_rand() only creates positive values, so the sum of the absolute products equals the exact result.
+    // Besides the rounding of both factors, the accumulation in floats contributes k rounding errors.
+    double u = precision == LAMP_PRECISION_FP16 ? LAMP_FP16_UNIT_ROUNDOFF : LAMP_BF16_UNIT_ROUNDOFF;
+    double bound = 2.01 * u + (double) k * 0x1p-24;
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double expected = 0.0;
+            for (size_t p = 0; p < k; ++p) {
+                expected += (double) LAMP_MAT_ELEMENT_AT(m1, i, p) * (double) LAMP_MAT_ELEMENT_AT(m2, p, j);
+            }
+            if (fabs(expected - LAMP_MAT_ELEMENT_AT(product, i, j)) > bound * expected) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+    }
+
+    lamp_mat_free(widened_product);
+    lamp_mat_free(w2);
+    lamp_mat_free(w1);
+    lamp_mat_free(product);
+    lamp_half_mat_free(h2);
+    lamp_half_mat_free(h1);
+    lamp_mat_free(m2);
+    lamp_mat_free(m1);
+    return result;
+}
+
+bool test_matrix_half_multiplication(void) {
+    LampPrecision precisions[] = {LAMP_PRECISION_FP16, LAMP_PRECISION_BF16};
+    for (size_t i = 0; i < 2; ++i) {
+        // Small shapes use the simple loop, the large one packs and converts several blocks along k and n
+        if (!half_multiplication_matches(3, 2, 1, precisions[i]) ||
+            !half_multiplication_matches(7, 5, 19, precisions[i]) ||
+            !half_multiplication_matches(131, 300, 2100, precisions[i])) {
+            return LAMP_TEST_FAILED;
+        }
+    }
+    return LAMP_TEST_PASSED;
+}
+
+// The integer multiplication has to match the float multiplication of the dequantized operands, and both may only
+// differ from the exact product by the rounding of the weights (half a step of their row) and inputs (of their sample)
+static bool quant_multiplication_matches(size_t m, size_t k, size_t n) {
+    LampMatrix *weights = lamp_mat_alloc(m, k);
+    LampMatrix *input = lamp_mat_alloc(k, n);
+    lamp_mat_rand(weights);
+    lamp_mat_rand(input);
+    for (size_t i = 0; i < LAMP_MAT_NUM_ELEMENTS(weights); ++i) {
+        weights->elements[i] = weights->elements[i] * 2.0f - 1.0f;
+    }
+    for (size_t i = 0; i < LAMP_MAT_NUM_ELEMENTS(input); ++i) {
+        input->elements[i] = input->elements[i] * 3.0f - 0.5f;
+    }
+
+    LampQuantMatrix *quant_weights = lamp_quant_mat_alloc(m, k);
+    LampQuantActivations *quant_input = lamp_quant_act_alloc(n, k);
+    lamp_quant_mat_from_float(quant_weights, weights);
+    lamp_quant_act_from_float(quant_input, input);
+    LampMatrix *product = lamp_mat_alloc(m, n);
+    lamp_quant_mat_multiply_into(product, quant_weights, quant_input, NULL);
+
+    LampMatrix *dequant_weights = lamp_mat_alloc(m, k);
+    LampMatrix *dequant_input = lamp_mat_alloc(k, n);
+    lamp_quant_mat_to_float(dequant_weights, quant_weights);
+    lamp_quant_act_to_float(dequant_input, quant_input);
+    LampMatrix *dequant_product = lamp_mat_alloc_multiply(dequant_weights, dequant_input);
+
+    bool result = LAMP_TEST_PASSED;
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double expected = 0.0;
+            double magnitude = 0.0;
+            double bound = 0.0;
+            for (size_t p = 0; p < k; ++p) {
+                double w = LAMP_MAT_ELEMENT_AT(weights, i, p);
+                double x = LAMP_MAT_ELEMENT_AT(input, p, j);
+                double w_error = 0.5 * quant_weights->scales[i];
+                double x_error = 0.5 * quant_input->scales[j];
+                expected += w * x;
+                magnitude += fabs(w * x);
+                bound += fabs(w) * x_error + fabs(x) * w_error + w_error * x_error;
+            }
+            // The float multiplication rounds every one of its k additions
+            double rounding = (double) k * 0x1p-24 * magnitude;
+            double actual = LAMP_MAT_ELEMENT_AT(product, i, j);
+            double dequantized = LAMP_MAT_ELEMENT_AT(dequant_product, i, j);
+            if (fabs(actual - dequantized) > 2.0 * rounding || fabs(actual - expected) > bound + 2.0 * rounding) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+    }
+
+    lamp_mat_free(dequant_product);
+    lamp_mat_free(dequant_input);
+    lamp_mat_free(dequant_weights);
+    lamp_mat_free(product);
+    lamp_quant_act_free(quant_input);
+    lamp_quant_mat_free(quant_weights);
+    lamp_mat_free(input);
+    lamp_mat_free(weights);
+    return result;
+}
+
+bool test_matrix_quant_multiplication(void) {
+    // Row counts that are not a multiple of the row group of the kernel, and a depth that leaves vector tails
+    if (!quant_multiplication_matches(3, 2, 1) ||
+        !quant_multiplication_matches(7, 5, 19) ||
+        !quant_multiplication_matches(131, 300, 67)) {
+        return LAMP_TEST_FAILED;
+    }
+    return LAMP_TEST_PASSED;
+}
+
+// Drop elements of a random matrix until roughly the given share of them is left, then compare the sparse
+// products with the dense ones for both layouts of B
+static bool sparse_multiplication_matches(size_t m, size_t k, size_t n, double density) {
+    LampMatrix *dense = lamp_mat_alloc(m, k);
+    lamp_mat_rand(dense);
+    for (size_t i = 0; i < LAMP_MAT_NUM_ELEMENTS(dense); ++i) {
+        if ((double) rand() / RAND_MAX >= density) {
+            dense->elements[i] = 0.0f;
+        }
+    }
+    LampSparseMatrix *sparse = lamp_sparse_mat_alloc_from_dense(dense);
+    LampMatrix *round_trip = lamp_mat_alloc(m, k);
+    lamp_mat_fill_with(round_trip, 1.0f);
+    lamp_sparse_mat_to_dense(round_trip, sparse);
+    bool result = lamp_matrix_equal(round_trip, dense);
+
+    LampMatrix *b = lamp_mat_alloc(k, n);
+    LampMatrix *bt = lamp_mat_alloc(n, k);
+    LampMatrix *bias = lamp_mat_alloc(m, 1);
+    lamp_mat_rand(b);
+    lamp_mat_transpose_into(bt, b);
+    lamp_mat_rand(bias);
+
+    LampMatrix *expected = lamp_mat_alloc(m, n);
+    LampMatrix *product = lamp_mat_alloc(m, n);
+    lamp_mat_multiply_into(expected, dense, b);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            LAMP_MAT_ELEMENT_AT(expected, i, j) += bias->elements[i];
+        }
+    }
+
+    LampGemmEpilogue epilogue = {.row_bias = bias->elements, .activation = NULL};
+    lamp_sparse_mat_multiply_into(product, sparse, b, &epilogue);
+    if (!relative_close(expected->elements, product->elements, m * n, 1e-5f)) {
+        result = LAMP_TEST_FAILED;
+    }
+    lamp_mat_fill_with(product, -1.0f);
+    lamp_sparse_gemm(true, n, sparse, bt->elements, k, product->elements, n, &epilogue);
+    if (!relative_close(expected->elements, product->elements, m * n, 1e-5f)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    lamp_sparse_mat_free(sparse);
+    lamp_mat_free(dense);
+    lamp_mat_free(round_trip);
+    lamp_mat_free(b);
+    lamp_mat_free(bt);
+    lamp_mat_free(bias);
+    lamp_mat_free(expected);
+    lamp_mat_free(product);
+    return result;
+}
+
+bool test_matrix_sparse(void) {
+    // Empty matrices, more columns than one block of the kernel and products, that are split over a pool
+    if (!sparse_multiplication_matches(3, 2, 1, 0.5) ||
+        !sparse_multiplication_matches(5, 8, 3, 0.0) ||
+        !sparse_multiplication_matches(7, 19, 300, 0.1) ||
+        !sparse_multiplication_matches(131, 300, 67, 0.2)) {
+        return LAMP_TEST_FAILED;
+    }
     return LAMP_TEST_PASSED;
 }
 
+bool test_matrix_views(void) {
+    // [0, 1, 2, 3]
+    // [4, 5, 6, 7]
+    // [8, 9, 10, 11]
+    LAMP_FLOAT_TYPE content[12];
+    for (size_t i = 0; i < 12; ++i) {
+        content[i] = (LAMP_FLOAT_TYPE) i;
+    }
+    LampMatrix *m = lamp_mat_alloc_from_array(3, 4, content);
+    LampMatrixView whole = lamp_mat_view(m);
+
+    LampMatrixView rows = lamp_mat_view_rows(&whole, 1, 2);
+    LampMatrixView cols = lamp_mat_view_cols(&whole, 2, 2);
+    LampMatrixView sub = lamp_mat_view_sub(&rows, 1, 1, 1, 2);
+    if (LAMP_VIEW_ELEMENT_AT(&rows, 0, 0) != 4 || LAMP_VIEW_ELEMENT_AT(&rows, 1, 3) != 11 ||
+        LAMP_VIEW_ELEMENT_AT(&cols, 2, 0) != 10 || LAMP_VIEW_ELEMENT_AT(&cols, 0, 1) != 3 ||
+        sub.num_rows != 1 || sub.num_cols != 2 || LAMP_VIEW_ELEMENT_AT(&sub, 0, 1) != 10) {
+        lamp_mat_free(m);
+        return LAMP_TEST_FAILED;
+    }
+
+    // [4, 5]   [2, 3]   [38, 47]
+    // [8, 9] * [6, 7] = [70, 87]
+    LampMatrixView left = lamp_mat_view_sub(&whole, 1, 0, 2, 2);
+    LampMatrixView right = lamp_mat_view_sub(&whole, 0, 2, 2, 2);
+    LampMatrix *product = lamp_mat_alloc(2, 2);
+    LampMatrixView product_view = lamp_mat_view(product);
+    lamp_mat_view_multiply_into(&product_view, &left, &right);
+
+    LAMP_FLOAT_TYPE expected_product[] = {38, 47, 70, 87};
+    LampMatrix *expected = lamp_mat_alloc_from_array(2, 2, expected_product);
+    bool result = lamp_matrix_equal(product, expected);
+
+    // Adding a view only touches the viewed elements
+    lamp_mat_view_add(&right, &left);
+    if (LAMP_VIEW_ELEMENT_AT(&whole, 0, 2) != 6 || LAMP_VIEW_ELEMENT_AT(&whole, 1, 3) != 16 ||
+        LAMP_VIEW_ELEMENT_AT(&whole, 0, 1) != 1 || LAMP_VIEW_ELEMENT_AT(&whole, 2, 2) != 10) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    lamp_mat_free(m);
+    lamp_mat_free(product);
+    lamp_mat_free(expected);
+    return result;
+}
+
 static LampTest matrix_tests[] = {
-        {test_matrix_fill,           "Matrix fill"},
-        {test_matrix_randomize,      "Matrix randomize"},
-        {test_matrix_equals,         "Matrix equals"},
-        {test_matrix_copies,         "Matrix copies"},
-        {test_matrix_multiplication, "Matrix mult"},
-        {test_matrix_allocation,     "Matrix alloc"},
-        {test_matrix_transpose,      "Matrix transpose"}
+        {test_matrix_fill,                 "Matrix fill"},
+        {test_matrix_randomize,            "Matrix randomize"},
+        {test_matrix_equals,               "Matrix equals"},
+        {test_matrix_copies,               "Matrix copies"},
+        {test_matrix_multiplication,       "Matrix mult"},
+        {test_matrix_multiplication_large, "Matrix mult large"},
+        {test_matrix_allocation,           "Matrix alloc"},
+        {test_matrix_transpose,            "Matrix transpose"},
+        {test_matrix_into_variants,        "Matrix into variants"},
+        {test_matrix_multiply_transposed,  "Matrix mult transposed"},
+        {test_matrix_simd_kernels,         "Matrix SIMD kernels"},
+        {test_matrix_gemm_tiles,           "Matrix GEMM tiles"},
+        {test_matrix_half_conversions,     "Matrix half conversions"},
+        {test_matrix_half_multiplication,  "Matrix half mult"},
+        {test_matrix_quant_multiplication, "Matrix quant mult"},
+        {test_matrix_sparse,               "Matrix sparse"},
+        {test_matrix_views,                "Matrix views"}
 };
 
 bool test_nn_alloc(void) {
@@ -241,31 +1053,2114 @@ bool test_nn_alloc(void) {
     return LAMP_TEST_PASSED;
 }
 
-static LampTest nn_tests[] = {
-        {test_nn_alloc, "NN alloc"}
-};
+// Compare the analytic gradients of the backpropagation with the central differences of
+// lamp_nn_finite_diff_gradients(), which leaves the parameters untouched and is exact up to the third derivative
+static bool backprop_matches_finite_diff(LampActivation hidden, LampActivation output) {
+    size_t arch[] = {2, 3, 2};
+    LampNN *nn = lamp_nn_alloc(arch, sizeof(arch) / sizeof(arch[0]));
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+    lamp_nn_set_activation(nn, 0, hidden);
+    lamp_nn_set_activation(nn, 1, output);
 
-static void show_result(bool success, char *test_name) {
-    printf("TEST: %s \t%s\n", test_name, success == LAMP_TEST_PASSED ? "SUCCESS" : "FAILED");
+    LAMP_FLOAT_TYPE ins[] = {0, 0, 0, 1, 1, 0, 1, 1};
+    LAMP_FLOAT_TYPE targs[] = {0, 0, 1, 0, 1, 0, 0, 1};
+    LampMatrix *input = lamp_mat_alloc_from_array(4, 2, ins);
+    LampMatrix *target = lamp_mat_alloc_from_array(4, 2, targs);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView target_view = lamp_mat_view(target);
+    LAMP_FLOAT_TYPE *expected = malloc(sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    assert(expected != NULL);
+
+    lamp_nn_backprop(nn, input, target);
+    // A small step rarely straddles the kink of a ReLU, the rounding of the loss stays far below the tolerance
+    lamp_nn_finite_diff_gradients(nn, &input_view, &target_view, 1e-4f, NULL, expected);
+    bool result = relative_close(expected, nn->grads, nn->params_size, 2e-2f);
+
+    free(expected);
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_nn_free(nn);
+    return result;
 }
 
-static bool run_test(const LampTest *test) {
-    assert(test != NULL);
-    return test->test_function();
+// The finite differences drift with large gradients, so the output layer uses bounded activations.
+// The derivatives of all activations are checked on their own by test_nn_activations().
+bool test_nn_backprop_gradients(void) {
+    if (!backprop_matches_finite_diff(LAMP_ACTIVATION_SIGMOID, LAMP_ACTIVATION_SIGMOID) ||
+        !backprop_matches_finite_diff(LAMP_ACTIVATION_TANH, LAMP_ACTIVATION_SOFTMAX) ||
+        !backprop_matches_finite_diff(LAMP_ACTIVATION_RELU, LAMP_ACTIVATION_SIGMOID) ||
+        !backprop_matches_finite_diff(LAMP_ACTIVATION_LEAKY_RELU, LAMP_ACTIVATION_SIGMOID) ||
+        !backprop_matches_finite_diff(LAMP_ACTIVATION_GELU, LAMP_ACTIVATION_SIGMOID) ||
+        !backprop_matches_finite_diff(LAMP_ACTIVATION_SOFTMAX, LAMP_ACTIVATION_SIGMOID)) {
+        return LAMP_TEST_FAILED;
+    }
+    return LAMP_TEST_PASSED;
 }
 
-int main() {
-    printf("LAMP Tests Matrix\n");
+// Check the derivative of every activation against central differences of L = sum(w (*) f(z))
+// for some fixed weights w, so dL/da = w is the incoming gradient.
+bool test_nn_activations(void) {
+    const size_t rows = 4, cols = 3;
+    const LAMP_FLOAT_TYPE step = 1e-2f;
+    LampMatrix *z = lamp_mat_alloc(rows, cols);
+    LampMatrix *a = lamp_mat_alloc(rows, cols);
+    LampMatrix *deltas = lamp_mat_alloc(rows, cols);
+    LampMatrix *probe = lamp_mat_alloc(rows, cols);
+    LampMatrix *w = lamp_mat_alloc(rows, cols);
+    for (size_t i = 0; i < rows * cols; ++i) {
+        // Keep a distance to 0, so the probes do not cross the kink of the ReLUs
+        z->elements[i] = ((LAMP_FLOAT_TYPE) (i % 5) - 2.2f) * 0.9f;
+        w->elements[i] = ((LAMP_FLOAT_TYPE) (i % 3) - 1.0f) * 0.5f + 0.1f;
+    }
 
-    int number_of_matrix_test = sizeof(matrix_tests) / sizeof(matrix_tests[0]);
-    for (int i = 0; i < number_of_matrix_test; ++i) {
-        show_result(run_test(&matrix_tests[i]), matrix_tests[i].desc);
+    bool result = LAMP_TEST_PASSED;
+    for (int act = 0; act < LAMP_ACTIVATION_COUNT; ++act) {
+        LampActivation activation = (LampActivation) act;
+        lamp_mat_copy_into(a, z);
+        lamp_activation_forward(activation, a);
+        lamp_mat_copy_into(deltas, w);
+        lamp_activation_backward(activation, deltas, a, z);
+
+        for (size_t i = 0; i < rows * cols; ++i) {
+            LAMP_FLOAT_TYPE loss[2];
+            for (int side = 0; side < 2; ++side) {
+                lamp_mat_copy_into(probe, z);
+                probe->elements[i] += side == 0 ? step : -step;
+                lamp_activation_forward(activation, probe);
+                loss[side] = 0.0f;
+                for (size_t k = 0; k < rows * cols; ++k) {
+                    loss[side] += w->elements[k] * probe->elements[k];
+                }
+            }
+            LAMP_FLOAT_TYPE grad = (loss[0] - loss[1]) / (2.0f * step);
+            if (LAMP_FABS(grad - deltas->elements[i]) > 2e-3f) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
     }
 
-    printf("\nLAMP Tests NN\n");
-    int number_of_nn_tests = sizeof(nn_tests) / sizeof(nn_tests[0]);
-    for (int i = 0; i < number_of_nn_tests; ++i) {
-        show_result(run_test(&nn_tests[i]), nn_tests[i].desc);
+    // Every column of the softmax is a probability distribution
+    lamp_mat_copy_into(a, z);
+    lamp_activation_forward(LAMP_ACTIVATION_SOFTMAX, a);
+    for (size_t j = 0; j < cols; ++j) {
+        LAMP_FLOAT_TYPE sum = 0.0f;
+        for (size_t i = 0; i < rows; ++i) {
+            sum += LAMP_MAT_ELEMENT_AT(a, i, j);
+        }
+        if (LAMP_FABS(sum - 1.0f) > 1e-6f) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    lamp_mat_free(z);
+    lamp_mat_free(a);
+    lamp_mat_free(deltas);
+    lamp_mat_free(probe);
+    lamp_mat_free(w);
+    return result;
+}
+
+bool test_nn_backprop_training(void) {
+    size_t arch[] = {2, 2, 1};
+    LampNN *nn = lamp_nn_alloc(arch, sizeof(arch) / sizeof(arch[0]));
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+
+    // OR-Gate
+    LAMP_FLOAT_TYPE ins[] = {0, 0, 0, 1, 1, 0, 1, 1};
+    LAMP_FLOAT_TYPE targs[] = {0, 1, 1, 1};
+    LampMatrix *input = lamp_mat_alloc_from_array(4, 2, ins);
+    LampMatrix *target = lamp_mat_alloc_from_array(4, 1, targs);
+
+    LAMP_FLOAT_TYPE initial_loss = lamp_nn_loss(nn, input, target);
+    for (int e = 0; e < 2000; ++e) {
+        lamp_nn_backprop(nn, input, target);
+        lamp_nn_apply_gradients(nn, 1.0f);
+    }
+    LAMP_FLOAT_TYPE final_loss = lamp_nn_loss(nn, input, target);
+
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_nn_free(nn);
+    return (final_loss < initial_loss && final_loss < 0.05f) ? LAMP_TEST_PASSED : LAMP_TEST_FAILED;
+}
+
+// A network processing several samples per forward pass has to produce the same loss and gradients
+// as one processing a single sample at a time. 5 samples with a batch size of 3 also cover a partial batch.
+bool test_nn_batched(void) {
+    size_t arch[] = {3, 4, 2};
+    LampNN *nn_single = lamp_nn_alloc(arch, sizeof(arch) / sizeof(arch[0]));
+    LampNN *nn_batched = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 3);
+    for (size_t i = 0; i < nn_single->connection_count; ++i) {
+        lamp_mat_rand(nn_single->connections[i].weights);
+        lamp_mat_rand(nn_single->connections[i].bias);
+        lamp_mat_copy_into(nn_batched->connections[i].weights, nn_single->connections[i].weights);
+        lamp_mat_copy_into(nn_batched->connections[i].bias, nn_single->connections[i].bias);
+    }
+
+    LampMatrix *input = lamp_mat_alloc(5, 3);
+    LampMatrix *target = lamp_mat_alloc(5, 2);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+
+    bool result = LAMP_TEST_PASSED;
+    if (LAMP_FABS(lamp_nn_loss(nn_single, input, target) - lamp_nn_loss(nn_batched, input, target)) > 1e-6f) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    lamp_nn_backprop(nn_single, input, target);
+    lamp_nn_backprop(nn_batched, input, target);
+    for (size_t i = 0; i < nn_single->connection_count; ++i) {
+        if (!lamp_matrix_equal(nn_single->connections[i].weights_grad, nn_batched->connections[i].weights_grad) ||
+            !lamp_matrix_equal(nn_single->connections[i].bias_grad, nn_batched->connections[i].bias_grad)) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_nn_free(nn_single);
+    lamp_nn_free(nn_batched);
+    return result;
+}
+
+static LampNN *alloc_xor_network(void) {
+    srand(1);
+    size_t arch[] = {2, 4, 1};
+    LampNN *nn = lamp_nn_alloc(arch, sizeof(arch) / sizeof(arch[0]));
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+    return nn;
+}
+
+// Follow the textbook formulas (with explicit bias correction) in double precision for a few steps
+static bool optimizer_matches_reference(const LampOptimizerConfig *config) {
+    LAMP_FLOAT_TYPE ins[] = {0, 0, 0, 1, 1, 0, 1, 1};
+    LAMP_FLOAT_TYPE targs[] = {0, 1, 1, 0};
+    LampMatrix *input = lamp_mat_alloc_from_array(4, 2, ins);
+    LampMatrix *target = lamp_mat_alloc_from_array(4, 1, targs);
+    LampNN *nn = alloc_xor_network();
+    LampOptimizer *optimizer = lamp_optimizer_alloc(nn, config);
+
+    double params[64] = {0}, m[64] = {0}, v[64] = {0};
+    assert(nn->params_size <= 64);
+    for (size_t i = 0; i < nn->params_size; ++i) {
+        params[i] = nn->params[i];
+    }
+
+    bool result = LAMP_TEST_PASSED;
+    for (int t = 1; t <= 5; ++t) {
+        lamp_nn_backprop(nn, input, target);
+        for (size_t i = 0; i < nn->params_size; ++i) {
+            double g = nn->grads[i];
+            if (config->type == LAMP_OPTIMIZER_SGD) {
+                m[i] = config->momentum * m[i] + g;
+                params[i] -= config->learning_rate * m[i];
+            } else {
+                m[i] = config->beta1 * m[i] + (1.0 - config->beta1) * g;
+                v[i] = config->beta2 * v[i] + (1.0 - config->beta2) * g * g;
+                double m_hat = m[i] / (1.0 - pow(config->beta1, t));
+                double v_hat = v[i] / (1.0 - pow(config->beta2, t));
+                if (config->type == LAMP_OPTIMIZER_ADAMW) {
+                    params[i] -= config->learning_rate * config->weight_decay * params[i];
+                }
+                params[i] -= config->learning_rate * m_hat / (sqrt(v_hat) + config->epsilon);
+            }
+        }
+        lamp_optimizer_step(optimizer, nn);
+
+        for (size_t i = 0; i < nn->params_size; ++i) {
+            if (fabs(params[i] - nn->params[i]) > 1e-5 * fmax(1.0, fabs(params[i]))) {
+                result = LAMP_TEST_FAILED;
+            }
+            // Continue from the same parameters, so the rounding differences do not add up
+            params[i] = nn->params[i];
+        }
+    }
+
+    lamp_optimizer_free(optimizer);
+    lamp_nn_free(nn);
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    return result;
+}
+
+bool test_nn_optimizers(void) {
+    LampOptimizerConfig configs[] = {
+            lamp_optimizer_sgd(0.5f, 0.0f),
+            lamp_optimizer_sgd(0.5f, 0.9f),
+            lamp_optimizer_adam(0.05f),
+            lamp_optimizer_adamw(0.05f, 0.1f),
+    };
+    size_t num_configs = sizeof(configs) / sizeof(configs[0]);
+    for (size_t c = 0; c < num_configs; ++c) {
+        if (!optimizer_matches_reference(&configs[c])) {
+            return LAMP_TEST_FAILED;
+        }
+    }
+
+    // With momentum or adaptive steps XOR is learned in a few hundred steps, where plain gradient descent
+    // from the same weights has barely started
+    LAMP_FLOAT_TYPE ins[] = {0, 0, 0, 1, 1, 0, 1, 1};
+    LAMP_FLOAT_TYPE targs[] = {0, 1, 1, 0};
+    LampMatrix *input = lamp_mat_alloc_from_array(4, 2, ins);
+    LampMatrix *target = lamp_mat_alloc_from_array(4, 1, targs);
+    const int steps = 500;
+
+    LampNN *nn = alloc_xor_network();
+    for (int e = 0; e < steps; ++e) {
+        lamp_nn_backprop(nn, input, target);
+        lamp_nn_apply_gradients(nn, 1.0f);
+    }
+    bool result = lamp_nn_loss(nn, input, target) > 0.1f;
+    lamp_nn_free(nn);
+
+    configs[3] = lamp_optimizer_adamw(0.05f, 1e-3f);
+    for (size_t c = 1; c < num_configs; ++c) {
+        nn = alloc_xor_network();
+        LampOptimizer *optimizer = lamp_optimizer_alloc(nn, &configs[c]);
+        for (int e = 0; e < steps; ++e) {
+            lamp_nn_backprop(nn, input, target);
+            lamp_optimizer_step(optimizer, nn);
+        }
+        if (lamp_nn_loss(nn, input, target) > 0.01f) {
+            result = LAMP_TEST_FAILED;
+        }
+        lamp_optimizer_free(optimizer);
+        lamp_nn_free(nn);
+    }
+
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    return result;
+}
+
+// Every thread of the pool multiplies once, so all of them own their packing buffers. Nobody leaves the barrier
+// before all threads have arrived, so every thread takes exactly one task.
+static void warm_up_task(void *context, size_t task_index) {
+    (void) task_index;
+    LampMatrix *a = lamp_mat_alloc(64, 64);
+    LampMatrix *c = lamp_mat_alloc_multiply(a, a);
+    lamp_mat_free(a);
+    lamp_mat_free(c);
+    pthread_barrier_wait(context);
+}
+
+// Allocations of the hot paths in the second round, the first round lets the matrix multiplications allocate
+// their packing buffers
+static size_t hot_path_allocations(LampNN *nn, size_t samples) {
+    size_t inputs = nn->layers[0].activations->num_rows;
+    size_t outputs = nn->layers[nn->layer_count - 1].activations->num_rows;
+    LampMatrix *input = lamp_mat_alloc(samples, inputs);
+    LampMatrix *target = lamp_mat_alloc(samples, outputs);
+    LampMatrix *output = lamp_mat_alloc(samples, outputs);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+    LampMatrixView inputs_view = lamp_mat_view(input);
+    LampMatrixView outputs_view = lamp_mat_view(output);
+    LampNNContext *ctx = lamp_nn_context_alloc(nn, nn->max_batch_size);
+    LampOptimizerConfig config = lamp_optimizer_adam(1e-3f);
+    LampOptimizer *optimizer = lamp_optimizer_alloc(nn, &config);
+
+    size_t allocations = 0;
+    for (int round = 0; round < 2; ++round) {
+        size_t before = lamp_alloc_count();
+        lamp_nn_set_batch_size(nn, nn->max_batch_size);
+        lamp_nn_forward(nn);
+        lamp_nn_backprop(nn, input, target);
+        lamp_optimizer_step(optimizer, nn);
+        lamp_nn_apply_gradients(nn, 1e-3f);
+        lamp_nn_infer(nn, ctx, &inputs_view, &outputs_view);
+        allocations = lamp_alloc_count() - before;
+    }
+
+    lamp_optimizer_free(optimizer);
+    lamp_nn_context_free(ctx);
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_mat_free(output);
+    return allocations;
+}
+
+// Once warmed up the hot paths work with the buffers of the network, context and optimizer only
+bool test_nn_no_allocations(void) {
+    if (!lamp_alloc_counting()) {
+        // Nothing to check without the wrapped allocation functions
+        return LAMP_TEST_PASSED;
+    }
+
+    size_t small_arch[] = {8, 16, 4};
+    LampNN *small = lamp_nn_alloc_batched(small_arch, sizeof(small_arch) / sizeof(small_arch[0]), 5);
+    lamp_nn_set_activation(small, 1, LAMP_ACTIVATION_SOFTMAX);
+    // Large enough for the packed multiplication on the pool, with a sparse connection
+    size_t large_arch[] = {64, 128, 32};
+    LampNN *large = lamp_nn_alloc_batched(large_arch, sizeof(large_arch) / sizeof(large_arch[0]), 64);
+    LampNN *networks[] = {small, large};
+    for (size_t n = 0; n < 2; ++n) {
+        for (size_t i = 0; i < networks[n]->connection_count; ++i) {
+            lamp_mat_rand(networks[n]->connections[i].weights);
+            lamp_mat_rand(networks[n]->connections[i].bias);
+        }
+    }
+    lamp_nn_prune(large, 0, 0.8f);
+
+    LampThreadPool *pool = lamp_threadpool_alloc(3);
+    lamp_threadpool_set_default(pool);
+    lamp_threadpool_set_threshold(0);
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned) lamp_threadpool_num_threads(pool));
+    lamp_threadpool_parallel_for(pool, lamp_threadpool_num_threads(pool), warm_up_task, &barrier);
+    pthread_barrier_destroy(&barrier);
+
+    bool result = hot_path_allocations(small, 12) == 0 && hot_path_allocations(large, 150) == 0;
+
+    // The counter has to see allocations at all
+    size_t before = lamp_alloc_count();
+    LampMatrix *copy = lamp_mat_alloc_copy(small->connections[0].weights);
+    result = result && lamp_alloc_count() > before;
+
+    lamp_threadpool_set_threshold(LAMP_THREADPOOL_DEFAULT_THRESHOLD);
+    lamp_threadpool_free(pool);
+    lamp_mat_free(copy);
+    lamp_nn_free(small);
+    lamp_nn_free(large);
+    return result;
+}
+
+// Feeding samples straight from a dataset has to give the same result as copying them into the input layer
+bool test_nn_forward_view(void) {
+    size_t arch[] = {3, 4, 2};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 2);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+
+    LampMatrix *dataset = lamp_mat_alloc(5, 3);
+    lamp_mat_rand(dataset);
+    LampMatrixView samples = lamp_mat_view(dataset);
+    LampMatrixView batch = lamp_mat_view_rows(&samples, 2, 2);
+
+    lamp_nn_forward_view(nn, &batch);
+    LampMatrix *from_view = lamp_mat_alloc_copy(nn->layers[nn->layer_count - 1].activations);
+
+    for (size_t s = 0; s < 2; ++s) {
+        for (size_t i = 0; i < 3; ++i) {
+            LAMP_MAT_ELEMENT_AT(nn->layers[0].activations, i, s) = LAMP_MAT_ELEMENT_AT(dataset, 2 + s, i);
+        }
+    }
+    lamp_nn_forward(nn);
+
+    bool result = lamp_matrix_equal(from_view, nn->layers[nn->layer_count - 1].activations);
+
+    lamp_mat_free(from_view);
+    lamp_mat_free(dataset);
+    lamp_nn_free(nn);
+    return result;
+}
+
+// The int8 forward pass has to stay close to the full precision one
+bool test_nn_quantized(void) {
+    const size_t batch = 64;
+    size_t arch[] = {64, 128, 32, 10};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), batch);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampMatrix *weights = nn->connections[i].weights;
+        lamp_mat_rand(weights);
+        lamp_mat_rand(nn->connections[i].bias);
+        // Zero centered weights scaled by the fan in keep the hidden activations out of saturation
+        for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(weights); ++j) {
+            weights->elements[j] = (weights->elements[j] * 2.0f - 1.0f) * 3.0f / sqrtf((float) weights->num_cols);
+        }
+    }
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_RELU);
+    lamp_nn_set_activation(nn, 1, LAMP_ACTIVATION_TANH);
+    lamp_nn_set_activation(nn, 2, LAMP_ACTIVATION_SOFTMAX);
+    lamp_mat_rand(nn->layers[0].activations);
+
+    const LampMatrix *output = nn->layers[nn->layer_count - 1].activations;
+    lamp_nn_forward(nn);
+    LampMatrix *expected = lamp_mat_alloc_copy(output);
+
+    LampNNQuantized *quantized = lamp_nn_quantize(nn);
+    lamp_nn_forward_quantized(nn, quantized);
+
+    // The probabilities may only move slightly and the predicted class has to stay the same for almost all samples
+    bool result = LAMP_TEST_PASSED;
+    size_t same_class = 0;
+    for (size_t j = 0; j < batch; ++j) {
+        size_t expected_class = 0;
+        size_t actual_class = 0;
+        for (size_t i = 0; i < output->num_rows; ++i) {
+            if (LAMP_FABS(LAMP_MAT_ELEMENT_AT(output, i, j) - LAMP_MAT_ELEMENT_AT(expected, i, j)) > 0.02f) {
+                result = LAMP_TEST_FAILED;
+            }
+            if (LAMP_MAT_ELEMENT_AT(expected, i, j) > LAMP_MAT_ELEMENT_AT(expected, expected_class, j)) {
+                expected_class = i;
+            }
+            if (LAMP_MAT_ELEMENT_AT(output, i, j) > LAMP_MAT_ELEMENT_AT(output, actual_class, j)) {
+                actual_class = i;
+            }
+        }
+        same_class += expected_class == actual_class;
+    }
+    if (same_class < batch * 95 / 100) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    lamp_nn_quantized_free(quantized);
+    lamp_mat_free(expected);
+    lamp_nn_free(nn);
+    return result;
+}
+
+typedef struct {
+    const LampNN *nn;
+    LampNNContext **contexts;
+    const LampMatrixView *input;
+    const LampMatrixView *output;
+} InferJob;
+
+// Every task infers one sample with its own context, while all of them share the network
+static void infer_task(void *context, size_t task_index) {
+    const InferJob *job = context;
+    LampMatrixView input = lamp_mat_view_rows(job->input, task_index, 1);
+    LampMatrixView output = lamp_mat_view_rows(job->output, task_index, 1);
+    lamp_nn_infer(job->nn, job->contexts[task_index], &input, &output);
+}
+
+bool test_nn_infer(void) {
+    size_t arch[] = {6, 9, 5, 4};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 11);
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_RELU);
+    lamp_nn_set_activation(nn, 2, LAMP_ACTIVATION_SOFTMAX);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+
+    LampMatrix *dataset = lamp_mat_alloc(11, 6);
+    lamp_mat_rand(dataset);
+    LampMatrixView samples = lamp_mat_view(dataset);
+    lamp_nn_forward_view(nn, &samples);
+    LampMatrix *expected = lamp_mat_transpose(nn->layers[nn->layer_count - 1].activations);
+
+    // The samples don't fit into one batch of the context
+    LampMatrix *output = lamp_mat_alloc(11, 4);
+    LampMatrixView outputs = lamp_mat_view(output);
+    LampNNContext *ctx = lamp_nn_context_alloc(nn, 3);
+    lamp_nn_infer(nn, ctx, &samples, &outputs);
+    bool result = relative_close(expected->elements, output->elements, LAMP_MAT_NUM_ELEMENTS(output), 1e-6f);
+    lamp_nn_context_free(ctx);
+
+    // Many threads at once
+    LampNNContext *contexts[11];
+    for (size_t i = 0; i < 11; ++i) {
+        contexts[i] = lamp_nn_context_alloc(nn, 1);
+    }
+    lamp_mat_fill_with(output, 0.0f);
+    InferJob job = {.nn = nn, .contexts = contexts, .input = &samples, .output = &outputs};
+    LampThreadPool *pool = lamp_threadpool_alloc(4);
+    lamp_threadpool_parallel_for(pool, 11, infer_task, &job);
+    lamp_threadpool_free(pool);
+    if (!relative_close(expected->elements, output->elements, LAMP_MAT_NUM_ELEMENTS(output), 1e-6f)) {
+        result = LAMP_TEST_FAILED;
+    }
+    for (size_t i = 0; i < 11; ++i) {
+        lamp_nn_context_free(contexts[i]);
+    }
+
+    lamp_mat_free(expected);
+    lamp_mat_free(output);
+    lamp_mat_free(dataset);
+    lamp_nn_free(nn);
+    return result;
+}
+
+static bool dense_forward_matches_unfused(size_t out, size_t in, size_t batch, LampActivation activation) {
+    LampMatrix *weights = lamp_mat_alloc(out, in);
+    LampMatrix *input = lamp_mat_alloc(in, batch);
+    LampMatrix *bias = lamp_mat_alloc(out, 1);
+    lamp_mat_rand(weights);
+    lamp_mat_rand(input);
+    lamp_mat_rand(bias);
+    // Keep the weighted sums small, so the sigmoid does not saturate and hide errors
+    for (size_t i = 0; i < LAMP_MAT_NUM_ELEMENTS(weights); ++i) {
+        weights->elements[i] = (weights->elements[i] - 0.5f) * 0.1f;
+    }
+
+    LampMatrix *fused = lamp_mat_alloc(out, batch);
+    lamp_nn_dense_forward(fused, weights, input, bias, activation);
+
+    LampMatrix *unfused = lamp_mat_alloc(out, batch);
+    lamp_mat_multiply_into(unfused, weights, input);
+    lamp_mat_add_column(unfused, bias);
+    lamp_activation_forward(activation, unfused);
+
+    bool result = lamp_matrix_equal(fused, unfused);
+
+    lamp_mat_free(unfused);
+    lamp_mat_free(fused);
+    lamp_mat_free(bias);
+    lamp_mat_free(input);
+    lamp_mat_free(weights);
+    return result;
+}
+
+// Weights and input in reduced precision have to give exactly the result of the widened operands
+static bool dense_forward_half_matches(size_t out, size_t in, size_t batch, LampActivation activation,
+                                       LampPrecision precision) {
+    LampMatrix *weights = lamp_mat_alloc(out, in);
+    LampMatrix *input = lamp_mat_alloc(in, batch);
+    LampMatrix *bias = lamp_mat_alloc(out, 1);
+    lamp_mat_rand(weights);
+    lamp_mat_rand(input);
+    lamp_mat_rand(bias);
+
+    LampHalfMatrix *half_weights = lamp_half_mat_alloc(out, in, precision);
+    LampHalfMatrix *half_input = lamp_half_mat_alloc(in, batch, precision);
+    lamp_half_mat_from_float(half_weights, weights);
+    lamp_half_mat_from_float(half_input, input);
+    lamp_half_mat_to_float(weights, half_weights);
+    lamp_half_mat_to_float(input, half_input);
+
+    LampMatrix *half = lamp_mat_alloc(out, batch);
+    LampMatrix *full = lamp_mat_alloc(out, batch);
+    lamp_nn_dense_forward_half(half, half_weights, half_input, bias, activation);
+    lamp_nn_dense_forward(full, weights, input, bias, activation);
+    bool result = lamp_matrix_equal(half, full);
+
+    lamp_mat_free(full);
+    lamp_mat_free(half);
+    lamp_half_mat_free(half_input);
+    lamp_half_mat_free(half_weights);
+    lamp_mat_free(bias);
+    lamp_mat_free(input);
+    lamp_mat_free(weights);
+    return result;
+}
+
+bool test_nn_dense_forward(void) {
+    // Small shapes use the simple loop, the large one the packed kernel with several blocks along k
+    for (int act = 0; act < LAMP_ACTIVATION_COUNT; ++act) {
+        if (!dense_forward_matches_unfused(3, 2, 1, (LampActivation) act) ||
+            !dense_forward_matches_unfused(7, 5, 19, (LampActivation) act) ||
+            !dense_forward_matches_unfused(131, 300, 67, (LampActivation) act) ||
+            !dense_forward_half_matches(7, 5, 19, (LampActivation) act, LAMP_PRECISION_FP16) ||
+            !dense_forward_half_matches(131, 300, 67, (LampActivation) act, LAMP_PRECISION_BF16)) {
+            return LAMP_TEST_FAILED;
+        }
+    }
+    return LAMP_TEST_PASSED;
+}
+
+bool test_nn_save_load(void) {
+    const char *path = "lamp_test_model.bin";
+    size_t arch[] = {3, 5, 4, 2};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 4);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_RELU);
+    lamp_nn_set_activation(nn, 2, LAMP_ACTIVATION_SOFTMAX);
+
+    LampMatrix *input = lamp_mat_alloc(4, 3);
+    lamp_mat_rand(input);
+    LampMatrixView samples = lamp_mat_view(input);
+    lamp_nn_forward_view(nn, &samples);
+
+    if (!lamp_nn_save(nn, path)) {
+        lamp_mat_free(input);
+        lamp_nn_free(nn);
+        return LAMP_TEST_FAILED;
+    }
+
+    bool result = LAMP_TEST_PASSED;
+    LampNN *loaded = lamp_nn_load(path, 4);
+    if (loaded == NULL || loaded->layer_count != nn->layer_count || loaded->params_size != nn->params_size) {
+        result = LAMP_TEST_FAILED;
+    } else {
+        for (size_t i = 0; i < nn->connection_count; ++i) {
+            // The parameters are used in place from the mapped file
+            const unsigned char *weights = (const unsigned char *) loaded->connections[i].weights->elements;
+            if (loaded->connections[i].activation != nn->connections[i].activation ||
+                weights < (const unsigned char *) loaded->mapping ||
+                weights >= (const unsigned char *) loaded->mapping + loaded->mapping_size ||
+                (size_t) weights % LAMP_ARENA_ALIGNMENT != 0) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+
+        lamp_nn_forward_view(loaded, &samples);
+        if (!lamp_matrix_equal(nn->layers[nn->layer_count - 1].activations,
+                               loaded->layers[loaded->layer_count - 1].activations)) {
+            result = LAMP_TEST_FAILED;
+        }
+
+        // Changing the loaded network does not change the file
+        lamp_mat_fill_with(loaded->connections[0].weights, 0.0f);
+        LampNN *reloaded = lamp_nn_load(path, 1);
+        if (reloaded == NULL || !lamp_matrix_equal(reloaded->connections[0].weights, nn->connections[0].weights)) {
+            result = LAMP_TEST_FAILED;
+        }
+        if (reloaded != NULL) {
+            lamp_nn_free(reloaded);
+        }
+    }
+    if (loaded != NULL) {
+        lamp_nn_free(loaded);
+    }
+
+    // Anything but a model is rejected
+    FILE *file = fopen(path, "wb");
+    fputs("definitely not a model", file);
+    fclose(file);
+    if (lamp_nn_load(path, 1) != NULL || lamp_nn_load("does/not/exist.bin", 1) != NULL) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    remove(path);
+    lamp_mat_free(input);
+    lamp_nn_free(nn);
+    return result;
+}
+
+// Write the first length bytes of contents to a file and try to load them as a model
+static LampNN *load_model_bytes(const char *path, const unsigned char *contents, size_t length) {
+    FILE *file = fopen(path, "wb");
+    bool success = file != NULL && fwrite(contents, 1, length, file) == length;
+    success = file != NULL && fclose(file) == 0 && success;
+    return success ? lamp_nn_load(path, 1) : NULL;
+}
+
+bool test_nn_load_untrusted(void) {
+    const char *path = "lamp_test_model.bin";
+    // Offsets of the header fields and of the architecture, that follows the header
+    const size_t layer_count_offset = 20, params_offset_offset = 24, params_size_offset = 32, neurons_offset = 64;
+
+    size_t arch[] = {3, 5, 2};
+    LampNN *nn = lamp_nn_alloc(arch, sizeof(arch) / sizeof(arch[0]));
+    unsigned char model[1024], contents[1024];
+    FILE *file = lamp_nn_save(nn, path) ? fopen(path, "rb") : NULL;
+    size_t length = file != NULL ? fread(model, 1, sizeof(model), file) : 0;
+    if (file != NULL) {
+        fclose(file);
+    }
+    lamp_nn_free(nn);
+    nn = length > neurons_offset && length < sizeof(model) ? load_model_bytes(path, model, length) : NULL;
+    if (nn == NULL) {
+        remove(path);
+        return LAMP_TEST_FAILED;
+    }
+    lamp_nn_free(nn);
+
+    // Cutting the file off anywhere before the end of the parameters
+    bool result = LAMP_TEST_PASSED;
+    for (size_t cut = 1; cut < length && result; cut += 7) {
+        result = load_model_bytes(path, model, length - cut) == NULL;
+    }
+
+    // A layer count far beyond the file together with the parameter offset, that belongs to it
+    uint32_t layers = UINT32_MAX;
+    uint64_t params_offset = (64 + 8 * (uint64_t) layers + 64 * ((uint64_t) layers - 1) + 63) / 64 * 64;
+    memcpy(contents, model, length);
+    memcpy(&contents[layer_count_offset], &layers, sizeof(layers));
+    memcpy(&contents[params_offset_offset], &params_offset, sizeof(params_offset));
+    result = result && load_model_bytes(path, contents, length) == NULL;
+
+    // 2^62 hidden neurons wrap the size of the parameter block around to 64 bytes (16 elements), so a file, that
+    // claims this size, would describe a network with billions of neurons
+    uint64_t params_size = 16, hidden = (uint64_t) 1 << 62;
+    memcpy(contents, model, length);
+    memcpy(&contents[params_size_offset], &params_size, sizeof(params_size));
+    memcpy(&contents[neurons_offset + sizeof(uint64_t)], &hidden, sizeof(hidden));
+    result = result && load_model_bytes(path, contents, length) == NULL;
+
+    remove(path);
+    return result;
+}
+
+static bool matrix_in_arena(const LampMatrix *mat, const LampArena *arena) {
+    const unsigned char *begin = (const unsigned char *) mat->elements;
+    const unsigned char *end = begin + LAMP_MAT_NUM_ELEMENTS(mat) * sizeof(LAMP_FLOAT_TYPE);
+    return ((size_t) begin % LAMP_ARENA_ALIGNMENT) == 0 && begin >= arena->base &&
+           end <= arena->base + arena->capacity;
+}
+
+bool test_nn_arena(void) {
+    size_t arch[] = {3, 5, 2};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 4);
+
+    bool result = LAMP_TEST_PASSED;
+    for (size_t i = 0; i < nn->layer_count; ++i) {
+        if (!matrix_in_arena(nn->layers[i].activations, nn->arena) ||
+            !matrix_in_arena(nn->layers[i].deltas, nn->arena)) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    // Parameters and gradients are found at the same offset of their block
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampNNConnection *conn = &nn->connections[i];
+        if (!matrix_in_arena(conn->weights, nn->arena) || !matrix_in_arena(conn->bias, nn->arena) ||
+            conn->weights->elements < nn->params ||
+            conn->bias->elements + LAMP_MAT_NUM_ELEMENTS(conn->bias) > nn->params + nn->params_size ||
+            conn->weights_grad->elements - nn->grads != conn->weights->elements - nn->params ||
+            conn->bias_grad->elements - nn->grads != conn->bias->elements - nn->params) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    // Resetting the parameter block resets every weight and bias
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+    memset(nn->params, 0, nn->params_size * sizeof(LAMP_FLOAT_TYPE));
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampMatrix *zeros = lamp_mat_alloc(arch[i + 1], arch[i]);
+        lamp_mat_fill_with(zeros, 0.0f);
+        if (!lamp_matrix_equal(zeros, nn->connections[i].weights)) {
+            result = LAMP_TEST_FAILED;
+        }
+        lamp_mat_free(zeros);
+    }
+
+    lamp_nn_free(nn);
+    return result;
+}
+
+bool test_nn_prune(void) {
+    size_t arch[] = {16, 32, 8};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 4);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampMatrix *weights = nn->connections[i].weights;
+        lamp_mat_rand(weights);
+        lamp_mat_rand(nn->connections[i].bias);
+        for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(weights); ++j) {
+            weights->elements[j] = weights->elements[j] * 2.0f - 1.0f;
+        }
+    }
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_TANH);
+
+    lamp_nn_prune(nn, 0, 0.8f);
+    lamp_nn_prune(nn, 1, 0.5f);
+    bool result = LAMP_TEST_PASSED;
+    const size_t expected_nonzeros[] = {512 - 409, 256 - 128};
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        const LampNNConnection *conn = &nn->connections[i];
+        size_t nonzeros = 0;
+        for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(conn->weights); ++j) {
+            nonzeros += conn->weights->elements[j] != 0.0f;
+        }
+        if (conn->sparse_weights == NULL || conn->sparse_weights->num_nonzeros != expected_nonzeros[i] ||
+            nonzeros != expected_nonzeros[i]) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    // A dense network with the same (pruned) parameters has to calculate the same outputs
+    LampNN *dense = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 4);
+    memcpy(dense->params, nn->params, sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    lamp_nn_set_activation(dense, 0, LAMP_ACTIVATION_TANH);
+
+    // More samples than fit into one batch
+    LampMatrix *input = lamp_mat_alloc(6, arch[0]);
+    LampMatrix *output = lamp_mat_alloc(6, arch[2]);
+    LampMatrix *expected = lamp_mat_alloc(6, arch[2]);
+    lamp_mat_rand(input);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView output_view = lamp_mat_view(output);
+    LampMatrixView expected_view = lamp_mat_view(expected);
+    LampNNContext *ctx = lamp_nn_context_alloc(nn, 4);
+    lamp_nn_infer(nn, ctx, &input_view, &output_view);
+    lamp_nn_infer(dense, ctx, &input_view, &expected_view);
+    if (!relative_close(expected->elements, output->elements, LAMP_MAT_NUM_ELEMENTS(output), 1e-5f)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    LampMatrixView batch = lamp_mat_view_rows(&input_view, 0, 4);
+    lamp_nn_forward_view(nn, &batch);
+    lamp_nn_forward_view(dense, &batch);
+    const LampMatrix *sparse_out = nn->layers[2].activations;
+    const LampMatrix *dense_out = dense->layers[2].activations;
+    if (!relative_close(dense_out->elements, sparse_out->elements, LAMP_MAT_NUM_ELEMENTS(dense_out), 1e-5f)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    // Back to dense storage, the pruned weights stay zero
+    lamp_nn_prune(nn, 0, 0.0f);
+    if (nn->connections[0].sparse_weights != NULL ||
+        memcmp(nn->params, dense->params, sizeof(LAMP_FLOAT_TYPE) * nn->params_size) != 0) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    lamp_nn_context_free(ctx);
+    lamp_mat_free(input);
+    lamp_mat_free(output);
+    lamp_mat_free(expected);
+    lamp_nn_free(dense);
+    lamp_nn_free(nn);
+    return result;
+}
+
+// Read a whole file into a buffer, that the caller frees
+static unsigned char *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL || fseek(file, 0, SEEK_END) != 0 || ftell(file) <= 0) {
+        if (file != NULL) {
+            fclose(file);
+        }
+        return NULL;
+    }
+    *length = (size_t) ftell(file);
+    unsigned char *contents = malloc(*length);
+    assert(contents != NULL);
+    rewind(file);
+    bool success = fread(contents, 1, *length, file) == *length;
+    fclose(file);
+    if (!success) {
+        free(contents);
+        return NULL;
+    }
+    return contents;
+}
+
+// A saved pruned model is still pruned after loading it, without writing to the mapped file: the mapping is
+// read-only while the network infers. An inference copy only saves its sparse weights, which the loaded network
+// uses right from the mapping. A column index out of range or a truncated sparse block are rejected.
+bool test_nn_prune_saved(void) {
+    const char *path = "lamp_test_pruned_model.bin";
+    size_t arch[] = {64, 48, 4};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 5);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampMatrix *weights = nn->connections[i].weights;
+        lamp_mat_rand(weights);
+        lamp_mat_rand(nn->connections[i].bias);
+        for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(weights); ++j) {
+            weights->elements[j] = weights->elements[j] * 2.0f - 1.0f;
+        }
+        lamp_nn_prune(nn, i, 0.9f);
+    }
+
+    LampMatrix *input = lamp_mat_alloc(5, arch[0]);
+    LampMatrix *expected = lamp_mat_alloc(5, arch[2]);
+    LampMatrix *output = lamp_mat_alloc(5, arch[2]);
+    lamp_mat_rand(input);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView expected_view = lamp_mat_view(expected);
+    LampMatrixView output_view = lamp_mat_view(output);
+    LampNNContext *ctx = lamp_nn_context_alloc(nn, 5);
+    lamp_nn_infer(nn, ctx, &input_view, &expected_view);
+
+    bool result = LAMP_TEST_PASSED;
+    LampNN *inference = lamp_nn_alloc_inference_copy(nn, 5);
+    LampNN *models[] = {nn, inference};
+    for (size_t m = 0; m < 2; ++m) {
+        LampNN *loaded = lamp_nn_save(models[m], path) ? lamp_nn_load(path, 5) : NULL;
+        if (loaded == NULL || lamp_nn_trainable(loaded) != (m == 0) ||
+            mprotect(loaded->mapping, loaded->mapping_size, PROT_READ) != 0) {
+            result = LAMP_TEST_FAILED;
+            if (loaded != NULL) {
+                lamp_nn_free(loaded);
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < loaded->connection_count; ++i) {
+            const LampSparseMatrix *sparse = loaded->connections[i].sparse_weights;
+            const unsigned char *values = sparse != NULL ? (const unsigned char *) sparse->values : NULL;
+            bool mapped = values >= (const unsigned char *) loaded->mapping &&
+                          values < (const unsigned char *) loaded->mapping + loaded->mapping_size;
+            if (sparse == NULL || sparse->num_nonzeros != nn->connections[i].sparse_weights->num_nonzeros ||
+                mapped != (m == 1)) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+        LampNNPlan *plan = lamp_nn_compile(loaded, 5);
+        lamp_nn_plan_infer(plan, &input_view, &output_view);
+        if (!relative_close(expected->elements, output->elements, LAMP_MAT_NUM_ELEMENTS(output), 1e-5f)) {
+            result = LAMP_TEST_FAILED;
+        }
+        lamp_nn_plan_free(plan);
+        mprotect(loaded->mapping, loaded->mapping_size, PROT_READ | PROT_WRITE);
+        lamp_nn_free(loaded);
+    }
+
+    // The inference copy infers the same outputs as the network it was copied from
+    lamp_nn_infer(inference, ctx, &input_view, &output_view);
+    if (!relative_close(expected->elements, output->elements, LAMP_MAT_NUM_ELEMENTS(output), 1e-5f)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    size_t length = 0;
+    unsigned char *contents = read_file(path, &length);
+    LampNN *loaded = contents != NULL ? lamp_nn_load(path, 1) : NULL;
+    if (loaded == NULL) {
+        result = LAMP_TEST_FAILED;
+    } else {
+        const LampSparseMatrix *sparse = loaded->connections[0].sparse_weights;
+        size_t col_offset = (size_t) ((unsigned char *) sparse->col_indices - (unsigned char *) loaded->mapping);
+        lamp_nn_free(loaded);
+
+        uint32_t col = (uint32_t) arch[0];
+        memcpy(&contents[col_offset + sizeof(uint32_t)], &col, sizeof(col));
+        if (load_model_bytes(path, contents, length) != NULL ||
+            load_model_bytes(path, contents, length - LAMP_ARENA_ALIGNMENT) != NULL) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    free(contents);
+    remove(path);
+    lamp_nn_free(inference);
+    lamp_nn_context_free(ctx);
+    lamp_mat_free(input);
+    lamp_mat_free(expected);
+    lamp_mat_free(output);
+    lamp_nn_free(nn);
+    return result;
+}
+
+// Bytes of memory a network takes, including the sparse weights and the mapped model file
+static size_t nn_memory(const LampNN *nn) {
+    size_t size = nn->arena->capacity + nn->mapping_size;
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        const LampSparseMatrix *sparse = nn->connections[i].sparse_weights;
+        if (sparse != NULL) {
+            size += sizeof(size_t) * (sparse->num_rows + 1);
+            size += sparse->external ? 0 : (sizeof(uint32_t) + sizeof(LAMP_FLOAT_TYPE)) * sparse->num_nonzeros;
+        }
+    }
+    return size;
+}
+
+// A connection of 512 * 512 weights takes 1 MB of dense weights and as much for their gradients. Pruned to 0.9,
+// the sparse weights of an inference copy take a fifth of the dense weights, in memory as well as in the model file.
+bool test_nn_prune_memory(void) {
+    const char *path = "lamp_test_pruned_model.bin";
+    size_t arch[] = {512, 512, 10};
+    LampNN *dense = lamp_nn_alloc(arch, sizeof(arch) / sizeof(arch[0]));
+    for (size_t i = 0; i < dense->connection_count; ++i) {
+        lamp_mat_rand(dense->connections[i].weights);
+    }
+    LampNN *pruned = lamp_nn_alloc_copy(dense, 1);
+    lamp_nn_prune(pruned, 0, 0.9f);
+    LampNN *inference = lamp_nn_alloc_inference_copy(pruned, 1);
+
+    // Pruning alone keeps the dense weights, only the inference copy drops them
+    bool result = nn_memory(pruned) > nn_memory(dense) && 4 * nn_memory(inference) < nn_memory(dense) &&
+                  inference->connections[0].weights->elements == NULL &&
+                  inference->connections[1].weights->elements != NULL;
+
+    LampNN *loaded_dense = lamp_nn_save(dense, path) ? lamp_nn_load(path, 1) : NULL;
+    LampNN *loaded_inference = lamp_nn_save(inference, path) ? lamp_nn_load(path, 1) : NULL;
+    result = result && loaded_dense != NULL && loaded_inference != NULL &&
+             4 * loaded_inference->mapping_size < loaded_dense->mapping_size &&
+             4 * nn_memory(loaded_inference) < nn_memory(loaded_dense);
+
+    if (loaded_dense != NULL) {
+        lamp_nn_free(loaded_dense);
+    }
+    if (loaded_inference != NULL) {
+        lamp_nn_free(loaded_inference);
+    }
+    remove(path);
+    lamp_nn_free(inference);
+    lamp_nn_free(pruned);
+    lamp_nn_free(dense);
+    return result;
+}
+
+// A pruned network stays pruned while it is trained, serially and data parallel, with plain gradient descent and
+// an optimizer. Every step backpropagates the gradients of the network, that the update changes, and the inference
+// of the sparse weights keeps up with the updates.
+bool test_nn_prune_training(void) {
+    srand(7);
+    size_t arch[] = {8, 12, 4};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 6);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampMatrix *weights = nn->connections[i].weights;
+        lamp_mat_rand(weights);
+        lamp_mat_rand(nn->connections[i].bias);
+        for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(weights); ++j) {
+            weights->elements[j] = weights->elements[j] * 2.0f - 1.0f;
+        }
+    }
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_TANH);
+    lamp_nn_prune(nn, 0, 0.75f);
+    lamp_nn_prune(nn, 1, 0.5f);
+    LAMP_FLOAT_TYPE *pruned_params = malloc(sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    LAMP_FLOAT_TYPE *expected = malloc(sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    assert(pruned_params != NULL && expected != NULL);
+    memcpy(pruned_params, nn->params, sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+
+    LampMatrix *input = lamp_mat_alloc(6, arch[0]);
+    LampMatrix *target = lamp_mat_alloc(6, arch[2]);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView target_view = lamp_mat_view(target);
+    LampThreadPool *pool = lamp_threadpool_alloc(2);
+    LampDataParallel *parallel = lamp_data_parallel_alloc(nn, pool);
+    LampOptimizerConfig config = lamp_optimizer_adam(1e-2f);
+    LampOptimizer *optimizer = lamp_optimizer_alloc(nn, &config);
+
+    bool result = LAMP_TEST_PASSED;
+    for (int step = 0; step < 6; ++step) {
+        if (step % 2 == 0) {
+            lamp_nn_backprop(nn, input, target);
+        } else {
+            lamp_data_parallel_backprop(parallel, input, target);
+        }
+        lamp_nn_finite_diff_gradients(nn, &input_view, &target_view, 1e-2f, NULL, expected);
+        for (size_t i = 0; i < nn->params_size; ++i) {
+            if (LAMP_FABS(expected[i] - nn->grads[i]) > 1e-3f) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+
+        if (step % 3 == 2) {
+            lamp_nn_apply_gradients(nn, 0.5f);
+        } else {
+            lamp_optimizer_step(optimizer, nn);
+        }
+        for (size_t i = 0; i < nn->connection_count; ++i) {
+            const LampMatrix *weights = nn->connections[i].weights;
+            size_t offset = (size_t) (weights->elements - nn->params);
+            for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(weights); ++j) {
+                if (pruned_params[offset + j] == 0.0f && weights->elements[j] != 0.0f) {
+                    result = LAMP_TEST_FAILED;
+                }
+            }
+        }
+    }
+    if (memcmp(pruned_params, nn->params, sizeof(LAMP_FLOAT_TYPE) * nn->params_size) == 0) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    // A copy owns its own sparse weights. Once switched back to dense, it infers what the trained sparse weights do.
+    LampNN *dense = lamp_nn_alloc_copy(nn, 6);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        if (dense->connections[i].sparse_weights == NULL ||
+            dense->connections[i].sparse_weights == nn->connections[i].sparse_weights) {
+            result = LAMP_TEST_FAILED;
+        }
+        lamp_nn_prune(dense, i, 0.0f);
+    }
+    LampMatrix *output = lamp_mat_alloc(6, arch[2]);
+    LampMatrix *dense_output = lamp_mat_alloc(6, arch[2]);
+    LampMatrixView output_view = lamp_mat_view(output);
+    LampMatrixView dense_view = lamp_mat_view(dense_output);
+    LampNNContext *ctx = lamp_nn_context_alloc(nn, 6);
+    lamp_nn_infer(nn, ctx, &input_view, &output_view);
+    lamp_nn_infer(dense, ctx, &input_view, &dense_view);
+    if (!relative_close(dense_output->elements, output->elements, LAMP_MAT_NUM_ELEMENTS(output), 1e-5f)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    lamp_nn_context_free(ctx);
+    lamp_mat_free(output);
+    lamp_mat_free(dense_output);
+    lamp_nn_free(dense);
+    lamp_optimizer_free(optimizer);
+    lamp_data_parallel_free(parallel);
+    lamp_threadpool_free(pool);
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    free(pruned_params);
+    free(expected);
+    lamp_nn_free(nn);
+    return result;
+}
+
+// Straightforward convolution of every output pixel, which the fast kernels are compared against
+static void conv_reference(const LampConv2dShape *shape, size_t batch, const LampConvInput *input,
+                           const LAMP_FLOAT_TYPE *weights, const LAMP_FLOAT_TYPE *bias, LAMP_FLOAT_TYPE *output) {
+    size_t out_height = lamp_conv2d_out_height(shape), out_width = lamp_conv2d_out_width(shape);
+    size_t k = shape->kernel_size;
+    for (size_t o = 0; o < shape->out_channels; ++o) {
+        for (size_t y = 0; y < out_height; ++y) {
+            for (size_t x = 0; x < out_width; ++x) {
+                for (size_t s = 0; s < batch; ++s) {
+                    double sum = bias[o];
+                    for (size_t c = 0; c < shape->in_channels; ++c) {
+                        for (size_t ky = 0; ky < k; ++ky) {
+                            for (size_t kx = 0; kx < k; ++kx) {
+                                long iy = (long) (y * shape->stride + ky) - (long) shape->padding;
+                                long ix = (long) (x * shape->stride + kx) - (long) shape->padding;
+                                if (iy < 0 || ix < 0 || iy >= (long) shape->in_height || ix >= (long) shape->in_width) {
+                                    continue;
+                                }
+                                size_t neuron = (c * shape->in_height + (size_t) iy) * shape->in_width + (size_t) ix;
+                                sum += weights[o * shape->in_channels * k * k + (c * k + ky) * k + kx] *
+                                       input->elements[neuron * input->neuron_stride + s * input->sample_stride];
+                            }
+                        }
+                    }
+                    output[((o * out_height + y) * out_width + x) * batch + s] = (LAMP_FLOAT_TYPE) sum;
+                }
+            }
+        }
+    }
+}
+
+static bool conv_kernels_match(const LampConv2dShape *shape, size_t batch) {
+    size_t in_neurons = shape->in_channels * shape->in_height * shape->in_width;
+    size_t out_neurons = shape->out_channels * lamp_conv2d_out_height(shape) * lamp_conv2d_out_width(shape);
+    size_t num_weights = shape->out_channels * shape->in_channels * shape->kernel_size * shape->kernel_size;
+
+    // The input is given with one sample per row, like the first layer of a network
+    LampMatrix *samples = lamp_mat_alloc(batch, in_neurons);
+    LampMatrix *weights = lamp_mat_alloc(shape->out_channels, num_weights / shape->out_channels);
+    LampMatrix *bias = lamp_mat_alloc(shape->out_channels, 1);
+    LampMatrix *deltas = lamp_mat_alloc(out_neurons, batch);
+    lamp_mat_rand(samples);
+    lamp_mat_rand(weights);
+    lamp_mat_rand(bias);
+    lamp_mat_rand(deltas);
+    LampConvInput input = {samples->elements, 1, in_neurons};
+
+    LAMP_FLOAT_TYPE *workspace = malloc(sizeof(LAMP_FLOAT_TYPE) * lamp_conv2d_workspace_size(shape, batch));
+    LAMP_FLOAT_TYPE *expected = malloc(sizeof(LAMP_FLOAT_TYPE) * out_neurons * batch);
+    LAMP_FLOAT_TYPE *output = malloc(sizeof(LAMP_FLOAT_TYPE) * out_neurons * batch);
+    LAMP_FLOAT_TYPE *grads[2];
+    LAMP_FLOAT_TYPE *input_deltas[2];
+    for (size_t i = 0; i < 2; ++i) {
+        grads[i] = calloc(num_weights + shape->out_channels, sizeof(LAMP_FLOAT_TYPE));
+        input_deltas[i] = malloc(sizeof(LAMP_FLOAT_TYPE) * in_neurons * batch);
+        assert(grads[i] != NULL && input_deltas[i] != NULL);
+    }
+    assert(workspace != NULL && expected != NULL && output != NULL);
+
+    conv_reference(shape, batch, &input, weights->elements, bias->elements, expected);
+    bool result = LAMP_TEST_PASSED;
+    const LampConvAlgorithm algorithms[] = {LAMP_CONV_IM2COL, LAMP_CONV_DIRECT};
+    for (size_t i = 0; i < 2; ++i) {
+        LampGemmEpilogue epilogue = {bias->elements, NULL};
+        memset(output, 0xff, sizeof(LAMP_FLOAT_TYPE) * out_neurons * batch);
+        lamp_conv2d_forward(algorithms[i], shape, batch, &input, weights->elements, output, workspace, &epilogue);
+        if (!relative_close(expected, output, out_neurons * batch, 1e-5f)) {
+            result = LAMP_TEST_FAILED;
+        }
+
+        memset(input_deltas[i], 0xff, sizeof(LAMP_FLOAT_TYPE) * in_neurons * batch);
+        lamp_conv2d_backward(algorithms[i], shape, batch, &input, weights->elements, deltas->elements, grads[i],
+                             grads[i] + num_weights, input_deltas[i], workspace);
+    }
+
+    // The reference only calculates the forward pass, so the backward passes are compared to each other
+    if (!relative_close(grads[0], grads[1], num_weights + shape->out_channels, 1e-5f) ||
+        !relative_close(input_deltas[0], input_deltas[1], in_neurons * batch, 1e-5f)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    // The convolution is linear in the input, so <deltas, conv(input)> = <input deltas, input>
+    double forward_dot = 0.0, backward_dot = 0.0;
+    for (size_t i = 0; i < out_neurons * batch; ++i) {
+        forward_dot += (double) deltas->elements[i] * (expected[i] - bias->elements[i / batch /
+                       (out_neurons / shape->out_channels)]);
+    }
+    for (size_t n = 0; n < in_neurons; ++n) {
+        for (size_t s = 0; s < batch; ++s) {
+            backward_dot += (double) input_deltas[0][n * batch + s] * LAMP_MAT_ELEMENT_AT(samples, s, n);
+        }
+    }
+    if (fabs(forward_dot - backward_dot) > 1e-4 * (1.0 + fabs(forward_dot))) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    for (size_t i = 0; i < 2; ++i) {
+        free(grads[i]);
+        free(input_deltas[i]);
+    }
+    free(workspace);
+    free(expected);
+    free(output);
+    lamp_mat_free(samples);
+    lamp_mat_free(weights);
+    lamp_mat_free(bias);
+    lamp_mat_free(deltas);
+    return result;
+}
+
+bool test_nn_conv_kernels(void) {
+    // Padding, strides and kernels, that do not tile the image evenly
+    const LampConv2dShape shapes[] = {
+            {3, 7, 5, 4, 3, 2, 1},
+            {2, 6, 6, 3, 1, 1, 0},
+            {1, 5, 5, 2, 5, 1, 2},
+            {4, 9, 8, 5, 3, 1, 0},
+    };
+    const size_t batch_sizes[] = {1, 3, 17};
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i) {
+        for (size_t j = 0; j < sizeof(batch_sizes) / sizeof(batch_sizes[0]); ++j) {
+            if (!conv_kernels_match(&shapes[i], batch_sizes[j])) {
+                return LAMP_TEST_FAILED;
+            }
+        }
+    }
+    return LAMP_TEST_PASSED;
+}
+
+// A small image classifier: 1x6x6 -> conv 2x6x6 -> pool 2x3x3 -> conv 3x2x2 -> dense 3
+static LampNN *alloc_conv_network(LampConnectionKind pooling, size_t max_batch_size) {
+    const LampNNConnectionSpec specs[] = {
+            {.kind = LAMP_CONNECTION_CONV2D, .shape = {1, 6, 6, 2, 3, 1, 1}},
+            {.kind = pooling, .shape = {2, 6, 6, 0, 2, 2, 0}},
+            {.kind = LAMP_CONNECTION_CONV2D, .shape = {2, 3, 3, 3, 2, 1, 0}},
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 3},
+    };
+    LampNN *nn = lamp_nn_alloc_layers(36, specs, sizeof(specs) / sizeof(specs[0]), max_batch_size);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        LampMatrix *weights = nn->connections[i].weights;
+        lamp_mat_rand(weights);
+        lamp_mat_rand(nn->connections[i].bias);
+        for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(weights); ++j) {
+            weights->elements[j] = weights->elements[j] - 0.5f;
+        }
+    }
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_TANH);
+    lamp_nn_set_activation(nn, 2, LAMP_ACTIVATION_TANH);
+    return nn;
+}
+
+static bool conv_backprop_matches_finite_diff(LampConnectionKind pooling, LampConvAlgorithm algorithm) {
+    srand(3);
+    LampNN *nn = alloc_conv_network(pooling, 4);
+    lamp_nn_set_conv_algorithm(nn, 0, algorithm);
+    lamp_nn_set_conv_algorithm(nn, 2, algorithm);
+
+    LampMatrix *input = lamp_mat_alloc(5, 36);
+    LampMatrix *target = lamp_mat_alloc(5, 3);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView target_view = lamp_mat_view(target);
+    lamp_nn_backprop(nn, input, target);
+
+    // A small step, so the maximum of a pooling window rarely changes between both sides of the difference
+    LAMP_FLOAT_TYPE *expected = malloc(sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    assert(expected != NULL);
+    lamp_nn_finite_diff_gradients(nn, &input_view, &target_view, 1e-3f, NULL, expected);
+    bool result = LAMP_TEST_PASSED;
+    for (size_t i = 0; i < nn->params_size; ++i) {
+        if (LAMP_FABS(expected[i] - nn->grads[i]) > 1e-3f) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    free(expected);
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_nn_free(nn);
+    return result;
+}
+
+bool test_nn_conv_network(void) {
+    bool result = conv_backprop_matches_finite_diff(LAMP_CONNECTION_MAX_POOL, LAMP_CONV_IM2COL) &&
+                  conv_backprop_matches_finite_diff(LAMP_CONNECTION_MAX_POOL, LAMP_CONV_DIRECT) &&
+                  conv_backprop_matches_finite_diff(LAMP_CONNECTION_AVG_POOL, LAMP_CONV_IM2COL) &&
+                  conv_backprop_matches_finite_diff(LAMP_CONNECTION_AVG_POOL, LAMP_CONV_DIRECT);
+
+    // Inference, a saved model and a network with a larger batch calculate the same outputs
+    const char *path = "lamp_test_conv_model.bin";
+    LampNN *nn = alloc_conv_network(LAMP_CONNECTION_MAX_POOL, 4);
+    LampMatrix *input = lamp_mat_alloc(7, 36);
+    LampMatrix *output = lamp_mat_alloc(7, 3);
+    lamp_mat_rand(input);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView output_view = lamp_mat_view(output);
+    LampNNContext *ctx = lamp_nn_context_alloc(nn, 4);
+    lamp_nn_infer(nn, ctx, &input_view, &output_view);
+
+    LampMatrixView batch = lamp_mat_view_rows(&input_view, 4, 3);
+    lamp_nn_forward_view(nn, &batch);
+    const LampMatrix *out = nn->layers[nn->layer_count - 1].activations;
+    for (size_t s = 0; s < 3; ++s) {
+        for (size_t j = 0; j < 3; ++j) {
+            if (LAMP_FABS(LAMP_MAT_ELEMENT_AT(out, j, s) - LAMP_MAT_ELEMENT_AT(output, 4 + s, j)) > 1e-6f) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+    }
+
+    LampNN *loaded = lamp_nn_save(nn, path) ? lamp_nn_load(path, 8) : NULL;
+    if (loaded == NULL || loaded->connection_count != nn->connection_count) {
+        result = LAMP_TEST_FAILED;
+    } else {
+        for (size_t i = 0; i < nn->connection_count; ++i) {
+            if (loaded->connections[i].kind != nn->connections[i].kind ||
+                memcmp(&loaded->connections[i].shape, &nn->connections[i].shape, sizeof(LampConv2dShape)) != 0) {
+                result = LAMP_TEST_FAILED;
+            }
+        }
+        LampMatrix *loaded_output = lamp_mat_alloc(7, 3);
+        LampMatrixView loaded_view = lamp_mat_view(loaded_output);
+        LampNNContext *loaded_ctx = lamp_nn_context_alloc(loaded, 8);
+        lamp_nn_infer(loaded, loaded_ctx, &input_view, &loaded_view);
+        if (!relative_close(output->elements, loaded_output->elements, LAMP_MAT_NUM_ELEMENTS(output), 1e-5f)) {
+            result = LAMP_TEST_FAILED;
+        }
+        lamp_nn_context_free(loaded_ctx);
+        lamp_mat_free(loaded_output);
+        lamp_nn_free(loaded);
+    }
+
+    remove(path);
+    lamp_nn_context_free(ctx);
+    lamp_mat_free(input);
+    lamp_mat_free(output);
+    lamp_nn_free(nn);
+    return result;
+}
+
+static bool layers_match_finite_diff(size_t inputs, const LampNNConnectionSpec specs[], size_t connection_count,
+                                     const LampActivation activations[]) {
+    LampNN *nn = lamp_nn_alloc_layers(inputs, specs, connection_count, 4);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_nn_set_activation(nn, i, activations[i]);
+        LampMatrix *weights = nn->connections[i].weights;
+        LampMatrix *bias = nn->connections[i].bias;
+        // Random gains around one for the normalizations
+        bool norm = nn->connections[i].kind == LAMP_CONNECTION_LAYER_NORM;
+        lamp_mat_rand(weights);
+        lamp_mat_rand(bias);
+        for (size_t j = 0; j < LAMP_MAT_NUM_ELEMENTS(weights); ++j) {
+            weights->elements[j] = norm ? weights->elements[j] + 0.5f : weights->elements[j] - 0.5f;
+        }
+    }
+
+    LampMatrix *input = lamp_mat_alloc(6, inputs);
+    LampMatrix *target = lamp_mat_alloc(6, nn->layers[nn->layer_count - 1].activations->num_rows);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView target_view = lamp_mat_view(target);
+    lamp_nn_backprop(nn, input, target);
+
+    LAMP_FLOAT_TYPE *expected = malloc(sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    assert(expected != NULL);
+    lamp_nn_finite_diff_gradients(nn, &input_view, &target_view, 1e-2f, NULL, expected);
+    bool result = LAMP_TEST_PASSED;
+    for (size_t i = 0; i < nn->params_size; ++i) {
+        if (LAMP_FABS(expected[i] - nn->grads[i]) > 1e-3f) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    free(expected);
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_nn_free(nn);
+    return result;
+}
+
+bool test_nn_layer_chain(void) {
+    srand(4);
+    // Layers of every kind behind each other, including one that keeps its weighted input (GELU) and a dropout,
+    // which is only active during training and therefore drops nothing here
+    const LampNNConnectionSpec chain[] = {
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 12},
+            {.kind = LAMP_CONNECTION_LAYER_NORM},
+            {.kind = LAMP_CONNECTION_ACTIVATION},
+            {.kind = LAMP_CONNECTION_DROPOUT},
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 3},
+    };
+    const LampActivation chain_activations[] = {
+            LAMP_ACTIVATION_LINEAR, LAMP_ACTIVATION_LINEAR, LAMP_ACTIVATION_GELU, LAMP_ACTIVATION_LINEAR,
+            LAMP_ACTIVATION_SIGMOID
+    };
+    // The first connection reads the transposed input
+    const LampNNConnectionSpec first_norm[] = {
+            {.kind = LAMP_CONNECTION_LAYER_NORM},
+            {.kind = LAMP_CONNECTION_ACTIVATION},
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 3},
+    };
+    const LampActivation first_norm_activations[] = {
+            LAMP_ACTIVATION_TANH, LAMP_ACTIVATION_SIGMOID, LAMP_ACTIVATION_LINEAR
+    };
+    bool result = layers_match_finite_diff(8, chain, sizeof(chain) / sizeof(chain[0]), chain_activations) &&
+                  layers_match_finite_diff(6, first_norm, sizeof(first_norm) / sizeof(first_norm[0]),
+                                           first_norm_activations);
+
+    // A fresh normalization keeps the normalized input: zero mean and unit variance for every sample.
+    // The workspace is planned for the largest need - the statistics of a batch - so nothing is allocated later.
+    LampNN *nn = lamp_nn_alloc_layers(8, chain, sizeof(chain) / sizeof(chain[0]), 5);
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_LINEAR);
+    lamp_mat_rand(nn->connections[0].weights);
+    lamp_mat_rand(nn->connections[4].weights);
+    LampMatrix *input = lamp_mat_alloc(5, 8);
+    LampMatrix *target = lamp_mat_alloc(5, 3);
+    LampMatrix *output = lamp_mat_alloc(5, 3);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView output_view = lamp_mat_view(output);
+    LampNNContext *ctx = lamp_nn_context_alloc(nn, 5);
+
+    size_t allocations = 0;
+    for (int round = 0; round < 2; ++round) {
+        size_t before = lamp_alloc_count();
+        lamp_nn_forward_view(nn, &input_view);
+        lamp_nn_backprop(nn, input, target);
+        lamp_nn_infer(nn, ctx, &input_view, &output_view);
+        allocations = lamp_alloc_count() - before;
+    }
+    lamp_nn_forward_view(nn, &input_view);
+    const LampMatrix *normalized = nn->layers[2].activations;
+    for (size_t s = 0; s < normalized->num_cols; ++s) {
+        double sum = 0.0, squares = 0.0;
+        for (size_t j = 0; j < normalized->num_rows; ++j) {
+            sum += LAMP_MAT_ELEMENT_AT(normalized, j, s);
+            squares += LAMP_MAT_ELEMENT_AT(normalized, j, s) * LAMP_MAT_ELEMENT_AT(normalized, j, s);
+        }
+        if (fabs(sum) > 1e-4 || fabs(squares / (double) normalized->num_rows - 1.0) > 1e-3) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+    if (nn->workspace == NULL || allocations != 0) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    lamp_nn_context_free(ctx);
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_mat_free(output);
+    lamp_nn_free(nn);
+    return result;
+}
+
+bool test_nn_dropout(void) {
+    srand(5);
+    const LampNNConnectionSpec specs[] = {
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 256},
+            {.kind = LAMP_CONNECTION_DROPOUT, .rate = 0.25f},
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 2},
+    };
+    LampNN *nn = lamp_nn_alloc_layers(4, specs, sizeof(specs) / sizeof(specs[0]), 1);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+    // A sigmoid would saturate with that many inputs and not pass any deltas back
+    lamp_nn_set_activation(nn, 2, LAMP_ACTIVATION_LINEAR);
+    LampMatrix *input = lamp_mat_alloc(1, 4);
+    LampMatrix *target = lamp_mat_alloc(1, 2);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+    LampMatrixView input_view = lamp_mat_view(input);
+
+    // Inference keeps every neuron
+    bool result = LAMP_TEST_PASSED;
+    lamp_nn_forward_view(nn, &input_view);
+    if (!lamp_matrix_equal(nn->layers[1].activations, nn->layers[2].activations)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    // Training drops about a quarter of the neurons and scales the others, so the expected value stays the same.
+    // A dropped neuron does not contribute to the loss, so the gradients of its weights are zero.
+    LampNN *copy = lamp_nn_alloc_copy(nn, 1);
+    lamp_nn_backprop(nn, input, target);
+    const LampMatrix *kept = nn->layers[1].activations;
+    const LampMatrix *dropped = nn->layers[2].activations;
+    const LampMatrix *weights_grad = nn->connections[0].weights_grad;
+    size_t dropped_count = 0;
+    for (size_t j = 0; j < kept->num_rows; ++j) {
+        bool is_dropped = LAMP_MAT_ELEMENT_AT(dropped, j, 0) == 0.0f;
+        dropped_count += is_dropped;
+        if (!is_dropped && LAMP_FABS(LAMP_MAT_ELEMENT_AT(dropped, j, 0) -
+                                     LAMP_MAT_ELEMENT_AT(kept, j, 0) / 0.75f) > 1e-6f) {
+            result = LAMP_TEST_FAILED;
+        }
+        if ((LAMP_MAT_ELEMENT_AT(nn->connections[0].bias_grad, j, 0) == 0.0f) != is_dropped ||
+            (is_dropped && LAMP_MAT_ELEMENT_AT(weights_grad, j, 0) != 0.0f)) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+    if (dropped_count < 40 || dropped_count > 90) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    // The masks only depend on seed and step: a copy reproduces them, the next batch drops others
+    lamp_nn_backprop(copy, input, target);
+    if (nn->step != 1 || memcmp(nn->grads, copy->grads, sizeof(LAMP_FLOAT_TYPE) * nn->params_size) != 0) {
+        result = LAMP_TEST_FAILED;
+    }
+    lamp_nn_backprop(copy, input, target);
+    if (memcmp(nn->grads, copy->grads, sizeof(LAMP_FLOAT_TYPE) * nn->params_size) == 0) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    // The rate is part of the model file
+    const char *path = "lamp_test_dropout_model.bin";
+    LampNN *loaded = lamp_nn_save(nn, path) ? lamp_nn_load(path, 1) : NULL;
+    if (loaded == NULL || loaded->connections[1].kind != LAMP_CONNECTION_DROPOUT ||
+        loaded->connections[1].rate != 0.25f) {
+        result = LAMP_TEST_FAILED;
+    }
+    if (loaded != NULL) {
+        lamp_nn_free(loaded);
+    }
+    remove(path);
+
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_nn_free(copy);
+    lamp_nn_free(nn);
+    return result;
+}
+
+// The compiled plan of nn calculates the same outputs as lamp_nn_infer() with the same batch size,
+// without allocating anything, and ends up with step_count steps
+static bool plan_matches_infer(LampNN *nn, size_t samples, size_t max_batch_size, size_t step_count) {
+    size_t inputs = nn->layers[0].activations->num_rows;
+    size_t outputs = nn->layers[nn->layer_count - 1].activations->num_rows;
+    LampMatrix *input = lamp_mat_alloc(samples, inputs);
+    LampMatrix *expected = lamp_mat_alloc(samples, outputs);
+    LampMatrix *actual = lamp_mat_alloc(samples, outputs);
+    lamp_mat_rand(input);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView expected_view = lamp_mat_view(expected);
+    LampMatrixView actual_view = lamp_mat_view(actual);
+    LampNNContext *ctx = lamp_nn_context_alloc(nn, max_batch_size);
+    lamp_nn_infer(nn, ctx, &input_view, &expected_view);
+
+    LampNNPlan *plan = lamp_nn_compile(nn, max_batch_size);
+    size_t before = lamp_alloc_count();
+    lamp_nn_plan_infer(plan, &input_view, &actual_view);
+    bool result = lamp_alloc_count() == before && plan->step_count == step_count &&
+                  plan->buffer_size <= plan->unplanned_size &&
+                  relative_close(expected->elements, actual->elements, samples * outputs, 1e-4f);
+
+    lamp_nn_plan_free(plan);
+    lamp_nn_context_free(ctx);
+    lamp_mat_free(input);
+    lamp_mat_free(expected);
+    lamp_mat_free(actual);
+    return result;
+}
+
+bool test_nn_plan(void) {
+    srand(6);
+    // The dense connection with the linear activation is folded into the next one, the dropouts are removed and
+    // the activation connection becomes the activation of the normalization
+    const LampNNConnectionSpec chain[] = {
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 4},
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 6},
+            {.kind = LAMP_CONNECTION_DROPOUT, .rate = 0.5f},
+            {.kind = LAMP_CONNECTION_LAYER_NORM},
+            {.kind = LAMP_CONNECTION_ACTIVATION},
+            {.kind = LAMP_CONNECTION_DROPOUT, .rate = 0.5f},
+            {.kind = LAMP_CONNECTION_DENSE, .outputs = 3},
+    };
+    LampNN *nn = lamp_nn_alloc_layers(10, chain, sizeof(chain) / sizeof(chain[0]), 4);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_LINEAR);
+    lamp_nn_set_activation(nn, 3, LAMP_ACTIVATION_LINEAR);
+    lamp_nn_set_activation(nn, 4, LAMP_ACTIVATION_TANH);
+    bool result = plan_matches_infer(nn, 11, 4, 3);
+    lamp_nn_free(nn);
+
+    // Batches of a convolution, that does not fit into one batch
+    nn = alloc_conv_network(LAMP_CONNECTION_MAX_POOL, 4);
+    result = result && plan_matches_infer(nn, 7, 4, nn->connection_count);
+    lamp_nn_free(nn);
+
+    // The layers of a deep network take turns in two buffers, no matter how deep it is
+    size_t architecture[12];
+    for (size_t i = 0; i < 12; ++i) {
+        architecture[i] = 64;
+    }
+    nn = lamp_nn_alloc_batched(architecture, 12, 8);
+    result = result && plan_matches_infer(nn, 8, 8, 11);
+    LampNNPlan *plan = lamp_nn_compile(nn, 8);
+    if (plan->buffer_size != 2 * 64 * 8 * sizeof(LAMP_FLOAT_TYPE) ||
+        plan->unplanned_size != 11 * 64 * 8 * sizeof(LAMP_FLOAT_TYPE)) {
+        result = LAMP_TEST_FAILED;
+    }
+    lamp_nn_plan_free(plan);
+    lamp_nn_free(nn);
+    return result;
+}
+
+static LampTest nn_tests[] = {
+        {test_nn_alloc,              "NN alloc"},
+        {test_nn_backprop_gradients, "NN backprop gradients"},
+        {test_nn_backprop_training,  "NN backprop training"},
+        {test_nn_batched,            "NN batched"},
+        {test_nn_arena,              "NN arena"},
+        {test_nn_forward_view,       "NN forward view"},
+        {test_nn_infer,              "NN infer"},
+        {test_nn_dense_forward,      "NN dense forward"},
+        {test_nn_conv_kernels,       "NN conv kernels"},
+        {test_nn_conv_network,       "NN conv network"},
+        {test_nn_layer_chain,        "NN layer chain"},
+        {test_nn_dropout,            "NN dropout"},
+        {test_nn_plan,               "NN plan"},
+        {test_nn_activations,        "NN activations"},
+        {test_nn_save_load,          "NN save and load"},
+        {test_nn_load_untrusted,     "NN load untrusted"},
+        {test_nn_quantized,          "NN quantized"},
+        {test_nn_prune,              "NN prune"},
+        {test_nn_prune_saved,        "NN prune saved"},
+        {test_nn_prune_memory,       "NN prune memory"},
+        {test_nn_prune_training,     "NN prune training"},
+        {test_nn_optimizers,         "NN optimizers"},
+        {test_nn_no_allocations,     "NN no allocations"}
+};
+
+static void count_task(void *context, size_t task_index) {
+    int *counters = context;
+    counters[task_index]++;
+}
+
+static void nested_task(void *context, size_t task_index) {
+    // The pool is busy with this very task, so the nested work has to run on the calling thread
+    int *counters = context;
+    lamp_threadpool_parallel_for(lamp_threadpool_for_work(0), 10, count_task, &counters[task_index * 10]);
+}
+
+bool test_threadpool_parallel_for(void) {
+    LampThreadPool *pool = lamp_threadpool_alloc(4);
+    int counters[1000] = {0};
+
+    lamp_threadpool_parallel_for(pool, 1000, count_task, counters);
+    lamp_threadpool_set_default(pool);
+    lamp_threadpool_set_threshold(0);
+    lamp_threadpool_parallel_for(pool, 100, nested_task, counters);
+    lamp_threadpool_set_threshold(LAMP_THREADPOOL_DEFAULT_THRESHOLD);
+    lamp_threadpool_free(pool);
+
+    for (size_t i = 0; i < 1000; ++i) {
+        if (counters[i] != 2) {
+            return LAMP_TEST_FAILED;
+        }
+    }
+    return LAMP_TEST_PASSED;
+}
+
+// Splitting the work must not change the results, every element is calculated in the same order
+bool test_threadpool_matrix_ops(void) {
+    LampMatrix *m1 = lamp_mat_alloc(301, 77);
+    LampMatrix *m2 = lamp_mat_alloc(77, 45);
+    LampMatrix *m3 = lamp_mat_alloc(45, 517);
+    lamp_mat_rand(m1);
+    lamp_mat_rand(m2);
+    lamp_mat_rand(m3);
+
+    LampMatrix *serial_rows = lamp_mat_alloc_multiply(m1, m2);
+    LampMatrix *serial_cols = lamp_mat_alloc_multiply(m2, m3);
+    LampMatrix *serial_sum = lamp_mat_alloc_sum(m1, m1);
+    lamp_mat_sigmoid(serial_sum);
+
+    LampThreadPool *pool = lamp_threadpool_alloc(3);
+    lamp_threadpool_set_default(pool);
+    lamp_threadpool_set_threshold(0);
+
+    LampMatrix *parallel_rows = lamp_mat_alloc_multiply(m1, m2);
+    LampMatrix *parallel_cols = lamp_mat_alloc_multiply(m2, m3);
+    LampMatrix *parallel_sum = lamp_mat_alloc_sum(m1, m1);
+    lamp_mat_sigmoid(parallel_sum);
+
+    bool result = lamp_matrix_equal(serial_rows, parallel_rows) &&
+                  lamp_matrix_equal(serial_cols, parallel_cols) &&
+                  lamp_matrix_equal(serial_sum, parallel_sum);
+
+    // Every block of rows has to use its own part of the bias in the fused epilogue
+    if (!dense_forward_matches_unfused(301, 77, 45, LAMP_ACTIVATION_SIGMOID) ||
+        !dense_forward_matches_unfused(16, 77, 517, LAMP_ACTIVATION_TANH)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    // Blocks of reduced precision operands are addressed in LampHalf elements
+    if (!half_multiplication_matches(301, 77, 45, LAMP_PRECISION_FP16) ||
+        !half_multiplication_matches(45, 77, 517, LAMP_PRECISION_BF16) ||
+        !quant_multiplication_matches(301, 77, 45)) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    lamp_mat_fill_with(parallel_sum, 3.0f);
+    for (size_t i = 0; i < LAMP_MAT_NUM_ELEMENTS(parallel_sum); ++i) {
+        if (parallel_sum->elements[i] != 3.0f) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    lamp_threadpool_set_threshold(LAMP_THREADPOOL_DEFAULT_THRESHOLD);
+    lamp_threadpool_free(pool);
+
+    lamp_mat_free(m1);
+    lamp_mat_free(m2);
+    lamp_mat_free(m3);
+    lamp_mat_free(serial_rows);
+    lamp_mat_free(serial_cols);
+    lamp_mat_free(serial_sum);
+    lamp_mat_free(parallel_rows);
+    lamp_mat_free(parallel_cols);
+    lamp_mat_free(parallel_sum);
+    return result;
+}
+
+// The gradients of every worker part have to sum up to the ones of the whole batch
+static bool data_parallel_matches(LampNN *nn, LampThreadPool *pool, const LampMatrix *input,
+                                  const LampMatrix *target) {
+    lamp_nn_backprop(nn, input, target);
+    LampMatrix *expected = lamp_mat_alloc(1, nn->params_size);
+    memcpy(expected->elements, nn->grads, sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+
+    LampDataParallel *parallel = lamp_data_parallel_alloc(nn, pool);
+    // Every worker has to start from zero instead of the gradients of the last batch
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_fill_with(nn->connections[i].weights_grad, 1e6f);
+        lamp_mat_fill_with(nn->connections[i].bias_grad, 1e6f);
+    }
+    lamp_data_parallel_backprop(parallel, input, target);
+
+    bool result = true;
+    for (size_t i = 0; i < nn->params_size; ++i) {
+        LAMP_FLOAT_TYPE diff = LAMP_FABS(nn->grads[i] - expected->elements[i]);
+        if (diff > 1e-5f * fmaxf(1.0f, LAMP_FABS(expected->elements[i]))) {
+            result = false;
+        }
+    }
+    for (size_t i = 1; i < parallel->num_workers; ++i) {
+        if (parallel->replicas[i]->params != nn->params) {
+            result = false;
+        }
+    }
+
+    lamp_data_parallel_free(parallel);
+    lamp_mat_free(expected);
+    return result;
+}
+
+bool test_threadpool_data_parallel(void) {
+    // Workers process more samples than fit into one batch of the network
+    size_t arch[] = {5, 7, 6, 3};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 2);
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_GELU);
+    lamp_nn_set_activation(nn, 1, LAMP_ACTIVATION_TANH);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+
+    LampMatrix *input = lamp_mat_alloc(13, arch[0]);
+    LampMatrix *target = lamp_mat_alloc(13, arch[3]);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+    // Fewer samples than workers
+    LampMatrix *small_input = lamp_mat_alloc(2, arch[0]);
+    LampMatrix *small_target = lamp_mat_alloc(2, arch[3]);
+    lamp_mat_rand(small_input);
+    lamp_mat_rand(small_target);
+
+    bool result = data_parallel_matches(nn, NULL, input, target);
+    // Uneven parts and a number of workers, that is not a power of two
+    const size_t num_threads[] = {2, 3, 4, 5};
+    for (size_t i = 0; i < sizeof(num_threads) / sizeof(num_threads[0]); ++i) {
+        LampThreadPool *pool = lamp_threadpool_alloc(num_threads[i]);
+        if (!data_parallel_matches(nn, pool, input, target) ||
+            !data_parallel_matches(nn, pool, small_input, small_target)) {
+            result = LAMP_TEST_FAILED;
+        }
+        lamp_threadpool_free(pool);
+    }
+
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_mat_free(small_input);
+    lamp_mat_free(small_target);
+    lamp_nn_free(nn);
+    return result;
+}
+
+bool test_threadpool_gradient_check(void) {
+    // Central differences are accurate enough to compare every parameter, as long as the curvature is moderate
+    srand(1);
+    size_t arch[] = {4, 6, 3};
+    LampNN *nn = lamp_nn_alloc_batched(arch, sizeof(arch) / sizeof(arch[0]), 2);
+    lamp_nn_set_activation(nn, 0, LAMP_ACTIVATION_TANH);
+    for (size_t i = 0; i < nn->connection_count; ++i) {
+        lamp_mat_rand(nn->connections[i].weights);
+        lamp_mat_rand(nn->connections[i].bias);
+    }
+
+    // More samples than fit into one batch of the network
+    LampMatrix *input = lamp_mat_alloc(5, arch[0]);
+    LampMatrix *target = lamp_mat_alloc(5, arch[2]);
+    lamp_mat_rand(input);
+    lamp_mat_rand(target);
+    LampMatrixView input_view = lamp_mat_view(input);
+    LampMatrixView target_view = lamp_mat_view(target);
+    lamp_nn_backprop(nn, input, target);
+
+    LAMP_FLOAT_TYPE *params = malloc(sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    LAMP_FLOAT_TYPE *serial = malloc(sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    LAMP_FLOAT_TYPE *parallel = malloc(sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+    assert(params != NULL && serial != NULL && parallel != NULL);
+    memcpy(params, nn->params, sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+
+    lamp_nn_finite_diff_gradients(nn, &input_view, &target_view, 1e-2f, NULL, serial);
+    bool result = LAMP_TEST_PASSED;
+    for (size_t i = 0; i < nn->params_size; ++i) {
+        if (LAMP_FABS(serial[i] - nn->grads[i]) > 1e-3f) {
+            result = LAMP_TEST_FAILED;
+        }
+    }
+
+    // Every parameter is probed the same way, no matter which worker does it
+    const size_t num_threads[] = {2, 3, 4};
+    for (size_t i = 0; i < sizeof(num_threads) / sizeof(num_threads[0]); ++i) {
+        LampThreadPool *pool = lamp_threadpool_alloc(num_threads[i]);
+        memset(parallel, 0xff, sizeof(LAMP_FLOAT_TYPE) * nn->params_size);
+        lamp_nn_finite_diff_gradients(nn, &input_view, &target_view, 1e-2f, pool, parallel);
+        if (memcmp(serial, parallel, sizeof(LAMP_FLOAT_TYPE) * nn->params_size) != 0) {
+            result = LAMP_TEST_FAILED;
+        }
+        lamp_threadpool_free(pool);
+    }
+
+    if (memcmp(params, nn->params, sizeof(LAMP_FLOAT_TYPE) * nn->params_size) != 0) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    free(params);
+    free(serial);
+    free(parallel);
+    lamp_mat_free(input);
+    lamp_mat_free(target);
+    lamp_nn_free(nn);
+    return result;
+}
+
+// The consumer pops while all producers push. Nothing may get lost and the nodes of every producer
+// have to arrive in the order they were pushed.
+#define QUEUE_PRODUCERS 4
+#define QUEUE_NODES_PER_PRODUCER 20000
+
+typedef struct {
+    LampQueueNode node;
+    size_t producer;
+    size_t sequence;
+} QueueTestNode;
+
+typedef struct {
+    LampQueue *queue;
+    QueueTestNode *nodes;
+} QueueProducer;
+
+static void *queue_producer_main(void *arg) {
+    QueueProducer *producer = arg;
+    for (size_t i = 0; i < QUEUE_NODES_PER_PRODUCER; ++i) {
+        lamp_queue_push(producer->queue, &producer->nodes[i].node);
+    }
+    return NULL;
+}
+
+bool test_threadpool_queue(void) {
+    LampQueue queue;
+    lamp_queue_init(&queue);
+    if (lamp_queue_pop(&queue) != NULL) {
+        return LAMP_TEST_FAILED;
+    }
+
+    QueueTestNode *nodes = malloc(sizeof(QueueTestNode) * QUEUE_PRODUCERS * QUEUE_NODES_PER_PRODUCER);
+    assert(nodes != NULL);
+    QueueProducer producers[QUEUE_PRODUCERS];
+    pthread_t threads[QUEUE_PRODUCERS];
+    for (size_t p = 0; p < QUEUE_PRODUCERS; ++p) {
+        producers[p].queue = &queue;
+        producers[p].nodes = &nodes[p * QUEUE_NODES_PER_PRODUCER];
+        for (size_t i = 0; i < QUEUE_NODES_PER_PRODUCER; ++i) {
+            producers[p].nodes[i].producer = p;
+            producers[p].nodes[i].sequence = i;
+        }
+        pthread_create(&threads[p], NULL, queue_producer_main, &producers[p]);
+    }
+
+    bool result = true;
+    size_t next_sequence[QUEUE_PRODUCERS] = {0};
+    for (size_t popped = 0; popped < QUEUE_PRODUCERS * QUEUE_NODES_PER_PRODUCER;) {
+        QueueTestNode *node = (QueueTestNode *) lamp_queue_pop(&queue);
+        if (node == NULL) {
+            continue;
+        }
+        if (node->sequence != next_sequence[node->producer]++) {
+            result = LAMP_TEST_FAILED;
+        }
+        popped++;
+    }
+
+    for (size_t p = 0; p < QUEUE_PRODUCERS; ++p) {
+        pthread_join(threads[p], NULL);
+    }
+    if (lamp_queue_pop(&queue) != NULL) {
+        result = LAMP_TEST_FAILED;
+    }
+    free(nodes);
+    return result;
+}
+
+static LampTest threadpool_tests[] = {
+        {test_threadpool_parallel_for,   "Threadpool parallel for"},
+        {test_threadpool_matrix_ops,     "Threadpool matrix ops"},
+        {test_threadpool_data_parallel,  "Threadpool data parallel"},
+        {test_threadpool_gradient_check, "Threadpool gradient check"},
+        {test_threadpool_queue,          "Threadpool MPSC queue"}
+};
+
+// Every batch has to contain the next samples of the file, with inputs and targets split correctly
+static bool dataset_batches_match(LampDataset *dataset, const LampMatrix *samples, size_t num_inputs,
+                                  size_t batch_size) {
+    LampMatrixView inputs, targets;
+    size_t next_sample = 0;
+    while (lamp_dataset_next(dataset, &inputs, &targets)) {
+        size_t remaining = samples->num_rows - next_sample;
+        size_t expected_rows = remaining < batch_size ? remaining : batch_size;
+        if (inputs.num_rows != expected_rows || targets.num_rows != expected_rows ||
+            inputs.num_cols != num_inputs || targets.num_cols != samples->num_cols - num_inputs) {
+            return false;
+        }
+        for (size_t i = 0; i < inputs.num_rows; ++i, ++next_sample) {
+            for (size_t j = 0; j < samples->num_cols; ++j) {
+                LAMP_FLOAT_TYPE value = j < num_inputs ? LAMP_VIEW_ELEMENT_AT(&inputs, i, j) :
+                                        LAMP_VIEW_ELEMENT_AT(&targets, i, j - num_inputs);
+                if (value != LAMP_MAT_ELEMENT_AT(samples, next_sample, j)) {
+                    return false;
+                }
+            }
+        }
+    }
+    // The end of the epoch is sticky
+    return next_sample == samples->num_rows && !lamp_dataset_next(dataset, &inputs, &targets) &&
+           !lamp_dataset_failed(dataset);
+}
+
+bool test_dataset_binary(void) {
+    const char *path = "lamp_test_dataset.bin";
+    LampMatrix *samples = lamp_mat_alloc(10, 5);
+    lamp_mat_rand(samples);
+    LampMatrixView all = lamp_mat_view(samples);
+    LampMatrixView inputs = lamp_mat_view_cols(&all, 0, 3);
+    LampMatrixView targets = lamp_mat_view_cols(&all, 3, 2);
+    if (!lamp_dataset_save(path, &inputs, &targets)) {
+        lamp_mat_free(samples);
+        return LAMP_TEST_FAILED;
+    }
+
+    bool result = LAMP_TEST_PASSED;
+    LampDataset *dataset = lamp_dataset_open(path, LAMP_DATASET_BINARY, 3, 2, 4);
+    if (dataset == NULL) {
+        result = LAMP_TEST_FAILED;
+    } else {
+        // Two epochs, the second one after rewinding
+        for (int epoch = 0; epoch < 2; ++epoch) {
+            if (!dataset_batches_match(dataset, samples, 3, 4)) {
+                result = LAMP_TEST_FAILED;
+            }
+            lamp_dataset_rewind(dataset);
+        }
+        lamp_dataset_close(dataset);
+    }
+
+    // The file does not match the expected layout
+    if (lamp_dataset_open(path, LAMP_DATASET_BINARY, 2, 3, 4) != NULL) {
+        result = LAMP_TEST_FAILED;
+    }
+
+    remove(path);
+    lamp_mat_free(samples);
+    return result;
+}
+
+bool test_dataset_csv(void) {
+    const char *path = "lamp_test_dataset.csv";
+    FILE *file = fopen(path, "w");
+    fputs("# x1, x2, target\n0, 0, 0\n0,1,1\n\n1, 0, 1\r\n1,1, 1\n0.5,-2.25,3e2\n", file);
+    fclose(file);
+
+    LAMP_FLOAT_TYPE values[] = {0, 0, 0, 0, 1, 1, 1, 0, 1, 1, 1, 1, 0.5f, -2.25f, 300.0f};
+    LampMatrix *samples = lamp_mat_alloc_from_array(5, 3, values);
+
+    bool result = LAMP_TEST_PASSED;
+    LampDataset *dataset = lamp_dataset_open(path, LAMP_DATASET_CSV, 2, 1, 2);
+    if (dataset == NULL || !dataset_batches_match(dataset, samples, 2, 2)) {
+        result = LAMP_TEST_FAILED;
+    }
+    if (dataset != NULL) {
+        lamp_dataset_close(dataset);
+    }
+
+    // A line with a missing value ends the epoch and reports the failure
+    file = fopen(path, "w");
+    fputs("1,2,3\n4,5\n6,7,8\n", file);
+    fclose(file);
+    dataset = lamp_dataset_open(path, LAMP_DATASET_CSV, 2, 1, 1);
+    LampMatrixView inputs, targets;
+    if (dataset == NULL || !lamp_dataset_next(dataset, &inputs, &targets) ||
+        lamp_dataset_next(dataset, &inputs, &targets) || !lamp_dataset_failed(dataset)) {
+        result = LAMP_TEST_FAILED;
+    }
+    if (dataset != NULL) {
+        lamp_dataset_close(dataset);
+    }
+
+    remove(path);
+    lamp_mat_free(samples);
+    return result;
+}
+
+static LampTest dataset_tests[] = {
+        {test_dataset_binary, "Dataset binary"},
+        {test_dataset_csv,    "Dataset CSV"}
+};
+
+static void show_result(bool success, char *test_name) {
+    printf("TEST: %s \t%s\n", test_name, success == LAMP_TEST_PASSED ? "SUCCESS" : "FAILED");
+}
+
+static bool run_test(const LampTest *test) {
+    assert(test != NULL);
+    return test->test_function();
+}
+
+int main() {
+    printf("LAMP Tests Matrix\n");
+
+    int number_of_matrix_test = sizeof(matrix_tests) / sizeof(matrix_tests[0]);
+    for (int i = 0; i < number_of_matrix_test; ++i) {
+        show_result(run_test(&matrix_tests[i]), matrix_tests[i].desc);
+    }
+
+    printf("\nLAMP Tests NN\n");
+    int number_of_nn_tests = sizeof(nn_tests) / sizeof(nn_tests[0]);
+    for (int i = 0; i < number_of_nn_tests; ++i) {
+        show_result(run_test(&nn_tests[i]), nn_tests[i].desc);
+    }
+
+    printf("\nLAMP Tests Threadpool\n");
+    int number_of_threadpool_tests = sizeof(threadpool_tests) / sizeof(threadpool_tests[0]);
+    for (int i = 0; i < number_of_threadpool_tests; ++i) {
+        show_result(run_test(&threadpool_tests[i]), threadpool_tests[i].desc);
+    }
+
+    printf("\nLAMP Tests Dataset\n");
+    int number_of_dataset_tests = sizeof(dataset_tests) / sizeof(dataset_tests[0]);
+    for (int i = 0; i < number_of_dataset_tests; ++i) {
+        show_result(run_test(&dataset_tests[i]), dataset_tests[i].desc);
     }
 
 